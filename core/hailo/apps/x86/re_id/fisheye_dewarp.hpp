@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+// Hailo includes
+#include "hailo_thread_pool.hpp"
+
+// Open source includes
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+/**
+ * @brief Intrinsics and distortion coefficients of a fisheye camera.
+ */
+struct FisheyeCalibration
+{
+    float fx, fy; // Focal lengths
+    float cx, cy; // Principal point
+    std::array<float, 4> distortion;
+
+    bool operator<(const FisheyeCalibration &other) const
+    {
+        return std::tie(fx, fy, cx, cy, distortion) < std::tie(other.fx, other.fy, other.cx, other.cy, other.distortion);
+    }
+};
+
+/**
+ * @brief Dewarp maps of one calibration at one resolution, in OpenCV's fixed-point form:
+ *        map1 holds the integer source coordinates (CV_16SC2), map2 the index into the interpolation table (CV_16UC1).
+ */
+struct FisheyeDewarpMaps
+{
+    cv::Mat map1;
+    cv::Mat map2;
+};
+
+/**
+ * @brief Undistorts fisheye frames in place.
+ *        Maps are built once per calibration and resolution and shared by every stream that uses them.
+ *        A frame is copied once into a reused per-thread source image, and the remap writes straight
+ *        back into the frame in row tiles spread over a thread pool.
+ */
+class FisheyeDewarp
+{
+private:
+    static constexpr int TILE_ROWS = 32;
+
+    using MapsKey = std::tuple<int, int, FisheyeCalibration>;
+
+    static std::mutex &maps_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::map<MapsKey, std::shared_ptr<const FisheyeDewarpMaps>> &maps_cache()
+    {
+        static std::map<MapsKey, std::shared_ptr<const FisheyeDewarpMaps>> cache;
+        return cache;
+    }
+
+    static HailoThreadPool &thread_pool()
+    {
+        static HailoThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+public:
+    /**
+     * @brief Get the maps of a calibration at a resolution, building them on first use.
+     */
+    static std::shared_ptr<const FisheyeDewarpMaps> get_maps(const FisheyeCalibration &calibration, cv::Size size)
+    {
+        std::lock_guard<std::mutex> lock(maps_mutex());
+        auto &cache = maps_cache();
+        MapsKey key(size.width, size.height, calibration);
+        auto itr = cache.find(key);
+        if (itr != cache.end())
+            return itr->second;
+
+        cv::Matx33f cam(calibration.fx, 0.0f, calibration.cx,
+                        0.0f, calibration.fy, calibration.cy,
+                        0.0f, 0.0f, 1.0f);
+        cv::Vec4f dist(calibration.distortion[0], calibration.distortion[1], calibration.distortion[2], calibration.distortion[3]);
+
+        auto maps = std::make_shared<FisheyeDewarpMaps>();
+        cv::fisheye::initUndistortRectifyMap(cam, dist, cv::Mat(), cam, size, CV_16SC2, maps->map1, maps->map2);
+        cache.emplace(key, maps);
+        return maps;
+    }
+
+    /**
+     * @brief Dewarp an image in place.
+     *
+     * @param image The image to dewarp, any stride.
+     * @param calibration The calibration of the camera that captured the image.
+     */
+    static void dewarp(cv::Mat &image, const FisheyeCalibration &calibration)
+    {
+        std::shared_ptr<const FisheyeDewarpMaps> maps = get_maps(calibration, image.size());
+
+        // remap can't run in place, the source is a copy that is reused between frames
+        thread_local cv::Mat source;
+        image.copyTo(source);
+
+        int tiles = (image.rows + TILE_ROWS - 1) / TILE_ROWS;
+        thread_pool().parallel_for(tiles, [&](size_t tile)
+                                   {
+            int start = tile * TILE_ROWS;
+            int end = std::min(start + TILE_ROWS, image.rows);
+            cv::Mat destination = image.rowRange(start, end);
+            cv::remap(source, destination, maps->map1.rowRange(start, end), maps->map2.rowRange(start, end), cv::INTER_LINEAR); });
+    }
+};
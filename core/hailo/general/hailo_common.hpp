@@ -43,12 +43,12 @@ namespace hailo_common
     inline void add_classification(HailoROIPtr roi, std::string type, std::string label, float confidence, int class_id = NULL_CLASS_ID)
     {
         add_object(roi,
-                   std::make_shared<HailoClassification>(type, class_id, label, confidence));
+                   hailo_make_shared<HailoClassification>(type, class_id, label, confidence));
     }
 
     inline HailoDetectionPtr add_detection(HailoROIPtr roi, HailoBBox bbox, std::string label, float confidence, int class_id = NULL_CLASS_ID)
     {
-        HailoDetectionPtr detection = std::make_shared<HailoDetection>(bbox, class_id, label, confidence);
+        HailoDetectionPtr detection = hailo_make_shared<HailoDetection>(bbox, class_id, label, confidence);
         detection->set_scaling_bbox(roi->get_bbox());
         add_object(roi, detection);
         return detection;
@@ -58,7 +58,7 @@ namespace hailo_common
     {
         for (auto det : detections)
         {
-            add_object(roi, std::make_shared<HailoDetection>(det));
+            add_object(roi, hailo_make_shared<HailoDetection>(det));
         }
     }
 
@@ -89,7 +89,7 @@ namespace hailo_common
 
     inline bool has_classifications(HailoROIPtr roi, std::string classification_type)
     {
-        for (auto obj : roi->get_objects_typed(HAILO_CLASSIFICATION))
+        for (auto &obj : roi->objects_typed(HAILO_CLASSIFICATION))
         {
             HailoClassificationPtr classification = std::dynamic_pointer_cast<HailoClassification>(obj);
             if (classification_type.compare(classification->get_classification_type()) == 0)
@@ -103,7 +103,7 @@ namespace hailo_common
     inline void remove_classifications(HailoROIPtr roi, std::string classification_type)
     {
         std::vector<HailoObjectPtr> classifications;
-        for (auto obj : roi->get_objects_typed(HAILO_CLASSIFICATION))
+        for (auto &obj : roi->objects_typed(HAILO_CLASSIFICATION))
         {
             HailoClassificationPtr classification = std::dynamic_pointer_cast<HailoClassification>(obj);
             if (classification_type.compare(classification->get_classification_type()) == 0)
@@ -116,10 +116,9 @@ namespace hailo_common
 
     inline std::vector<HailoDetectionPtr> get_hailo_detections(HailoROIPtr roi)
     {
-        std::vector<HailoObjectPtr> objects = roi->get_objects_typed(HAILO_DETECTION);
         std::vector<HailoDetectionPtr> detections;
 
-        for (auto obj : objects)
+        for (auto &obj : roi->objects_typed(HAILO_DETECTION))
         {
             detections.emplace_back(std::dynamic_pointer_cast<HailoDetection>(obj));
         }
@@ -128,10 +127,9 @@ namespace hailo_common
 
     inline std::vector<HailoTileROIPtr> get_hailo_tiles(HailoROIPtr roi)
     {
-        std::vector<HailoObjectPtr> objects = roi->get_objects_typed(HAILO_TILE);
         std::vector<HailoTileROIPtr> tiles;
 
-        for (auto obj : objects)
+        for (auto &obj : roi->objects_typed(HAILO_TILE))
         {
             tiles.emplace_back(std::dynamic_pointer_cast<HailoTileROI>(obj));
         }
@@ -140,10 +138,9 @@ namespace hailo_common
 
     inline std::vector<HailoClassificationPtr> get_hailo_classifications(HailoROIPtr roi, std::string classification_type = "")
     {
-        std::vector<HailoObjectPtr> objects = roi->get_objects_typed(HAILO_CLASSIFICATION);
         std::vector<HailoClassificationPtr> classifications;
 
-        for (auto obj : objects)
+        for (auto &obj : roi->objects_typed(HAILO_CLASSIFICATION))
         {
             HailoClassificationPtr classification = std::dynamic_pointer_cast<HailoClassification>(obj);
             if (classification_type.empty() || classification_type.compare(classification->get_classification_type()) == 0)
@@ -156,10 +153,9 @@ namespace hailo_common
 
     inline std::vector<HailoUniqueIDPtr> get_hailo_unique_id(HailoROIPtr roi)
     {
-        std::vector<HailoObjectPtr> objects = roi->get_objects_typed(HAILO_UNIQUE_ID);
         std::vector<HailoUniqueIDPtr> unique_ids;
 
-        for (auto obj : objects)
+        for (auto &obj : roi->objects_typed(HAILO_UNIQUE_ID))
         {
             unique_ids.emplace_back(std::dynamic_pointer_cast<HailoUniqueID>(obj));
         }
@@ -168,10 +164,9 @@ namespace hailo_common
 
     inline std::vector<HailoUniqueIDPtr> get_hailo_unique_id_by_mode(HailoROIPtr roi, hailo_unique_id_mode_t mode)
     {
-        std::vector<HailoObjectPtr> objects = roi->get_objects_typed(HAILO_UNIQUE_ID);
         std::vector<HailoUniqueIDPtr> unique_ids;
 
-        for (auto obj : objects)
+        for (auto &obj : roi->objects_typed(HAILO_UNIQUE_ID))
         {
             HailoUniqueIDPtr unique_id = std::dynamic_pointer_cast<HailoUniqueID>(obj);
             if(unique_id->get_mode() == mode)
@@ -194,10 +189,9 @@ namespace hailo_common
 
     inline std::vector<HailoLandmarksPtr> get_hailo_landmarks(HailoROIPtr roi)
     {
-        std::vector<HailoObjectPtr> objects = roi->get_objects_typed(HAILO_LANDMARKS);
         std::vector<HailoLandmarksPtr> landmarks;
 
-        for (auto obj : objects)
+        for (auto &obj : roi->objects_typed(HAILO_LANDMARKS))
         {
             landmarks.emplace_back(std::dynamic_pointer_cast<HailoLandmarks>(obj));
         }
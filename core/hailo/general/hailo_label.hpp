@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+/**
+ * @brief Process wide set of interned label strings.
+ * Strings are only ever added, so a pointer to an interned label stays valid for the lifetime of the process.
+ * Labels are also published to a fixed size, insert only hash table of atomic pointers, so looking up a label
+ * that is already interned doesn't take the lock. Once that table is half full, newer labels are only found
+ * under the lock.
+ */
+class HailoLabelRegistry
+{
+private:
+    static constexpr std::size_t LOOKUP_SLOTS = 4096; // Power of two
+    static constexpr std::size_t MAX_LOOKUP_LABELS = LOOKUP_SLOTS / 2;
+
+    std::array<std::atomic<const std::string *>, LOOKUP_SLOTS> m_lookup{};
+    std::size_t m_lookup_labels = 0; // Guarded by m_mutex
+    std::mutex m_mutex;
+    std::unordered_set<std::string> m_labels;
+
+    // Linear probing, slots are only ever filled, so an empty slot ends the search.
+    const std::string *find(const std::string &label, std::size_t hash) const
+    {
+        for (std::size_t i = 0; i < LOOKUP_SLOTS; i++)
+        {
+            const std::string *interned = m_lookup[(hash + i) & (LOOKUP_SLOTS - 1)].load(std::memory_order_acquire);
+            if (interned == nullptr || *interned == label)
+                return interned;
+        }
+        return nullptr;
+    }
+
+    // Must be called with m_mutex held.
+    void publish(const std::string *interned, std::size_t hash)
+    {
+        if (m_lookup_labels >= MAX_LOOKUP_LABELS)
+            return;
+        for (std::size_t i = 0; i < LOOKUP_SLOTS; i++)
+        {
+            std::atomic<const std::string *> &slot = m_lookup[(hash + i) & (LOOKUP_SLOTS - 1)];
+            const std::string *current = slot.load(std::memory_order_relaxed);
+            if (current == interned)
+                return;
+            if (current == nullptr)
+            {
+                slot.store(interned, std::memory_order_release);
+                m_lookup_labels++;
+                return;
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief The registry instance, never destroyed so labels of objects released during static destruction stay valid.
+     */
+    static HailoLabelRegistry &instance()
+    {
+        static HailoLabelRegistry *registry = new HailoLabelRegistry();
+        return *registry;
+    }
+
+    /**
+     * @brief Get the interned copy of a label, adding it on first use.
+     *
+     * @param label The label to intern.
+     * @return const std::string* - Stable pointer to the interned label.
+     */
+    const std::string *intern(const std::string &label)
+    {
+        const std::size_t hash = std::hash<std::string>{}(label);
+        if (const std::string *interned = find(label, hash))
+            return interned;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::string *interned = &*m_labels.insert(label).first;
+        publish(interned, hash);
+        return interned;
+    }
+};
+
+/**
+ * @brief A compact handle to an interned label.
+ * Copying a label is copying a pointer, and equal labels compare by pointer.
+ * The empty label isn't interned, so a default constructed label costs nothing.
+ */
+class HailoLabel
+{
+private:
+    const std::string *m_label;
+
+    static const std::string &empty_label()
+    {
+        static const std::string empty;
+        return empty;
+    }
+
+public:
+    HailoLabel() : m_label(nullptr){};
+    HailoLabel(const std::string &label) : m_label(label.empty() ? nullptr : HailoLabelRegistry::instance().intern(label)){};
+
+    const std::string &str() const
+    {
+        return m_label ? *m_label : empty_label();
+    }
+
+    bool operator==(const HailoLabel &other) const
+    {
+        return m_label == other.m_label;
+    }
+
+    bool operator!=(const HailoLabel &other) const
+    {
+        return m_label != other.m_label;
+    }
+};
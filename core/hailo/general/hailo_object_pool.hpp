@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Counters of the metadata objects pool.
+ *        A hit is an allocation served from a recycled block, a miss went to the heap.
+ */
+struct HailoObjectPoolStats
+{
+    uint64_t hits;
+    uint64_t misses;
+};
+
+/**
+ * @brief Process wide pool of memory blocks for metadata objects (detections, classifications, ROIs etc.).
+ * Objects are created per frame and die with their buffer, usually on another thread, so a block is recycled
+ * into a free list of its size class instead of going back to the heap. The pool is not bound to a stream or
+ * a buffer: objects may outlive the buffer they were created for (trackers, aggregators), and the block is
+ * only recycled once the last reference is gone.
+ */
+class HailoObjectPool
+{
+private:
+    static constexpr std::size_t BLOCK_ALIGNMENT = 64;
+    static constexpr std::size_t SIZE_CLASSES = 16; // blocks of up to 1KB
+    static constexpr std::size_t MAX_FREE_BLOCKS = 8192;
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    struct SizeClass
+    {
+        std::mutex mutex;
+        FreeBlock *head = nullptr;
+        std::size_t count = 0;
+    };
+
+    std::array<SizeClass, SIZE_CLASSES> m_classes;
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+
+    static std::size_t size_class(std::size_t size)
+    {
+        return (size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT - 1;
+    }
+
+public:
+    /**
+     * @brief The pool instance, never destroyed so objects released during static destruction are still safe.
+     */
+    static HailoObjectPool &instance()
+    {
+        static HailoObjectPool *pool = new HailoObjectPool();
+        return *pool;
+    }
+
+    void *allocate(std::size_t size)
+    {
+        std::size_t index = size_class(size);
+        if (index >= SIZE_CLASSES)
+            return ::operator new(size);
+
+        SizeClass &size_class = m_classes[index];
+        {
+            std::lock_guard<std::mutex> lock(size_class.mutex);
+            FreeBlock *block = size_class.head;
+            if (block != nullptr)
+            {
+                size_class.head = block->next;
+                size_class.count--;
+                m_hits.fetch_add(1, std::memory_order_relaxed);
+                return block;
+            }
+        }
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new((index + 1) * BLOCK_ALIGNMENT);
+    }
+
+    void deallocate(void *ptr, std::size_t size)
+    {
+        std::size_t index = size_class(size);
+        if (index < SIZE_CLASSES)
+        {
+            SizeClass &size_class = m_classes[index];
+            std::lock_guard<std::mutex> lock(size_class.mutex);
+            if (size_class.count < MAX_FREE_BLOCKS)
+            {
+                FreeBlock *block = static_cast<FreeBlock *>(ptr);
+                block->next = size_class.head;
+                size_class.head = block;
+                size_class.count++;
+                return;
+            }
+        }
+        ::operator delete(ptr);
+    }
+
+    HailoObjectPoolStats stats() const
+    {
+        return {m_hits.load(std::memory_order_relaxed), m_misses.load(std::memory_order_relaxed)};
+    }
+};
+
+/**
+ * @brief Allocator over the HailoObjectPool, used through hailo_make_shared.
+ */
+template <typename T>
+class HailoPoolAllocator
+{
+public:
+    using value_type = T;
+
+    HailoPoolAllocator() noexcept = default;
+    template <typename U>
+    HailoPoolAllocator(const HailoPoolAllocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over aligned types are not supported by the objects pool");
+        return static_cast<T *>(HailoObjectPool::instance().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept
+    {
+        HailoObjectPool::instance().deallocate(ptr, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const HailoPoolAllocator<U> &) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const HailoPoolAllocator<U> &) const noexcept { return false; }
+};
+
+/**
+ * @brief Drop in replacement of std::make_shared for metadata objects, the object and its control block
+ *        share one pooled block.
+ */
+template <typename T, typename... Args>
+inline std::shared_ptr<T> hailo_make_shared(Args &&...args)
+{
+    return std::allocate_shared<T>(HailoPoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Current hit/miss counters of the metadata objects pool.
+ */
+inline HailoObjectPoolStats hailo_object_pool_stats()
+{
+    return HailoObjectPool::instance().stats();
+}
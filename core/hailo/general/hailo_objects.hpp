@@ -9,14 +9,20 @@
 
 #pragma once
 
+#include "hailo_label.hpp"
+#include "hailo_object_pool.hpp"
 #include "hailo_tensors.hpp"
+#include <cassert>
 #include <map>
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <iterator>
 #include <mutex>
+#include <thread>
 
 #define CLAMP(x, low, high) (((x) > (high)) ? (high) : (((x) < (low)) ? (low) : (x)))
 #define CLIP(x) (CLAMP(x, 0, 255))
@@ -154,6 +160,72 @@ public:
     const float ymax() const { return m_ymin + m_height; }
 };
 
+/**
+ * @brief The lock embedded in every HailoObject.
+ * The critical sections of the metadata are a few loads and stores, so a spinlock on an atomic flag
+ * is enough, and unlike a heap allocated std::mutex it costs nothing to create. Copies of an object get
+ * their own (unlocked) lock, they no longer share the lock of the original.
+ * The lock isn't recursive. Debug builds assert that a thread doesn't lock an object it already holds,
+ * for example by modifying a main object while iterating its objects_typed() view.
+ * Building with -Dobjects_locking=false (HAILO_OBJECTS_NO_LOCKING) elides the locking altogether. That relies on
+ * the ownership handoff of the pipeline: only the element that currently holds a buffer reads or writes its
+ * metadata, and every module loaded in the process must be built the same way.
+ */
+class HailoObjectMutex
+{
+private:
+    std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+#if !defined(HAILO_OBJECTS_NO_LOCKING) && !defined(NDEBUG)
+    // Only the owner writes its own id here, so relaxed loads are enough to tell whether the caller holds the lock.
+    std::atomic<std::thread::id> m_owner{};
+
+    void set_owner() noexcept { m_owner.store(std::this_thread::get_id(), std::memory_order_relaxed); }
+    void clear_owner() noexcept { m_owner.store(std::thread::id(), std::memory_order_relaxed); }
+    void assert_not_owner() const noexcept
+    {
+        assert(m_owner.load(std::memory_order_relaxed) != std::this_thread::get_id() &&
+               "HailoObject locked again by the thread holding it, is it modified while iterating objects_typed()?");
+    }
+#else
+    void set_owner() noexcept {}
+    void clear_owner() noexcept {}
+    void assert_not_owner() const noexcept {}
+#endif
+
+public:
+    HailoObjectMutex() = default;
+    HailoObjectMutex(const HailoObjectMutex &) noexcept {};
+    HailoObjectMutex &operator=(const HailoObjectMutex &) noexcept { return *this; };
+
+    void lock() noexcept
+    {
+#ifndef HAILO_OBJECTS_NO_LOCKING
+        assert_not_owner();
+        while (m_flag.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+        set_owner();
+#endif
+    }
+    bool try_lock() noexcept
+    {
+#ifndef HAILO_OBJECTS_NO_LOCKING
+        if (m_flag.test_and_set(std::memory_order_acquire))
+            return false;
+        set_owner();
+        return true;
+#else
+        return true;
+#endif
+    }
+    void unlock() noexcept
+    {
+#ifndef HAILO_OBJECTS_NO_LOCKING
+        clear_owner();
+        m_flag.clear(std::memory_order_release);
+#endif
+    }
+};
+
 /**
  * @brief Represents an object that is a usable output after postprocessing.
  * An abstract class for all objects to inherit from.
@@ -161,14 +233,11 @@ public:
 class HailoObject
 {
 protected:
-    std::shared_ptr<std::mutex> mutex;
+    HailoObjectMutex mutex;
 
 public:
     // Constructor
-    HailoObject()
-    {
-        mutex = std::make_shared<std::mutex>();
-    };
+    HailoObject() = default;
     // Destructor
     virtual ~HailoObject() = default;
     HailoObject &operator=(const HailoObject &other) = default;
@@ -186,6 +255,71 @@ public:
 
 using HailoObjectPtr = std::shared_ptr<HailoObject>;
 
+/**
+ * @brief A filtered view of the sub objects of a given type, attached to a main object.
+ * Nothing is copied, the owner stays locked while the view is alive. The lock isn't recursive, so don't call
+ * any method of the same owner (add, remove or get objects, tensors...) while iterating it: collect what is
+ * needed and act after the loop, or iterate get_objects_typed() instead. Debug builds assert on such calls.
+ */
+class HailoObjectsTypedView
+{
+public:
+    class iterator
+    {
+    private:
+        std::vector<HailoObjectPtr>::const_iterator m_current;
+        std::vector<HailoObjectPtr>::const_iterator m_end;
+        hailo_object_t m_type;
+
+        void skip()
+        {
+            while (m_current != m_end && (*m_current)->get_type() != m_type)
+                ++m_current;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = HailoObjectPtr;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const HailoObjectPtr *;
+        using reference = const HailoObjectPtr &;
+
+        iterator(std::vector<HailoObjectPtr>::const_iterator current, std::vector<HailoObjectPtr>::const_iterator end, hailo_object_t type)
+            : m_current(current), m_end(end), m_type(type)
+        {
+            skip();
+        }
+        reference operator*() const { return *m_current; }
+        pointer operator->() const { return &*m_current; }
+        iterator &operator++()
+        {
+            ++m_current;
+            skip();
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+        bool operator==(const iterator &other) const { return m_current == other.m_current; }
+        bool operator!=(const iterator &other) const { return m_current != other.m_current; }
+    };
+
+    HailoObjectsTypedView(HailoObjectMutex &mutex, const std::vector<HailoObjectPtr> &objects, hailo_object_t type)
+        : m_lock(mutex), m_objects(objects), m_type(type){};
+
+    iterator begin() const { return iterator(m_objects.begin(), m_objects.end(), m_type); }
+    iterator end() const { return iterator(m_objects.end(), m_objects.end(), m_type); }
+    bool empty() const { return begin() == end(); }
+
+private:
+    std::unique_lock<HailoObjectMutex> m_lock;
+    const std::vector<HailoObjectPtr> &m_objects;
+    hailo_object_t m_type;
+};
+
 /**
  * @brief Represents a HailoObject that can hold other objects.
  *  for example a face detection can hold landmarks or age classification, gender classification etc...
@@ -197,10 +331,7 @@ protected:
     std::map<std::string, HailoTensorPtr> m_tensors;
 
 public:
-    HailoMainObject()
-    {
-        mutex = std::make_shared<std::mutex>();
-    };
+    HailoMainObject() = default;
     virtual ~HailoMainObject() = default;
     HailoMainObject(HailoMainObject &&other) noexcept : HailoObject(other), m_sub_objects(std::move(other.m_sub_objects)){};
     HailoMainObject(const HailoMainObject &other) : HailoObject(other), m_sub_objects(other.m_sub_objects){};
@@ -214,7 +345,7 @@ public:
      */
     void add_object(HailoObjectPtr obj)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_sub_objects.emplace_back(obj);
     };
 
@@ -225,7 +356,7 @@ public:
      */
     void add_tensor(HailoTensorPtr tensor)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_tensors.emplace(tensor->name(), tensor);
     };
 
@@ -237,7 +368,7 @@ public:
      */
     void remove_object(HailoObjectPtr obj)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_sub_objects.erase(std::remove(m_sub_objects.begin(), m_sub_objects.end(), obj), m_sub_objects.end());
     };
 
@@ -249,7 +380,7 @@ public:
      */
     void remove_object(uint index)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_sub_objects.erase(m_sub_objects.begin() + index);
     };
 
@@ -261,7 +392,7 @@ public:
      */
     HailoTensorPtr get_tensor(std::string name)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         auto itr = m_tensors.find(name);
         if (itr == m_tensors.end())
         {
@@ -288,7 +419,7 @@ public:
      */
     std::vector<HailoTensorPtr> get_tensors()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         std::vector<HailoTensorPtr> _tensors;
         _tensors.reserve(m_tensors.size());
         for (auto &tensor_pair : m_tensors)
@@ -315,7 +446,7 @@ public:
      */
     void clear_tensors()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_tensors.clear();
     }
 
@@ -326,7 +457,7 @@ public:
      */
     std::vector<HailoObjectPtr> get_objects()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_sub_objects;
     }
 
@@ -338,7 +469,7 @@ public:
      */
     std::vector<HailoObjectPtr> get_objects_typed(hailo_object_t type)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         std::vector<HailoObjectPtr> filtered_subobjects;
         for (auto &obj : m_sub_objects)
         {
@@ -350,6 +481,18 @@ public:
         return filtered_subobjects;
     }
 
+    /**
+     * @brief Iterate the objects of a given type, attached to this main object, without copying them.
+     *        This main object is locked until the view goes out of scope, see HailoObjectsTypedView.
+     *
+     * @param type The type of object to iterate.
+     * @return HailoObjectsTypedView
+     */
+    HailoObjectsTypedView objects_typed(hailo_object_t type)
+    {
+        return HailoObjectsTypedView(mutex, m_sub_objects, type);
+    }
+
     /**
      * @brief Removes all the objects of a given type, attached to this main object.
      *
@@ -357,10 +500,11 @@ public:
      */
     void remove_objects_typed(hailo_object_t type)
     {
-        for (auto obj : this->get_objects_typed(type))
-        {
-            this->remove_object(obj);
-        }
+        std::lock_guard<HailoObjectMutex> lock(mutex);
+        m_sub_objects.erase(std::remove_if(m_sub_objects.begin(), m_sub_objects.end(),
+                                           [type](const HailoObjectPtr &obj)
+                                           { return obj->get_type() == type; }),
+                            m_sub_objects.end());
     }
 };
 using HailoMainObjectPtr = std::shared_ptr<HailoMainObject>;
@@ -426,7 +570,7 @@ public:
      */
     HailoBBox &get_bbox()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_bbox;
     }
 
@@ -437,7 +581,7 @@ public:
      */
     void set_bbox(HailoBBox bbox)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_bbox = std::move(bbox);
     }
 
@@ -448,7 +592,7 @@ public:
      */
     HailoBBox &get_scaling_bbox()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_scaling_bbox;
     }
 
@@ -459,7 +603,7 @@ public:
      */
     void set_scaling_bbox(HailoBBox bbox)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         float new_xmin = (m_scaling_bbox.xmin() * bbox.width()) + bbox.xmin();
         float new_ymin = (m_scaling_bbox.ymin() * bbox.height()) + bbox.ymin();
         float new_width = m_scaling_bbox.width() * bbox.width();
@@ -474,7 +618,7 @@ public:
      */
     void clear_scaling_bbox()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_scaling_bbox = HailoBBox(0.0, 0.0, 1.0, 1.0);
     }
 
@@ -485,7 +629,7 @@ public:
      */
     std::string get_stream_id()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_stream_id;
     }
 
@@ -496,7 +640,7 @@ public:
      */
     void set_stream_id(std::string stream_id)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_stream_id = std::move(stream_id);
     }
 };
@@ -579,7 +723,7 @@ class HailoDetection : public HailoROI
 {
 protected:
     float m_confidence;  // Confidence of the detection.
-    std::string m_label; // The label of detection, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
+    HailoLabel m_label;  // The label of detection, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
     int m_class_id;      // Class id, initialized to -1 if missing.
 public:
     /**
@@ -600,6 +744,16 @@ public:
      * @param confidence The confidence of the detection.
      */
     HailoDetection(HailoBBox bbox, int class_id, const std::string &label, float confidence) : HailoROI(bbox), m_confidence(assure_normal(confidence)), m_label(label), m_class_id(class_id){};
+    /**
+     * @brief Construct a new New Hailo Detection object from an already interned label,
+     *        skipping the label lookup (e.g. decoders that resolve their dataset once).
+     *
+     * @param bbox HailoBBox - a bounding box representing the region of interest in the frame.
+     * @param class_id The detection's class id, if theres any.
+     * @param label HailoLabel what the detection is.
+     * @param confidence The confidence of the detection.
+     */
+    HailoDetection(HailoBBox bbox, int class_id, HailoLabel label, float confidence) : HailoROI(bbox), m_confidence(assure_normal(confidence)), m_label(label), m_class_id(class_id){};
 
     // Move constructor
     HailoDetection(HailoDetection &&other) noexcept : HailoROI(other),
@@ -650,41 +804,40 @@ public:
 
     virtual hailo_object_t get_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return HAILO_DETECTION;
     }
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
-        return std::make_shared<HailoDetection>(*this);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
+        return hailo_make_shared<HailoDetection>(*this);
     }
 
     // Getters of DetectionObject.
 
     float get_confidence()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_confidence;
     }
     void set_confidence(float conf)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_confidence = conf;
     }
     std::string get_label()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
-        return m_label;
+        std::lock_guard<HailoObjectMutex> lock(mutex);
+        return m_label.str();
     }
     void set_label(std::string label)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_label = label;
     }
     int get_class_id()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_class_id;
     }
 };
@@ -699,7 +852,7 @@ class HailoClassification : public HailoObject
 protected:
     float m_confidence;                // Confidence of the classification.
     std::string m_classification_type; // Type of labeling, e.g. "age", "gender", "color", etc...
-    std::string m_label;               // The label of classification, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
+    HailoLabel m_label;                // The label of classification, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
     int m_class_id;                    // Class id, initialized to -1 if missing.
 public:
     /**
@@ -734,6 +887,18 @@ public:
                         int class_id,
                         std::string label,
                         float confidence) : m_confidence(assure_normal(confidence)), m_classification_type(classification_type), m_label(label), m_class_id(class_id){};
+    /**
+     * @brief Construct a new Hailo Classification object from an already interned label.
+     *
+     * @param classification_type The type of classification.
+     * @param class_id Class ID of the classification result.
+     * @param label classification result.
+     * @param confidence confidence of classification result.
+     */
+    HailoClassification(const std::string &classification_type,
+                        int class_id,
+                        HailoLabel label,
+                        float confidence) : m_confidence(assure_normal(confidence)), m_classification_type(classification_type), m_label(label), m_class_id(class_id){};
     // Move Constructor
     HailoClassification(HailoClassification &&other) : m_confidence(assure_normal(other.m_confidence)),
                                                        m_classification_type(std::move(other.m_classification_type)),
@@ -772,13 +937,12 @@ public:
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
-        return std::make_shared<HailoClassification>(*this);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
+        return hailo_make_shared<HailoClassification>(*this);
     }
 
     virtual hailo_object_t get_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return HAILO_CLASSIFICATION;
     }
 
@@ -786,22 +950,22 @@ public:
 
     float get_confidence()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_confidence;
     }
     std::string get_label()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
-        return m_label;
+        std::lock_guard<HailoObjectMutex> lock(mutex);
+        return m_label.str();
     }
     std::string get_classification_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_classification_type;
     }
     int get_class_id()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_class_id;
     }
 };
@@ -861,7 +1025,7 @@ public:
      */
     void add_point(HailoPoint point)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_points.emplace_back(point);
     };
 
@@ -872,22 +1036,22 @@ public:
      */
     void set_points(std::vector<HailoPoint> points)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_points.clear();
         m_points = std::move(points);
     };
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
-        return std::make_shared<HailoLandmarks>(*this);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
+        return hailo_make_shared<HailoLandmarks>(*this);
     }
 
     // Getters for HailoLandmarks object.
 
     std::vector<HailoPoint> get_points()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_points;
     }
     float get_threshold()
@@ -937,8 +1101,8 @@ public:
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
-        return std::make_shared<HailoUniqueID>(*this);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
+        return hailo_make_shared<HailoUniqueID>(*this);
     }
 
     virtual hailo_object_t get_type()
@@ -1127,38 +1291,37 @@ public:
 
     virtual hailo_object_t get_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return HAILO_USER_META;
     }
 
     float get_user_float()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_user_float;
     }
     std::string get_user_string()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_user_string;
     }
     int get_user_int()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         return m_user_int;
     }
     void set_user_float(float user_float)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_user_float = user_float;
     }
     void set_user_string(std::string user_string)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_user_string = user_string;
     }
     void set_user_int(int user_int)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoObjectMutex> lock(mutex);
         m_user_int = user_int;
     }
 };
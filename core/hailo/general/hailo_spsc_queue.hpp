@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *        Neither side ever blocks: push fails when the queue is full and pop fails when it is empty.
+ *        Slots are allocated once, so items that own memory (vectors, documents) keep it between uses.
+ */
+template <typename T>
+class HailoSPSCQueue
+{
+private:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    std::vector<T> m_slots;
+    // Written by the consumer, read by the producer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head{0};
+    // Written by the producer, read by the consumer
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail{0};
+
+    std::size_t next(std::size_t index) const
+    {
+        return (index + 1 == m_slots.size()) ? 0 : index + 1;
+    }
+
+public:
+    /**
+     * @param capacity Maximal number of queued items.
+     */
+    explicit HailoSPSCQueue(std::size_t capacity) : m_slots(capacity + 1){};
+
+    HailoSPSCQueue(const HailoSPSCQueue &) = delete;
+    HailoSPSCQueue &operator=(const HailoSPSCQueue &) = delete;
+
+    /**
+     * @brief Move an item into the queue. Producer thread only.
+     *
+     * @return false if the queue is full, the item is left untouched.
+     */
+    bool push(T &&item)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t next_tail = next(tail);
+        if (next_tail == m_head.load(std::memory_order_acquire))
+            return false;
+        std::swap(m_slots[tail], item);
+        m_tail.store(next_tail, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Move the oldest item out of the queue. Consumer thread only.
+     *        The item's previous content is swapped into the free slot and reused by a later push.
+     *
+     * @return false if the queue is empty.
+     */
+    bool pop(T &item)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        std::swap(item, m_slots[head]);
+        m_head.store(next(head), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const
+    {
+        return m_slots.size() - 1;
+    }
+};
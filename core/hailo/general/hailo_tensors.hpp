@@ -9,16 +9,104 @@
 
 #pragma once
 #include "hailo/hailo_gst_tensor_metadata.hpp"
+#include <array>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 class HailoTensor
 {
 private:
     uint8_t *m_data;                            // Pointer to the data of the tensor.
     hailo_tensor_metadata_t m_tensor_meta_info; // tensor metadata info.
     std::string m_name;                         // Name of output tensor.
+    std::array<float, 256> m_lut_uint8;         // Dequantized value of every uint8 code.
+    std::shared_ptr<std::vector<float>> m_lut_uint16; // Dequantized value of every uint16 code, built on first use.
+
+    void build_lut_uint8()
+    {
+        for (uint value = 0; value < m_lut_uint8.size(); value++)
+            m_lut_uint8[value] = fix_scale(value);
+    }
+
+    /**
+     * @brief Dequantize count values with SIMD arithmetic, same operations (and results) as fix_scale.
+     */
+    template <typename T>
+    void dequantize_range(const T *in, float *out, size_t count)
+    {
+        const float zp = m_tensor_meta_info.quant_info.qp_zp;
+        const float scale = m_tensor_meta_info.quant_info.qp_scale;
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128 v_zp = _mm_set1_ps(zp);
+        const __m128 v_scale = _mm_set1_ps(scale);
+        const __m128i v_zero = _mm_setzero_si128();
+        if constexpr (std::is_same<T, uint8_t>::value)
+        {
+            for (; i + 16 <= count; i += 16)
+            {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+                __m128i words[2] = {_mm_unpacklo_epi8(bytes, v_zero), _mm_unpackhi_epi8(bytes, v_zero)};
+                for (int half = 0; half < 2; half++)
+                {
+                    __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words[half], v_zero));
+                    __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words[half], v_zero));
+                    _mm_storeu_ps(out + i + half * 8, _mm_mul_ps(_mm_sub_ps(low, v_zp), v_scale));
+                    _mm_storeu_ps(out + i + half * 8 + 4, _mm_mul_ps(_mm_sub_ps(high, v_zp), v_scale));
+                }
+            }
+        }
+        else if constexpr (std::is_same<T, uint16_t>::value)
+        {
+            for (; i + 8 <= count; i += 8)
+            {
+                __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+                __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, v_zero));
+                __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, v_zero));
+                _mm_storeu_ps(out + i, _mm_mul_ps(_mm_sub_ps(low, v_zp), v_scale));
+                _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_sub_ps(high, v_zp), v_scale));
+            }
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        const float32x4_t v_zp = vdupq_n_f32(zp);
+        const float32x4_t v_scale = vdupq_n_f32(scale);
+        if constexpr (std::is_same<T, uint8_t>::value)
+        {
+            for (; i + 8 <= count; i += 8)
+            {
+                uint16x8_t words = vmovl_u8(vld1_u8(reinterpret_cast<const uint8_t *>(in + i)));
+                float32x4_t low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+                float32x4_t high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(words)));
+                vst1q_f32(out + i, vmulq_f32(vsubq_f32(low, v_zp), v_scale));
+                vst1q_f32(out + i + 4, vmulq_f32(vsubq_f32(high, v_zp), v_scale));
+            }
+        }
+        else if constexpr (std::is_same<T, uint16_t>::value)
+        {
+            for (; i + 8 <= count; i += 8)
+            {
+                uint16x8_t words = vld1q_u16(reinterpret_cast<const uint16_t *>(in + i));
+                float32x4_t low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+                float32x4_t high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(words)));
+                vst1q_f32(out + i, vmulq_f32(vsubq_f32(low, v_zp), v_scale));
+                vst1q_f32(out + i + 4, vmulq_f32(vsubq_f32(high, v_zp), v_scale));
+            }
+        }
+#endif
+        for (; i < count; i++)
+            out[i] = fix_scale(in[i]);
+    }
+
 public:
     /**
      * @brief Construct a new Hailo Tensor object
@@ -27,7 +115,10 @@ public:
      * @param tensor_meta_info - info about the output, represented as hailo_tensor_metadata_t.
      */
     HailoTensor(uint8_t *data, const hailo_tensor_metadata_t &tensor_meta_info) :
-        m_data(data), m_tensor_meta_info(tensor_meta_info), m_name(m_tensor_meta_info.name) {};
+        m_data(data), m_tensor_meta_info(tensor_meta_info), m_name(m_tensor_meta_info.name)
+    {
+        build_lut_uint8();
+    };
     // Destructor
     ~HailoTensor() = default;
     // Copy constructor
@@ -94,6 +185,78 @@ public:
         return T((float(num) / m_tensor_meta_info.quant_info.qp_scale)  + m_tensor_meta_info.quant_info.qp_zp);
     }
 
+    /**
+     * @brief Gets the dequantization table of this tensor, indexed by the quantized value.
+     *        256 entries for uint8 (built with the tensor), 65536 entries for uint16 (built on first use).
+     *
+     * @return const float* dequantized value of every code.
+     */
+    template <typename T>
+    const float *dequantization_lut()
+    {
+        static_assert(std::is_same<T, uint8_t>::value || std::is_same<T, uint16_t>::value,
+                      "dequantization tables exist only for uint8 and uint16 tensors");
+        if constexpr (std::is_same<T, uint8_t>::value)
+            return m_lut_uint8.data();
+
+        // Concurrent first calls may both build the table, each gets a complete one.
+        std::shared_ptr<std::vector<float>> lut = std::atomic_load(&m_lut_uint16);
+        if (!lut)
+        {
+            lut = std::make_shared<std::vector<float>>(std::numeric_limits<uint16_t>::max() + 1);
+            for (uint value = 0; value < lut->size(); value++)
+                (*lut)[value] = fix_scale(value);
+            std::atomic_store(&m_lut_uint16, lut);
+        }
+        return lut->data();
+    }
+
+    /**
+     * @brief Converts a threshold on dequantized values to the quantized domain,
+     *        so cells can be rejected without dequantizing them:
+     *        fix_scale(value) >= threshold  <=>  value >= quantized_threshold<T>(threshold).
+     *
+     * @param threshold threshold in the dequantized domain.
+     * @return uint32_t smallest passing quantized value, max(T) + 1 if no value passes.
+     */
+    template <typename T>
+    uint32_t quantized_threshold(float threshold)
+    {
+        const uint32_t end = static_cast<uint32_t>(std::numeric_limits<T>::max()) + 1;
+        float estimate = std::ceil(threshold / m_tensor_meta_info.quant_info.qp_scale + m_tensor_meta_info.quant_info.qp_zp);
+        uint32_t value = !(estimate > 0.0f) ? 0 : (estimate >= float(end)) ? end : static_cast<uint32_t>(estimate);
+        // Fix the float rounding of the estimate so it agrees with fix_scale exactly
+        while (value > 0 && fix_scale(value - 1) >= threshold)
+            value--;
+        while (value < end && fix_scale(value) < threshold)
+            value++;
+        return value;
+    }
+
+    /**
+     * @brief Dequantizes the whole tensor into a float buffer (SIMD where available).
+     *
+     * @param out buffer of at least size() floats.
+     */
+    template <typename T>
+    void dequantize_to(float *out)
+    {
+        dequantize_range(reinterpret_cast<const T *>(m_data), out, size());
+    }
+
+    /**
+     * @brief Dequantizes the whole tensor into a float buffer, by the tensor's format type.
+     *
+     * @param out buffer of at least size() floats.
+     */
+    void dequantize_to(float *out)
+    {
+        if (m_tensor_meta_info.format.type == HailoTensorFormatType::HAILO_FORMAT_TYPE_UINT16)
+            dequantize_to<uint16_t>(out);
+        else
+            dequantize_to<uint8_t>(out);
+    }
+
     /**
      * @brief Gets a specific cell of this tensor.
      *
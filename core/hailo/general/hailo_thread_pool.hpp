@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed size pool of worker threads.
+ *        Owned by the element (or component) that uses it, so work submitted by one element
+ *        never competes with global thread settings of other libraries (OpenCV etc.).
+ */
+class HailoThreadPool
+{
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop;
+
+    void worker_loop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]
+                          { return m_stop || !m_tasks.empty(); });
+                if (m_stop && m_tasks.empty())
+                    return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit HailoThreadPool(size_t num_threads) : m_stop(false)
+    {
+        num_threads = std::max<size_t>(num_threads, 1);
+        m_workers.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; i++)
+            m_workers.emplace_back(&HailoThreadPool::worker_loop, this);
+    }
+
+    ~HailoThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (std::thread &worker : m_workers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+    }
+
+    HailoThreadPool(const HailoThreadPool &) = delete;
+    HailoThreadPool &operator=(const HailoThreadPool &) = delete;
+
+    size_t size() const { return m_workers.size(); }
+
+    /**
+     * @brief Submit a task to the pool.
+     *
+     * @return std::future of the task's result.
+     */
+    template <typename F>
+    auto enqueue(F &&f) -> std::future<decltype(f())>
+    {
+        using result_t = decltype(f());
+        auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(f));
+        std::future<result_t> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace([task]()
+                            { (*task)(); });
+        }
+        m_cv.notify_one();
+        return result;
+    }
+
+    /**
+     * @brief Run func(index) for every index in [0, count), split across the workers and the calling thread.
+     *        Blocks until all the indices were processed. Indices are handed out dynamically,
+     *        so uneven work items (e.g. crops of different sizes) balance out.
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)> &func)
+    {
+        if (count == 0)
+            return;
+        if (count == 1)
+        {
+            func(0);
+            return;
+        }
+
+        auto next_index = std::make_shared<std::atomic<size_t>>(0);
+        auto run = [next_index, count, &func]()
+        {
+            for (size_t i = (*next_index)++; i < count; i = (*next_index)++)
+                func(i);
+        };
+
+        size_t helpers = std::min(m_workers.size(), count - 1);
+        std::vector<std::future<void>> futures;
+        futures.reserve(helpers);
+        for (size_t i = 0; i < helpers; i++)
+            futures.emplace_back(enqueue(run));
+        run();
+        for (std::future<void> &future : futures)
+            future.get();
+    }
+};
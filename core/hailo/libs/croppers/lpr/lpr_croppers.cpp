@@ -49,7 +49,7 @@ float quality_estimation(std::shared_ptr<HailoMat> hailo_mat, const HailoBBox &r
         return -1.0;
 
     // If it is not too small then we can make the crop
-    HailoROIPtr crop_roi = std::make_shared<HailoROI>(HailoBBox(cropped_xmin, cropped_ymin, cropped_width_n, cropped_height_n));
+    HailoROIPtr crop_roi = hailo_make_shared<HailoROI>(HailoBBox(cropped_xmin, cropped_ymin, cropped_width_n, cropped_height_n));
     std::vector<cv::Mat> cropped_image_vec = hailo_mat->crop(crop_roi);
 
     // Convert image to BGR
@@ -42,7 +42,7 @@ void add_attribute_prediction_to_roi(HailoROIPtr roi, std::vector<HailoUniqueIDP
         if (label != "No_Beard")
         {
             // Create the classification result
-            classification = std::make_shared<HailoClassification>(std::string("face_attributes"),
+            classification = hailo_make_shared<HailoClassification>(std::string("face_attributes"),
                                                                    index,
                                                                    label,
                                                                    confidence);
@@ -58,7 +58,7 @@ void add_attribute_prediction_to_roi(HailoROIPtr roi, std::vector<HailoUniqueIDP
         if (new_label != "")
         {
             // Create the classification result
-            classification = std::make_shared<HailoClassification>(std::string("face_attributes"),
+            classification = hailo_make_shared<HailoClassification>(std::string("face_attributes"),
                                                                    index,
                                                                    new_label,
                                                                    0.99f);
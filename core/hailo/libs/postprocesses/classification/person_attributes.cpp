@@ -61,14 +61,14 @@ void person_attributes_postprocess(HailoROIPtr roi, std::string output_layer_nam
         HailoClassificationPtr classification;
         if (label != "" && confidence > RESNET_V1_18_PERSON_THRESHOLD)
         {
-            classification = std::make_shared<HailoClassification>(std::string("person_attributes"),
+            classification = hailo_make_shared<HailoClassification>(std::string("person_attributes"),
                                                                    i,
                                                                    label,
                                                                    0.99f);
         }
         else if(label == "Male")
         {
-            classification = std::make_shared<HailoClassification>(std::string("person_attributes"),
+            classification = hailo_make_shared<HailoClassification>(std::string("person_attributes"),
                                                         i,
                                                         "Female",
                                                         0.99f);
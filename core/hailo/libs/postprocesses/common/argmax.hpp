@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace common
+{
+
+    /**
+     * @brief Index of the first maximal element of a contiguous array.
+     *
+     * @param data  -  const T *
+     *        The values to scan, e.g. the class channels of one anchor.
+     *
+     * @param count  -  std::size_t
+     *        Number of values, must be positive.
+     */
+    template <typename T>
+    inline std::size_t argmax(const T *data, std::size_t count)
+    {
+        return std::max_element(data, data + count) - data;
+    }
+
+    // Quantized class scores are scanned a lot (every anchor that passes objectness),
+    // the unsigned 8/16 bit versions find the maximal value with SIMD and then its first position.
+    template <>
+    inline std::size_t argmax<uint8_t>(const uint8_t *data, std::size_t count)
+    {
+        uint8_t max_value = 0;
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        if (count >= 16)
+        {
+            __m128i v_max = _mm_setzero_si128();
+            for (; i + 16 <= count; i += 16)
+                v_max = _mm_max_epu8(v_max, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+            v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 8));
+            v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 4));
+            v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 2));
+            v_max = _mm_max_epu8(v_max, _mm_srli_si128(v_max, 1));
+            max_value = static_cast<uint8_t>(_mm_cvtsi128_si32(v_max));
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        if (count >= 16)
+        {
+            uint8x16_t v_max = vdupq_n_u8(0);
+            for (; i + 16 <= count; i += 16)
+                v_max = vmaxq_u8(v_max, vld1q_u8(data + i));
+            max_value = vmaxvq_u8(v_max);
+        }
+#endif
+        for (; i < count; i++)
+            max_value = std::max(max_value, data[i]);
+        return static_cast<const uint8_t *>(std::memchr(data, max_value, count)) - data;
+    }
+
+    template <>
+    inline std::size_t argmax<uint16_t>(const uint16_t *data, std::size_t count)
+    {
+        uint16_t max_value = 0;
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        if (count >= 8)
+        {
+            // SSE2 only has a signed 16 bit max, flip the sign bit to keep the unsigned order
+            const __m128i v_sign = _mm_set1_epi16(static_cast<short>(0x8000));
+            __m128i v_max = _mm_set1_epi16(static_cast<short>(0x8000));
+            for (; i + 8 <= count; i += 8)
+                v_max = _mm_max_epi16(v_max, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), v_sign));
+            // Reduce with shuffles, shifting zeros in would compete as 0x8000
+            v_max = _mm_max_epi16(v_max, _mm_shuffle_epi32(v_max, _MM_SHUFFLE(1, 0, 3, 2)));
+            v_max = _mm_max_epi16(v_max, _mm_shuffle_epi32(v_max, _MM_SHUFFLE(2, 3, 0, 1)));
+            v_max = _mm_max_epi16(v_max, _mm_shufflelo_epi16(v_max, _MM_SHUFFLE(2, 3, 0, 1)));
+            max_value = static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_xor_si128(v_max, v_sign)));
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        if (count >= 8)
+        {
+            uint16x8_t v_max = vdupq_n_u16(0);
+            for (; i + 8 <= count; i += 8)
+                v_max = vmaxq_u16(v_max, vld1q_u16(data + i));
+            max_value = vmaxvq_u16(v_max);
+        }
+#endif
+        for (; i < count; i++)
+            max_value = std::max(max_value, data[i]);
+        return std::find(data, data + count, max_value) - data;
+    }
+
+}
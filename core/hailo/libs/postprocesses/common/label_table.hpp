@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "hailo_label.hpp"
+
+namespace common
+{
+
+    /**
+     * @brief Resolves the class ids of a dataset (see common/labels) to interned labels.
+     * The whole dataset is interned when the table is built, so build it once per dataset (a static, or in
+     * the init of the postprocess params) and not per frame. Lookups are const, the table can be shared by
+     * threads. Ids missing from the dataset get an empty label.
+     */
+    class LabelTable
+    {
+    private:
+        std::array<HailoLabel, 256> m_labels;
+
+    public:
+        LabelTable() = default;
+        explicit LabelTable(const std::map<uint8_t, std::string> &dataset)
+        {
+            for (const auto &entry : dataset)
+                m_labels[entry.first] = HailoLabel(entry.second);
+        }
+
+        HailoLabel operator[](uint8_t class_id) const
+        {
+            return m_labels[class_id];
+        }
+    };
+
+}
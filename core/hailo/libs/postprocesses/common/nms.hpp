@@ -4,12 +4,427 @@
  **/
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
 namespace common
 {
 
-    float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2)
+    /**
+     * @brief Flat (structure of arrays) buffer of candidate boxes.
+     *        Decoders push raw candidates here instead of building HailoDetection objects,
+     *        NMS runs on the plain arrays and only the surviving indices are materialized.
+     *        Coordinates are corners (xmin, ymin, xmax, ymax).
+     */
+    class DetectionBoxes
+    {
+    public:
+        std::vector<float> xmin;
+        std::vector<float> ymin;
+        std::vector<float> xmax;
+        std::vector<float> ymax;
+        std::vector<float> score;
+        std::vector<int> class_id;
+
+        void clear()
+        {
+            xmin.clear();
+            ymin.clear();
+            xmax.clear();
+            ymax.clear();
+            score.clear();
+            class_id.clear();
+        }
+
+        void reserve(std::size_t capacity)
+        {
+            xmin.reserve(capacity);
+            ymin.reserve(capacity);
+            xmax.reserve(capacity);
+            ymax.reserve(capacity);
+            score.reserve(capacity);
+            class_id.reserve(capacity);
+        }
+
+        void resize(std::size_t size)
+        {
+            xmin.resize(size);
+            ymin.resize(size);
+            xmax.resize(size);
+            ymax.resize(size);
+            score.resize(size);
+            class_id.resize(size);
+        }
+
+        std::size_t size() const { return score.size(); }
+        bool empty() const { return score.empty(); }
+
+        void push_back(float box_xmin, float box_ymin, float box_xmax, float box_ymax, float box_score, int box_class_id)
+        {
+            xmin.push_back(box_xmin);
+            ymin.push_back(box_ymin);
+            xmax.push_back(box_xmax);
+            ymax.push_back(box_ymax);
+            score.push_back(box_score);
+            class_id.push_back(box_class_id);
+        }
+
+        HailoBBox bbox(std::size_t index) const
+        {
+            return HailoBBox(xmin[index], ymin[index], xmax[index] - xmin[index], ymax[index] - ymin[index]);
+        }
+    };
+
+    /**
+     * @brief Drop, in place, every box whose score is not above threshold, starting at index begin.
+     *        The scores are compared four at a time so runs of boxes that all pass (or all fail) move as a block,
+     *        only mixed groups are compacted one by one. The order of the remaining boxes is kept.
+     */
+    inline void filter_boxes(DetectionBoxes &boxes, float threshold, std::size_t begin = 0)
+    {
+        const std::size_t count = boxes.size();
+        std::size_t out = begin;
+        auto keep = [&boxes, &out](std::size_t i)
+        {
+            if (out != i)
+            {
+                boxes.xmin[out] = boxes.xmin[i];
+                boxes.ymin[out] = boxes.ymin[i];
+                boxes.xmax[out] = boxes.xmax[i];
+                boxes.ymax[out] = boxes.ymax[i];
+                boxes.score[out] = boxes.score[i];
+                boxes.class_id[out] = boxes.class_id[i];
+            }
+            out++;
+        };
+
+        std::size_t i = begin;
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+        const float *score = boxes.score.data();
+#if defined(__SSE2__)
+        const __m128 v_threshold = _mm_set1_ps(threshold);
+#else
+        const float32x4_t v_threshold = vdupq_n_f32(threshold);
+#endif
+        for (; i + 4 <= count; i += 4)
+        {
+#if defined(__SSE2__)
+            int mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(score + i), v_threshold));
+            bool all = (mask == 0xF);
+            bool none = (mask == 0);
+#else
+            uint32x4_t mask = vcgtq_f32(vld1q_f32(score + i), v_threshold);
+            bool all = (vminvq_u32(mask) != 0);
+            bool none = (vmaxvq_u32(mask) == 0);
+#endif
+            if (none)
+                continue;
+            for (std::size_t j = i; j < i + 4; j++)
+            {
+                if (all || score[j] > threshold)
+                    keep(j);
+            }
+        }
+#endif
+        for (; i < count; i++)
+        {
+            if (boxes.score[i] > threshold)
+                keep(i);
+        }
+        boxes.resize(out);
+    }
+
+    enum class NmsMethod
+    {
+        NONE,          // Boxes were already suppressed (e.g. on-chip NMS), only apply the caps.
+        HARD,          // Classic NMS, drop every box that overlaps a kept box by more than iou_threshold.
+        SOFT_LINEAR,   // Soft-NMS, scale the score by (1 - iou) when iou is above iou_threshold.
+        SOFT_GAUSSIAN, // Soft-NMS, scale the score by exp(-iou^2 / sigma).
+    };
+
+    struct NmsParams
+    {
+        float iou_threshold = 0.5f;
+        bool cross_classes = false;
+        NmsMethod method = NmsMethod::HARD;
+        float sigma = 0.5f;            // Gaussian soft-NMS only
+        float score_threshold = 0.001f; // Soft-NMS only, boxes decayed below it are dropped
+        std::size_t max_boxes = 0;      // 0 means no cap
+        std::size_t max_boxes_per_class = 0;
+    };
+
+    /**
+     * @brief IOU of a single box against count boxes laid out in contiguous arrays.
+     *        Uses SSE2 on x86_64 and NEON on aarch64 (both are part of the base ISA), scalar otherwise.
+     */
+    inline void iou_row(float x1, float y1, float x2, float y2, float area,
+                        const float *xmin, const float *ymin, const float *xmax, const float *ymax, const float *areas,
+                        std::size_t count, float *out)
+    {
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        const __m128 v_x1 = _mm_set1_ps(x1);
+        const __m128 v_y1 = _mm_set1_ps(y1);
+        const __m128 v_x2 = _mm_set1_ps(x2);
+        const __m128 v_y2 = _mm_set1_ps(y2);
+        const __m128 v_area = _mm_set1_ps(area);
+        const __m128 v_zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 w = _mm_sub_ps(_mm_min_ps(v_x2, _mm_loadu_ps(xmax + i)), _mm_max_ps(v_x1, _mm_loadu_ps(xmin + i)));
+            __m128 h = _mm_sub_ps(_mm_min_ps(v_y2, _mm_loadu_ps(ymax + i)), _mm_max_ps(v_y1, _mm_loadu_ps(ymin + i)));
+            __m128 overlap = _mm_mul_ps(_mm_max_ps(w, v_zero), _mm_max_ps(h, v_zero));
+            __m128 union_area = _mm_sub_ps(_mm_add_ps(v_area, _mm_loadu_ps(areas + i)), overlap);
+            _mm_storeu_ps(out + i, _mm_div_ps(overlap, union_area));
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        const float32x4_t v_x1 = vdupq_n_f32(x1);
+        const float32x4_t v_y1 = vdupq_n_f32(y1);
+        const float32x4_t v_x2 = vdupq_n_f32(x2);
+        const float32x4_t v_y2 = vdupq_n_f32(y2);
+        const float32x4_t v_area = vdupq_n_f32(area);
+        const float32x4_t v_zero = vdupq_n_f32(0.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t w = vsubq_f32(vminq_f32(v_x2, vld1q_f32(xmax + i)), vmaxq_f32(v_x1, vld1q_f32(xmin + i)));
+            float32x4_t h = vsubq_f32(vminq_f32(v_y2, vld1q_f32(ymax + i)), vmaxq_f32(v_y1, vld1q_f32(ymin + i)));
+            float32x4_t overlap = vmulq_f32(vmaxq_f32(w, v_zero), vmaxq_f32(h, v_zero));
+            float32x4_t union_area = vsubq_f32(vaddq_f32(v_area, vld1q_f32(areas + i)), overlap);
+            vst1q_f32(out + i, vdivq_f32(overlap, union_area));
+        }
+#endif
+        for (; i < count; i++)
+        {
+            const float w = std::max(std::min(x2, xmax[i]) - std::max(x1, xmin[i]), 0.0f);
+            const float h = std::max(std::min(y2, ymax[i]) - std::max(y1, ymin[i]), 0.0f);
+            const float overlap = w * h;
+            out[i] = overlap / (area + areas[i] - overlap);
+        }
+    }
+
+    /**
+     * @brief NMS over a DetectionBoxes buffer.
+     *        All the scratch memory is owned by the engine and reused between calls,
+     *        so once warmed up a frame does not allocate. Use nms_engine() to get the calling thread's instance.
+     */
+    class NmsEngine
+    {
+    private:
+        std::vector<uint32_t> m_order;
+        std::vector<uint32_t> m_keep;
+        // Per class bucket, gathered in score order so the IOU kernel reads contiguous memory
+        std::vector<float> m_xmin;
+        std::vector<float> m_ymin;
+        std::vector<float> m_xmax;
+        std::vector<float> m_ymax;
+        std::vector<float> m_area;
+        std::vector<float> m_score;
+        std::vector<float> m_iou;
+        std::vector<uint8_t> m_alive;
+
+        void gather(const DetectionBoxes &boxes, std::size_t begin, std::size_t end)
+        {
+            std::size_t count = end - begin;
+            m_xmin.resize(count);
+            m_ymin.resize(count);
+            m_xmax.resize(count);
+            m_ymax.resize(count);
+            m_area.resize(count);
+            m_score.resize(count);
+            m_iou.resize(count);
+            m_alive.assign(count, 1);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                uint32_t index = m_order[begin + i];
+                m_xmin[i] = boxes.xmin[index];
+                m_ymin[i] = boxes.ymin[index];
+                m_xmax[i] = boxes.xmax[index];
+                m_ymax[i] = boxes.ymax[index];
+                m_area[i] = (m_xmax[i] - m_xmin[i]) * (m_ymax[i] - m_ymin[i]);
+                m_score[i] = boxes.score[index];
+            }
+        }
+
+        void hard_nms(std::size_t begin, std::size_t end, const NmsParams &params)
+        {
+            std::size_t count = end - begin;
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (!m_alive[i])
+                    continue;
+                m_keep.push_back(m_order[begin + i]);
+                if (params.max_boxes_per_class && ++kept >= params.max_boxes_per_class)
+                    break;
+                std::size_t rest = count - i - 1;
+                iou_row(m_xmin[i], m_ymin[i], m_xmax[i], m_ymax[i], m_area[i],
+                        &m_xmin[i + 1], &m_ymin[i + 1], &m_xmax[i + 1], &m_ymax[i + 1], &m_area[i + 1],
+                        rest, m_iou.data());
+                // The boxes are in score order, so an overlapping box always loses to the current one
+                for (std::size_t j = 0; j < rest; j++)
+                {
+                    if (m_iou[j] >= params.iou_threshold)
+                        m_alive[i + 1 + j] = 0;
+                }
+            }
+        }
+
+        void soft_nms(DetectionBoxes &boxes, std::size_t begin, std::size_t end, const NmsParams &params)
+        {
+            std::size_t count = end - begin;
+            std::size_t kept = 0;
+            while (!params.max_boxes_per_class || kept < params.max_boxes_per_class)
+            {
+                // Decayed scores change the order, pick the best remaining box each round
+                std::size_t best = count;
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    if (m_alive[i] && (best == count || m_score[i] > m_score[best]))
+                        best = i;
+                }
+                if (best == count)
+                    break;
+
+                m_alive[best] = 0;
+                uint32_t index = m_order[begin + best];
+                boxes.score[index] = m_score[best];
+                m_keep.push_back(index);
+                kept++;
+
+                iou_row(m_xmin[best], m_ymin[best], m_xmax[best], m_ymax[best], m_area[best],
+                        m_xmin.data(), m_ymin.data(), m_xmax.data(), m_ymax.data(), m_area.data(),
+                        count, m_iou.data());
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    if (!m_alive[i])
+                        continue;
+                    float weight = 1.0f;
+                    if (params.method == NmsMethod::SOFT_GAUSSIAN)
+                        weight = std::exp(-(m_iou[i] * m_iou[i]) / params.sigma);
+                    else if (m_iou[i] >= params.iou_threshold)
+                        weight = 1.0f - m_iou[i];
+                    m_score[i] *= weight;
+                    if (m_score[i] < params.score_threshold)
+                        m_alive[i] = 0;
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Run NMS on the given boxes.
+         *        Boxes with a non positive score are ignored. Soft-NMS writes the decayed scores back into boxes.score.
+         *
+         * @return const std::vector<uint32_t>&
+         *         Indices (into boxes) of the surviving boxes, highest score first.
+         *         Valid until the next call on this engine.
+         */
+        const std::vector<uint32_t> &run(DetectionBoxes &boxes, const NmsParams &params)
+        {
+            m_order.clear();
+            m_keep.clear();
+            for (uint32_t i = 0; i < boxes.size(); i++)
+            {
+                if (boxes.score[i] > 0.0f)
+                    m_order.push_back(i);
+            }
+
+            const float *score = boxes.score.data();
+            const int *class_id = boxes.class_id.data();
+            bool per_class = !params.cross_classes;
+            // Sort indices only, bucketing by class on the way so every class is one contiguous run
+            std::sort(m_order.begin(), m_order.end(),
+                      [score, class_id, per_class](uint32_t a, uint32_t b)
+                      {
+                          if (per_class && class_id[a] != class_id[b])
+                              return class_id[a] < class_id[b];
+                          return score[a] > score[b];
+                      });
+
+            for (std::size_t begin = 0; begin < m_order.size();)
+            {
+                std::size_t end = begin + 1;
+                if (per_class)
+                {
+                    while (end < m_order.size() && class_id[m_order[end]] == class_id[m_order[begin]])
+                        end++;
+                }
+                else
+                {
+                    end = m_order.size();
+                }
+
+                if (params.method == NmsMethod::NONE)
+                {
+                    std::size_t count = end - begin;
+                    if (params.max_boxes_per_class)
+                        count = std::min(count, params.max_boxes_per_class);
+                    m_keep.insert(m_keep.end(), m_order.begin() + begin, m_order.begin() + begin + count);
+                }
+                else
+                {
+                    gather(boxes, begin, end);
+                    if (params.method == NmsMethod::HARD)
+                        hard_nms(begin, end, params);
+                    else
+                        soft_nms(boxes, begin, end, params);
+                }
+                begin = end;
+            }
+
+            std::stable_sort(m_keep.begin(), m_keep.end(),
+                             [score](uint32_t a, uint32_t b)
+                             { return score[a] > score[b]; });
+            if (params.max_boxes && m_keep.size() > params.max_boxes)
+                m_keep.resize(params.max_boxes);
+
+            return m_keep;
+        }
+    };
+
+    /**
+     * @brief The calling thread's NMS engine. Postprocesses run on the streaming thread of their element,
+     *        so every element keeps warm scratch buffers without sharing them.
+     */
+    inline NmsEngine &nms_engine()
+    {
+        static thread_local NmsEngine engine;
+        return engine;
+    }
+
+    /**
+     * @brief Scratch DetectionBoxes of the calling thread, for decoders that don't keep their own buffer.
+     *        Cleared on every call.
+     */
+    inline DetectionBoxes &nms_boxes()
+    {
+        static thread_local DetectionBoxes boxes;
+        boxes.clear();
+        return boxes;
+    }
+
+    /**
+     * @brief Perform NMS on a DetectionBoxes buffer with the calling thread's engine.
+     *
+     * @return const std::vector<uint32_t>&
+     *         Indices of the surviving boxes, highest score first.
+     */
+    inline const std::vector<uint32_t> &nms(DetectionBoxes &boxes, const NmsParams &params)
+    {
+        return nms_engine().run(boxes, params);
+    }
+
+    inline float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2)
     {
         // Calculate IOU between two detection boxes
         const float width_of_overlap_area = std::min(box_1.xmax(), box_2.xmax()) - std::max(box_1.xmin(), box_2.xmin());
@@ -26,6 +441,8 @@ namespace common
 
     /**
      * @brief Perform IOU based NMS on a vector of HailoDetection objects
+     *        Kept for postprocesses that build their detections up front (landmarks, keypoints etc.),
+     *        the boxes are flattened and go through the same engine.
      *
      * @param objects  -  std::vector<HailoDetection>
      *        The detections to perform NMS on.
@@ -36,47 +453,26 @@ namespace common
      * @param should_nms_cross_classes  -  bool
      *        If true, then apply NMS regardless of class differences. Default false.
      */
-    void nms(std::vector<HailoDetection> &objects, const float iou_thr, bool should_nms_cross_classes = false)
+    inline void nms(std::vector<HailoDetection> &objects, const float iou_thr, bool should_nms_cross_classes = false)
     {
-        std::vector<HailoDetection> objects_after_nms;
-        // The network may propose multiple detections of similar size/score,
-        // which are actually the same detection. We want to filter out the lesser
-        // detections with a simple nms.
-        std::sort(objects.begin(), objects.end(),
-                  [](HailoDetection a, HailoDetection b)
-                  { return a.get_confidence() > b.get_confidence(); });
-
-        for (uint index = 0; index < objects.size(); index++)
-        {
-            if (objects[index].get_confidence() != 0.0f)
-            {
-                for (uint jindex = index + 1; jindex < objects.size(); jindex++)
-                {
-                    if ((should_nms_cross_classes || (objects[index].get_class_id() == objects[jindex].get_class_id())) &&
-                        objects[jindex].get_confidence() != 0.0f)
-                    {
-                        // For each detection, calculate the IOU against each following detection.
-                        float iou = iou_calc(objects[index].get_bbox(), objects[jindex].get_bbox());
-                        // If the IOU is above threshold, then we have two similar detections,
-                        // and want to delete the one.
-                        if (iou >= iou_thr)
-                        {
-                            // The detections are arranged in highest score order,
-                            // so we want to erase the latter detection.
-                            objects[jindex].set_confidence(0.0f);
-                        }
-                    }
-                }
-            }
-        }
-        for (uint index = 0; index < objects.size(); index++)
+        DetectionBoxes &boxes = nms_boxes();
+        boxes.reserve(objects.size());
+        for (HailoDetection &object : objects)
         {
-            if (objects[index].get_confidence() != 0.0f)
-            {
-                objects_after_nms.push_back(objects[index]);
-            }
+            HailoBBox bbox = object.get_bbox();
+            boxes.push_back(bbox.xmin(), bbox.ymin(), bbox.xmax(), bbox.ymax(), object.get_confidence(), object.get_class_id());
         }
-        objects = objects_after_nms;
+
+        NmsParams params;
+        params.iou_threshold = iou_thr;
+        params.cross_classes = should_nms_cross_classes;
+        const std::vector<uint32_t> &keep = nms(boxes, params);
+
+        std::vector<HailoDetection> objects_after_nms;
+        objects_after_nms.reserve(keep.size());
+        for (uint32_t index : keep)
+            objects_after_nms.emplace_back(std::move(objects[index]));
+        objects = std::move(objects_after_nms);
     }
 
-}
\ No newline at end of file
+}
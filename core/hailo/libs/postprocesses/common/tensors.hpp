@@ -36,12 +36,21 @@ namespace common
         return xtensor;
     }
 
+    template <typename T>
+    auto get_xtensor_view(HailoTensorPtr &tensor)
+    {
+        // Non owning view of a HailoTensorPtr (quantized), the data is not copied.
+        // Valid as long as the tensor's buffer is.
+        return xt::adapt(reinterpret_cast<T *>(tensor->data()), tensor->size(), xt::no_ownership(), tensor->shape());
+    }
+
+    template <typename T = uint8_t>
     xt::xarray<float> get_xtensor_float(HailoTensorPtr &tensor)
     {
-        // Adapt a HailoTensorPtr to an xarray (quantized)
-        auto quant_info = tensor->quant_info();
-        xt::xarray<uint8_t> xtensor = get_xtensor(tensor);
-        return dequantize(xtensor, quant_info.qp_scale, quant_info.qp_zp);
+        // Adapt a HailoTensorPtr to an xarray (dequantized), in one vectorized pass over the tensor
+        xt::xarray<float> xtensor = xt::xarray<float>::from_shape(tensor->shape());
+        tensor->dequantize_to<T>(xtensor.data());
+        return xtensor;
     }
     /**
      * @brief Get the only the tensors (vector) from a map of string->tensor.
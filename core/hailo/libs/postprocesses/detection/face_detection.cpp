@@ -344,26 +344,29 @@ void encode_detections(std::vector<HailoDetection> &objects,
                        xt::xarray<float> &detection_boxes,
                        xt::xarray<float> &scores,
                        xt::xarray<float> &landmarks,
+                       const float iou_threshold,
                        network_type network)
 {
-    // Here we will package the processed detections into the HailoDetection meta
-    // The detection meta will hold the following items:
-    float confidence, w, h, xmin, ymin = 0.0f;
-    // There is only 1 class in this network (face) so there is no need for label.
-    std::string label = "face";
-    // Iterate over our results
+    // Perform nms on the raw boxes first, so only the surviving faces are packaged
+    // (with their landmarks) into the HailoDetection meta.
+    common::DetectionBoxes &boxes = common::nms_boxes();
+    boxes.reserve(scores.size());
     for (uint index = 0; index < scores.size(); ++index)
     {
-        confidence = scores(index);                                  // Get the score for this detection
-        xmin = detection_boxes(index, 0);                            // Box xmin, relative to image size
-        ymin = detection_boxes(index, 1);                            // Box ymin, relative to image size
-        w = (detection_boxes(index, 2) - detection_boxes(index, 0)); // Box width, relative to image size
-        h = (detection_boxes(index, 3) - detection_boxes(index, 1)); // Box height, relative to image size
+        boxes.push_back(detection_boxes(index, 0), detection_boxes(index, 1), // Box xmin, ymin relative to image size
+                        detection_boxes(index, 2), detection_boxes(index, 3), // Box xmax, ymax relative to image size
+                        scores(index), NULL_CLASS_ID);
+    }
+    common::NmsParams nms_params;
+    nms_params.iou_threshold = iou_threshold;
+    const std::vector<uint32_t> &keep = common::nms(boxes, nms_params);
 
-        // Once all parameters are calculated, push them into the meta
-        // Class = 1 since centerpose only detects people
-        HailoBBox bbox(xmin, ymin, w, h);
-        HailoDetection detected_face(bbox, label, confidence);
+    // There is only 1 class in this network (face) so there is no need for label.
+    std::string label = "face";
+    objects.reserve(keep.size());
+    for (uint32_t index : keep)
+    {
+        HailoDetection detected_face(boxes.bbox(index), label, boxes.score[index]);
 
         if (landmarks.dimension() > 0)
         {
@@ -410,8 +413,7 @@ std::vector<HailoDetection> face_detection_postprocess(std::vector<HailoTensorPt
     for (uint i = 0; i < tensors.size(); ++i)
     {
         // While we're here, adapt the tensor into an xarray of float (dequantized).
-        xt::xarray<uint8_t> xdata = common::get_xtensor(tensors[i]);
-        xt::xarray<float> xdata_rescaled = common::dequantize(xdata, tensors[i]->quant_info().qp_scale, tensors[i]->quant_info().qp_zp);
+        xt::xarray<float> xdata_rescaled = common::get_xtensor_float(tensors[i]);
         // output layers are paired: boxes:classes:landmarks, boxes:classes:landmarks, boxes:classes:landmarks, etc...
         if (i % outputs_per_branch == 0)
         {
@@ -496,16 +498,15 @@ std::vector<HailoDetection> face_detection_postprocess(std::vector<HailoTensorPt
     // // RESULTS ENCODING
     // //-------------------------------
 
-    // // Encode the individual boxes/keypoints and package them into the meta
+    // // Perform nms to throw out similar detections, then encode the remaining
+    // // boxes/keypoints and package them into the meta
     encode_detections(objects,
                       std::get<0>(boxes_and_landmarks),
                       std::get<1>(boxes_and_landmarks),
                       std::get<2>(boxes_and_landmarks),
+                      iou_threshold,
                       network);
 
-    // // Perform nms to throw out similar detections
-    common::nms(objects, iou_threshold);
-
     return objects;
 }
 
@@ -6,20 +6,25 @@
 #include <string>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <memory>
 #include "hailo_objects.hpp"
 #include "common/structures.hpp"
 #include "common/nms.hpp"
+#include "common/label_table.hpp"
 #include "common/labels/coco_ninety.hpp"
 #include "common/labels/coco_visdrone.hpp"
 
-static const int DEFAULT_MAX_BOXES = 100;
+static const int DEFAULT_MAX_BOXES = 0; // No cap
 static const float DEFAULT_THRESHOLD = 0.4;
 
 class HailoNMSDecode
 {
 private:
     HailoTensorPtr _nms_output_tensor;
-    std::map<uint8_t, std::string> labels_dict;
+    std::unique_ptr<const common::LabelTable> _owned_labels; // Only when built from a dataset map
+    const common::LabelTable *_labels;
     float _detection_thr;
     uint _max_boxes;
     bool _filter_by_score;
@@ -38,36 +43,136 @@ private:
         return dequant_bbox;
     }
 
-    void parse_bbox_to_detection_object(auto dequant_bbox, uint32_t class_index, std::vector<HailoDetection> &_objects)
+    /**
+     * @brief Deinterleave count boxes of one class into the flat arrays of boxes.
+     */
+    template <typename BBoxType>
+    void scan_class(const uint8_t *data, uint32_t count, int class_index, common::DetectionBoxes &boxes)
     {
-        float confidence = CLAMP(dequant_bbox.score, 0.0f, 1.0f);
-        // filter score by detection threshold if needed.
-        if (!_filter_by_score || dequant_bbox.score > _detection_thr)
+        const BBoxType *bbox_structs = reinterpret_cast<const BBoxType *>(data);
+        std::size_t first = boxes.size();
+        boxes.resize(first + count);
+        float *xmin = boxes.xmin.data() + first;
+        float *ymin = boxes.ymin.data() + first;
+        float *xmax = boxes.xmax.data() + first;
+        float *ymax = boxes.ymax.data() + first;
+        float *score = boxes.score.data() + first;
+        for (uint32_t i = 0; i < count; i++)
         {
-            float32_t w, h = 0.0f;
-            // parse width and height of the box
-            std::tie(w, h) = get_shape(&dequant_bbox);
-            // create new detection object and add it to the vector of detections
-            _objects.push_back(HailoDetection(HailoBBox(dequant_bbox.x_min, dequant_bbox.y_min, w, h), class_index, labels_dict[class_index], confidence));
+            xmin[i] = bbox_structs[i].x_min;
+            ymin[i] = bbox_structs[i].y_min;
+            xmax[i] = bbox_structs[i].x_max;
+            ymax[i] = bbox_structs[i].y_max;
+            score[i] = bbox_structs[i].score;
         }
-    }
-
-    std::pair<float, float> get_shape(auto *bbox_struct)
-    {
-        float32_t w = bbox_struct->x_max - bbox_struct->x_min;
-        float32_t h = bbox_struct->y_max - bbox_struct->y_min;
-        return std::pair<float, float>(w, h);
+        std::fill(boxes.class_id.begin() + first, boxes.class_id.end(), class_index);
     }
 
 public:
-    HailoNMSDecode(HailoTensorPtr tensor, std::map<uint8_t, std::string> &labels_dict, float detection_thr = DEFAULT_THRESHOLD, uint max_boxes = DEFAULT_MAX_BOXES, bool filter_by_score = false)
-        : _nms_output_tensor(tensor), labels_dict(labels_dict), _detection_thr(detection_thr), _max_boxes(max_boxes), _filter_by_score(filter_by_score), _nms_shape(tensor->nms_shape())
+    /**
+     * @param labels The labels of the dataset, built once and kept alive by the caller (see common::LabelTable).
+     */
+    HailoNMSDecode(HailoTensorPtr tensor, const common::LabelTable &labels, float detection_thr = DEFAULT_THRESHOLD, uint max_boxes = DEFAULT_MAX_BOXES, bool filter_by_score = false)
+        : _nms_output_tensor(tensor), _labels(&labels), _detection_thr(detection_thr), _max_boxes(max_boxes), _filter_by_score(filter_by_score), _nms_shape(tensor->nms_shape())
     {
         // making sure that the network's output is indeed an NMS type, by checking the order type value included in the metadata
         if (!tensor->format().is_nms)
             throw std::invalid_argument("Output tensor " + _nms_output_tensor->name() + " is not an NMS type");
     };
 
+    /**
+     * @brief Interns the whole dataset for this decoder only, prefer passing a LabelTable built once.
+     */
+    HailoNMSDecode(HailoTensorPtr tensor, const std::map<uint8_t, std::string> &labels_dict, float detection_thr = DEFAULT_THRESHOLD, uint max_boxes = DEFAULT_MAX_BOXES, bool filter_by_score = false)
+        : _nms_output_tensor(tensor), _owned_labels(std::make_unique<const common::LabelTable>(labels_dict)), _labels(_owned_labels.get()),
+          _detection_thr(detection_thr), _max_boxes(max_boxes), _filter_by_score(filter_by_score), _nms_shape(tensor->nms_shape())
+    {
+        if (!tensor->format().is_nms)
+            throw std::invalid_argument("Output tensor " + _nms_output_tensor->name() + " is not an NMS type");
+    };
+
+    /**
+     * @brief First decoding phase: scan the nms buffer into flat arrays, without creating any object.
+     *        Each class is copied as one block, then the score threshold (when filter_by_score is set)
+     *        and the confidence clamping run over the whole score array at once.
+     *        The boxes are in buffer order, class ids start at 1.
+     *
+     * @return common::DetectionBoxes&
+     *         The calling thread's scratch buffer (common::nms_boxes()), valid until the next decode on this thread.
+     */
+    template <typename T, typename BBoxType>
+    common::DetectionBoxes &decode_boxes()
+    {
+        common::DetectionBoxes &boxes = common::nms_boxes();
+        if (!_nms_output_tensor)
+            return boxes;
+
+        uint32_t max_bboxes_per_class = _nms_shape.max_bboxes_per_class;
+        uint32_t num_of_classes = _nms_shape.number_of_classes;
+        size_t buffer_offset = 0;
+        const uint8_t *buffer = _nms_output_tensor->data();
+        for (size_t class_id = 0; class_id < num_of_classes; class_id++)
+        {
+            float32_t bbox_count = 0;
+            memcpy(&bbox_count, buffer + buffer_offset, sizeof(bbox_count));
+            buffer_offset += sizeof(bbox_count);
+
+            if (bbox_count == 0) // No detections
+                continue;
+            if (bbox_count > max_bboxes_per_class)
+                throw std::runtime_error("Runtime error - Got more than the maximum bboxes per class in the nms buffer");
+
+            uint32_t count = static_cast<uint32_t>(bbox_count);
+            if (std::is_same<T, uint16_t>::value)
+            {
+                // output type (T) is uint16, the boxes are laid out as common::hailo_bbox_float32_t
+                scan_class<common::hailo_bbox_float32_t>(buffer + buffer_offset, count, class_id + 1, boxes);
+                buffer_offset += count * sizeof(common::hailo_bbox_float32_t);
+            }
+            else
+            {
+                scan_class<BBoxType>(buffer + buffer_offset, count, class_id + 1, boxes);
+                buffer_offset += count * sizeof(BBoxType);
+            }
+        }
+
+        // filter score by detection threshold if needed, on the raw score like before clamping
+        if (_filter_by_score)
+            common::filter_boxes(boxes, _detection_thr);
+        for (float &score : boxes.score)
+            score = CLAMP(score, 0.0f, 1.0f);
+        return boxes;
+    }
+
+    /**
+     * @brief Second decoding phase: pick the boxes of decode_boxes() that become detections.
+     *        The boxes were already suppressed by the device, so no NMS is performed. Without max_boxes
+     *        (0) every box is kept, otherwise only the max_boxes best scored ones.
+     *
+     * @return const std::vector<uint32_t>&
+     *         Indices into boxes, in buffer order. Valid until the next call on this thread.
+     */
+    const std::vector<uint32_t> &top_boxes(common::DetectionBoxes &boxes)
+    {
+        thread_local std::vector<uint32_t> keep;
+        keep.clear();
+        if (_max_boxes == 0 || boxes.size() <= _max_boxes)
+        {
+            keep.resize(boxes.size());
+            for (uint32_t i = 0; i < keep.size(); i++)
+                keep[i] = i;
+            return keep;
+        }
+
+        common::NmsParams nms_params;
+        nms_params.method = common::NmsMethod::NONE;
+        nms_params.max_boxes = _max_boxes;
+        const std::vector<uint32_t> &best = common::nms(boxes, nms_params);
+        keep.assign(best.begin(), best.end());
+        std::sort(keep.begin(), keep.end());
+        return keep;
+    }
+
     template <typename T, typename BBoxType>
     std::vector<HailoDetection> decode()
     {
@@ -103,42 +208,20 @@ public:
         ymin = 0.551805 xmin = 0.389635 ymax = 0.741805 xmax = 0.561974 score = 0.95
         */
 
-        if (!_nms_output_tensor)
-            return std::vector<HailoDetection>{};
-
         std::vector<HailoDetection> _objects;
-        _objects.reserve(_max_boxes);
-        uint32_t max_bboxes_per_class = _nms_shape.max_bboxes_per_class;
-        uint32_t num_of_classes = _nms_shape.number_of_classes;
-        size_t buffer_offset = 0;
-        uint8_t *buffer = _nms_output_tensor->data();
-        for (size_t class_id = 0; class_id < num_of_classes; class_id++)
-        {
-            float32_t bbox_count = 0;
-            memcpy(&bbox_count, buffer + buffer_offset, sizeof(bbox_count));
-            buffer_offset += sizeof(bbox_count);
+        if (!_nms_output_tensor)
+            return _objects;
 
-            if (bbox_count == 0) // No detections
-                continue;
-            if (bbox_count > max_bboxes_per_class)
-                throw std::runtime_error("Runtime error - Got more than the maximum bboxes per class in the nms buffer");
+        common::DetectionBoxes &boxes = decode_boxes<T, BBoxType>();
+        const std::vector<uint32_t> &keep = top_boxes(boxes);
 
-            for (size_t bbox_index = 0; bbox_index < static_cast<uint32_t>(bbox_count); bbox_index++)
-            {
-                if (std::is_same<T, uint16_t>::value)
-                {
-                    // output type (T) is uint16, so we need to do dequantization before parsing
-                    common::hailo_bbox_float32_t *bbox = (common::hailo_bbox_float32_t *)(&buffer[buffer_offset]);
-                    parse_bbox_to_detection_object(*bbox, class_id + 1, _objects);
-                    buffer_offset += sizeof(common::hailo_bbox_float32_t);
-                }
-                else
-                {
-                    BBoxType *bbox_struct = (BBoxType *)(&buffer[buffer_offset]);
-                    parse_bbox_to_detection_object(*bbox_struct, class_id + 1, _objects);
-                    buffer_offset += sizeof(BBoxType);
-                }
-            }
+        // Only the kept boxes become detection objects
+        _objects.reserve(keep.size());
+        const common::LabelTable &labels = *_labels;
+        for (uint32_t index : keep)
+        {
+            int class_index = boxes.class_id[index];
+            _objects.emplace_back(boxes.bbox(index), class_index, labels[class_index], boxes.score[index]);
         }
         return _objects;
     }
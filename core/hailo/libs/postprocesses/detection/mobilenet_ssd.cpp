@@ -12,36 +12,40 @@ static const std::string DEFAULT_SSD_MERGED_OUTPUT_LAYER = "ssd_mobilenet_v1_no_
 static const std::string DEFAULT_SSD_VISDRONE_OUTPUT_LAYER = "ssd_mobilenet_v1_visdrone/nms1";
 
 
-static void mobilenet_ssd_base(HailoROIPtr roi, const std::string output_layer, std::map<uint8_t, std::string> &labels_dict)
+static void mobilenet_ssd_base(HailoROIPtr roi, const std::string output_layer, const common::LabelTable &labels)
 {
     if (!roi->has_tensors())
     {
         return;
     }
 
-    auto post = HailoNMSDecode(roi->get_tensor(output_layer), labels_dict);
+    auto post = HailoNMSDecode(roi->get_tensor(output_layer), labels);
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
 
 void mobilenet_ssd(HailoROIPtr roi)
 {
-    mobilenet_ssd_base(roi, DEFAULT_SSD_OUTPUT_LAYER, common::coco_ninety_classes);
+    static const common::LabelTable labels(common::coco_ninety_classes);
+    mobilenet_ssd_base(roi, DEFAULT_SSD_OUTPUT_LAYER, labels);
 }
 
 void mobilenet_ssd_h10(HailoROIPtr roi)
 {
-    mobilenet_ssd_base(roi, DEFAULT_SSD_H10_OUTPUT_LAYER, common::coco_ninety_classes);
+    static const common::LabelTable labels(common::coco_ninety_classes);
+    mobilenet_ssd_base(roi, DEFAULT_SSD_H10_OUTPUT_LAYER, labels);
 }
 
 void mobilenet_ssd_merged(HailoROIPtr roi)
 {
-    mobilenet_ssd_base(roi, DEFAULT_SSD_MERGED_OUTPUT_LAYER, common::coco_ninety_classes);
+    static const common::LabelTable labels(common::coco_ninety_classes);
+    mobilenet_ssd_base(roi, DEFAULT_SSD_MERGED_OUTPUT_LAYER, labels);
 }
 
 void mobilenet_ssd_visdrone(HailoROIPtr roi)
 {
-    mobilenet_ssd_base(roi, DEFAULT_SSD_VISDRONE_OUTPUT_LAYER, common::coco_visdrone_classes);
+    static const common::LabelTable labels(common::coco_visdrone_classes);
+    mobilenet_ssd_base(roi, DEFAULT_SSD_VISDRONE_OUTPUT_LAYER, labels);
 }
 
 void filter(HailoROIPtr roi)
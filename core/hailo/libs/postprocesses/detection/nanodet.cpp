@@ -16,6 +16,7 @@
 #include "hailo_objects.hpp"
 #include "common/tensors.hpp"
 #include "common/nms.hpp"
+#include "common/label_table.hpp"
 #include "common/labels/coco_eighty.hpp"
 #include "nanodet.hpp"
 
@@ -64,7 +65,7 @@ std::pair<std::vector<xt::xarray<float>>, xt::xarray<float>> get_boxes_and_score
     for (uint i=0; i < tensors.size(); i++)
     {
         // Extract and dequantize the layer
-        auto layer = common::dequantize(common::get_xtensor(tensors[i]), tensors[i]->quant_info().qp_scale, tensors[i]->quant_info().qp_zp);
+        auto layer = common::get_xtensor_float(tensors[i]);
         int num_proposals = layer.shape(0)*layer.shape(1);
 
         // From the layer extract the scores
@@ -81,7 +82,7 @@ std::pair<std::vector<xt::xarray<float>>, xt::xarray<float>> get_boxes_and_score
 }
 
 /**
- * @brief Decodes the box tensors into HailoDetections
+ * @brief Decodes the box tensors into a flat buffer of candidate boxes
  * 
  * @param raw_boxes  -  std::vector<xt::xarray<float>>
  *        The unprocessed box tensors
@@ -98,20 +99,19 @@ std::pair<std::vector<xt::xarray<float>>, xt::xarray<float>> get_boxes_and_score
  * @param regression_length  -  int
  *        Regression length of anchors
  * 
- * @return std::vector<HailoDetection> 
- *         The vector of detected objects before NMS
+ * @param boxes  -  common::DetectionBoxes
+ *        The candidate boxes before NMS, filled in place
  */
-std::vector<HailoDetection> decode_boxes(std::vector<xt::xarray<float>> raw_boxes,
-                                            xt::xarray<float> scores,
-                                            std::vector<int> network_dims,
-                                            std::vector<int> strides,
-                                            int regression_length)
+void decode_boxes(std::vector<xt::xarray<float>> raw_boxes,
+                  xt::xarray<float> scores,
+                  std::vector<int> network_dims,
+                  std::vector<int> strides,
+                  int regression_length,
+                  common::DetectionBoxes &boxes)
 {
     int strided_width, strided_height, class_index;
-    std::vector<HailoDetection> detections;
     int instance_index = 0;
     float confidence = 0.0;
-    std::string label;
     for (uint i=0; i < raw_boxes.size(); i++)
     {
         strided_width = network_dims[0] / strides[i];
@@ -144,22 +144,19 @@ std::vector<HailoDetection> decode_boxes(std::vector<xt::xarray<float>> raw_boxe
 
         for (uint j=0; j < decoded_boxes.shape(0); j++)
         {
-            HailoBBox bbox(decoded_boxes(j, 0) / network_dims[0],
-                           decoded_boxes(j, 1) / network_dims[1],
-                           (decoded_boxes(j, 2) - decoded_boxes(j, 0)) / network_dims[0],
-                           (decoded_boxes(j, 3) - decoded_boxes(j, 1)) / network_dims[1]);
             class_index = xt::argmax(xt::row(scores, instance_index))(0);
             confidence = scores(instance_index, class_index);
             instance_index++;
             if (confidence < SCORE_THRESHOLD)
                 continue;
 
-            label = common::coco_eighty[class_index + 1];
-            HailoDetection detected_instance(bbox, class_index, label, confidence);
-            detections.push_back(detected_instance);
+            boxes.push_back(decoded_boxes(j, 0) / network_dims[0],
+                            decoded_boxes(j, 1) / network_dims[1],
+                            decoded_boxes(j, 2) / network_dims[0],
+                            decoded_boxes(j, 3) / network_dims[1],
+                            confidence, class_index);
         }
     }
-    return detections;
 }
 
 /**
@@ -203,10 +200,23 @@ std::vector<HailoDetection> nanodet_postprocess(std::vector<HailoTensorPtr> &ten
     common::sigmoid(scores.data(), scores.size());
 
     // Decode the boxes
-    detections = decode_boxes(raw_boxes, scores, network_dims, strides, regression_length);
+    common::DetectionBoxes &boxes = common::nms_boxes();
+    decode_boxes(raw_boxes, scores, network_dims, strides, regression_length, boxes);
 
     // Filter with NMS
-    common::nms(detections, IOU_THRESHOLD, true);
+    common::NmsParams nms_params;
+    nms_params.iou_threshold = IOU_THRESHOLD;
+    nms_params.cross_classes = true;
+    const std::vector<uint32_t> &keep = common::nms(boxes, nms_params);
+
+    // Only the boxes that survived NMS become detection objects
+    detections.reserve(keep.size());
+    static const common::LabelTable labels(common::coco_eighty);
+    for (uint32_t index : keep)
+    {
+        int class_index = boxes.class_id[index];
+        detections.emplace_back(boxes.bbox(index), class_index, labels[class_index + 1], boxes.score[index]);
+    }
 
     return detections;
 }
@@ -95,6 +95,7 @@ YoloParamsNMS *init(const std::string config_path, const std::string function_na
         }
         fclose(fp);
     }
+    params->label_table = common::LabelTable(params->labels);
     return params;
 }
 void free_resources(void *params_void_ptr)
@@ -107,13 +108,32 @@ static std::map<uint8_t, std::string> yolo_vehicles_labels = {
     {0, "unlabeled"},
     {1, "car"}};
 
+// The label tables of the fixed datasets, interned on first use and shared by all the frames.
+static const common::LabelTable &coco_eighty_labels()
+{
+    static const common::LabelTable labels(common::coco_eighty);
+    return labels;
+}
+
+static const common::LabelTable &vehicles_labels()
+{
+    static const common::LabelTable labels(yolo_vehicles_labels);
+    return labels;
+}
+
+static const common::LabelTable &personface_labels()
+{
+    static const common::LabelTable labels(common::yolo_personface);
+    return labels;
+}
+
 void yolov5(HailoROIPtr roi)
 {
     if (!roi->has_tensors())
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5M_OUTPUT_LAYER), common::coco_eighty);
+    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5M_OUTPUT_LAYER), coco_eighty_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -124,7 +144,7 @@ void yolov5s_nv12(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5S_OUTPUT_LAYER), common::coco_eighty);
+    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5S_OUTPUT_LAYER), coco_eighty_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -135,7 +155,7 @@ void yolov8s(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV8S_OUTPUT_LAYER), common::coco_eighty);
+    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV8S_OUTPUT_LAYER), coco_eighty_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -146,7 +166,7 @@ void yolov8m(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV8M_OUTPUT_LAYER), common::coco_eighty);
+    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV8M_OUTPUT_LAYER), coco_eighty_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -157,7 +177,7 @@ void yolox(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor("yolox_nms_postprocess"), common::coco_eighty);
+    auto post = HailoNMSDecode(roi->get_tensor("yolox_nms_postprocess"), coco_eighty_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -168,7 +188,7 @@ void yolov5m_vehicles(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5M_VEHICLES_OUTPUT_LAYER), yolo_vehicles_labels);
+    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5M_VEHICLES_OUTPUT_LAYER), vehicles_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -179,7 +199,7 @@ void yolov5m_vehicles_nv12(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor("yolov5m_vehicles_nv12/yolov5_nms_postprocess"), yolo_vehicles_labels);
+    auto post = HailoNMSDecode(roi->get_tensor("yolov5m_vehicles_nv12/yolov5_nms_postprocess"), vehicles_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -190,7 +210,7 @@ void yolov5s_personface(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor("yolov5s_personface_nv12/yolov5_nms_postprocess"), common::yolo_personface);
+    auto post = HailoNMSDecode(roi->get_tensor("yolov5s_personface_nv12/yolov5_nms_postprocess"), personface_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     hailo_common::add_detections(roi, detections);
 }
@@ -201,7 +221,7 @@ void yolov5_no_persons(HailoROIPtr roi)
     {
         return;
     }
-    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5M_OUTPUT_LAYER), common::coco_eighty);
+    auto post = HailoNMSDecode(roi->get_tensor(DEFAULT_YOLOV5M_OUTPUT_LAYER), coco_eighty_labels());
     auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
     for (auto it = detections.begin(); it != detections.end();)
     {
@@ -229,7 +249,7 @@ void filter(HailoROIPtr roi, void *params_void_ptr)
     {
         if (std::regex_search(tensor->name(), std::regex("nms_postprocess"))) 
         {
-            auto post = HailoNMSDecode(tensor, params->labels, params->detection_threshold, params->max_boxes, params->filter_by_score);
+            auto post = HailoNMSDecode(tensor, params->label_table, params->detection_threshold, params->max_boxes, params->filter_by_score);
             auto detections = post.decode<float32_t, common::hailo_bbox_float32_t>();
             hailo_common::add_detections(roi, detections);
         }
@@ -5,6 +5,7 @@
 #pragma once
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
+#include "common/label_table.hpp"
 
 __BEGIN_DECLS
 
@@ -12,13 +13,14 @@ class YoloParamsNMS
 {
 public:
     std::map<std::uint8_t, std::string> labels;
+    common::LabelTable label_table; // labels interned once, built by init()
     float detection_threshold;
     uint max_boxes;
     bool filter_by_score=false;
     YoloParamsNMS(std::map<uint8_t, std::string> dataset = std::map<uint8_t, std::string>(),
                   float detection_threshold = 0.3f,
-                  uint max_boxes = 200)
-        : labels(dataset),
+                  uint max_boxes = 0) // 0 keeps every box
+        : labels(dataset), label_table(labels),
           detection_threshold(detection_threshold), 
           max_boxes(max_boxes) {}
 };
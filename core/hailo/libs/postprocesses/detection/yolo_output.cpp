@@ -2,10 +2,14 @@
  * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
  * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
  **/
+#include <array>
 #include <cmath>
+#include <limits>
 #include <vector>
 #include <algorithm>
+#include <type_traits>
 #include "yolo_output.hpp"
+#include "common/argmax.hpp"
 
 std::pair<uint, float> YoloOutputLayer::get_class(uint row, uint col, uint anchor)
 {
@@ -38,6 +42,118 @@ float YoloOutputLayer::sigmoid(float x)
     return 1.0f / (1.0f + expf(-x));
 }
 
+bool YoloOutputLayer::decode_rows(float threshold, uint image_width, uint image_height, common::DetectionBoxes &boxes)
+{
+    YoloBoxDecoding decoding;
+    if (!_tensor || !get_box_decoding(decoding))
+        return false;
+    if (_is_uint16)
+        decode_rows_typed<uint16_t>(decoding, threshold, image_width, image_height, boxes);
+    else
+        decode_rows_typed<uint8_t>(decoding, threshold, image_width, image_height, boxes);
+    return true;
+}
+
+template <typename T>
+void YoloOutputLayer::decode_rows_typed(const YoloBoxDecoding &decoding, float threshold, uint image_width, uint image_height, common::DetectionBoxes &boxes)
+{
+    constexpr bool use_lut = std::is_same<T, uint8_t>::value;
+    const T *data = reinterpret_cast<const T *>(_tensor->data());
+    const uint features = _tensor->features();
+    const uint anchor_channels = features / NUM_ANCHORS;
+    // Same order of operations as the per-cell accessors, so both paths give the same boxes
+    auto confidence_of = [this](T value)
+    {
+        float confidence = _tensor->fix_scale(value);
+        return _perform_sigmoid ? sigmoid(confidence) : confidence;
+    };
+    auto center_of = [this, &decoding](T value)
+    {
+        float center = _tensor->fix_scale(value);
+        if (decoding.center_sigmoid)
+            center = sigmoid(center);
+        return center * decoding.center_scale + decoding.center_offset;
+    };
+    auto shape_of = [this, &decoding](T value)
+    {
+        float shape = _tensor->fix_scale(value);
+        return decoding.shape_exp ? expf(shape) : (2.0f * shape) * (2.0f * shape);
+    };
+
+    // 8 bit tensors have only 256 codes, so every activation is a table lookup
+    std::array<float, 256> confidence_lut, center_lut, shape_lut;
+    if constexpr (use_lut)
+    {
+        for (uint value = 0; value < 256; value++)
+        {
+            confidence_lut[value] = confidence_of(value);
+            center_lut[value] = center_of(value);
+            shape_lut[value] = shape_of(value);
+        }
+    }
+    auto lookup = [](const std::array<float, 256> &lut, auto compute, T value)
+    {
+        if constexpr (use_lut)
+            return lut[value];
+        else
+            return compute(value);
+    };
+
+    // Smallest quantized objectness that passes threshold (the activations are monotonic),
+    // anything below it is skipped without being dequantized.
+    uint32_t low = 0;
+    uint32_t high = static_cast<uint32_t>(std::numeric_limits<T>::max()) + 1;
+    while (low < high)
+    {
+        uint32_t mid = (low + high) / 2;
+        if (confidence_of(static_cast<T>(mid)) < threshold)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    const uint32_t quantized_threshold = low;
+
+    // Class channels scanned by get_class: class ids [label_offset, _num_classes]
+    const uint class_channel = CLASS_CHANNEL_OFFSET + label_offset - 1;
+    const uint class_count = _num_classes - label_offset + 1;
+    for (uint row = 0; row < _height; ++row)
+    {
+        for (uint col = 0; col < _width; ++col)
+        {
+            const T *cell = data + (row * _width + col) * features;
+            for (uint anchor = 0; anchor < NUM_ANCHORS; ++anchor)
+            {
+                const T *prediction = cell + anchor * anchor_channels;
+                T objectness = prediction[CONF_CHANNEL_OFFSET];
+                if (objectness < quantized_threshold)
+                    continue;
+
+                std::size_t class_index = common::argmax(prediction + class_channel, class_count);
+                T class_prob = prediction[class_channel + class_index];
+                // Final confidence: box confidence * class probability
+                float confidence = lookup(confidence_lut, confidence_of, objectness) * lookup(confidence_lut, confidence_of, class_prob);
+                if (confidence <= threshold)
+                    continue;
+                // No class scored above zero, same fallback as get_class
+                uint class_id = (class_prob == 0) ? 1 : label_offset + class_index;
+
+                float x = lookup(center_lut, center_of, prediction[0]);
+                float y = lookup(center_lut, center_of, prediction[1]);
+                float w = lookup(shape_lut, shape_of, prediction[2]);
+                float h = lookup(shape_lut, shape_of, prediction[3]);
+                x = (x + col) / _width;
+                y = (y + row) / _height;
+                w = w * _anchors[anchor * 2] / image_width;
+                h = h * _anchors[anchor * 2 + 1] / image_height;
+                // Get the top left corner of the object.
+                float xmin = (x - (w / 2.0f));
+                float ymin = (y - (h / 2.0f));
+                boxes.push_back(xmin, ymin, xmin + w, ymin + h, confidence, class_id);
+            }
+        }
+    }
+}
+
 uint YoloOutputLayer::get_class_prob(uint row, uint col, uint anchor, uint class_id)
 {
     uint channel = _tensor->features() / NUM_ANCHORS * anchor + CLASS_CHANNEL_OFFSET + class_id - 1;
@@ -64,6 +180,12 @@ std::pair<float, float> Yolov5OL::get_center(uint row, uint col, uint anchor)
     return std::pair<float, float>(x, y);
 }
 
+bool Yolov5OL::get_box_decoding(YoloBoxDecoding &decoding)
+{
+    decoding = {false, 2.0f, -0.5f, false};
+    return true;
+}
+
 std::pair<float, float> Yolov5OL::get_shape(uint row, uint col, uint anchor, uint image_width, uint image_height)
 {
     float w, h = 0.0f;
@@ -90,6 +212,12 @@ std::pair<float, float> Yolov3OL::get_shape(uint row, uint col, uint anchor, uin
     return std::pair<float, float>(w, h);
 }
 
+bool Yolov3OL::get_box_decoding(YoloBoxDecoding &decoding)
+{
+    decoding = {true, 1.0f, 0.0f, true};
+    return true;
+}
+
 std::pair<float, float> Yolov3OL::get_center(uint row, uint col, uint anchor)
 {
     float x, y = 0.0f;
@@ -162,6 +290,12 @@ float TinyYolov4OL::get_class_conf(uint prob_max)
     return conf;
 }
 
+bool TinyYolov4OL::get_box_decoding(YoloBoxDecoding &decoding)
+{
+    decoding = {true, SCALE_XY, -0.5f * (SCALE_XY - 1), true};
+    return true;
+}
+
 std::pair<float, float> TinyYolov4OL::get_shape(uint row, uint col, uint anchor, uint image_width, uint image_height)
 {
     float w, h = 0.0f;
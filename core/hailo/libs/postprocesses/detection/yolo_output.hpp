@@ -4,8 +4,22 @@
  **/
 #pragma once
 #include "hailo_objects.hpp"
+#include "common/nms.hpp"
 #include <iostream>
 
+/**
+ * @brief How the raw box channels of a single tensor layer become a normalized box:
+ *        center = (act(v) * center_scale + center_offset + cell) / grid size,
+ *        shape = f(v) * anchor / image size.
+ */
+struct YoloBoxDecoding
+{
+    bool center_sigmoid; // act(v) is sigmoid(v) when true, v otherwise
+    float center_scale;
+    float center_offset;
+    bool shape_exp; // f(v) is exp(v) when true, (2 * v)^2 otherwise
+};
+
 /**
  * @brief Base class to represent OutputLayer of Yolo networks.
  *
@@ -80,12 +94,33 @@ public:
      * @return std::pair<float, float> pair of w,h of the shape of this prediction.
      */
     virtual std::pair<float, float> get_shape(uint row, uint col, uint anchor, uint image_width, uint image_height) = 0;
+    /**
+     * @brief Decode all the boxes that pass threshold straight from the raw NHWC rows of the tensor.
+     *        Objectness is compared in the quantized domain, so most anchors are rejected without
+     *        dequantizing anything. Only layers with a single output tensor support it.
+     *
+     * @param threshold Postprocess threshold.
+     * @param image_width Network's input image width.
+     * @param image_height Network's input image height.
+     * @param[out] boxes Flat buffer of candidate boxes.
+     * @return false if the layer doesn't support row decoding, boxes is left untouched.
+     */
+    bool decode_rows(float threshold, uint image_width, uint image_height, common::DetectionBoxes &boxes);
 
 protected:
     bool _perform_sigmoid;
     bool _is_uint16;
     HailoTensorPtr _tensor;
     float sigmoid(float x);
+    /**
+     * @brief Get the box decoding of a single tensor layer.
+     *
+     * @param[out] decoding
+     * @return false if the layer can't be decoded by decode_rows.
+     */
+    virtual bool get_box_decoding(YoloBoxDecoding &decoding) { return false; }
+    template <typename T>
+    void decode_rows_typed(const YoloBoxDecoding &decoding, float threshold, uint image_width, uint image_height, common::DetectionBoxes &boxes);
     /**
      * @brief Get the class channel object
      *
@@ -126,6 +161,9 @@ public:
     virtual std::pair<float, float> get_center(uint row, uint col, uint anchor);
     virtual float get_class_conf(uint prob_max);
     virtual std::pair<float, float> get_shape(uint row, uint col, uint anchor, uint image_width, uint image_height);
+
+protected:
+    virtual bool get_box_decoding(YoloBoxDecoding &decoding);
 };
 
 class TinyYolov4OL : public YoloOutputLayer
@@ -147,6 +185,9 @@ public:
     virtual std::pair<float, float> get_center(uint row, uint col, uint anchor);
     virtual float get_class_conf(uint prob_max);
     virtual std::pair<float, float> get_shape(uint row, uint col, uint anchor, uint image_width, uint image_height);
+
+protected:
+    virtual bool get_box_decoding(YoloBoxDecoding &decoding);
 };
 
 class Yolov4OL : public YoloOutputLayer
@@ -202,6 +243,9 @@ public:
     virtual float get_class_conf(uint prob_max);
     virtual std::pair<float, float> get_center(uint row, uint col, uint anchor);
     virtual std::pair<float, float> get_shape(uint row, uint col, uint anchor, uint image_width, uint image_height);
+
+protected:
+    virtual bool get_box_decoding(YoloBoxDecoding &decoding);
 };
 
 class YoloXOL : public YoloOutputLayer
@@ -10,6 +10,7 @@
 
 #include "yolo_postprocess.hpp"
 #include "common/nms.hpp"
+#include "common/label_table.hpp"
 #include "json_config.hpp"
 
 #include "rapidjson/document.h"
@@ -35,31 +36,37 @@ protected:
     float _iou_thr;
     uint m_image_width;
     uint m_image_height;
-    std::map<uint8_t, std::string> m_dataset;
+    const common::LabelTable &m_labels;
 
 public:
     virtual ~YoloPost() = default;
-    YoloPost(std::map<uint8_t, std::string> dataset,
+    YoloPost(const common::LabelTable &labels,
              float detection_threshold,
              float iou_threshold,
              uint max_boxes)
         : _max_boxes(max_boxes), _detection_thr(detection_threshold),
-          _iou_thr(iou_threshold), m_dataset(dataset){};
+          _iou_thr(iou_threshold), m_labels(labels){};
 
     std::vector<HailoDetection> decode()
     {
-        std::vector<HailoDetection> objects;
-        objects.reserve(_max_boxes);
+        common::DetectionBoxes &boxes = common::nms_boxes();
         for (auto layer : _layers)
         {
-            extract_boxes(layer, objects);
+            extract_boxes(layer, boxes);
         }
-        common::nms(objects, _iou_thr);
-        if (objects.size() > _max_boxes)
+
+        common::NmsParams nms_params;
+        nms_params.iou_threshold = _iou_thr;
+        nms_params.max_boxes = _max_boxes;
+        const std::vector<uint32_t> &keep = common::nms(boxes, nms_params);
+
+        // Only the boxes that survived NMS become detection objects
+        std::vector<HailoDetection> objects;
+        objects.reserve(keep.size());
+        for (uint32_t index : keep)
         {
-            HailoBBox bbox(0, 0, 1, 1);
-            HailoDetection empty_detection(bbox, "None", 0.0);
-            objects.resize(_max_boxes, empty_detection);
+            int class_id = boxes.class_id[index];
+            objects.emplace_back(boxes.bbox(index), class_id, m_labels[class_id], boxes.score[index]);
         }
 
         return objects;
@@ -75,15 +82,19 @@ public:
      *
      * @param[in] image_size Network's input image width/height.
      * @param[in] thr Postprocess threshold.
-     * @param[out] objects Reference to vector of detections.
+     * @param[out] boxes Flat buffer of candidate boxes.
      */
     void extract_boxes(std::shared_ptr<YoloOutputLayer> layer,
-                       std::vector<HailoDetection> &objects);
+                       common::DetectionBoxes &boxes);
 };
 
 void YoloPost::extract_boxes(std::shared_ptr<YoloOutputLayer> layer,
-                             std::vector<HailoDetection> &objects)
+                             common::DetectionBoxes &boxes)
 {
+    // Single tensor layers are decoded straight from the raw rows
+    if (layer->decode_rows(_detection_thr, m_image_width, m_image_height, boxes))
+        return;
+
     uint class_id = 0;
     float x, y, h, w, confidence, class_confidence = 0.0f;
     float xmin, ymin = 0.0f;
@@ -106,7 +117,7 @@ void YoloPost::extract_boxes(std::shared_ptr<YoloOutputLayer> layer,
                     // Get the top left corner of the object.
                     xmin = (x - (w / 2.0f));
                     ymin = (y - (h / 2.0f));
-                    objects.push_back(HailoDetection(HailoBBox(xmin, ymin, w, h), class_id, m_dataset[class_id], confidence));
+                    boxes.push_back(xmin, ymin, xmin + w, ymin + h, confidence, class_id);
                 }
             }
         }
@@ -117,7 +128,7 @@ class Yolov5 : public YoloPost
 {
 public:
     Yolov5(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
+        : YoloPost(params->label_table, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
     {
         if (_tensors.size() > 0)
         {
@@ -150,7 +161,7 @@ class Yolov3 : public YoloPost
 {
 public:
     Yolov3(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
+        : YoloPost(params->label_table, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
     {
         if (_tensors.size() > 0)
         {
@@ -181,7 +192,7 @@ class TinyYolov4LicensePlates : public YoloPost
 {
 public:
     TinyYolov4LicensePlates(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
+        : YoloPost(params->label_table, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
     {
         if (_tensors.size() > 0)
         {
@@ -213,7 +224,7 @@ class Yolov4 : public YoloPost
 {
 public:
     Yolov4(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _roi(roi)
+        : YoloPost(params->label_table, params->detection_threshold, params->iou_threshold, params->max_boxes), _roi(roi)
     {
         if (_roi->has_tensors())
         {
@@ -251,7 +262,7 @@ class YoloX : public YoloPost
 {
 public:
     YoloX(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _roi(roi)
+        : YoloPost(params->label_table, params->detection_threshold, params->iou_threshold, params->max_boxes), _roi(roi)
     {
         if (_roi->has_tensors())
         {
@@ -304,7 +315,7 @@ void yolov5_no_faces(HailoROIPtr roi, void *params_void_ptr)
     for (auto &det : detections)
     {
         if (det.get_label() == "person")
-            hailo_common::add_object(roi, std::make_shared<HailoDetection>(det));
+            hailo_common::add_object(roi, hailo_make_shared<HailoDetection>(det));
     }
 }
 
@@ -460,6 +471,7 @@ YoloParams *init(const std::string config_path, const std::string function_name)
             std::cerr << function_name << " network doesn't have default parameters, run might fail" << std::endl;
             params = new YoloParams;
         }
+        params->label_table = common::LabelTable(params->labels);
         return params;
     }
     else
@@ -567,6 +579,7 @@ YoloParams *init(const std::string config_path, const std::string function_name)
         }
         fclose(fp);
     }
+    params->label_table = common::LabelTable(params->labels);
     return params;
 }
 void YoloParams::check_params_logic(uint num_classes_tensors)
@@ -7,6 +7,7 @@
 #include "hailo_common.hpp"
 #include "yolo_output.hpp"
 #include "common/labels/coco_eighty.hpp"
+#include "common/label_table.hpp"
 
 __BEGIN_DECLS
 
@@ -16,6 +17,7 @@ public:
     float iou_threshold;
     float detection_threshold;
     std::map<std::uint8_t, std::string> labels;
+    common::LabelTable label_table; // labels interned once, built by init()
     uint num_classes;
     uint max_boxes;
     std::vector<std::vector<int>> anchors_vec;
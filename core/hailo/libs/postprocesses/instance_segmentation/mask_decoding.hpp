@@ -1,5 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "hailo_objects.hpp"
 #include "xtensor/xmath.hpp"
 #include "xtensor/xadapt.hpp"
 
@@ -19,64 +25,149 @@ auto xtensor_sigmoid(auto &tensor)
 inline float sigmoid(float x) { return 1.0f / (1.0f + std::exp(-1.0 * x)); }
 
 /**
- * @brief  Compute tensor dot product along specified axes for arrays.
-            In this case along axis 2 of the first matrix and axis 0 of the second.
+ * @brief The area of one instance in the proto layer and its mask coefficients.
+ *        The area is [xmin, xmax) x [ymin, ymax) in proto pixels.
+ */
+struct MaskCrop
+{
+    int xmin, ymin, xmax, ymax;
+    const float *coefficients;
+
+    int width() const { return xmax - xmin; }
+    int height() const { return ymax - ymin; }
+};
+
+/**
+ * @brief A binary instance mask at proto resolution, row-major, 255 inside the instance and 0 outside.
+ *        xmin and ymin place the mask in the proto layer.
+ */
+struct InstanceMask
+{
+    int xmin, ymin;
+    int width, height;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Compute the mask logits (coefficients x proto) of all the instances of a frame in one pass.
+ *        This is a single matrix product of the instance coefficients (K x C) and the proto layer (C x pixels),
+ *        restricted to the union of the instance crops. The proto is walked one row at a time: the row is
+ *        transposed once to planar channels, then every instance whose crop covers it accumulates its logits
+ *        over its own columns with plain multiply-add loops the compiler vectorizes. Every proto row is read
+ *        once no matter how many instances overlap it, and nothing is allocated once the scratch is warm.
  *
- * @param matrix_1 left matrix in the dot product
- * @param matrix_2 right matrix in the dot product
- * @return xt::xarray<float> the dot product result
+ * @param proto The proto layer, row-major (height, width, channels).
+ * @param crops The instances, each one with channels coefficients.
+ * @param on_row Called as on_row(instance_index, row_in_crop, logits, crop_width) for every row of every crop.
  */
-xt::xarray<float> dot_product_axis_2(xt::xarray<float, xt::layout_type::row_major> matrix_1,
-                                     xt::xarray<float, xt::layout_type::row_major> matrix_2)
+template <typename OnRow>
+void decode_mask_logits(const xt::xarray<float> &proto, const std::vector<MaskCrop> &crops, OnRow on_row)
 {
-    uint axis_length = matrix_1.shape(2);
-    if (axis_length != matrix_2.shape(0))
+    if (crops.empty())
+        return;
+
+    const int proto_width = proto.shape(1);
+    const int channels = proto.shape(2);
+    const float *proto_data = proto.data();
+
+    int union_ymin = proto.shape(0);
+    int union_ymax = 0;
+    for (const MaskCrop &crop : crops)
     {
-        throw std::invalid_argument("dot_product_axis_2 error: axis don't match!");
+        if (crop.width() <= 0 || crop.height() <= 0)
+            continue;
+        union_ymin = std::min(union_ymin, crop.ymin);
+        union_ymax = std::max(union_ymax, crop.ymax);
     }
-    float row_sum;
-    xt::xarray<float>::shape_type shape = {matrix_1.shape(0), matrix_1.shape(1)};
-    xt::xarray<float, xt::layout_type::row_major> product_matrix(shape);
-    for (uint i = 0; i < matrix_1.shape(0); ++i)
+
+    thread_local std::vector<float> planar;
+    thread_local std::vector<float> logits;
+    for (int y = union_ymin; y < union_ymax; y++)
     {
-        for (uint j = 0; j < matrix_1.shape(1); ++j)
+        // Columns needed by the crops that cover this row
+        int row_xmin = proto_width;
+        int row_xmax = 0;
+        for (const MaskCrop &crop : crops)
         {
-            row_sum = 0.0;
-            for (uint k = 0; k < axis_length; ++k)
+            if (y >= crop.ymin && y < crop.ymax && crop.width() > 0)
             {
-                row_sum += matrix_1(i, j, k) * matrix_2(k);
+                row_xmin = std::min(row_xmin, crop.xmin);
+                row_xmax = std::max(row_xmax, crop.xmax);
             }
-            product_matrix(i, j) = row_sum;
+        }
+        if (row_xmin >= row_xmax)
+            continue;
+
+        // Interleaved (pixel, channel) -> planar (channel, pixel), so the product runs over contiguous pixels
+        const int row_width = row_xmax - row_xmin;
+        planar.resize(static_cast<std::size_t>(channels) * row_width);
+        logits.resize(row_width);
+        const float *source = proto_data + (static_cast<std::size_t>(y) * proto_width + row_xmin) * channels;
+        for (int x = 0; x < row_width; x++)
+        {
+            for (int c = 0; c < channels; c++)
+                planar[static_cast<std::size_t>(c) * row_width + x] = source[x * channels + c];
+        }
+
+        for (std::size_t index = 0; index < crops.size(); index++)
+        {
+            const MaskCrop &crop = crops[index];
+            if (y < crop.ymin || y >= crop.ymax || crop.width() <= 0)
+                continue;
+
+            const int width = crop.width();
+            const float *plane = planar.data() + (crop.xmin - row_xmin);
+            float *acc = logits.data();
+            std::fill(acc, acc + width, 0.0f);
+            // Four channels per pass over the row, to load and store the accumulators less often
+            int c = 0;
+            for (; c + 4 <= channels; c += 4)
+            {
+                const float w0 = crop.coefficients[c];
+                const float w1 = crop.coefficients[c + 1];
+                const float w2 = crop.coefficients[c + 2];
+                const float w3 = crop.coefficients[c + 3];
+                const float *p0 = plane + static_cast<std::size_t>(c) * row_width;
+                const float *p1 = p0 + row_width;
+                const float *p2 = p1 + row_width;
+                const float *p3 = p2 + row_width;
+                for (int x = 0; x < width; x++)
+                    acc[x] += w0 * p0[x] + w1 * p1[x] + w2 * p2[x] + w3 * p3[x];
+            }
+            for (; c < channels; c++)
+            {
+                const float w = crop.coefficients[c];
+                const float *p = plane + static_cast<std::size_t>(c) * row_width;
+                for (int x = 0; x < width; x++)
+                    acc[x] += w * p[x];
+            }
+            on_row(index, y - crop.ymin, acc, width);
         }
     }
-    return product_matrix;
 }
 
-/*
- * @brief Decode the mask coefficients of yolov5seg results into a format that makes sense
- * and add it to the detected instance for future calculation of the final mask
+/**
+ * @brief Gather the proto crop and mask coefficients of every instance.
+ *        Instances without coefficients get an empty crop and a null coefficients pointer.
  *
  * @param objects vector of the detected instances
- * @param proto the 32 mask prototypes that the coefficients select portions of to form the mask
+ * @param proto the mask prototypes
+ * @param matrices receives the coefficients matrix of each instance (or null), they own the coefficients
+ * @return std::vector<MaskCrop> one crop per instance
  */
-void decode_masks(std::vector<HailoDetection> &objects, const xt::xarray<float> &proto)
+inline std::vector<MaskCrop> gather_mask_crops(std::vector<HailoDetection> &objects, const xt::xarray<float> &proto, std::vector<HailoMatrixPtr> &matrices)
 {
-    xt::xarray<float>::shape_type mask_shape = {proto.shape(0), proto.shape(1)};
-    int proto_width = proto.shape(0);
-    int proto_height = proto.shape(1);
-    int xmin, ymin, xmax, ymax;
+    int proto_height = proto.shape(0);
+    int proto_width = proto.shape(1);
+    std::size_t channels = proto.shape(2);
+
+    std::vector<MaskCrop> crops;
+    crops.reserve(objects.size());
+    matrices.clear();
+    matrices.reserve(objects.size());
     for (auto &instance : objects)
     {
-        // Gather the detection bounds for this instance,
-        // they are relative scale so multiply by proto size
-        HailoBBox bbox = instance.get_bbox();
-        xmin = CLAMP(bbox.xmin() * proto_width, 0, proto_width);
-        xmax = CLAMP(bbox.xmax() * proto_width, 0, proto_width);
-        ymin = CLAMP(bbox.ymin() * proto_height, 0, proto_height);
-        ymax = CLAMP(bbox.ymax() * proto_height, 0, proto_height);
-        // Crop a view of the proto layer of just this instance's detection area
-        auto cropped_proto = xt::view(proto, xt::range(ymin, ymax), xt::range(xmin, xmax));
-        HailoMatrixPtr matrix = NULL;
+        HailoMatrixPtr matrix = nullptr;
         for (auto obj : instance.get_objects())
         {
             if (obj->get_type() == HAILO_MATRIX)
@@ -84,25 +175,104 @@ void decode_masks(std::vector<HailoDetection> &objects, const xt::xarray<float>
                 matrix = std::dynamic_pointer_cast<HailoMatrix>(obj);
             }
         }
-        if (matrix == NULL) // no mask attached
+        matrices.push_back(matrix);
+        if (matrix == nullptr) // no mask attached
         {
-            return;
+            crops.push_back(MaskCrop{0, 0, 0, 0, nullptr});
+            continue;
         }
-        xt::xarray<int>::shape_type shape = {matrix->height()};
-        xt::xarray<float> mask_coefficients = xt::adapt(matrix->get_data().data(), matrix->height(), xt::no_ownership(), shape);
+        if (matrix->get_data().size() != channels)
+            throw std::invalid_argument("decode_masks error: mask coefficients don't match the proto channels!");
 
-        // Calculate a matrix multiplication of the instance's coefficients and the cropped proto layer and transpose it
-        xt::xarray<float, xt::layout_type::column_major> cropped_mask = xt::transpose(dot_product_axis_2(cropped_proto, mask_coefficients));
-        instance.remove_object(matrix); // not needed anymore
+        // Gather the detection bounds for this instance,
+        // they are relative scale so multiply by proto size
+        HailoBBox bbox = instance.get_bbox();
+        MaskCrop crop;
+        crop.xmin = CLAMP(bbox.xmin() * proto_width, 0, proto_width);
+        crop.xmax = CLAMP(bbox.xmax() * proto_width, 0, proto_width);
+        crop.ymin = CLAMP(bbox.ymin() * proto_height, 0, proto_height);
+        crop.ymax = CLAMP(bbox.ymax() * proto_height, 0, proto_height);
+        crop.coefficients = matrix->get_data().data();
+        crops.push_back(crop);
+    }
+    return crops;
+}
 
-        // Calculate the sigmoid of the mask
-        cropped_mask = xtensor_sigmoid(cropped_mask);
+/*
+ * @brief Decode the mask coefficients of yolov5seg results into a format that makes sense
+ * and add it to the detected instance for future calculation of the final mask
+ *
+ * @param objects vector of the detected instances
+ * @param proto the 32 mask prototypes that the coefficients select portions of to form the mask
+ * @param mask_threshold pixels whose confidence is not above it are set to 0 without computing their sigmoid,
+ *        0 keeps the confidence of every pixel
+ */
+void decode_masks(std::vector<HailoDetection> &objects, const xt::xarray<float> &proto, float mask_threshold = 0.0f)
+{
+    std::vector<HailoMatrixPtr> matrices;
+    std::vector<MaskCrop> crops = gather_mask_crops(objects, proto, matrices);
+
+    // sigmoid is monotonic, so the threshold is compared against the logits directly
+    float logit_threshold = -std::numeric_limits<float>::infinity();
+    if (mask_threshold >= 1.0f)
+        logit_threshold = std::numeric_limits<float>::infinity();
+    else if (mask_threshold > 0.0f)
+        logit_threshold = std::log(mask_threshold / (1.0f - mask_threshold));
+
+    std::vector<std::vector<float>> masks(objects.size());
+    for (std::size_t i = 0; i < crops.size(); i++)
+    {
+        if (matrices[i] != nullptr)
+            masks[i].resize(static_cast<std::size_t>(std::max(crops[i].width(), 0)) * std::max(crops[i].height(), 0));
+    }
+
+    decode_mask_logits(proto, crops, [&](std::size_t index, int row, const float *logits, int width)
+                       {
+        float *mask_row = masks[index].data() + static_cast<std::size_t>(row) * width;
+        for (int x = 0; x < width; x++)
+            mask_row[x] = (logits[x] > logit_threshold) ? sigmoid(logits[x]) : 0.0f; });
+
+    for (std::size_t i = 0; i < objects.size(); i++)
+    {
+        if (matrices[i] == nullptr)
+            continue;
+        objects[i].remove_object(matrices[i]); // not needed anymore
 
-        // allocate and memcpy to a new memory so it points to the right data
-        std::vector<float> data(cropped_mask.shape(0) * cropped_mask.shape(1));
-        memcpy(data.data(), cropped_mask.data(), sizeof(float) * cropped_mask.shape(0) * cropped_mask.shape(1));
-        
         // Add the mask to the object meta
-        instance.add_object(std::make_shared<HailoConfClassMask>(std::move(data), cropped_mask.shape(0), cropped_mask.shape(1), 0.3, instance.get_class_id()));
+        objects[i].add_object(std::make_shared<HailoConfClassMask>(std::move(masks[i]), crops[i].width(), crops[i].height(), 0.3, objects[i].get_class_id()));
+    }
+}
+
+/**
+ * @brief Decode the mask coefficients of yolov5seg results into binary masks at proto resolution,
+ *        for consumers that only need the instance area. No sigmoid is computed, the logits are
+ *        compared against the threshold's logit. The instances are left untouched.
+ *
+ * @param objects vector of the detected instances
+ * @param proto the mask prototypes
+ * @param mask_threshold confidence above which a pixel belongs to the instance
+ * @return std::vector<InstanceMask> one mask per instance, empty for instances without coefficients
+ */
+std::vector<InstanceMask> decode_binary_masks(std::vector<HailoDetection> &objects, const xt::xarray<float> &proto, float mask_threshold = 0.5f)
+{
+    std::vector<HailoMatrixPtr> matrices;
+    std::vector<MaskCrop> crops = gather_mask_crops(objects, proto, matrices);
+    const float logit_threshold = std::log(mask_threshold / (1.0f - mask_threshold));
+
+    std::vector<InstanceMask> masks(objects.size());
+    for (std::size_t i = 0; i < crops.size(); i++)
+    {
+        masks[i].xmin = crops[i].xmin;
+        masks[i].ymin = crops[i].ymin;
+        masks[i].width = std::max(crops[i].width(), 0);
+        masks[i].height = std::max(crops[i].height(), 0);
+        masks[i].data.resize(static_cast<std::size_t>(masks[i].width) * masks[i].height);
     }
+
+    decode_mask_logits(proto, crops, [&](std::size_t index, int row, const float *logits, int width)
+                       {
+        uint8_t *mask_row = masks[index].data.data() + static_cast<std::size_t>(row) * width;
+        for (int x = 0; x < width; x++)
+            mask_row[x] = (logits[x] > logit_threshold) ? 255 : 0; });
+    return masks;
 }
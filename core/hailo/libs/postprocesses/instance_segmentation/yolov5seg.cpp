@@ -4,7 +4,9 @@
 #include "hailo_common.hpp"
 #include "common/tensors.hpp"
 #include "common/nms.hpp"
+#include "common/label_table.hpp"
 #include "common/labels/coco_eighty.hpp"
+#include "common/argmax.hpp"
 #include "mask_decoding.hpp"
 
 #include "json_config.hpp"
@@ -14,8 +16,6 @@
 #include "rapidjson/filereadstream.h"
 #include "rapidjson/schema.h"
 
-#include <thread>
-#include <future>
 #include <iterator>
 #if __GNUC__ > 8
 #include <filesystem>
@@ -74,165 +74,127 @@ std::tuple<xt::xarray<float>, xt::xarray<float>> make_grid(xt::xarray<float> &an
 }
 
 /*
- * @brief Returns a vector of indices, of detections that have: is_object * max(class_confidence) > score_threshold
+ * @brief Refresh the cached quantized thresholds of a branch when its quantization changes
+ *        (in practice only on the first frame).
  *
- * @param all_scores an xview with the confidence scores for each class, for each detection
- * @param all_is_object an xview with the confidence that this detection is an object, for each detection
+ * @param state the cached state of the branch
+ * @param tensor the output tensor of the branch
  * @param score_threshold float
  */
-auto filter_above_threshold(auto &all_scores, auto &is_object_threshold, const float score_threshold, const uint16_t threshold_quantized, const float qp_zp, const float qp_scale)
+void update_branch_state(Yolov5segBranchState &state, HailoTensorPtr &tensor, const float score_threshold)
 {
-    std::vector<uint> indices;
-    std::vector<float> scores;
-    std::vector<uint> classes;
-    int this_index;
-    float conf_deq, is_object_deq;
-    uint16_t is_object;
-    for (uint i = 0; i < is_object_threshold.size(); i++)
-    {
-        // first check if the object parameter is bigger than threshold
-        is_object = is_object_threshold(i, 0);
-        if (is_object > threshold_quantized)
-        {
-            this_index = xt::argmax(xt::row(all_scores, i))(0) + 1;
-            // dequantize and decode
-            conf_deq = sigmoid(dequant(all_scores(i, this_index - 1), qp_zp, qp_scale));
-            is_object_deq = sigmoid(dequant(is_object, qp_zp, qp_scale));
-            if (conf_deq*is_object_deq > score_threshold)
-            {
-                indices.emplace_back(i);
-                scores.emplace_back(conf_deq * is_object_deq);
-                classes.emplace_back(this_index);
-        }
-    }
-    }
-    return std::tuple<std::vector<uint>, std::vector<float>, std::vector<uint>>(std::move(indices), std::move(scores), std::move(classes));
+    hailo_tensor_quant_info_t quant_info = tensor->quant_info();
+    if (state.initialized && state.qp_zp == quant_info.qp_zp && state.qp_scale == quant_info.qp_scale)
+        return;
+    state.qp_zp = quant_info.qp_zp;
+    state.qp_scale = quant_info.qp_scale;
+    // quantize the score threshold + "undecode" it (do inverse of sigmoid), to avoid doing dequantization and decoding on all class scores
+    state.objectness_threshold = quant(inverse_sigmoid(score_threshold), state.qp_zp, state.qp_scale);
+    state.initialized = true;
 }
 
 /*
- * @brief Gets the xviews of the decoded and filtered results, and adds them to a vector of HailoDetections
+ * @brief Does the decoding and the filtering for one output, straight from the quantized tensor.
+ *        The tensor is read through a non owning view, every row is rejected on its quantized objectness first,
+ *        and only the rows that pass the score threshold are dequantized and turned into HailoDetections.
  *
- * @param size int representing amount of detections
- * @param boxes xview of (x, y, w, h), x and y are the center of the box
- * @param is_object an xview with the confidence that this detection is an object, for each detection
- * @param scores an xview with the confidence scores for each class, for each detection
- * @param masks an xview with 32 coefficients representing a mask per detection
- * @param objects a vecor of HailoDetections, to which the detections will be added
+ * @param tensor the output tensor of the branch, (h, w, num_anchors * (BOX_CO + 1 + num_classes + MASK_CO))
+ * @param stride the stride of the branch
+ * @param grid the grid of the branch, (h, w, num_anchors, 2)
+ * @param anchor_grid the anchor grid of the branch, (h, w, num_anchors, 2)
+ * @param state the cached state of the branch, holds the quantized objectness threshold
  *  */
-std::vector<HailoDetection> create_hailo_detections(auto &scores_vec, auto &classes_vec, auto &xy, auto wh, auto &masks, const int input_width, const int input_height)
+std::vector<HailoDetection> yolov5_decoding(HailoTensorPtr &tensor, const int stride, const xt::xarray<float> &grid, const xt::xarray<float> &anchor_grid, const int num_anchors, const float score_threshold, const Yolov5segBranchState &state, const int input_width, const int input_height)
 {
-    int class_index;
-    float confidence, w, h, x, y = 0.0;
+    auto output = common::get_xtensor_view<uint16_t>(tensor);
+    const uint16_t *data = output.data();
+    const int row_size = tensor->features() / num_anchors;
+    const int num_classes = row_size - BOX_CO - 1 - MASK_CO;
+    const std::size_t num_rows = output.size() / row_size;
+    const float *grid_data = grid.data();
+    const float *anchor_grid_data = anchor_grid.data();
+    const float qp_zp = state.qp_zp;
+    const float qp_scale = state.qp_scale;
+
     std::vector<HailoDetection> objects;
-    for (uint i = 0; i < scores_vec.size(); i++)
+    static const common::LabelTable labels(common::coco_eighty);
+    for (std::size_t i = 0; i < num_rows; i++)
     {
-        // Get the box parameters for this box
-        x = (xy(i, 0)) / input_width;
-        y = (xy(i, 1)) / input_height;
-        w = (wh(i, 0)) / input_width;
-        h = (wh(i, 1)) / input_height;
-        // x and y represented center of box, so they need to be changed to left bottom corner
-        HailoBBox bbox(x - w / 2, y - h / 2, w, h);
-        class_index = classes_vec[i];
-        std::string label = common::coco_eighty[class_index];
-        confidence = scores_vec[i];
-        // create mask
-        xt::xarray<float> mask_coefficients = xt::squeeze(xt::view(masks, xt::keep(i), xt::all()));
-        HailoDetection detected_instance(bbox, class_index, label, confidence);
-        std::vector<float> data(mask_coefficients.shape(0));
-        memcpy(data.data(), mask_coefficients.data(), sizeof(float) * mask_coefficients.shape(0));
-        // create the detection itself
-        detected_instance.add_object((std::make_shared<HailoMatrix>(data, mask_coefficients.shape(0), 1)));
-        objects.push_back(detected_instance);
-    }
-    return objects;
-}
-
-/*
- * @brief Does the decoding and the filtering for the output, and adds the results to the HailoDetections vector
- *
- *  */
-std::vector<HailoDetection> yolov5_decoding(xt::xarray<uint16_t> &output, const int stride, xt::xarray<float> &anchors, xt::xarray<float> &grid, xt::xarray<float> &anchor_grid, const int num_anchors, const float score_threshold, float qp_zp, float qp_scale, const int input_width, const int input_height)
-{
-    int h = output.shape()[0];
-    int w = output.shape()[1];
-    int num_classes = (output.shape()[2] / 3) - BOX_CO - 1 - MASK_CO;
-
-    // prepare data for filter function
-    auto all_decoded = xt::reshape_view(output, {num_anchors * h * w, BOX_CO + 1 + num_classes + MASK_CO}); // {number of detections, 117}
-    auto all_is_object = xt::view(all_decoded, xt::all(), xt::range(4, 5));
-    auto all_scores = xt::view(all_decoded, xt::all(), xt::range(5, num_classes + 5));
-    // quantize the score threshold + "undecode" it (do inverse of sigmoid), to avoid doing dequantization and decoding on all class scores
-    uint16_t threshold_quantized = quant(inverse_sigmoid(score_threshold), qp_zp, qp_scale);
-    auto filtered = filter_above_threshold(all_scores, all_is_object, score_threshold, threshold_quantized, qp_zp, qp_scale);
-    std::vector<uint> indices = std::get<0>(filtered);
-    std::vector<float> scores_vec = std::get<1>(filtered);
-    std::vector<uint> classes_vec = std::get<2>(filtered);
-
-    // filter xy and grid
-    auto xy = xt::view(all_decoded, xt::all(), xt::range(_, 2));
-    auto reshaped_grid = xt::reshape_view(grid, xy.shape());
-    auto filtered_xy = xt::view(xy, xt::keep(indices), xt::all());
-    auto filtered_grid = xt::view(reshaped_grid, xt::keep(indices), xt::all());
-    // dequantize and decode xy
-    xt::xarray<float> deq_xy = (filtered_xy - qp_zp) * qp_scale;
-    deq_xy = (xtensor_sigmoid(deq_xy) * 2 + filtered_grid) * stride;
+        const uint16_t *row = data + i * row_size;
+        // first check if the object parameter is bigger than threshold
+        uint16_t is_object = row[BOX_CO];
+        if (is_object <= state.objectness_threshold)
+            continue;
 
-    // filter wh and anchor grid
-    auto wh = xt::view(all_decoded, xt::all(), xt::range(2, 4));
-    auto reshaped_anchor_grid = xt::reshape_view(anchor_grid, wh.shape());
-    auto filtered_wh = xt::view(wh, xt::keep(indices), xt::all());
-    auto filtered_anchor_grid = xt::view(reshaped_anchor_grid, xt::keep(indices), xt::all());
-    // dequantize and decode wh
-    xt::xarray<float> deq_wh = (filtered_wh - qp_zp) * qp_scale;
-    deq_wh = xt::square(xtensor_sigmoid(deq_wh) * 2) * filtered_anchor_grid;
+        int class_index = common::argmax(row + BOX_CO + 1, num_classes) + 1;
+        // dequantize and decode
+        float confidence = sigmoid(dequant(row[BOX_CO + class_index], qp_zp, qp_scale)) * sigmoid(dequant(is_object, qp_zp, qp_scale));
+        if (confidence <= score_threshold)
+            continue;
 
-    // filter and dequantize masks
-    auto filtered_masks = xt::view(all_decoded, xt::keep(indices), xt::range(num_classes + 5, _));
-    xt::xarray<float> masks = (filtered_masks - qp_zp) * qp_scale;
+        // dequantize and decode xy and wh, x and y are the center of the box
+        float x = (sigmoid(dequant(row[0], qp_zp, qp_scale)) * 2 + grid_data[i * 2]) * stride / input_width;
+        float y = (sigmoid(dequant(row[1], qp_zp, qp_scale)) * 2 + grid_data[i * 2 + 1]) * stride / input_height;
+        float w = sigmoid(dequant(row[2], qp_zp, qp_scale)) * 2;
+        float h = sigmoid(dequant(row[3], qp_zp, qp_scale)) * 2;
+        w = w * w * anchor_grid_data[i * 2] / input_width;
+        h = h * h * anchor_grid_data[i * 2 + 1] / input_height;
+        // x and y represented center of box, so they need to be changed to left bottom corner
+        HailoBBox bbox(x - w / 2, y - h / 2, w, h);
+        HailoDetection detected_instance(bbox, class_index, labels[class_index], confidence);
 
-    // create HailoDetections for the NMS and the mask decoding
-    std::vector<HailoDetection> objects = create_hailo_detections(scores_vec, classes_vec, deq_xy, deq_wh, masks, input_width, input_height);
+        // dequantize the mask coefficients, they are decoded into a mask after the nms
+        const uint16_t *mask_row = row + BOX_CO + 1 + num_classes;
+        std::vector<float> mask_coefficients(MASK_CO);
+        for (int k = 0; k < MASK_CO; k++)
+            mask_coefficients[k] = dequant(mask_row[k], qp_zp, qp_scale);
+        detected_instance.add_object(std::make_shared<HailoMatrix>(std::move(mask_coefficients), MASK_CO, 1));
+        objects.push_back(std::move(detected_instance));
+    }
     return objects;
 }
 
 /*
- * @brief Does dequantize and decoding for each output seperately
+ * @brief Does dequantize and decoding for each output in parallel, and then calls nms and decode masks
  *
  *  */
-std::vector<HailoDetection> post_per_branch(std::string branch_name, const int index, std::map<std::string, HailoTensorPtr> tensors, std::vector<xt::xarray<float>> anchor_list, std::vector<int> stride_list, const float iou_threshold, const float score_threshold, std::vector<xt::xarray<float>> grids, std::vector<xt::xarray<float>> anchor_grids, const int num_anchors, const int input_width, const int input_height)
+std::vector<HailoDetection> yolov5seg_post(const std::map<std::string, HailoTensorPtr> &tensors, Yolov5segParams *params)
 {
-    auto output = common::get_xtensor_uint16(tensors[branch_name]);
-    float qp_zp = tensors[branch_name]->quant_info().qp_zp;
-    float qp_scale = tensors[branch_name]->quant_info().qp_scale;
-    return yolov5_decoding(output, stride_list[index], anchor_list[index], grids[index], anchor_grids[index], num_anchors, score_threshold, qp_zp, qp_scale, input_width, input_height);
-}
-
-/*
- * @brief Does dequantize and decoding for each output, and then calls nms and decode masks
- *
- *  */
-std::vector<HailoDetection> yolov5seg_post(auto &tensors, auto &anchor_list, auto &stride_list, const float iou_threshold, const float score_threshold, auto &grids, auto &anchor_grids, const int num_anchors, const int input_width, const int input_height, auto &outputs_name)
-{
-    auto proto_tensor = common::dequantize(common::get_xtensor(tensors[outputs_name[0]]), tensors[outputs_name[0]]->quant_info().qp_scale, tensors[outputs_name[0]]->quant_info().qp_zp);
+    const std::size_t num_branches = params->strides.size();
+    // Branch i (stride strides[i]) is the output outputs_name[num_branches - i], outputs_name[0] is the proto layer
+    std::vector<HailoTensorPtr> branch_tensors(num_branches);
+    for (std::size_t index = 0; index < num_branches; index++)
+    {
+        branch_tensors[index] = tensors.at(params->outputs_name[num_branches - index]);
+        update_branch_state(params->branch_states[index], branch_tensors[index], params->score_threshold);
+    }
+    HailoTensorPtr proto_tensor = tensors.at(params->outputs_name[0]);
 
-    // run the postprocess for each branch seperately
-    std::future<std::vector<HailoDetection>> t2 = std::async(post_per_branch, outputs_name[1], 2, tensors, anchor_list, stride_list, iou_threshold, score_threshold, grids, anchor_grids, num_anchors, input_width, input_height);
-    std::future<std::vector<HailoDetection>> t1 = std::async(post_per_branch, outputs_name[2], 1, tensors, anchor_list, stride_list, iou_threshold, score_threshold, grids, anchor_grids, num_anchors, input_width, input_height);
-    std::future<std::vector<HailoDetection>> t0 = std::async(post_per_branch, outputs_name[3], 0, tensors, anchor_list, stride_list, iou_threshold, score_threshold, grids, anchor_grids, num_anchors, input_width, input_height);
-    std::vector<HailoDetection> d2 = t2.get();
-    std::vector<HailoDetection> d1 = t1.get();
-    std::vector<HailoDetection> d0 = t0.get();
+    // run the postprocess for each branch, and dequantize the proto layer, in parallel
+    std::vector<std::vector<HailoDetection>> branch_detections(num_branches);
+    params->thread_pool->parallel_for(num_branches + 1, [&](size_t index)
+                                      {
+        if (index == num_branches)
+        {
+            params->proto.resize(proto_tensor->shape());
+            proto_tensor->dequantize_to<uint8_t>(params->proto.data());
+            return;
+        }
+        branch_detections[index] = yolov5_decoding(branch_tensors[index], params->strides[index], params->grids[index], params->anchor_grids[index],
+                                                   params->num_anchors, params->score_threshold, params->branch_states[index],
+                                                   params->input_shape[0], params->input_shape[1]); });
 
     // concatenate all detections
+    std::size_t total = 0;
+    for (auto &detections : branch_detections)
+        total += detections.size();
     std::vector<HailoDetection> all_detections;
-    all_detections.reserve(d0.size() + d1.size() + d2.size());
-    all_detections.insert(all_detections.end(), d0.begin(), d0.end());
-    all_detections.insert(all_detections.end(), d1.begin(), d1.end());
-    all_detections.insert(all_detections.end(), d2.begin(), d2.end());
+    all_detections.reserve(total);
+    for (auto &detections : branch_detections)
+        all_detections.insert(all_detections.end(), std::make_move_iterator(detections.begin()), std::make_move_iterator(detections.end()));
 
-    common::nms(all_detections, iou_threshold);
-    decode_masks(all_detections, proto_tensor);
+    common::nms(all_detections, params->iou_threshold);
+    decode_masks(all_detections, params->proto, params->mask_threshold);
     return all_detections;
 }
 
@@ -256,6 +218,9 @@ Yolov5segParams *init(const std::string config_path, const std::string function_
             "score_threshold": {
             "type": "number"
             },
+            "mask_threshold": {
+            "type": "number"
+            },
             "outputs_size": {
             "type": "array",
             "items": {
@@ -313,6 +278,8 @@ Yolov5segParams *init(const std::string config_path, const std::string function_
 
             params->iou_threshold = doc_config_json["iou_threshold"].GetFloat();
             params->score_threshold = doc_config_json["score_threshold"].GetFloat();
+            if (doc_config_json.HasMember("mask_threshold"))
+                params->mask_threshold = doc_config_json["mask_threshold"].GetFloat();
 
             // parse anchors
             auto config_anchors = doc_config_json["anchors"].GetArray();
@@ -388,6 +355,8 @@ Yolov5segParams *init(const std::string config_path, const std::string function_
     params->grids = grids;
     params->anchor_grids = anchor_grids;
     params->num_anchors = num_anchors;
+    params->branch_states.resize(outputs_size.size());
+    params->thread_pool = std::make_unique<HailoThreadPool>(outputs_size.size());
     return params;
 }
 
@@ -406,7 +375,7 @@ void yolov5seg(HailoROIPtr roi, void *params_void_ptr)
 {
     Yolov5segParams *params = reinterpret_cast<Yolov5segParams *>(params_void_ptr);
     std::map<std::string, HailoTensorPtr> tensors = roi->get_tensors_by_name();
-    std::vector<HailoDetection> detections = yolov5seg_post(tensors, params->anchors, params->strides, params->iou_threshold, params->score_threshold, params->grids, params->anchor_grids, params->num_anchors, params->input_shape[0], params->input_shape[1], params->outputs_name);
+    std::vector<HailoDetection> detections = yolov5seg_post(tensors, params);
     hailo_common::add_detections(roi, detections);
 }
 
@@ -3,16 +3,32 @@
  * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
  **/
 #pragma once
+#include <memory>
 #include "hailo_objects.hpp"
+#include "hailo_thread_pool.hpp"
 #include "xtensor/xarray.hpp"
 #include "xtensor/xio.hpp"
 
 __BEGIN_DECLS
+/**
+ * @brief Decoding state of one output branch that depends on its quantization,
+ *        computed on the first frame and reused while the quantization doesn't change.
+ */
+class Yolov5segBranchState
+{
+public:
+    bool initialized = false;
+    float qp_zp = 0.0f;
+    float qp_scale = 0.0f;
+    uint16_t objectness_threshold = 0; // score_threshold, inverse sigmoid and quantized
+};
+
 class Yolov5segParams
 {
 public:
     float iou_threshold;
     float score_threshold;
+    float mask_threshold; // mask pixels not above it are zeroed without computing their sigmoid, 0 keeps them all
     int num_anchors;
     std::vector<int> outputs_size;
     std::vector<std::string> outputs_name;
@@ -21,10 +37,14 @@ public:
     std::vector<int> strides;
     std::vector<xt::xarray<float>> grids;
     std::vector<xt::xarray<float>> anchor_grids;
+    std::vector<Yolov5segBranchState> branch_states;
+    std::unique_ptr<HailoThreadPool> thread_pool; // decodes the branches in parallel
+    xt::xarray<float> proto;                      // dequantized proto layer, reused between frames
 
     Yolov5segParams() {
         iou_threshold = 0.6;
         score_threshold = 0.25;
+        mask_threshold = 0.0;
         outputs_size = {20, 40, 80};
         outputs_name = {"yolov5n_seg/conv63", "yolov5n_seg/conv48", "yolov5n_seg/conv55", "yolov5n_seg/conv61"};
         anchors = {{116, 90, 156, 198, 373, 326},
@@ -174,7 +174,7 @@ void mspn_postprocess(HailoROIPtr roi, const float score_threshold, bool perform
     {
         points.emplace_back(HailoPoint(preds(i, 0), preds(i, 1), preds(i, 2)));
     }
-    roi->add_object(std::make_shared<HailoLandmarks>("centerpose", points, score_threshold, centerpose_joint_pairs));
+    roi->add_object(hailo_make_shared<HailoLandmarks>("centerpose", points, score_threshold, centerpose_joint_pairs));
 }
 
 /**
@@ -2,41 +2,76 @@
  * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
  * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
  **/
-#include <regex>
+#include <cstring>
+#include <iostream>
 #include "semantic_segmentation.hpp"
-#include "common/tensors.hpp"
 
-void semantic_segmentation(HailoROIPtr roi)
+SemanticSegmentationParams *init(const std::string config_path, const std::string function_name)
 {
-    if (!roi->has_tensors())
+    return new SemanticSegmentationParams();
+}
+
+void free_resources(void *params_void_ptr)
+{
+    SemanticSegmentationParams *params = reinterpret_cast<SemanticSegmentationParams *>(params_void_ptr);
+    delete params;
+}
+
+/**
+ * @brief Get the argmax tensor of the roi. The tensor is searched by name once,
+ *        later frames look it up directly until it is missing.
+ */
+static HailoTensorPtr get_argmax_tensor(HailoROIPtr roi, SemanticSegmentationParams *params)
+{
+    if (!params->tensor_name.empty())
     {
-        return;
+        try
+        {
+            return roi->get_tensor(params->tensor_name);
+        }
+        catch (const std::invalid_argument &)
+        {
+            params->tensor_name.clear();
+        }
     }
-    HailoTensorPtr tensor_ptr;
-    std::vector<HailoTensorPtr> tensors = roi->get_tensors();
+
     // find the argmax1 tensor
-    for (auto tensor : tensors)
+    HailoTensorPtr tensor_ptr;
+    for (auto tensor : roi->get_tensors())
     {
-        if (std::regex_search(tensor->name(), std::regex("argmax"))) 
+        if (tensor->name().find("argmax") != std::string::npos)
         {
             tensor_ptr = tensor;
         }
     }
+    if (tensor_ptr)
+        params->tensor_name = tensor_ptr->name();
+    return tensor_ptr;
+}
+
+void semantic_segmentation(HailoROIPtr roi, SemanticSegmentationParams *params)
+{
+    if (!roi->has_tensors())
+    {
+        return;
+    }
+    HailoTensorPtr tensor_ptr = get_argmax_tensor(roi, params);
     if (!tensor_ptr)
     {
         std::cerr << "Semantic Segmentation post process: No argmax tensor found" << std::endl;
         return;
     }
-    xt::xarray<uint8_t> tensor_data = common::get_xtensor(tensor_ptr);
 
-    // allocate and memcpy to a new memory so it points to the right data
-    std::vector<uint8_t> data(tensor_ptr->size());
+    // The tensor lives in the network's output buffer, which is recycled once the frame is processed,
+    // so the class ids are copied once into a buffer recycled from an older mask
+    std::vector<uint8_t> data = params->mask_pool->acquire(tensor_ptr->size());
     memcpy(data.data(), tensor_ptr->data(), sizeof(uint8_t) * tensor_ptr->size());
-    auto obj_ptr = std::make_shared<HailoClassMask>(std::move(data), tensor_ptr->width(), tensor_ptr->height(), 0.3);
+    HailoClassMaskPtr obj_ptr = params->mask_pool->make_mask(std::move(data), tensor_ptr->width(), tensor_ptr->height(), 0.3);
     hailo_common::add_object(roi, obj_ptr);
 }
 
-void filter(HailoROIPtr roi)
+void filter(HailoROIPtr roi, void *params_void_ptr)
 {
-    semantic_segmentation(roi);
-}
\ No newline at end of file
+    SemanticSegmentationParams *params = reinterpret_cast<SemanticSegmentationParams *>(params_void_ptr);
+    semantic_segmentation(roi, params);
+}
@@ -3,9 +3,22 @@
 * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
 **/
 #pragma once
+#include <memory>
+#include <string>
+#include <vector>
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
+#include "hailo_class_mask_pool.hpp"
+
+class SemanticSegmentationParams
+{
+public:
+    std::string tensor_name; // The argmax output, resolved on the first frame
+    std::shared_ptr<ClassMaskPool> mask_pool = ClassMaskPool::create();
+};
 
 __BEGIN_DECLS
- void filter(HailoROIPtr roi);
+SemanticSegmentationParams *init(const std::string config_path, const std::string function_name);
+void free_resources(void *params_void_ptr);
+void filter(HailoROIPtr roi, void *params_void_ptr);
 __END_DECLS
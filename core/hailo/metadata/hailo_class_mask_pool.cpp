@@ -0,0 +1,62 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+#include "hailo_class_mask_pool.hpp"
+
+namespace
+{
+    /**
+     * @brief A HailoClassMask whose buffer goes back to its pool when the mask is destroyed.
+     */
+    class PooledClassMask : public HailoClassMask
+    {
+    private:
+        std::shared_ptr<ClassMaskPool> m_pool;
+
+    public:
+        PooledClassMask(std::shared_ptr<ClassMaskPool> pool, std::vector<uint8_t> &&data_vec, int mask_width, int mask_height, float transparency)
+            : HailoClassMask(std::move(data_vec), mask_width, mask_height, transparency), m_pool(std::move(pool)){};
+
+        virtual ~PooledClassMask()
+        {
+            m_pool->release(std::move(m_data));
+        }
+    };
+}
+
+ClassMaskPool::ClassMaskPool(size_t max_free) : m_max_free(max_free) {}
+
+ClassMaskPool::~ClassMaskPool() = default;
+
+std::shared_ptr<ClassMaskPool> ClassMaskPool::create(size_t max_free)
+{
+    return std::shared_ptr<ClassMaskPool>(new ClassMaskPool(max_free));
+}
+
+std::vector<uint8_t> ClassMaskPool::acquire(size_t size)
+{
+    std::vector<uint8_t> data;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free.empty())
+        {
+            data = std::move(m_free.back());
+            m_free.pop_back();
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+HailoClassMaskPtr ClassMaskPool::make_mask(std::vector<uint8_t> &&data, int mask_width, int mask_height, float transparency)
+{
+    return std::make_shared<PooledClassMask>(shared_from_this(), std::move(data), mask_width, mask_height, transparency);
+}
+
+void ClassMaskPool::release(std::vector<uint8_t> &&data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_free.size() < m_max_free)
+        m_free.emplace_back(std::move(data));
+}
@@ -0,0 +1,49 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "hailo_objects.hpp"
+
+// Spare buffers kept by a ClassMaskPool, enough for the masks in flight between the filter and the sink
+#define MAX_POOLED_MASKS 8
+
+/**
+ * @brief Recycles the data buffers of the class masks of one stream.
+ *        A mask gives its buffer back when it is destroyed (downstream, on any thread),
+ *        so once warm a frame reuses the buffer of an older frame instead of allocating a new one.
+ *        Post processes are unloaded while their masks may still be alive, so the pool, the masks and
+ *        their control blocks are all created here, in the meta library, and none of the code run
+ *        when they are released lives in the post process.
+ */
+class ClassMaskPool : public std::enable_shared_from_this<ClassMaskPool>
+{
+private:
+    std::mutex m_mutex;
+    std::vector<std::vector<uint8_t>> m_free;
+    size_t m_max_free;
+
+    explicit ClassMaskPool(size_t max_free);
+
+public:
+    static std::shared_ptr<ClassMaskPool> create(size_t max_free = MAX_POOLED_MASKS);
+
+    ClassMaskPool(const ClassMaskPool &) = delete;
+    ClassMaskPool &operator=(const ClassMaskPool &) = delete;
+    ~ClassMaskPool();
+
+    /**
+     * @brief Get a buffer of size bytes, recycled from a released mask when there is one.
+     */
+    std::vector<uint8_t> acquire(size_t size);
+
+    /**
+     * @brief Create a class mask over data, its buffer goes back to this pool when the mask is destroyed.
+     */
+    HailoClassMaskPtr make_mask(std::vector<uint8_t> &&data, int mask_width, int mask_height, float transparency);
+
+    void release(std::vector<uint8_t> &&data);
+};
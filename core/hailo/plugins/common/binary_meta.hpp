@@ -0,0 +1,199 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Binary wire format of the HailoROI hierarchy, written by encode_binary and read by decode_binary.
+  All values are little endian and unaligned, arrays are copied as is.
+
+    Message        := Header Roi
+    Header         := u32 magic | u16 version | u16 reserved | u32 message_size | u64 buffer_offset
+                      | i64 timestamp_ms | String stream_id
+    Roi            := BBox Objects
+    Objects        := u32 count | Object[count]
+    Object         := u8 type (hailo_object_t) | u32 payload_size | payload
+    BBox           := f32 xmin | f32 ymin | f32 width | f32 height
+    String         := u32 length | char[length]
+
+    HAILO_DETECTION       := BBox | i32 class_id | f32 confidence | String label | Objects
+    HAILO_CLASSIFICATION  := String type | i32 class_id | f32 confidence | String label
+    HAILO_LANDMARKS       := String type | f32 threshold | u32 n | (f32 x, f32 y, f32 confidence)[n]
+                             | u32 m | (i32 first, i32 second)[m]
+    HAILO_TILE            := BBox | u32 index | f32 overlap_x | f32 overlap_y | u32 layer | u32 mode | Objects
+    HAILO_UNIQUE_ID       := i32 id | i32 mode
+    HAILO_MATRIX          := u32 height | u32 width | u32 features | u32 n | f32[n]
+    HAILO_DEPTH_MASK      := i32 width | i32 height | f32 transparency | u32 n | f32[n]
+    HAILO_CLASS_MASK      := i32 width | i32 height | f32 transparency | u32 n | u8[n]
+    HAILO_CONF_CLASS_MASK := i32 width | i32 height | f32 transparency | i32 class_id | u32 n | f32[n]
+
+  message_size covers the whole message, so messages can be concatenated in a file.
+  payload_size lets a reader skip object types it doesn't know.
+  Mask and matrix arrays hold exactly width * height (times features for a matrix) values, and objects
+  are nested at most MAX_OBJECTS_DEPTH levels deep.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "The binary metadata format is little endian only");
+
+namespace binary_meta
+{
+    const uint32_t MAGIC = 0x424f4c48; // "HLOB"
+    const uint16_t VERSION = 1;
+    const size_t MESSAGE_SIZE_OFFSET = sizeof(uint32_t) + 2 * sizeof(uint16_t);
+    const uint32_t MAX_OBJECTS_DEPTH = 32;
+
+    /**
+     * @brief Appends values to a byte vector.
+     *        Sizes that are only known after their content was written are reserved and patched later.
+     */
+    class Writer
+    {
+    private:
+        std::vector<uint8_t> &m_buffer;
+
+    public:
+        explicit Writer(std::vector<uint8_t> &buffer) : m_buffer(buffer){};
+
+        void write_bytes(const void *data, size_t size)
+        {
+            const uint8_t *bytes = static_cast<const uint8_t *>(data);
+            m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+        }
+
+        template <typename T>
+        void write(T value)
+        {
+            write_bytes(&value, sizeof(T));
+        }
+
+        void write_string(const std::string &str)
+        {
+            write<uint32_t>(str.size());
+            write_bytes(str.data(), str.size());
+        }
+
+        template <typename T>
+        void write_array(const std::vector<T> &array)
+        {
+            write<uint32_t>(array.size());
+            write_bytes(array.data(), array.size() * sizeof(T));
+        }
+
+        /**
+         * @brief Reserve a u32 to be patched later.
+         *
+         * @return size_t The offset of the reserved u32.
+         */
+        size_t reserve_u32()
+        {
+            size_t offset = m_buffer.size();
+            write<uint32_t>(0);
+            return offset;
+        }
+
+        void patch_u32(size_t offset, uint32_t value)
+        {
+            std::memcpy(m_buffer.data() + offset, &value, sizeof(value));
+        }
+
+        size_t size() const
+        {
+            return m_buffer.size();
+        }
+    };
+
+    /**
+     * @brief Reads values from a byte range, throwing std::runtime_error when reading past its end.
+     */
+    class Reader
+    {
+    private:
+        const uint8_t *m_data;
+        size_t m_size;
+        size_t m_position;
+
+        void require(size_t size)
+        {
+            if (size > m_size - m_position)
+                throw std::runtime_error("binary metadata message is truncated");
+        }
+
+    public:
+        Reader(const void *data, size_t size) : m_data(static_cast<const uint8_t *>(data)), m_size(size), m_position(0){};
+
+        void read_bytes(void *data, size_t size)
+        {
+            require(size);
+            if (size > 0)
+                std::memcpy(data, m_data + m_position, size);
+            m_position += size;
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            read_bytes(&value, sizeof(T));
+            return value;
+        }
+
+        std::string read_string()
+        {
+            uint32_t length = read<uint32_t>();
+            require(length);
+            std::string str(reinterpret_cast<const char *>(m_data + m_position), length);
+            m_position += length;
+            return str;
+        }
+
+        template <typename T>
+        std::vector<T> read_array()
+        {
+            uint32_t count = read<uint32_t>();
+            if (count > (m_size - m_position) / sizeof(T))
+                throw std::runtime_error("binary metadata message is truncated");
+            std::vector<T> array(count);
+            read_bytes(array.data(), count * sizeof(T));
+            return array;
+        }
+
+        void skip(size_t size)
+        {
+            require(size);
+            m_position += size;
+        }
+
+        size_t position() const
+        {
+            return m_position;
+        }
+
+        void seek(size_t position)
+        {
+            if (position > m_size)
+                throw std::runtime_error("binary metadata message is truncated");
+            m_position = position;
+        }
+
+        size_t remaining() const
+        {
+            return m_size - m_position;
+        }
+
+        /**
+         * @brief End the readable range at a position, like the end of a message followed by another one.
+         */
+        void set_end(size_t end)
+        {
+            if (end < m_position || end > m_size)
+                throw std::runtime_error("binary metadata message is truncated");
+            m_size = end;
+        }
+    };
+}
@@ -5,6 +5,16 @@
 
 #include "common/image.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 size_t get_size(GstCaps *caps)
 {
     size_t size;
@@ -49,7 +59,169 @@ cv::Mat get_mat_from_gst_frame(GstVideoFrame *frame)
     return get_mat_from_video_info(&frame->info, (char *)GST_VIDEO_FRAME_PLANE_DATA(frame, 0));
 }
 
-void resize_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
+// Fixed point precision of the bilinear weights of the packed YUY2 resize
+#define YUY2_RESIZE_WEIGHT_BITS (7)
+#define YUY2_RESIZE_WEIGHT_ONE (1 << YUY2_RESIZE_WEIGHT_BITS)
+
+/**
+ * @brief Source pixels and weight of a destination pixel, following the half pixel centers convention of cv::resize.
+ */
+static inline void yuy2_linear_coordinate(int dst, int src_size, float scale, int &src0, int &src1, int &weight)
+{
+    float fx = (dst + 0.5f) * scale - 0.5f;
+    int sx = (int)std::floor(fx);
+    float fraction = fx - sx;
+    if (sx < 0)
+    {
+        sx = 0;
+        fraction = 0.0f;
+    }
+    if (sx >= src_size - 1)
+    {
+        sx = src_size - 1;
+        fraction = 0.0f;
+    }
+    src0 = sx;
+    src1 = std::min(sx + 1, src_size - 1);
+    weight = (int)std::lround(fraction * YUY2_RESIZE_WEIGHT_ONE);
+}
+
+static inline int yuy2_nearest_coordinate(int dst, int src_size, float scale)
+{
+    return std::min((int)std::floor(dst * scale), src_size - 1);
+}
+
+/**
+ * @brief Byte offsets in a source row (and weights) for every byte of a destination row.
+ *        Y is sampled over the full width of the row, U and V over the macropixels.
+ */
+static void yuy2_build_column_table(int src_cols, int dst_cols, bool linear,
+                                    std::vector<int> &offsets0, std::vector<int> &offsets1, std::vector<int16_t> &weights)
+{
+    int dst_bytes = dst_cols * 4;
+    offsets0.resize(dst_bytes);
+    offsets1.resize(dst_bytes);
+    weights.resize(dst_bytes);
+    // Y rows are twice as wide as the U and V rows on both sides, so they share the scale
+    float scale = float(src_cols) / dst_cols;
+    for (int c = 0; c < dst_bytes; c++)
+    {
+        int component = c & 3;
+        bool luma = (component & 1) == 0;
+        int dst_index = luma ? (c >> 2) * 2 + (component >> 1) : c >> 2;
+        int src_size = luma ? src_cols * 2 : src_cols;
+        int src0, src1, weight = 0;
+        if (linear)
+            yuy2_linear_coordinate(dst_index, src_size, scale, src0, src1, weight);
+        else
+            src0 = src1 = yuy2_nearest_coordinate(dst_index, src_size, scale);
+        // Y k sits at byte (k / 2) * 4 + (k % 2) * 2 of its row, U and V of macropixel k at 4k + 1 and 4k + 3
+        offsets0[c] = luma ? (src0 >> 1) * 4 + (src0 & 1) * 2 : src0 * 4 + component;
+        offsets1[c] = luma ? (src1 >> 1) * 4 + (src1 & 1) * 2 : src1 * 4 + component;
+        weights[c] = weight;
+    }
+}
+
+static void yuy2_interpolate_row(const uint8_t *src_row, const std::vector<int> &offsets0, const std::vector<int> &offsets1,
+                                 const std::vector<int16_t> &weights, int16_t *row)
+{
+    for (size_t c = 0; c < weights.size(); c++)
+    {
+        row[c] = src_row[offsets0[c]] * (YUY2_RESIZE_WEIGHT_ONE - weights[c]) + src_row[offsets1[c]] * weights[c];
+    }
+}
+
+static void yuy2_blend_rows(const int16_t *row0, const int16_t *row1, int weight, uint8_t *dst, int size)
+{
+    const int weight0 = YUY2_RESIZE_WEIGHT_ONE - weight;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i weights = _mm_set1_epi32((weight << 16) | weight0);
+    const __m128i round = _mm_set1_epi32(1 << (2 * YUY2_RESIZE_WEIGHT_BITS - 1));
+    for (; i + 8 <= size; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(row0 + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(row1 + i));
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights);
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 2 * YUY2_RESIZE_WEIGHT_BITS);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 2 * YUY2_RESIZE_WEIGHT_BITS);
+        __m128i packed = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(packed, packed));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const int16x4_t weights0 = vdup_n_s16(weight0);
+    const int16x4_t weights1 = vdup_n_s16(weight);
+    for (; i + 8 <= size; i += 8)
+    {
+        int16x8_t a = vld1q_s16(row0 + i);
+        int16x8_t b = vld1q_s16(row1 + i);
+        int32x4_t lo = vmlal_s16(vmull_s16(vget_low_s16(a), weights0), vget_low_s16(b), weights1);
+        int32x4_t hi = vmlal_s16(vmull_s16(vget_high_s16(a), weights0), vget_high_s16(b), weights1);
+        uint16x8_t packed = vcombine_u16(vqrshrun_n_s32(lo, 2 * YUY2_RESIZE_WEIGHT_BITS), vqrshrun_n_s32(hi, 2 * YUY2_RESIZE_WEIGHT_BITS));
+        vst1_u8(dst + i, vqmovn_u16(packed));
+    }
+#endif
+    for (; i < size; i++)
+    {
+        dst[i] = (row0[i] * weight0 + row1[i] * weight + (1 << (2 * YUY2_RESIZE_WEIGHT_BITS - 1))) >> (2 * YUY2_RESIZE_WEIGHT_BITS);
+    }
+}
+
+/**
+ * @brief Resize a packed YUY2 image (macropixels of Y0 U Y1 V) in one pass, straight into the destination rows.
+ *        The source is read in place, so a crop is just a view of the frame.
+ */
+static void resize_yuy2_packed(const cv::Mat &src, cv::Mat &dst, bool linear)
+{
+    thread_local std::vector<int> offsets0, offsets1;
+    thread_local std::vector<int16_t> weights;
+    yuy2_build_column_table(src.cols, dst.cols, linear, offsets0, offsets1, weights);
+    int dst_bytes = dst.cols * 4;
+    float row_scale = float(src.rows) / dst.rows;
+
+    if (!linear)
+    {
+        for (int dy = 0; dy < dst.rows; dy++)
+        {
+            const uint8_t *src_row = src.ptr<uint8_t>(yuy2_nearest_coordinate(dy, src.rows, row_scale));
+            uint8_t *dst_row = dst.ptr<uint8_t>(dy);
+            for (int c = 0; c < dst_bytes; c++)
+                dst_row[c] = src_row[offsets0[c]];
+        }
+        return;
+    }
+
+    // Horizontally interpolated source rows, reused while consecutive destination rows share them
+    thread_local std::vector<int16_t> rows[2];
+    rows[0].resize(dst_bytes);
+    rows[1].resize(dst_bytes);
+    int16_t *row_buffers[2] = {rows[0].data(), rows[1].data()};
+    int cached_rows[2] = {-1, -1};
+    for (int dy = 0; dy < dst.rows; dy++)
+    {
+        int sy0, sy1, weight;
+        yuy2_linear_coordinate(dy, src.rows, row_scale, sy0, sy1, weight);
+        if (cached_rows[0] != sy0 && cached_rows[1] == sy0)
+        {
+            std::swap(row_buffers[0], row_buffers[1]);
+            std::swap(cached_rows[0], cached_rows[1]);
+        }
+        if (cached_rows[0] != sy0)
+        {
+            yuy2_interpolate_row(src.ptr<uint8_t>(sy0), offsets0, offsets1, weights, row_buffers[0]);
+            cached_rows[0] = sy0;
+        }
+        if (cached_rows[1] != sy1)
+        {
+            yuy2_interpolate_row(src.ptr<uint8_t>(sy1), offsets0, offsets1, weights, row_buffers[1]);
+            cached_rows[1] = sy1;
+        }
+        yuy2_blend_rows(row_buffers[0], row_buffers[1], weight, dst.ptr<uint8_t>(dy), dst_bytes);
+    }
+}
+
+static void resize_yuy2_planar(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
 {
     // Split the yuy2 channels into Y U Y V
     std::vector<cv::Mat> channels(4);
@@ -82,6 +254,26 @@ void resize_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolati
     resized_y_channels_2_split.release();
 }
 
+void resize_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
+{
+    if (cropped_image.empty() || resized_image.empty())
+        return;
+    resized_image.create(resized_image.rows, resized_image.cols, CV_8UC4);
+    switch (interpolation)
+    {
+    case cv::INTER_LINEAR:
+        resize_yuy2_packed(cropped_image, resized_image, true);
+        break;
+    case cv::INTER_NEAREST:
+        resize_yuy2_packed(cropped_image, resized_image, false);
+        break;
+    default:
+        // Other interpolations (area, cubic...) resize the planes with OpenCV
+        resize_yuy2_planar(cropped_image, resized_image, interpolation);
+        break;
+    }
+}
+
 void resize_nv12(std::vector<cv::Mat> &cropped_image_vec, std::vector<cv::Mat> &resized_image_vec, int interpolation)
 {
     uint resize_width_y = resized_image_vec[0].cols;
@@ -94,38 +286,114 @@ void resize_nv12(std::vector<cv::Mat> &cropped_image_vec, std::vector<cv::Mat> &
     cv::resize(cropped_image_vec[1], resized_image_vec[1], cv::Size(resize_width_uv, resize_height_uv), 0, 0, interpolation);
 }
 
-HailoBBox resize_letterbox_rgb(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation)
+/**
+ * @brief Placement of the resized image inside the letterbox and the width of its borders.
+ */
+struct LetterboxGeometry
+{
+    int top;
+    int bottom;
+    int left;
+    int right;
+    int width;
+    int height;
+};
+
+static LetterboxGeometry letterbox_geometry(const cv::Mat &cropped_image, const cv::Mat &resized_image)
 {
-    cv::Mat tmp;
+    LetterboxGeometry geometry;
     float ratio = std::min(float(resized_image.rows) / cropped_image.rows, float(resized_image.cols) / cropped_image.cols);
-    int new_width = std::round(cropped_image.cols * ratio);
-    int new_height = std::round(cropped_image.rows * ratio);
+    geometry.width = std::max<int>(std::round(cropped_image.cols * ratio), 1);
+    geometry.height = std::max<int>(std::round(cropped_image.rows * ratio), 1);
 
-    cv::resize(cropped_image, tmp, cv::Size(new_width, new_height), 0, 0, interpolation);
-    float middle_point_width = (resized_image.cols - new_width) / 2;
-    float middle_point_height = (resized_image.rows - new_height) / 2;
+    float middle_point_width = (resized_image.cols - geometry.width) / 2;
+    float middle_point_height = (resized_image.rows - geometry.height) / 2;
 
     // Calculate the number of pixels we should colorize
-    int top = std::round(middle_point_height - 0.1);
-    int bottom = std::round(middle_point_height + 0.1);
-    int left = std::round(middle_point_width - 0.1);
-    int right = std::round(middle_point_width + 0.1);
+    geometry.top = std::round(middle_point_height - 0.1);
+    geometry.bottom = std::round(middle_point_height + 0.1);
+    geometry.left = std::round(middle_point_width - 0.1);
+    geometry.right = std::round(middle_point_width + 0.1);
 
     // Sometimes due to rounding errors the letterbox borders can be slightly off, so we need to correct it
     // Oterwise the resized image will have different dimensions than the requested ones (+-1 pixel)
-    int cols_diff = resized_image.cols - (tmp.cols + left + right);
-    int rows_diff = resized_image.rows - (tmp.rows + top + bottom);
-    top = top + rows_diff;
-    left = left + cols_diff;
-    
-    HailoBBox letterboxed_scale = HailoBBox(-(left / float(new_width)),                      // x-offset
-                                            -(top / float(new_height)),                      // y-offset
-                                            1.0 / (new_width / float(resized_image.cols)),   // width factor
-                                            1.0 / (new_height / float(resized_image.rows))); // height factor
-
-    cv::copyMakeBorder(tmp, resized_image, top, bottom, left, right, cv::BORDER_CONSTANT, color);
-    tmp.release();
-    return letterboxed_scale;
+    int cols_diff = resized_image.cols - (geometry.width + geometry.left + geometry.right);
+    int rows_diff = resized_image.rows - (geometry.height + geometry.top + geometry.bottom);
+    geometry.top = geometry.top + rows_diff;
+    geometry.left = geometry.left + cols_diff;
+    return geometry;
+}
+
+static HailoBBox letterbox_scale(const LetterboxGeometry &geometry, const cv::Mat &resized_image)
+{
+    return HailoBBox(-(geometry.left / float(geometry.width)),                      // x-offset
+                     -(geometry.top / float(geometry.height)),                      // y-offset
+                     1.0 / (geometry.width / float(resized_image.cols)),            // width factor
+                     1.0 / (geometry.height / float(resized_image.rows)));          // height factor
+}
+
+/**
+ * @brief Paint the border strips of a letterboxed image, leaving the resized image in the middle untouched.
+ *        A row of the border color is kept per thread, so for a fixed output size and color every strip is a memcpy.
+ */
+static void fill_letterbox_borders(cv::Mat &resized_image, const LetterboxGeometry &geometry, const cv::Scalar &color)
+{
+    thread_local std::vector<uint8_t> border_row;
+    thread_local cv::Scalar border_color;
+    thread_local int border_type = -1;
+
+    size_t pixel_size = resized_image.elemSize();
+    size_t row_size = resized_image.cols * pixel_size;
+    if (border_row.size() != row_size || border_type != resized_image.type() || border_color != color)
+    {
+        cv::Mat row(1, resized_image.cols, resized_image.type(), color);
+        border_row.assign(row.data, row.data + row_size);
+        border_type = resized_image.type();
+        border_color = color;
+    }
+
+    int bottom_start = geometry.top + geometry.height;
+    for (int row = 0; row < resized_image.rows; row++)
+    {
+        uint8_t *row_data = resized_image.ptr<uint8_t>(row);
+        if (row < geometry.top || row >= bottom_start)
+        {
+            memcpy(row_data, border_row.data(), row_size);
+            continue;
+        }
+        memcpy(row_data, border_row.data(), geometry.left * pixel_size);
+        size_t right_start = (geometry.left + geometry.width) * pixel_size;
+        memcpy(row_data + right_start, border_row.data(), row_size - right_start);
+    }
+}
+
+HailoBBox resize_letterbox_rgb(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation)
+{
+    LetterboxGeometry geometry = letterbox_geometry(cropped_image, resized_image);
+
+    // Resize straight into the middle of the output, then paint only the borders around it
+    cv::Mat letterboxed_image = resized_image(cv::Rect(geometry.left, geometry.top, geometry.width, geometry.height));
+    cv::resize(cropped_image, letterboxed_image, letterboxed_image.size(), 0, 0, interpolation);
+    fill_letterbox_borders(resized_image, geometry, color);
+
+    return letterbox_scale(geometry, resized_image);
+}
+
+HailoBBox resize_letterbox_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation)
+{
+    // Convert the color to a YUY2 macropixel
+    uint y = RGB2Y(color[0], color[1], color[2]);
+    uint u = RGB2U(color[0], color[1], color[2]);
+    uint v = RGB2V(color[0], color[1], color[2]);
+    cv::Scalar yuy2_color(y, u, y, v);
+
+    // The geometry is computed over macropixels, both dimensions of a macropixel scale by the same ratio
+    LetterboxGeometry geometry = letterbox_geometry(cropped_image, resized_image);
+    cv::Mat letterboxed_image = resized_image(cv::Rect(geometry.left, geometry.top, geometry.width, geometry.height));
+    resize_yuy2(cropped_image, letterboxed_image, interpolation);
+    fill_letterbox_borders(resized_image, geometry, yuy2_color);
+
+    return letterbox_scale(geometry, resized_image);
 }
 
 HailoBBox resize_letterbox_nv12(std::vector<cv::Mat> &cropped_image_vec, std::vector<cv::Mat> &resized_image_vec, cv::Scalar color, int interpolation)
@@ -134,11 +402,10 @@ HailoBBox resize_letterbox_nv12(std::vector<cv::Mat> &cropped_image_vec, std::ve
     uint y = RGB2Y(color[0], color[1], color[2]);
     uint u = RGB2U(color[0], color[1], color[2]);
     uint v = RGB2V(color[0], color[1], color[2]);
-    cv::Scalar nv12_color(y, u, v);
 
     // Perform the letterbox resize on the Y and UV channels separately
-    HailoBBox letterboxed_scale = resize_letterbox_rgb(cropped_image_vec[0], resized_image_vec[0], nv12_color, interpolation);
-    resize_letterbox_rgb(cropped_image_vec[1], resized_image_vec[1], nv12_color, interpolation);
+    HailoBBox letterboxed_scale = resize_letterbox_rgb(cropped_image_vec[0], resized_image_vec[0], cv::Scalar(y), interpolation);
+    resize_letterbox_rgb(cropped_image_vec[1], resized_image_vec[1], cv::Scalar(u, v), interpolation);
 
     return letterboxed_scale;
 }
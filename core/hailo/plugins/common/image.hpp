@@ -109,6 +109,26 @@ void resize_nv12(std::vector<cv::Mat> &cropped_image_vec, std::vector<cv::Mat> &
  */
 HailoBBox resize_letterbox_rgb(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation = cv::INTER_LINEAR);
 
+/**
+ * @brief Resize a YUY2 image (4 channel cv::Mat) using Letterbox strategy
+ *
+ * @param cropped_image - cv::Mat &
+ *        The cropped image to resize
+ *
+ * @param resized_image - cv::Mat &
+ *        The resized image container to fill
+ *        (dims for resizing are assumed from here)
+ *
+ * @param color - cv::Scalar
+ *        The RGB color to fill the letterbox with
+ *
+ * @param interpolation - int
+ *        The interpolation type to resize by.
+ *        Must be a supported opencv type
+ *        (bilinear, nearest neighbors, etc...)
+ */
+HailoBBox resize_letterbox_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation = cv::INTER_LINEAR);
+
 /**
  * @brief Resize an NV12 image using Letterbox strategy
  *
@@ -0,0 +1,32 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <glib-object.h>
+
+/**
+ * @brief Serialization format of the metadata exported/imported by the export and import elements.
+ */
+typedef enum
+{
+    HAILO_METADATA_FORMAT_JSON,
+    HAILO_METADATA_FORMAT_BINARY,
+} HailoMetadataFormat;
+
+#define GST_TYPE_HAILO_METADATA_FORMAT (gst_hailo_metadata_format_get_type())
+/**
+ * @brief The enum type of the "format" property, shared by hailoexportzmq, hailoexportfile and hailoimportzmq.
+ */
+inline GType
+gst_hailo_metadata_format_get_type(void)
+{
+    static const GEnumValue hailo_metadata_formats[] = {
+        {HAILO_METADATA_FORMAT_JSON, "JSON text", "json"},
+        {HAILO_METADATA_FORMAT_BINARY, "Compact binary records (see common/binary_meta.hpp)", "binary"},
+        {0, NULL, NULL},
+    };
+    static GType metadata_format = g_enum_register_static("GstHailoMetadataFormat", hailo_metadata_formats);
+    return metadata_format;
+}
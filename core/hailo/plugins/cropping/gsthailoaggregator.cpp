@@ -27,10 +27,15 @@ static GstStateChangeReturn gst_hailoaggregator_change_state(GstElement *element
 
 #define DEFAULT_FORWARD_STICKY_EVENTS TRUE
 
+#define DEFAULT_MAX_INFLIGHT_FRAMES 1
+#define MIN_MAX_INFLIGHT_FRAMES 1
+#define MAX_MAX_INFLIGHT_FRAMES 32
+
 enum
 {
     PROP_0,
     PROP_FLATTEN_DETECTIONS,
+    PROP_MAX_INFLIGHT_FRAMES,
 };
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
@@ -60,6 +65,7 @@ static gboolean gst_hailoaggregator_sink_event(GstPad *pad,
                                                GstEvent *event);
 static GstFlowReturn gst_hailoaggregator_chain_main(GstPad *pad, GstObject *parent, GstBuffer *buf);
 static GstFlowReturn gst_hailoaggregator_chain_sub(GstPad *pad, GstObject *parent, GstBuffer *buf);
+static GstFlowReturn gst_hailoaggregator_release_ready_frames(GstHailoAggregator *hailoaggregator);
 
 static gboolean gst_hailoaggregator_sink_query(GstPad *pad,
                                                  GstObject *parent, GstQuery *query);
@@ -90,6 +96,12 @@ gst_hailoaggregator_class_init(GstHailoAggregatorClass *klass)
     g_object_class_install_property(gobject_class, PROP_FLATTEN_DETECTIONS,
                                     g_param_spec_boolean("flatten-detections", "Flatten detections", "perform a 'flattening' functionality on the detection metadata when receiving each frame", false,
                                                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_MAX_INFLIGHT_FRAMES,
+                                    g_param_spec_uint("max-inflight-frames", "Max inflight frames",
+                                                      "Maximum number of main frames waiting for their crops at the same time. "
+                                                      "Values above 1 let the crops of consecutive frames be processed concurrently, main frames are still pushed in order.",
+                                                      MIN_MAX_INFLIGHT_FRAMES, MAX_MAX_INFLIGHT_FRAMES, DEFAULT_MAX_INFLIGHT_FRAMES,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
 }
 
 static void
@@ -115,8 +127,12 @@ gst_hailoaggregator_init(GstHailoAggregator *hailoaggregator)
     gst_pad_use_fixed_caps(hailoaggregator->srcpad);
 
     gst_element_add_pad(GST_ELEMENT(hailoaggregator), hailoaggregator->srcpad);
-    hailoaggregator->num_of_frames = 0;
     hailoaggregator->mainframe = NULL;
+    hailoaggregator->max_inflight_frames = DEFAULT_MAX_INFLIGHT_FRAMES;
+    hailoaggregator->flushing = false;
+    hailoaggregator->last_flow_return = GST_FLOW_OK;
+    hailoaggregator->pending_frames.clear();
+    hailoaggregator->pending_order.clear();
 
     hailoaggregator->flatten_detections = false;
     hailoaggregator->eos_main = false;
@@ -134,6 +150,9 @@ gst_hailoaggregator_set_property(GObject *object, guint prop_id,
     case PROP_FLATTEN_DETECTIONS:
         hailoaggregator->flatten_detections = g_value_get_boolean(value);
         break;
+    case PROP_MAX_INFLIGHT_FRAMES:
+        hailoaggregator->max_inflight_frames = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -151,6 +170,9 @@ gst_hailoaggregator_get_property(GObject *object, guint prop_id, GValue *value,
     case PROP_FLATTEN_DETECTIONS:
         g_value_set_boolean(value, hailoaggregator->flatten_detections);
         break;
+    case PROP_MAX_INFLIGHT_FRAMES:
+        g_value_set_uint(value, hailoaggregator->max_inflight_frames);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -205,10 +227,9 @@ static gboolean gst_hailoaggregator_sink_query(GstPad *pad,
 
 /**
  * Checks whether all sinkpads got eos.
+ * Must be called with hailoaggregator->mutex held.
  *
  * @param[in] hailoaggregator         aggregator element to check
- * @param[in] event       Pointer to the event
- * @param[in] user_data   The srcpad to send the event to.
  * @return Upon success, returns true. Otherwise, returns false.
  */
 static gboolean
@@ -217,6 +238,7 @@ gst_hailoaggregator_all_sinkpads_eos_unlocked(GstHailoAggregator *hailoaggregato
     return (hailoaggregator->eos_main && hailoaggregator->eos_sub);
 }
 
+// Must be called with hailoaggregator->mutex held.
 static void
 gst_hailoaggregator_update_eos(GstHailoAggregator *hailoaggregator, GstPad *pad, bool eos)
 {
@@ -230,6 +252,16 @@ gst_hailoaggregator_update_eos(GstHailoAggregator *hailoaggregator, GstPad *pad,
     }
 }
 
+// Must be called with hailoaggregator->mutex held.
+static void
+gst_hailoaggregator_drop_pending_frames_unlocked(GstHailoAggregator *hailoaggregator)
+{
+    for (auto &frame : hailoaggregator->pending_frames)
+        gst_buffer_unref(frame.second.buffer);
+    hailoaggregator->pending_frames.clear();
+    hailoaggregator->pending_order.clear();
+}
+
 static gboolean
 gst_hailoaggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
 {
@@ -240,6 +272,38 @@ gst_hailoaggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
 
     GST_DEBUG_OBJECT(pad, "received event %" GST_PTR_FORMAT, event);
 
+    if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_START)
+    {
+        // Wake up the chain functions, they return flushing. Frames in flight are dropped on flush stop.
+        {
+            std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+            hailoaggregator->flushing = true;
+        }
+        hailoaggregator->cv_main.notify_all();
+        hailoaggregator->cv_sub.notify_all();
+    }
+    else if (GST_EVENT_IS_SERIALIZED(event) && GST_EVENT_TYPE(event) != GST_EVENT_FLUSH_STOP)
+    {
+        if (pad == hailoaggregator->sinkpad_main)
+        {
+            // Serialized events must not overtake the main frames in flight, wait until they are pushed.
+            std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
+            hailoaggregator->cv_main.wait(lock, [hailoaggregator]
+                                          { return hailoaggregator->pending_frames.empty() || hailoaggregator->eos_sub || hailoaggregator->flushing; });
+        }
+        else if (GST_EVENT_TYPE(event) == GST_EVENT_EOS)
+        {
+            // No more crops are coming, release all the main frames in flight.
+            {
+                std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+                hailoaggregator->eos_sub = true;
+            }
+            hailoaggregator->cv_main.notify_all();
+            hailoaggregator->cv_sub.notify_all();
+        }
+        gst_hailoaggregator_release_ready_frames(hailoaggregator);
+    }
+
     if (GST_EVENT_IS_STICKY(event))
     {
         unlock = TRUE;
@@ -247,14 +311,15 @@ gst_hailoaggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
 
         if (GST_EVENT_TYPE(event) == GST_EVENT_EOS)
         {
-            GST_OBJECT_LOCK(hailoaggregator);
-            gst_hailoaggregator_update_eos(hailoaggregator, pad, true);
+            {
+                std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+                gst_hailoaggregator_update_eos(hailoaggregator, pad, true);
+                forward = gst_hailoaggregator_all_sinkpads_eos_unlocked(hailoaggregator);
+            }
             // Unlocking both condition variables in order to finish the chain function.
             // After that the pads can be freed by the change_state of base class.
             hailoaggregator->cv_main.notify_all();
             hailoaggregator->cv_sub.notify_all();
-            forward = gst_hailoaggregator_all_sinkpads_eos_unlocked(hailoaggregator);
-            GST_OBJECT_UNLOCK(hailoaggregator);
         }
         else if (pad != hailoaggregator->sinkpad_main)
         {
@@ -265,9 +330,11 @@ gst_hailoaggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
     {
         unlock = TRUE;
         GST_PAD_STREAM_LOCK(hailoaggregator->srcpad);
-        GST_OBJECT_LOCK(hailoaggregator);
+        std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
         gst_hailoaggregator_update_eos(hailoaggregator, pad, false);
-        GST_OBJECT_UNLOCK(hailoaggregator);
+        gst_hailoaggregator_drop_pending_frames_unlocked(hailoaggregator);
+        hailoaggregator->flushing = false;
+        hailoaggregator->last_flow_return = GST_FLOW_OK;
     }
 
     if (forward && GST_EVENT_IS_SERIALIZED(event))
@@ -303,70 +370,149 @@ gst_hailoaggregator_chain_sub(GstPad *pad, GstObject *parent, GstBuffer *buf)
 {
     GstHailoAggregator *hailoaggregator = GST_HAILO_AGGREGATOR_CAST(parent);
     GstHailoAggregatorClass *hailoaggregator_class = GST_HAILO_AGGREGATOR_GET_CLASS(hailoaggregator);
+    bool frame_completed = false;
 
     std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
 
-    // Wait until main frame is not null & the offset of main frame is not smaller.
-    if (hailoaggregator->mainframe == NULL || hailoaggregator->mainframe->offset < buf->offset)
-    {
-        hailoaggregator->cv_sub.wait(lock);
-    }
+    // Wait until the main frame this sub frame was cropped from arrives.
+    hailoaggregator->cv_sub.wait(lock, [hailoaggregator, buf]
+                                 { return hailoaggregator->flushing || hailoaggregator->eos_main ||
+                                          hailoaggregator->pending_frames.count(buf->offset) != 0; });
 
-    if (hailoaggregator->mainframe != NULL)
+    auto frame = hailoaggregator->pending_frames.find(buf->offset);
+    if (frame != hailoaggregator->pending_frames.end())
     {
         HailoROIPtr sub_buffer_roi = get_hailo_main_roi(buf);
+        hailoaggregator->mainframe = frame->second.buffer;
         hailoaggregator_class->handle_sub_frame_roi(hailoaggregator, sub_buffer_roi);
+        hailoaggregator->mainframe = NULL;
 
         // Increase the number of received frames.
-        hailoaggregator->num_of_frames++;
-        if (hailoaggregator->num_of_frames >= hailoaggregator->expected_frames)
-        {
-            // Release the mutex in the main chain if all the frames received.
-            hailoaggregator->cv_main.notify_one();
-            hailoaggregator->num_of_frames = 0;
-        }
+        frame->second.num_of_frames++;
+        frame_completed = frame->second.num_of_frames >= frame->second.expected_frames;
+    }
+    else
+    {
+        GST_DEBUG_OBJECT(hailoaggregator, "No main frame with offset %" G_GUINT64_FORMAT " for sub frame, dropping it", buf->offset);
     }
+    lock.unlock();
 
     gst_buffer_remove_hailo_meta(buf);
     gst_buffer_unref(buf);
+
+    if (frame_completed)
+    {
+        // With a single frame in flight the main thread pushes it, otherwise push the main frames that are done,
+        // this one may be next in line.
+        hailoaggregator->cv_main.notify_all();
+        if (hailoaggregator->max_inflight_frames > 1)
+            gst_hailoaggregator_release_ready_frames(hailoaggregator);
+    }
+
     return GST_FLOW_OK;
 }
 
 static GstFlowReturn
 gst_hailoaggregator_chain_main(GstPad *pad, GstObject *parent, GstBuffer *buf)
 {
-    GstFlowReturn ret = GST_FLOW_ERROR;
     GstHailoAggregator *hailoaggregator = GST_HAILO_AGGREGATOR_CAST(parent);
-    GstHailoAggregatorClass *hailoaggregator_class = GST_HAILO_AGGREGATOR_GET_CLASS(hailoaggregator);
     std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
+    guint64 offset = buf->offset;
+
+    // Wait for room in the in-flight window. A frame with the same offset can't be told apart from this one,
+    // so it has to be released first.
+    hailoaggregator->cv_main.wait(lock, [hailoaggregator, offset]
+                                  { return hailoaggregator->flushing ||
+                                           (hailoaggregator->pending_frames.size() < hailoaggregator->max_inflight_frames &&
+                                            hailoaggregator->pending_frames.count(offset) == 0); });
+    if (hailoaggregator->flushing)
+    {
+        lock.unlock();
+        gst_buffer_unref(buf);
+        return GST_FLOW_FLUSHING;
+    }
 
-    // Get excpected frames from the main frame ROI
-    HailoROIPtr hailo_roi = get_hailo_main_roi(buf);
-
-    hailoaggregator->expected_frames = gst_buffer_get_hailo_cropping_meta(buf)->num_of_crops;
+    // Get excpected frames from the cropping meta of the main frame
+    HailoAggregatorFrame frame = {buf, gst_buffer_get_hailo_cropping_meta(buf)->num_of_crops, 0};
+    hailoaggregator->pending_frames[offset] = frame;
+    hailoaggregator->pending_order.push_back(offset);
+    lock.unlock();
+    hailoaggregator->cv_sub.notify_all();
 
-    if (hailoaggregator->expected_frames != 0 && !hailoaggregator->eos_sub)
+    if (hailoaggregator->max_inflight_frames == 1)
     {
-        hailoaggregator->mainframe = buf;
-        hailoaggregator->cv_sub.notify_one();
-        hailoaggregator->cv_main.wait(lock);
-        hailoaggregator->mainframe = NULL;
+        // A single frame in flight, block until all of its crops arrived and push it from this thread.
+        lock.lock();
+        hailoaggregator->cv_main.wait(lock, [hailoaggregator, offset]
+                                      {
+                                          auto pending = hailoaggregator->pending_frames.find(offset);
+                                          return hailoaggregator->flushing || hailoaggregator->eos_sub ||
+                                                 pending == hailoaggregator->pending_frames.end() ||
+                                                 pending->second.num_of_frames >= pending->second.expected_frames; });
+        lock.unlock();
     }
-    lock.unlock();
 
-    
-    hailoaggregator_class->handle_main_roi_post_aggregation(hailoaggregator, hailo_roi);
+    gst_hailoaggregator_release_ready_frames(hailoaggregator);
 
-    gst_pad_sticky_events_foreach(hailoaggregator->sinkpad_main, forward_events, hailoaggregator->srcpad);
+    // Report downstream flow errors upstream, even if they happened while pushing from the sub frames thread.
+    lock.lock();
+    if (hailoaggregator->flushing)
+        return GST_FLOW_FLUSHING;
+    return hailoaggregator->last_flow_return;
+}
+
+/**
+ * Pushes downstream the main frames at the head of the in-flight window that are done aggregating.
+ * Frames are done when all their crops arrived, or when no more crops will arrive (sub pad got eos).
+ * May be called from both the main and the sub frames threads. Frames are pushed under the srcpad stream lock,
+ * so they stay in arrival order and are serialized with the events sent downstream.
+ *
+ * @param[in] hailoaggregator   GstHailoAggregator.
+ * @return GstFlowReturn of the last push.
+ */
+static GstFlowReturn
+gst_hailoaggregator_release_ready_frames(GstHailoAggregator *hailoaggregator)
+{
+    GstHailoAggregatorClass *hailoaggregator_class = GST_HAILO_AGGREGATOR_GET_CLASS(hailoaggregator);
+    GstFlowReturn ret = GST_FLOW_OK;
 
-    // Remove the cropping meta from the main frame.
-    if (! gst_buffer_remove_hailo_cropping_meta(buf))
+    GST_PAD_STREAM_LOCK(hailoaggregator->srcpad);
+    while (true)
     {
-        GST_ERROR_OBJECT(hailoaggregator, "Failed to remove cropping meta from main frame");
-    }
+        GstBuffer *buf = NULL;
+        {
+            std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+            if (hailoaggregator->pending_order.empty())
+                break;
+            auto frame = hailoaggregator->pending_frames.find(hailoaggregator->pending_order.front());
+            if (hailoaggregator->flushing ||
+                (!hailoaggregator->eos_sub && frame->second.num_of_frames < frame->second.expected_frames))
+                break;
+            buf = frame->second.buffer;
+            hailoaggregator->pending_frames.erase(frame);
+            hailoaggregator->pending_order.erase(hailoaggregator->pending_order.begin());
+        }
+        // A slot in the window was freed. Waiters take the srcpad stream lock before pushing anything,
+        // so they can't overtake this frame.
+        hailoaggregator->cv_main.notify_all();
+
+        HailoROIPtr hailo_roi = get_hailo_main_roi(buf);
+        hailoaggregator_class->handle_main_roi_post_aggregation(hailoaggregator, hailo_roi);
+
+        gst_pad_sticky_events_foreach(hailoaggregator->sinkpad_main, forward_events, hailoaggregator->srcpad);
 
-    // Push main buffer into the src pad.
-    ret = gst_pad_push(hailoaggregator->srcpad, buf);
+        // Remove the cropping meta from the main frame.
+        if (!gst_buffer_remove_hailo_cropping_meta(buf))
+        {
+            GST_ERROR_OBJECT(hailoaggregator, "Failed to remove cropping meta from main frame");
+        }
+
+        // Push main buffer into the src pad.
+        ret = gst_pad_push(hailoaggregator->srcpad, buf);
+        std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+        hailoaggregator->last_flow_return = ret;
+    }
+    GST_PAD_STREAM_UNLOCK(hailoaggregator->srcpad);
     return ret;
 }
 
@@ -409,10 +555,21 @@ gst_hailoaggregator_change_state(GstElement *element, GstStateChange transition)
     GstHailoAggregator *aggregator = GST_HAILO_AGGREGATOR(element);
     switch (transition)
     {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    {
+        std::lock_guard<std::mutex> lock(aggregator->mutex);
+        aggregator->flushing = false;
+        aggregator->last_flow_return = GST_FLOW_OK;
+        break;
+    }
     case GST_STATE_CHANGE_PAUSED_TO_READY:
     {
         // Unlocking both condition variables in order to finish the chain function.
         // After that the pads can be freed by the change_state of base class.
+        {
+            std::lock_guard<std::mutex> lock(aggregator->mutex);
+            aggregator->flushing = true;
+        }
         aggregator->cv_main.notify_all();
         aggregator->cv_sub.notify_all();
         break;
@@ -426,5 +583,12 @@ gst_hailoaggregator_change_state(GstElement *element, GstStateChange transition)
     if (ret == GST_STATE_CHANGE_FAILURE)
         return ret;
 
+    if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    {
+        // Drop main frames that never finished aggregating.
+        std::lock_guard<std::mutex> lock(aggregator->mutex);
+        gst_hailoaggregator_drop_pending_frames_unlocked(aggregator);
+    }
+
     return ret;
 }
@@ -10,6 +10,8 @@
 
 #pragma once
 #include <gst/gst.h>
+#include <map>
+#include <vector>
 #include <mutex>
 #include <condition_variable>
 
@@ -34,6 +36,16 @@ G_BEGIN_DECLS
 typedef struct _GstHailoAggregator GstHailoAggregator;
 typedef struct _GstHailoAggregatorClass GstHailoAggregatorClass;
 
+/**
+ * A main frame waiting for its sub frames (crops) to be aggregated.
+ */
+struct HailoAggregatorFrame
+{
+    GstBuffer *buffer;
+    uint expected_frames;
+    uint num_of_frames;
+};
+
 struct _GstHailoAggregator
 {
     GstElement element;
@@ -41,15 +53,20 @@ struct _GstHailoAggregator
     GstPad *srcpad;
 
     GstPad *sinkpad_main;
-    bool eos_main;
+    bool eos_main; // Guarded by mutex.
     GstPad *sinkpad_sub;
-    bool eos_sub;
-    GstBuffer *mainframe;
-    uint num_of_frames;
-    uint expected_frames;
-    uint last_offset;
+    bool eos_sub; // Guarded by mutex.
+    GstBuffer *mainframe; // The main frame the current sub frame is aggregated into.
     gboolean flatten_detections;
+    uint max_inflight_frames;
+    bool flushing;
+    GstFlowReturn last_flow_return;
+
+    // Main frames in flight, keyed by buffer offset. Released downstream in arrival order.
+    std::map<guint64, HailoAggregatorFrame> pending_frames;
+    std::vector<guint64> pending_order;
 
+    // Guards the frames in flight, the eos flags and flushing. Main frames are pushed under the srcpad stream lock.
     std::mutex mutex;
     std::condition_variable cv_main;
     std::condition_variable cv_sub;
@@ -27,6 +27,9 @@
 GST_DEBUG_CATEGORY_STATIC(gst_hailo_basecropper_debug);
 #define GST_CAT_DEFAULT gst_hailo_basecropper_debug
 
+#define DEFAULT_CROP_THREADS 1
+#define MAX_CROP_THREADS 16
+
 enum
 {
     PROP_0,
@@ -34,6 +37,8 @@ enum
     PROP_DROP_UNCROPPED_BUFFERS,
     PROP_CROPPING_PERIOD,
     PROP_FILTER_STREAMS,
+    PROP_CROP_THREADS,
+    PROP_CROP_TIME,
 #ifdef HAILO15_TARGET
     PROP_USE_DSP,
     PROP_POOL_SIZE,
@@ -120,6 +125,16 @@ gst_hailo_basecropper_class_init(GstHailoBaseCropperClass *klass)
                                                                              "Filter stream", "",
                                                                              (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)),
                                                          (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PROP_CROP_THREADS,
+                                    g_param_spec_uint("crop-threads", "Crop Threads",
+                                                      "Number of threads used to crop and resize the ROIs of a frame. Crops are still pushed in their original order. Default 1 (crop on the streaming thread)",
+                                                      1, MAX_CROP_THREADS, DEFAULT_CROP_THREADS,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_CROP_TIME,
+                                    g_param_spec_uint64("crop-time", "Crop Time",
+                                                        "Time in microseconds spent cropping and resizing all the ROIs of the last frame",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 
 #ifdef HAILO15_TARGET
     g_object_class_install_property(gobject_class, PROP_USE_DSP,
@@ -176,6 +191,9 @@ gst_hailo_basecropper_init(GstHailoBaseCropper *hailo_basecropper)
     hailo_basecropper->drop_uncropped_buffers = false;
     hailo_basecropper->buffer_pool = NULL;
     hailo_basecropper->stream_ids_buff_offset.clear();
+    hailo_basecropper->crop_threads = DEFAULT_CROP_THREADS;
+    hailo_basecropper->crop_pool = nullptr;
+    hailo_basecropper->crop_time = 0;
     for (uint i = 0; i < GST_HAILO_CROPPER_MAX_FILTER_STREAMS; i++)
         hailo_basecropper->filter_streams[i] = "";
 }
@@ -204,6 +222,7 @@ static void gst_hailo_basecropper_dispose(GObject *object)
         gst_object_unref(hailo_basecropper->buffer_pool);
         hailo_basecropper->buffer_pool = NULL;
     }
+    hailo_basecropper->crop_pool.reset();
 
     G_OBJECT_CLASS(gst_hailo_basecropper_parent_class)->dispose(object);
 }
@@ -302,6 +321,9 @@ gst_hailo_basecropper_set_property(GObject *object, guint prop_id,
     case PROP_FILTER_STREAMS:
         set_filter_streams(hailo_basecropper, value);
         break;
+    case PROP_CROP_THREADS:
+        hailo_basecropper->crop_threads = g_value_get_uint(value);
+        break;
 #ifdef HAILO15_TARGET
     case PROP_USE_DSP:
         hailo_basecropper->use_dsp = g_value_get_boolean(value);
@@ -336,6 +358,14 @@ gst_hailo_basecropper_get_property(GObject *object, guint prop_id,
     case PROP_FILTER_STREAMS:
         get_filter_streams(hailo_basecropper, value);
         break;
+    case PROP_CROP_THREADS:
+        g_value_set_uint(value, hailo_basecropper->crop_threads);
+        break;
+    case PROP_CROP_TIME:
+        GST_OBJECT_LOCK(hailo_basecropper);
+        g_value_set_uint64(value, hailo_basecropper->crop_time);
+        GST_OBJECT_UNLOCK(hailo_basecropper);
+        break;
 #ifdef HAILO15_TARGET
     case PROP_USE_DSP:
         g_value_set_boolean(value, hailo_basecropper->use_dsp);
@@ -821,14 +851,14 @@ static GstBuffer *handle_one_crop(GstHailoBaseCropper *hailo_basecropper, GstBuf
 }
 
 /**
- * Creates new crop buffers from given HailoROIs
+ * Creates new crop buffers from given HailoROIs one by one, pushing each crop as soon as it is ready.
  *
  * @param[in] hailo_basecropper      cropping element.
  * @param[in] buf               Buffer to crop.
  * @param[in] crop_rois        Vector of HailoROI of buf to crop from.
  * @return boolean, whether all cropping were successful.
  */
-static gboolean handle_crops(GstHailoBaseCropper *hailo_basecropper, GstBuffer *buf, std::vector<HailoROIPtr> &crop_rois)
+static gboolean handle_crops_serial(GstHailoBaseCropper *hailo_basecropper, GstBuffer *buf, std::vector<HailoROIPtr> &crop_rois)
 {
     for (HailoROIPtr &crop_roi : crop_rois)
     {
@@ -851,6 +881,90 @@ static gboolean handle_crops(GstHailoBaseCropper *hailo_basecropper, GstBuffer *
     return TRUE;
 }
 
+/**
+ * Crops and resizes all the ROIs of a frame on the crop thread pool, then pushes the crops in their original order.
+ *
+ * @param[in] hailo_basecropper      cropping element.
+ * @param[in] buf               Buffer to crop.
+ * @param[in] crop_rois        Vector of HailoROI of buf to crop from.
+ * @return boolean, whether all cropping were successful.
+ */
+static gboolean handle_crops_parallel(GstHailoBaseCropper *hailo_basecropper, GstBuffer *buf, std::vector<HailoROIPtr> &crop_rois)
+{
+    if (!gst_pad_is_active(hailo_basecropper->srcpad_crop))
+    {
+        GST_INFO_OBJECT(hailo_basecropper, "Crop src pad is not active, dropping buffer");
+        return TRUE;
+    }
+
+    std::vector<GstBuffer *> crop_buffers(crop_rois.size(), NULL);
+    hailo_basecropper->crop_pool->parallel_for(crop_rois.size(), [hailo_basecropper, buf, &crop_rois, &crop_buffers](size_t i)
+                                               { crop_buffers[i] = handle_one_crop(hailo_basecropper, buf, crop_rois[i]); });
+
+    gboolean ret = TRUE;
+    for (GstBuffer *newbuf : crop_buffers)
+    {
+        if (!ret || !newbuf || !gst_pad_is_active(hailo_basecropper->srcpad_crop))
+        {
+            // Once a crop failed or the pad went down, release the crops that won't be pushed.
+            if (!newbuf)
+            {
+                GST_WARNING_OBJECT(hailo_basecropper, "Could not crop buffer with offset %jd", buf->offset);
+                ret = FALSE;
+            }
+            else
+            {
+                gst_buffer_unref(newbuf);
+            }
+            continue;
+        }
+        newbuf->offset = buf->offset;
+
+        // Push the cropped buffer into the crop src pad.
+        gst_pad_push(hailo_basecropper->srcpad_crop, newbuf);
+    }
+    return ret;
+}
+
+/**
+ * Creates new crop buffers from given HailoROIs
+ *
+ * @param[in] hailo_basecropper      cropping element.
+ * @param[in] buf               Buffer to crop.
+ * @param[in] crop_rois        Vector of HailoROI of buf to crop from.
+ * @return boolean, whether all cropping were successful.
+ */
+static gboolean handle_crops(GstHailoBaseCropper *hailo_basecropper, GstBuffer *buf, std::vector<HailoROIPtr> &crop_rois)
+{
+    gint64 start_time = g_get_monotonic_time();
+    gboolean ret;
+    bool use_pool = hailo_basecropper->crop_threads > 1 && crop_rois.size() > 1;
+#ifdef HAILO15_TARGET
+    // The DSP serializes crops on its own.
+    use_pool = use_pool && !hailo_basecropper->use_dsp;
+#endif
+
+    if (use_pool)
+    {
+        // The calling thread takes part in the work, so the pool holds one thread less than requested.
+        if (!hailo_basecropper->crop_pool || hailo_basecropper->crop_pool->size() != hailo_basecropper->crop_threads - 1)
+            hailo_basecropper->crop_pool = std::make_unique<HailoThreadPool>(hailo_basecropper->crop_threads - 1);
+        ret = handle_crops_parallel(hailo_basecropper, buf, crop_rois);
+    }
+    else
+    {
+        ret = handle_crops_serial(hailo_basecropper, buf, crop_rois);
+    }
+
+    guint64 crop_time = g_get_monotonic_time() - start_time;
+    GST_OBJECT_LOCK(hailo_basecropper);
+    hailo_basecropper->crop_time = crop_time;
+    GST_OBJECT_UNLOCK(hailo_basecropper);
+    GST_DEBUG_OBJECT(hailo_basecropper, "Cropped %zu ROIs of buffer with offset %jd in %" G_GUINT64_FORMAT " us",
+                     crop_rois.size(), buf->offset, crop_time);
+    return ret;
+}
+
 uint filter_streams_have_name(GstHailoBaseCropper *hailo_basecropper, const gchar *name)
 {
     for (uint i = 0; i < hailo_basecropper->num_streams_to_filter; ++i)
@@ -978,7 +1092,7 @@ void resize_normal(cv::InterpolationFlags method,
 
 /**
  * @brief Resize the an image using Letterbox strategy
- *        Supports RGB/BGR
+ *        Supports RGB/BGR, RGBA, NV12, and YUY2
  *
  * @param method - cv::InterpolationFlags
  *        The interpulation to use.
@@ -1011,6 +1125,14 @@ void resize_letterbox(cv::InterpolationFlags method,
             roi->set_scaling_bbox(letterboxed_scale);
         break;
     }
+    case GST_VIDEO_FORMAT_YUY2:
+    {
+        static const cv::Scalar color(114, 114, 114);
+        HailoBBox letterboxed_scale = resize_letterbox_yuy2(cropped_image_vec[0], resized_image_vec[0], color, method);
+        if (!no_scaling_bbox)
+            roi->set_scaling_bbox(letterboxed_scale);
+        break;
+    }
     case GST_VIDEO_FORMAT_RGBA:
     case GST_VIDEO_FORMAT_RGB:
     {
@@ -1022,7 +1144,7 @@ void resize_letterbox(cv::InterpolationFlags method,
     }
     default:
     {
-        std::cerr << "Letterbox resizing is supported only for RGB at this moment." << std::endl;
+        std::cerr << "Letterbox resizing is supported only for RGB, RGBA, NV12 and YUY2 at this moment." << std::endl;
         break;
     }
     }
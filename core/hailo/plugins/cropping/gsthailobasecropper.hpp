@@ -8,6 +8,7 @@
 #include <gst/video/video-format.h>
 #include <opencv2/opencv.hpp>
 #include "hailo_objects.hpp"
+#include "hailo_thread_pool.hpp"
 
 G_BEGIN_DECLS
 
@@ -45,6 +46,9 @@ struct _GstHailoBaseCropper
     GstPad *sinkpad, *srcpad_crop, *srcpad_main;
     std::map<std::string, int> stream_ids_buff_offset;
     const gchar *filter_streams[GST_HAILO_CROPPER_MAX_FILTER_STREAMS];
+    uint crop_threads;
+    std::unique_ptr<HailoThreadPool> crop_pool;
+    guint64 crop_time; // Time (us) spent cropping the last frame.
 };
 
 struct _GstHailoBaseCropperClass
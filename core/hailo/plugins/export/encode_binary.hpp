@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+// General cpp includes
+#include <string>
+#include <vector>
+
+// Tappas includes
+#include "hailo_objects.hpp"
+#include "hailo_common.hpp"
+#include "common/binary_meta.hpp"
+
+namespace encode_binary
+{
+    void encode_bbox(binary_meta::Writer &writer, HailoBBox bbox);
+    void encode_detection(binary_meta::Writer &writer, HailoDetectionPtr detection);
+    void encode_classification(binary_meta::Writer &writer, HailoClassificationPtr classification);
+    void encode_landmarks(binary_meta::Writer &writer, HailoLandmarksPtr landmarks);
+    void encode_tile(binary_meta::Writer &writer, HailoTileROIPtr tile);
+    void encode_unique_id(binary_meta::Writer &writer, HailoUniqueIDPtr id);
+    void encode_mask(binary_meta::Writer &writer, HailoMaskPtr mask);
+    void encode_depth_mask(binary_meta::Writer &writer, HailoDepthMaskPtr mask);
+    void encode_class_mask(binary_meta::Writer &writer, HailoClassMaskPtr mask);
+    void encode_conf_class_mask(binary_meta::Writer &writer, HailoConfClassMaskPtr mask);
+    void encode_matrix(binary_meta::Writer &writer, HailoMatrixPtr matrix);
+    void encode_hailo_objects(binary_meta::Writer &writer, HailoROIPtr roi);
+}
+
+namespace encode_binary
+{
+    inline void encode_bbox(binary_meta::Writer &writer, HailoBBox bbox)
+    {
+        writer.write<float>(bbox.xmin());
+        writer.write<float>(bbox.ymin());
+        writer.write<float>(bbox.width());
+        writer.write<float>(bbox.height());
+    }
+
+    inline void encode_detection(binary_meta::Writer &writer, HailoDetectionPtr detection)
+    {
+        encode_bbox(writer, detection->get_bbox());
+        writer.write<int32_t>(detection->get_class_id());
+        writer.write<float>(detection->get_confidence());
+        writer.write_string(detection->get_label());
+
+        // Recurse this object
+        encode_hailo_objects(writer, detection);
+    }
+
+    inline void encode_classification(binary_meta::Writer &writer, HailoClassificationPtr classification)
+    {
+        writer.write_string(classification->get_classification_type());
+        writer.write<int32_t>(classification->get_class_id());
+        writer.write<float>(classification->get_confidence());
+        writer.write_string(classification->get_label());
+    }
+
+    inline void encode_landmarks(binary_meta::Writer &writer, HailoLandmarksPtr landmarks)
+    {
+        writer.write_string(landmarks->get_landmarks_type());
+        writer.write<float>(landmarks->get_threshold());
+
+        std::vector<HailoPoint> points = landmarks->get_points();
+        writer.write<uint32_t>(points.size());
+        for (auto &point : points)
+        {
+            writer.write<float>(point.x());
+            writer.write<float>(point.y());
+            writer.write<float>(point.confidence());
+        }
+
+        std::vector<std::pair<int, int>> pairs = landmarks->get_pairs();
+        writer.write<uint32_t>(pairs.size());
+        for (auto &pair : pairs)
+        {
+            writer.write<int32_t>(pair.first);
+            writer.write<int32_t>(pair.second);
+        }
+    }
+
+    inline void encode_tile(binary_meta::Writer &writer, HailoTileROIPtr tile)
+    {
+        encode_bbox(writer, tile->get_bbox());
+        writer.write<uint32_t>(tile->get_index());
+        writer.write<float>(tile->get_overlap_x_axis());
+        writer.write<float>(tile->get_overlap_y_axis());
+        writer.write<uint32_t>(tile->get_layer());
+        writer.write<uint32_t>(tile->get_mode());
+
+        // Recurse this object
+        encode_hailo_objects(writer, tile);
+    }
+
+    inline void encode_unique_id(binary_meta::Writer &writer, HailoUniqueIDPtr id)
+    {
+        writer.write<int32_t>(id->get_id());
+        writer.write<int32_t>(id->get_mode());
+    }
+
+    inline void encode_mask(binary_meta::Writer &writer, HailoMaskPtr mask)
+    {
+        writer.write<int32_t>(mask->get_width());
+        writer.write<int32_t>(mask->get_height());
+        writer.write<float>(mask->get_transparency());
+    }
+
+    inline void encode_depth_mask(binary_meta::Writer &writer, HailoDepthMaskPtr mask)
+    {
+        encode_mask(writer, mask);
+        writer.write_array(mask->get_data());
+    }
+
+    inline void encode_class_mask(binary_meta::Writer &writer, HailoClassMaskPtr mask)
+    {
+        encode_mask(writer, mask);
+        writer.write_array(mask->get_data());
+    }
+
+    inline void encode_conf_class_mask(binary_meta::Writer &writer, HailoConfClassMaskPtr mask)
+    {
+        encode_mask(writer, mask);
+        writer.write<int32_t>(mask->get_class_id());
+        writer.write_array(mask->get_data());
+    }
+
+    inline void encode_matrix(binary_meta::Writer &writer, HailoMatrixPtr matrix)
+    {
+        writer.write<uint32_t>(matrix->height());
+        writer.write<uint32_t>(matrix->width());
+        writer.write<uint32_t>(matrix->features());
+        writer.write_array(matrix->get_data());
+    }
+
+    /**
+     * @brief Encode the sub objects of an roi as a count followed by tagged objects.
+     *        Objects without a binary encoding (e.g. HailoUserMeta) are not written.
+     */
+    inline void encode_hailo_objects(binary_meta::Writer &writer, HailoROIPtr roi)
+    {
+        size_t count_offset = writer.reserve_u32();
+        uint32_t count = 0;
+        for (auto obj : roi->get_objects())
+        {
+            hailo_object_t type = obj->get_type();
+            switch (type)
+            {
+            case HAILO_DETECTION:
+            case HAILO_CLASSIFICATION:
+            case HAILO_LANDMARKS:
+            case HAILO_TILE:
+            case HAILO_UNIQUE_ID:
+            case HAILO_DEPTH_MASK:
+            case HAILO_CLASS_MASK:
+            case HAILO_CONF_CLASS_MASK:
+            case HAILO_MATRIX:
+                break;
+            default:
+                // continue
+                continue;
+            }
+
+            writer.write<uint8_t>(type);
+            size_t size_offset = writer.reserve_u32();
+            size_t payload_start = writer.size();
+            switch (type)
+            {
+            case HAILO_DETECTION:
+                encode_detection(writer, std::dynamic_pointer_cast<HailoDetection>(obj));
+                break;
+            case HAILO_CLASSIFICATION:
+                encode_classification(writer, std::dynamic_pointer_cast<HailoClassification>(obj));
+                break;
+            case HAILO_LANDMARKS:
+                encode_landmarks(writer, std::dynamic_pointer_cast<HailoLandmarks>(obj));
+                break;
+            case HAILO_TILE:
+                encode_tile(writer, std::dynamic_pointer_cast<HailoTileROI>(obj));
+                break;
+            case HAILO_UNIQUE_ID:
+                encode_unique_id(writer, std::dynamic_pointer_cast<HailoUniqueID>(obj));
+                break;
+            case HAILO_DEPTH_MASK:
+                encode_depth_mask(writer, std::dynamic_pointer_cast<HailoDepthMask>(obj));
+                break;
+            case HAILO_CLASS_MASK:
+                encode_class_mask(writer, std::dynamic_pointer_cast<HailoClassMask>(obj));
+                break;
+            case HAILO_CONF_CLASS_MASK:
+                encode_conf_class_mask(writer, std::dynamic_pointer_cast<HailoConfClassMask>(obj));
+                break;
+            case HAILO_MATRIX:
+                encode_matrix(writer, std::dynamic_pointer_cast<HailoMatrix>(obj));
+                break;
+            default:
+                break;
+            }
+            writer.patch_u32(size_offset, writer.size() - payload_start);
+            count++;
+        }
+        writer.patch_u32(count_offset, count);
+    }
+
+    /**
+     * @brief Encode a whole message: the header and the roi with all its sub objects.
+     *
+     * @param buffer The vector to append the message to.
+     * @param roi The roi to encode.
+     * @param buffer_offset The offset of the buffer the roi belongs to.
+     * @param timestamp Timestamp of the message in milliseconds.
+     * @param stream_id The stream id of the roi.
+     */
+    inline void encode_hailo_roi(std::vector<uint8_t> &buffer, HailoROIPtr roi, uint64_t buffer_offset, int64_t timestamp, const std::string &stream_id)
+    {
+        binary_meta::Writer writer(buffer);
+        size_t message_start = writer.size();
+        writer.write<uint32_t>(binary_meta::MAGIC);
+        writer.write<uint16_t>(binary_meta::VERSION);
+        writer.write<uint16_t>(0);
+        size_t size_offset = writer.reserve_u32();
+        writer.write<uint64_t>(buffer_offset);
+        writer.write<int64_t>(timestamp);
+        writer.write_string(stream_id);
+
+        encode_bbox(writer, roi->get_bbox());
+        encode_hailo_objects(writer, roi);
+        writer.patch_u32(size_offset, writer.size() - message_start);
+    }
+
+}
@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+// General cpp includes
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tappas includes
+#include "hailo_spsc_queue.hpp"
+
+// Open source includes
+#define RAPIDJSON_HAS_STDSTRING 1
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+/**
+ * @brief An encoded buffer waiting to be written, either a JSON document or a binary message.
+ */
+struct HailoExportFileEntry
+{
+    rapidjson::Document json;
+    std::vector<uint8_t> binary;
+    bool is_binary = false;
+};
+
+/**
+ * @brief Writes the entries of hailoexportfile from a background thread.
+ *        The streaming thread only moves entries into a bounded lock-free queue, it never waits for the disk:
+ *        when the queue is full the entry is dropped and counted. The writer thread drains everything that
+ *        is queued, serializes JSON documents as compact lines (NDJSON), writes the batch with a single
+ *        fwrite, and rotates the file by size and/or time.
+ */
+class HailoExportFileWriter
+{
+private:
+    static constexpr std::chrono::milliseconds IDLE_WAKEUP{100};
+
+    HailoSPSCQueue<HailoExportFileEntry> m_queue;
+    HailoExportFileEntry m_next; // Filled by the streaming thread before push
+    std::string m_location;
+    uint64_t m_max_file_size;
+    std::chrono::seconds m_rotation_interval;
+
+    FILE *m_file = nullptr;
+    uint64_t m_file_size = 0;
+    uint32_t m_file_index = 0;
+    std::chrono::steady_clock::time_point m_file_opened;
+
+    std::thread m_thread;
+    std::mutex m_mutex; // Only guards the sleep of the writer thread
+    std::condition_variable m_cv;
+    std::atomic<bool> m_stop{false};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_write_errors{0};
+
+    std::string file_name(uint32_t index) const
+    {
+        return (index == 0) ? m_location : m_location + "." + std::to_string(index);
+    }
+
+    bool open_file()
+    {
+        m_file = fopen(file_name(m_file_index).c_str(), "wb");
+        m_file_size = 0;
+        m_file_opened = std::chrono::steady_clock::now();
+        return m_file != nullptr;
+    }
+
+    void rotate_if_needed()
+    {
+        bool too_big = (m_max_file_size > 0) && (m_file_size >= m_max_file_size);
+        bool too_old = (m_rotation_interval.count() > 0) && (m_file_size > 0) &&
+                       (std::chrono::steady_clock::now() - m_file_opened >= m_rotation_interval);
+        if (!too_big && !too_old)
+            return;
+
+        fclose(m_file);
+        m_file_index++;
+        if (!open_file())
+            m_write_errors++;
+    }
+
+    void write_batch(const void *data, size_t size)
+    {
+        if (size == 0 || m_file == nullptr)
+            return;
+        if (fwrite(data, 1, size, m_file) != size)
+            m_write_errors++;
+        m_file_size += size;
+    }
+
+    /**
+     * @brief Write all the queued entries, rotating between entries when the file is full.
+     */
+    void drain(HailoExportFileEntry &entry, rapidjson::StringBuffer &batch)
+    {
+        while (m_queue.pop(entry))
+        {
+            if (entry.is_binary)
+            {
+                // Binary messages are written as is, flush pending json lines first to keep the order
+                write_batch(batch.GetString(), batch.GetSize());
+                batch.Clear();
+                write_batch(entry.binary.data(), entry.binary.size());
+            }
+            else
+            {
+                rapidjson::Writer<rapidjson::StringBuffer> writer(batch);
+                entry.json.Accept(writer);
+                batch.Put('\n');
+            }
+
+            if (m_max_file_size > 0 && m_file_size + batch.GetSize() >= m_max_file_size)
+            {
+                write_batch(batch.GetString(), batch.GetSize());
+                batch.Clear();
+                rotate_if_needed();
+            }
+        }
+        write_batch(batch.GetString(), batch.GetSize());
+        batch.Clear();
+        if (m_file != nullptr)
+            fflush(m_file);
+    }
+
+    void writer_loop()
+    {
+        HailoExportFileEntry entry;
+        rapidjson::StringBuffer batch;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait_for(lock, IDLE_WAKEUP, [this]
+                              { return m_stop || !m_queue.empty(); });
+            }
+            bool stop = m_stop;
+            drain(entry, batch);
+            if (stop)
+                return;
+            if (m_file != nullptr)
+                rotate_if_needed();
+        }
+    }
+
+public:
+    /**
+     * @param location Path of the first file, rotated files get a ".<index>" suffix.
+     * @param queue_size Maximal number of entries waiting to be written.
+     * @param max_file_size Rotate after a file reaches this many bytes, 0 disables.
+     * @param rotation_interval Rotate after a file was open for this many seconds, 0 disables.
+     */
+    HailoExportFileWriter(std::string location, size_t queue_size, uint64_t max_file_size, uint32_t rotation_interval)
+        : m_queue(queue_size), m_location(std::move(location)), m_max_file_size(max_file_size), m_rotation_interval(rotation_interval){};
+
+    ~HailoExportFileWriter()
+    {
+        stop();
+    }
+
+    HailoExportFileWriter(const HailoExportFileWriter &) = delete;
+    HailoExportFileWriter &operator=(const HailoExportFileWriter &) = delete;
+
+    /**
+     * @brief Open the first file and start the writer thread.
+     *
+     * @return false if the file could not be opened.
+     */
+    bool start()
+    {
+        if (!open_file())
+            return false;
+        m_thread = std::thread(&HailoExportFileWriter::writer_loop, this);
+        return true;
+    }
+
+    /**
+     * @brief Write the remaining entries, stop the writer thread and close the file.
+     */
+    void stop()
+    {
+        if (m_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_one();
+            m_thread.join();
+        }
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    /**
+     * @brief The entry to fill before calling push. Streaming thread only.
+     *        It holds the buffers of an already written entry, so they are reused.
+     */
+    HailoExportFileEntry &next_entry()
+    {
+        return m_next;
+    }
+
+    /**
+     * @brief Queue the entry returned by next_entry for writing. Never blocks, streaming thread only.
+     *
+     * @return false if the queue was full and the entry was dropped.
+     */
+    bool push()
+    {
+        if (!m_queue.push(std::move(m_next)))
+        {
+            m_dropped++;
+            return false;
+        }
+        m_cv.notify_one();
+        return true;
+    }
+
+    uint64_t dropped() const
+    {
+        return m_dropped;
+    }
+
+    uint64_t write_errors() const
+    {
+        return m_write_errors;
+    }
+};
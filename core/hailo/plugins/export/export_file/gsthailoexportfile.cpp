@@ -14,9 +14,7 @@
 #include "rapidjson/document.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/error/en.h"
-#include "rapidjson/filewritestream.h"
 #include "rapidjson/writer.h"
-#include "rapidjson/prettywriter.h"
 
 GST_DEBUG_CATEGORY_STATIC(gst_hailoexportfile_debug_category);
 #define GST_CAT_DEFAULT gst_hailoexportfile_debug_category
@@ -45,8 +43,18 @@ enum
 {
     PROP_0,
     PROP_FIlE_PATH,
+    PROP_FORMAT,
+    PROP_QUEUE_SIZE,
+    PROP_MAX_FILE_SIZE,
+    PROP_ROTATION_INTERVAL,
+    PROP_DROPPED,
 };
 
+#define DEFAULT_FORMAT (HAILO_METADATA_FORMAT_JSON)
+#define DEFAULT_QUEUE_SIZE (64)
+#define DEFAULT_MAX_FILE_SIZE (0)
+#define DEFAULT_ROTATION_INTERVAL (0)
+
 static void
 gst_hailoexportfile_class_init(GstHailoExportFileClass *klass)
 {
@@ -54,9 +62,9 @@ gst_hailoexportfile_class_init(GstHailoExportFileClass *klass)
     GstBaseTransformClass *base_transform_class =
         GST_BASE_TRANSFORM_CLASS(klass);
 
-    const char *description = "Exports HailoObjects in JSON format to a file."
+    const char *description = "Exports HailoObjects in JSON or binary format to a file, from a background writer thread."
                               "\n\t\t\t   "
-                              "Encodes classes contained by HailoROI objects to JSON.";
+                              "Encodes classes contained by HailoROI objects to JSON or binary messages.";
     /* Setting up pads and setting metadata should be moved to
        base_class_init if you intend to subclass this class. */
     gst_element_class_add_pad_template(GST_ELEMENT_CLASS(klass),
@@ -78,6 +86,31 @@ gst_hailoexportfile_class_init(GstHailoExportFileClass *klass)
                                     g_param_spec_string("location", "Path to export file.",
                                                         "Location of the JSON file to save", "hailo_meta.json",
                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_FORMAT,
+                                    g_param_spec_enum("format", "File format",
+                                                      "Format of the exported file. json writes a compact JSON line per buffer (NDJSON), binary appends a length-prefixed binary message per buffer.",
+                                                      GST_TYPE_HAILO_METADATA_FORMAT, DEFAULT_FORMAT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_QUEUE_SIZE,
+                                    g_param_spec_uint("queue-size", "Queue size",
+                                                      "Number of buffers waiting for the writer thread. When the queue is full the buffer's meta is dropped instead of stalling the pipeline.",
+                                                      1, G_MAXUINT16, DEFAULT_QUEUE_SIZE,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_MAX_FILE_SIZE,
+                                    g_param_spec_uint64("max-file-size", "Max file size",
+                                                        "Start a new file (location.1, location.2, ...) once the current one reaches this many bytes. 0 disables.",
+                                                        0, G_MAXUINT64, DEFAULT_MAX_FILE_SIZE,
+                                                        (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_ROTATION_INTERVAL,
+                                    g_param_spec_uint("rotation-interval", "Rotation interval",
+                                                      "Start a new file (location.1, location.2, ...) every this many seconds. 0 disables.",
+                                                      0, G_MAXUINT, DEFAULT_ROTATION_INTERVAL,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_DROPPED,
+                                    g_param_spec_uint64("dropped", "Dropped buffers",
+                                                        "Number of buffers whose meta was dropped because the writer queue was full.",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 
     gobject_class->dispose = gst_hailoexportfile_dispose;
     gobject_class->finalize = gst_hailoexportfile_finalize;
@@ -90,6 +123,12 @@ static void
 gst_hailoexportfile_init(GstHailoExportFile *hailoexportfile)
 {
     hailoexportfile->file_path = g_strdup("hailo_meta.json");
+    hailoexportfile->format = DEFAULT_FORMAT;
+    hailoexportfile->queue_size = DEFAULT_QUEUE_SIZE;
+    hailoexportfile->max_file_size = DEFAULT_MAX_FILE_SIZE;
+    hailoexportfile->rotation_interval = DEFAULT_ROTATION_INTERVAL;
+    hailoexportfile->writer = nullptr;
+    hailoexportfile->dropped = 0;
     hailoexportfile->buffer_offset = 0;
 }
 
@@ -105,6 +144,18 @@ void gst_hailoexportfile_set_property(GObject *object, guint property_id,
     case PROP_FIlE_PATH:
         hailoexportfile->file_path = g_strdup(g_value_get_string(value));
         break;
+    case PROP_FORMAT:
+        hailoexportfile->format = (HailoMetadataFormat)g_value_get_enum(value);
+        break;
+    case PROP_QUEUE_SIZE:
+        hailoexportfile->queue_size = g_value_get_uint(value);
+        break;
+    case PROP_MAX_FILE_SIZE:
+        hailoexportfile->max_file_size = g_value_get_uint64(value);
+        break;
+    case PROP_ROTATION_INTERVAL:
+        hailoexportfile->rotation_interval = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -123,6 +174,24 @@ void gst_hailoexportfile_get_property(GObject *object, guint property_id,
     case PROP_FIlE_PATH:
         g_value_set_string(value, hailoexportfile->file_path);
         break;
+    case PROP_FORMAT:
+        g_value_set_enum(value, hailoexportfile->format);
+        break;
+    case PROP_QUEUE_SIZE:
+        g_value_set_uint(value, hailoexportfile->queue_size);
+        break;
+    case PROP_MAX_FILE_SIZE:
+        g_value_set_uint64(value, hailoexportfile->max_file_size);
+        break;
+    case PROP_ROTATION_INTERVAL:
+        g_value_set_uint(value, hailoexportfile->rotation_interval);
+        break;
+    case PROP_DROPPED:
+        // The writer is swapped by start/stop under the object lock
+        GST_OBJECT_LOCK(hailoexportfile);
+        g_value_set_uint64(value, hailoexportfile->writer ? hailoexportfile->writer->dropped() : hailoexportfile->dropped);
+        GST_OBJECT_UNLOCK(hailoexportfile);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -155,9 +224,21 @@ gst_hailoexportfile_start(GstBaseTransform *trans)
     GstHailoExportFile *hailoexportfile = GST_HAILO_EXPORT_FILE(trans);
     GST_DEBUG_OBJECT(hailoexportfile, "start");
 
-    hailoexportfile->json_file = fopen(hailoexportfile->file_path, "w");
-    fputs("[]", hailoexportfile->json_file);
-    fclose(hailoexportfile->json_file);
+    HailoExportFileWriter *writer = new HailoExportFileWriter(hailoexportfile->file_path,
+                                                              hailoexportfile->queue_size,
+                                                              hailoexportfile->max_file_size,
+                                                              hailoexportfile->rotation_interval);
+    if (!writer->start())
+    {
+        GST_ERROR_OBJECT(hailoexportfile, "hailoexportfile failed to open %s", hailoexportfile->file_path);
+        delete writer;
+        return FALSE;
+    }
+
+    GST_OBJECT_LOCK(hailoexportfile);
+    hailoexportfile->writer = writer;
+    hailoexportfile->dropped = 0;
+    GST_OBJECT_UNLOCK(hailoexportfile);
 
     return TRUE;
 }
@@ -168,6 +249,26 @@ gst_hailoexportfile_stop(GstBaseTransform *trans)
     GstHailoExportFile *hailoexportfile = GST_HAILO_EXPORT_FILE(trans);
     GST_DEBUG_OBJECT(hailoexportfile, "stop");
 
+    GST_OBJECT_LOCK(hailoexportfile);
+    HailoExportFileWriter *writer = hailoexportfile->writer;
+    hailoexportfile->writer = nullptr;
+    if (writer != nullptr)
+        hailoexportfile->dropped = writer->dropped();
+    GST_OBJECT_UNLOCK(hailoexportfile);
+
+    if (writer != nullptr)
+    {
+        // Writes the queued entries before closing the file
+        writer->stop();
+        if (writer->write_errors() > 0)
+            GST_WARNING_OBJECT(hailoexportfile, "hailoexportfile failed %" G_GUINT64_FORMAT " writes to %s",
+                               writer->write_errors(), hailoexportfile->file_path);
+        GST_OBJECT_LOCK(hailoexportfile);
+        hailoexportfile->dropped = writer->dropped();
+        GST_OBJECT_UNLOCK(hailoexportfile);
+        delete writer;
+    }
+
     return TRUE;
 }
 
@@ -177,16 +278,10 @@ gst_hailoexportfile_transform_ip(GstBaseTransform *trans,
 {
     GstHailoExportFile *hailoexportfile = GST_HAILO_EXPORT_FILE(trans);
 
-    // Get the roi from the current buffer and encode it to a JSON entry
     HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
-    rapidjson::Document encoded_roi = encode_json::encode_hailo_roi(hailo_roi);
-
-    // Add a timestamp
     auto timenow = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-    encoded_roi.AddMember("timestamp (ms)", rapidjson::Value(timenow), encoded_roi.GetAllocator());
-    encoded_roi.AddMember("buffer_offset", rapidjson::Value(hailoexportfile->buffer_offset), encoded_roi.GetAllocator());
 
-    // Add the stream-id
+    // Get the stream-id
     std::string stream_id = hailo_roi->get_stream_id();
 
     if (stream_id.length() == 0)
@@ -196,28 +291,25 @@ gst_hailoexportfile_transform_ip(GstBaseTransform *trans,
         g_free(id);
     }
 
-    encoded_roi.AddMember("stream_id", stream_id, encoded_roi.GetAllocator() );
-
-    // Open the file 
-    hailoexportfile->json_file = fopen(hailoexportfile->file_path, "rb+");
-
-    // Replace the "]" terminator with "," (if not empty)
-    if (std::getc(hailoexportfile->json_file) == '[' && std::getc(hailoexportfile->json_file) != ']') {
-        std::fseek(hailoexportfile->json_file, -1, SEEK_END);
-        std::fputc(',', hailoexportfile->json_file);
-    } else {
-        std::fseek(hailoexportfile->json_file, -1, SEEK_END);
+    // Encode the roi on the streaming thread, so the writer thread gets a snapshot of this buffer's meta
+    HailoExportFileEntry &entry = hailoexportfile->writer->next_entry();
+    entry.is_binary = (hailoexportfile->format == HAILO_METADATA_FORMAT_BINARY);
+    if (entry.is_binary)
+    {
+        entry.binary.clear();
+        encode_binary::encode_hailo_roi(entry.binary, hailo_roi, hailoexportfile->buffer_offset, timenow, stream_id);
+    }
+    else
+    {
+        entry.json = encode_json::encode_hailo_roi(hailo_roi);
+        entry.json.AddMember("timestamp (ms)", rapidjson::Value(timenow), entry.json.GetAllocator());
+        entry.json.AddMember("buffer_offset", rapidjson::Value(hailoexportfile->buffer_offset), entry.json.GetAllocator());
+        entry.json.AddMember("stream_id", stream_id, entry.json.GetAllocator());
     }
 
-    // Append the new entry to the document
-    char writeBuffer[65536];
-    rapidjson::FileWriteStream write_stream(hailoexportfile->json_file, writeBuffer, sizeof(writeBuffer));
-    rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(write_stream);
-    encoded_roi.Accept(writer);
-
-    // Close the array
-    std::fputc(']', hailoexportfile->json_file);
-    fclose(hailoexportfile->json_file);
+    // Never waits for the disk, the meta of this buffer is dropped if the writer is behind
+    if (!hailoexportfile->writer->push())
+        GST_DEBUG_OBJECT(hailoexportfile, "Writer queue is full, dropping buffer %u", hailoexportfile->buffer_offset);
 
     hailoexportfile->buffer_offset++;
     GST_DEBUG_OBJECT(hailoexportfile, "transform_ip");
@@ -7,6 +7,9 @@
 #include <gst/base/gstbasetransform.h>
 #include "hailo_objects.hpp"
 #include "export/encode_json.hpp"
+#include "export/encode_binary.hpp"
+#include "common/metadata_format.hpp"
+#include "export_file_writer.hpp"
 #include <cstdio>
 
 G_BEGIN_DECLS
@@ -24,7 +27,12 @@ struct _GstHailoExportFile
 {
     GstBaseTransform base_hailoexportfile;
     gchar *file_path;
-    FILE* json_file;
+    HailoMetadataFormat format;
+    guint queue_size;
+    guint64 max_file_size;
+    guint rotation_interval;
+    HailoExportFileWriter *writer;
+    guint64 dropped;
     uint buffer_offset;
 };
 
@@ -45,8 +45,11 @@ enum
 {
     PROP_0,
     PROP_ADDRESS,
+    PROP_FORMAT,
 };
 
+#define DEFAULT_FORMAT (HAILO_METADATA_FORMAT_JSON)
+
 static void
 gst_hailoexportzmq_class_init(GstHailoExportZMQClass *klass)
 {
@@ -54,9 +57,9 @@ gst_hailoexportzmq_class_init(GstHailoExportZMQClass *klass)
     GstBaseTransformClass *base_transform_class =
         GST_BASE_TRANSFORM_CLASS(klass);
 
-    const char *description = "Exports HailoObjects in JSON format to a ZMQ socket."
+    const char *description = "Exports HailoObjects in JSON or binary format to a ZMQ socket."
                               "\n\t\t\t   "
-                              "Encodes classes contained by HailoROI objects to JSON.";
+                              "Encodes classes contained by HailoROI objects to JSON or binary messages.";
     /* Setting up pads and setting metadata should be moved to
        base_class_init if you intend to subclass this class. */
     gst_element_class_add_pad_template(GST_ELEMENT_CLASS(klass),
@@ -78,6 +81,11 @@ gst_hailoexportzmq_class_init(GstHailoExportZMQClass *klass)
                                     g_param_spec_string("address", "Endpoint address.",
                                                         "Address to bind the socket to.", "tcp://*:5555",
                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_FORMAT,
+                                    g_param_spec_enum("format", "Message format",
+                                                      "Format of the exported messages. binary is a compact length-prefixed encoding, cheaper to encode and decode than JSON.",
+                                                      GST_TYPE_HAILO_METADATA_FORMAT, DEFAULT_FORMAT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
 
     gobject_class->dispose = gst_hailoexportzmq_dispose;
     gobject_class->finalize = gst_hailoexportzmq_finalize;
@@ -90,6 +98,7 @@ static void
 gst_hailoexportzmq_init(GstHailoExportZMQ *hailoexportzmq)
 {
     hailoexportzmq->address = g_strdup("tcp://*:5555");
+    hailoexportzmq->format = DEFAULT_FORMAT;
     hailoexportzmq->buffer_offset = 0;
 }
 
@@ -105,6 +114,9 @@ void gst_hailoexportzmq_set_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         hailoexportzmq->address = g_strdup(g_value_get_string(value));
         break;
+    case PROP_FORMAT:
+        hailoexportzmq->format = (HailoMetadataFormat)g_value_get_enum(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -123,6 +135,9 @@ void gst_hailoexportzmq_get_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         g_value_set_string(value, hailoexportzmq->address);
         break;
+    case PROP_FORMAT:
+        g_value_set_enum(value, hailoexportzmq->format);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -178,37 +193,65 @@ gst_hailoexportzmq_stop(GstBaseTransform *trans)
     return TRUE;
 }
 
-static GstFlowReturn
-gst_hailoexportzmq_transform_ip(GstBaseTransform *trans,
-                                 GstBuffer *buffer)
+static void
+gst_hailoexportzmq_free_json(void *data, void *hint)
 {
-    GstHailoExportZMQ *hailoexportzmq = GST_HAILO_EXPORT_ZMQ(trans);
+    delete static_cast<rapidjson::StringBuffer *>(hint);
+}
+
+static void
+gst_hailoexportzmq_free_binary(void *data, void *hint)
+{
+    delete static_cast<std::vector<uint8_t> *>(hint);
+}
+
+/**
+ * @brief Encode the roi to a zmq message in the selected format.
+ *        The message takes ownership of the encoded data and frees it once sent, so it isn't copied.
+ */
+static zmq::message_t
+gst_hailoexportzmq_encode(GstHailoExportZMQ *hailoexportzmq, HailoROIPtr hailo_roi, int64_t timestamp)
+{
+    if (hailoexportzmq->format == HAILO_METADATA_FORMAT_BINARY)
+    {
+        std::vector<uint8_t> *binary_buffer = new std::vector<uint8_t>();
+        encode_binary::encode_hailo_roi(*binary_buffer, hailo_roi, hailoexportzmq->buffer_offset, timestamp, hailo_roi->get_stream_id());
+        return zmq::message_t(binary_buffer->data(), binary_buffer->size(), gst_hailoexportzmq_free_binary, binary_buffer);
+    }
 
-    // Get the roi from the current buffer and encode it to a JSON entry
-    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
     rapidjson::Document encoded_roi = encode_json::encode_hailo_roi(hailo_roi);
 
     // Add a timestamp
-    auto timenow = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-    encoded_roi.AddMember("timestamp (ms)", rapidjson::Value(timenow), encoded_roi.GetAllocator());
+    encoded_roi.AddMember("timestamp (ms)", rapidjson::Value(timestamp), encoded_roi.GetAllocator());
     encoded_roi.AddMember("buffer_offset", rapidjson::Value(hailoexportzmq->buffer_offset), encoded_roi.GetAllocator());
 
     // Get the buffer of the json
-    rapidjson::StringBuffer json_buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(json_buffer);
+    rapidjson::StringBuffer *json_buffer = new rapidjson::StringBuffer();
+    rapidjson::Writer<rapidjson::StringBuffer> writer(*json_buffer);
     encoded_roi.Accept(writer);
 
-    // Send the message
-    zmq::message_t json_message(json_buffer.GetSize());
-    // Copy is required since zmq::message_t would only wrap the data, so if the buffer is freed/overwritten
-    // while the message is sending you will get garbage data or a segfault.
-    std::memcpy(json_message.data(), json_buffer.GetString(), json_buffer.GetSize()); 
+    return zmq::message_t(const_cast<char *>(json_buffer->GetString()), json_buffer->GetSize(), gst_hailoexportzmq_free_json, json_buffer);
+}
+
+static GstFlowReturn
+gst_hailoexportzmq_transform_ip(GstBaseTransform *trans,
+                                 GstBuffer *buffer)
+{
+    GstHailoExportZMQ *hailoexportzmq = GST_HAILO_EXPORT_ZMQ(trans);
+
+    // Get the roi from the current buffer and encode it to a message
+    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
+    auto timenow = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    zmq::message_t message = gst_hailoexportzmq_encode(hailoexportzmq, hailo_roi, timenow);
+    size_t message_size = message.size();
+
+    // Send the message, zmq frees the encoded data through the message's free function once it is sent
 #if (CPPZMQ_VERSION_MAJOR >= 4 && CPPZMQ_VERSION_MINOR >= 6 && CPPZMQ_VERSION_PATCH >= 0)
-    zmq::send_result_t result = hailoexportzmq->socket->send(json_message, zmq::send_flags(ZMQ_DONTWAIT));
+    zmq::send_result_t result = hailoexportzmq->socket->send(message, zmq::send_flags(ZMQ_DONTWAIT));
 #else
-    zmq::detail::send_result_t result = hailoexportzmq->socket->send(json_message, zmq::send_flags(ZMQ_DONTWAIT));
+    zmq::detail::send_result_t result = hailoexportzmq->socket->send(message, zmq::send_flags(ZMQ_DONTWAIT));
 #endif
-    if (result != json_message.size())
+    if (result != message_size)
         GST_WARNING("hailoexportzmq failed to send buffer!");
 
     hailoexportzmq->buffer_offset++;
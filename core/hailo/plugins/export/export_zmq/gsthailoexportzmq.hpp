@@ -7,6 +7,8 @@
 #include <gst/base/gstbasetransform.h>
 #include "hailo_objects.hpp"
 #include "export/encode_json.hpp"
+#include "export/encode_binary.hpp"
+#include "common/metadata_format.hpp"
 #include <cstdio>
 #include <zmq.hpp>
 
@@ -25,6 +27,7 @@ struct _GstHailoExportZMQ
 {
     GstBaseTransform base_hailoexportzmq;
     gchar *address;
+    HailoMetadataFormat format;
     uint buffer_offset;
     zmq::context_t *context;
     zmq::socket_t *socket;
@@ -8,11 +8,8 @@
 #include <string>
 #include <ostream>
 #include <filesystem>
-#include "xtensor/xarray.hpp"
-#include "xtensor/xadapt.hpp"
-#include "xtensor/xsort.hpp"
-#include "xtensor/xio.hpp"
 #include "hailo_objects.hpp"
+#include "gallery_index.hpp"
 #include "export/encode_json.hpp"
 #include "import/decode_json.hpp"
 
@@ -24,35 +21,12 @@
 #include "rapidjson/writer.h"
 #include "rapidjson/prettywriter.h"
 
-static xt::xarray<float> gallery_get_xtensor(HailoMatrixPtr matrix)
-{
-    // Adapt a HailoTensorPtr to an xarray (quantized)
-    xt::xarray<float> xtensor = xt::adapt(matrix->get_data().data(), matrix->size(), xt::no_ownership(), matrix->shape());
-    return xt::squeeze(xtensor);
-}
-
-static float gallery_one_dim_dot_product(xt::xarray<float> array1, xt::xarray<float> array2)
-{
-    if (array1.dimension() > 1 || array2.dimension() > 1)
-    {
-        throw std::runtime_error("One of the arrays has more than 1 dimension");
-    }
-    if (array1.shape(0) != array2.shape(0))
-    {
-        throw std::runtime_error("Arrays are with different shape");
-    }
-    return xt::sum(array1 * array2)[0];
-}
-
 class Gallery
 {
 private:
-    // Each embedding is represented by HailoMatrixPtr
-    // Each global_id has a vector of embeddings (I.e. vector of HailoMatrixPtr)
-    // of all the embeddings related to this ID.
-    // For the whole gallery there is a vector of global id's (i.e. vector of vectors of HailoMatrixPtr)
-    // where the global ID is represented by the outer vector's index.
-    std::vector<std::vector<HailoMatrixPtr>> m_embeddings;
+    // Each global_id has a queue of the embeddings related to this ID, kept by the index
+    // where the global ID is represented by its index + 1.
+    GalleryIndex m_index;
     std::map<int, int> tracking_id_to_global_id;
     std::vector<std::string> m_embedding_names;
     float m_similarity_thr;
@@ -67,28 +41,9 @@ public:
                                                                   m_json_file(nullptr), m_save_new_embeddings(false),
                                                                   m_json_file_path(nullptr), m_load_local_embeddings(false){};
 
-    static float get_distance(std::vector<HailoMatrixPtr> embeddings_queue, HailoMatrixPtr matrix)
+    std::vector<float> get_embeddings_distances(HailoMatrixPtr matrix)
     {
-        xt::xarray<float> new_embedding = gallery_get_xtensor(matrix);
-        float max_thr = 0.0f;
-        float thr;
-        for (HailoMatrixPtr embedding_mat : embeddings_queue)
-        {
-            xt::xarray<float> embedding = gallery_get_xtensor(embedding_mat);
-            thr = gallery_one_dim_dot_product(embedding, new_embedding);
-            max_thr = thr > max_thr ? thr : max_thr;
-        }
-        return 1.0f - max_thr;
-    }
-
-    xt::xarray<float> get_embeddings_distances(HailoMatrixPtr matrix)
-    {
-        std::vector<float> distances;
-        for (auto embeddings_queue : m_embeddings)
-        {
-            distances.push_back(get_distance(embeddings_queue, matrix));
-        }
-        return xt::adapt(distances);
+        return m_index.distances(matrix->get_data().data(), matrix->size());
     }
 
     void init_local_gallery_file(const char *file_path)
@@ -139,12 +94,7 @@ public:
 
     void add_embedding(uint global_id, HailoMatrixPtr matrix)
     {
-        global_id--;
-        if (m_embeddings[global_id].size() >= m_queue_size)
-        {
-            m_embeddings[global_id].pop_back();
-        }
-        m_embeddings[global_id].insert(m_embeddings[global_id].begin(), matrix);
+        m_index.add(global_id - 1, matrix->get_data().data(), matrix->size(), m_queue_size);
     }
 
     void write_to_json_file(rapidjson::Document document)
@@ -186,17 +136,14 @@ public:
 
     uint create_new_global_id()
     {
-        std::vector<HailoMatrixPtr> queue;
-        m_embeddings.push_back(queue);
-        uint global_id = m_embeddings.size();
+        uint global_id = m_index.add_id() + 1;
         return global_id;
     }
 
     std::pair<uint, float> get_closest_global_id(HailoMatrixPtr matrix)
     {
-        auto distances = get_embeddings_distances(matrix);
-        auto global_id = xt::argpartition(distances, 1, xt::xnone())[0];
-        return std::pair<uint, float>(global_id + 1, distances[global_id]);
+        auto closest = m_index.closest(matrix->get_data().data(), matrix->size());
+        return std::pair<uint, float>(closest.first + 1, closest.second);
     }
 
     HailoMatrixPtr get_embedding_matrix(HailoDetectionPtr detection)
@@ -261,7 +208,7 @@ public:
             return;
         }
 
-        if (m_embeddings.empty())
+        if (m_index.empty())
         {
             // Gallery is empty, adding new global id
             uint global_id = create_new_global_id();
@@ -308,4 +255,10 @@ public:
     void set_queue_size(uint size) { m_queue_size = size; };
     float get_similarity_threshold() { return m_similarity_thr; };
     uint get_queue_size() { return m_queue_size; };
+    void set_search_mode(gallery_search_mode_t mode) { m_index.set_search_mode(mode); };
+    void set_ann_threshold(uint threshold) { m_index.set_ann_threshold(threshold); };
+    void set_ann_probes(uint probes) { m_index.set_ann_probes(probes); };
+    gallery_search_mode_t get_search_mode() { return m_index.get_search_mode(); };
+    uint get_ann_threshold() { return m_index.get_ann_threshold(); };
+    uint get_ann_probes() { return m_index.get_ann_probes(); };
 };
@@ -0,0 +1,396 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+typedef enum
+{
+    GALLERY_SEARCH_EXACT,
+    GALLERY_SEARCH_APPROXIMATE,
+} gallery_search_mode_t;
+
+static inline float gallery_dot_product(const float *a, const float *b, size_t size)
+{
+    size_t i = 0;
+    float sum = 0.0f;
+#if defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= size; i += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= size; i += 8)
+    {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#endif
+    for (; i < size; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+/**
+ * @brief Embeddings storage and search of the gallery.
+ * Every embedding of every global id is a row in one contiguous float buffer, the similarity of two
+ * embeddings is their dot product (the recognition postprocesses L2 normalize them), and the similarity
+ * of a global id is the best one over its embeddings queue.
+ * In exact mode every row is scanned. In approximate mode, once the gallery holds ann_threshold rows,
+ * the rows are clustered (IVF: spherical k-means on a sample) and a query scans only the rows of its
+ * ann_probes closest clusters. More probes mean better recall and slower queries.
+ * Clustering runs on a background thread over a copy of the rows, queries keep using the previous
+ * clusters (or scan every row) until the new ones are swapped in.
+ */
+class GalleryIndex
+{
+private:
+    static constexpr int FREE_SLOT = -1;
+    static constexpr uint32_t NO_LIST = UINT32_MAX;
+    static constexpr uint KMEANS_ITERATIONS = 8;
+    static constexpr size_t KMEANS_SAMPLES_PER_LIST = 32;
+
+    /**
+     * @brief The clusters of the rows, valid when num_lists > 0.
+     */
+    struct IvfLists
+    {
+        size_t num_lists = 0;
+        size_t trained_rows = 0;
+        std::vector<float> centroids;
+        std::vector<std::vector<uint32_t>> lists;
+        std::vector<uint32_t> slot_list; // NO_LIST for slots that aren't in any list
+        std::vector<uint32_t> slot_position;
+
+        uint32_t nearest_list(const float *embedding, size_t dim) const
+        {
+            uint32_t best_list = 0;
+            float best_score = -INFINITY;
+            for (uint32_t list = 0; list < num_lists; list++)
+            {
+                float score = gallery_dot_product(embedding, centroids.data() + list * dim, dim);
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best_list = list;
+                }
+            }
+            return best_list;
+        }
+
+        void insert(uint32_t slot, const float *embedding, size_t dim)
+        {
+            uint32_t list = nearest_list(embedding, dim);
+            slot_list[slot] = list;
+            slot_position[slot] = lists[list].size();
+            lists[list].push_back(slot);
+        }
+
+        void erase(uint32_t slot)
+        {
+            if (slot_list[slot] == NO_LIST)
+                return;
+            std::vector<uint32_t> &list = lists[slot_list[slot]];
+            uint32_t last = list.back();
+            list[slot_position[slot]] = last;
+            slot_position[last] = slot_position[slot];
+            list.pop_back();
+            slot_list[slot] = NO_LIST;
+        }
+
+        void add_slot()
+        {
+            slot_list.push_back(NO_LIST);
+            slot_position.push_back(0);
+        }
+    };
+
+    size_t m_dim;
+    std::vector<float> m_rows;                  // m_dim floats per slot
+    std::vector<int> m_slot_owner;              // global id index of each slot, FREE_SLOT if unused
+    std::vector<std::deque<uint32_t>> m_id_slots; // slots of each global id, newest first
+    std::vector<uint32_t> m_free_slots;
+    size_t m_active_rows;
+
+    gallery_search_mode_t m_mode;
+    size_t m_ann_threshold;
+    uint m_ann_probes;
+
+    IvfLists m_ivf;
+    // Clustering in flight, and the slots written or freed since its copy of the rows was taken
+    std::future<IvfLists> m_training;
+    std::vector<uint32_t> m_changed_slots;
+
+    // Query scratch
+    std::vector<float> m_similarities;
+    std::vector<std::pair<float, uint32_t>> m_list_scores;
+
+    const float *row(uint32_t slot) const { return m_rows.data() + slot * m_dim; }
+
+    /**
+     * @brief Cluster a copy of the rows, runs on the training thread.
+     */
+    static IvfLists train(std::vector<float> rows, std::vector<int> slot_owner, size_t dim)
+    {
+        IvfLists ivf;
+        std::vector<uint32_t> active;
+        for (uint32_t slot = 0; slot < slot_owner.size(); slot++)
+        {
+            if (slot_owner[slot] != FREE_SLOT)
+                active.push_back(slot);
+        }
+        auto row = [&rows, dim](uint32_t slot)
+        { return rows.data() + slot * dim; };
+
+        ivf.num_lists = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(active.size()))));
+        size_t num_samples = std::min(active.size(), ivf.num_lists * KMEANS_SAMPLES_PER_LIST);
+        size_t stride = active.size() / num_samples;
+        ivf.centroids.resize(ivf.num_lists * dim);
+        for (size_t list = 0; list < ivf.num_lists; list++)
+            std::copy_n(row(active[list * (active.size() / ivf.num_lists)]), dim, ivf.centroids.data() + list * dim);
+
+        std::vector<float> sums(ivf.num_lists * dim);
+        std::vector<uint32_t> counts(ivf.num_lists);
+        for (uint iteration = 0; iteration < KMEANS_ITERATIONS; iteration++)
+        {
+            std::fill(sums.begin(), sums.end(), 0.0f);
+            std::fill(counts.begin(), counts.end(), 0);
+            for (size_t sample = 0; sample < num_samples; sample++)
+            {
+                const float *embedding = row(active[sample * stride]);
+                uint32_t list = ivf.nearest_list(embedding, dim);
+                float *sum = sums.data() + list * dim;
+                for (size_t i = 0; i < dim; i++)
+                    sum[i] += embedding[i];
+                counts[list]++;
+            }
+            for (size_t list = 0; list < ivf.num_lists; list++)
+            {
+                // Empty clusters keep their centroid, the others move to the normalized mean
+                if (counts[list] == 0)
+                    continue;
+                float *sum = sums.data() + list * dim;
+                float norm = std::sqrt(gallery_dot_product(sum, sum, dim));
+                if (norm > 0.0f)
+                    std::transform(sum, sum + dim, ivf.centroids.data() + list * dim, [norm](float v)
+                                   { return v / norm; });
+            }
+        }
+
+        ivf.lists.assign(ivf.num_lists, std::vector<uint32_t>());
+        ivf.slot_list.assign(slot_owner.size(), NO_LIST);
+        ivf.slot_position.resize(slot_owner.size());
+        for (uint32_t slot : active)
+            ivf.insert(slot, row(slot), dim);
+        ivf.trained_rows = active.size();
+        return ivf;
+    }
+
+    void start_training()
+    {
+        m_changed_slots.clear();
+        m_training = std::async(std::launch::async, &GalleryIndex::train, m_rows, m_slot_owner, m_dim);
+    }
+
+    /**
+     * @brief Swap in the clusters of a finished training, after fixing up the slots changed meanwhile.
+     */
+    void poll_training()
+    {
+        if (!m_training.valid() || m_training.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+
+        IvfLists ivf = m_training.get();
+        while (ivf.slot_list.size() < m_slot_owner.size())
+            ivf.add_slot();
+        for (uint32_t slot : m_changed_slots)
+            ivf.erase(slot);
+        for (uint32_t slot : m_changed_slots)
+        {
+            if (m_slot_owner[slot] != FREE_SLOT && ivf.slot_list[slot] == NO_LIST)
+                ivf.insert(slot, row(slot), m_dim);
+        }
+        m_changed_slots.clear();
+        m_ivf = std::move(ivf);
+    }
+
+    void slot_changed(uint32_t slot)
+    {
+        if (m_training.valid())
+            m_changed_slots.push_back(slot);
+    }
+
+    void scan(const float *query, uint32_t slot)
+    {
+        float similarity = gallery_dot_product(query, row(slot), m_dim);
+        float &best = m_similarities[m_slot_owner[slot]];
+        best = std::max(best, similarity);
+    }
+
+public:
+    GalleryIndex() : m_dim(0), m_active_rows(0), m_mode(GALLERY_SEARCH_EXACT), m_ann_threshold(10000), m_ann_probes(8){};
+
+    size_t num_ids() const { return m_id_slots.size(); }
+    bool empty() const { return m_id_slots.empty(); }
+
+    /**
+     * @brief Add a new global id with no embeddings.
+     *
+     * @return uint - The index of the new global id.
+     */
+    uint add_id()
+    {
+        m_id_slots.emplace_back();
+        return m_id_slots.size() - 1;
+    }
+
+    /**
+     * @brief Add an embedding to a global id, dropping its oldest embedding if it already holds queue_size.
+     */
+    void add(uint id, const float *embedding, size_t size, uint queue_size)
+    {
+        if (m_dim == 0)
+            m_dim = size;
+        if (size != m_dim)
+            throw std::runtime_error("Embeddings are with different shape");
+        poll_training();
+
+        std::deque<uint32_t> &slots = m_id_slots[id];
+        while (!slots.empty() && slots.size() >= queue_size)
+        {
+            uint32_t oldest = slots.back();
+            slots.pop_back();
+            if (m_ivf.num_lists > 0)
+                m_ivf.erase(oldest);
+            m_slot_owner[oldest] = FREE_SLOT;
+            m_free_slots.push_back(oldest);
+            m_active_rows--;
+            slot_changed(oldest);
+        }
+
+        uint32_t slot;
+        if (!m_free_slots.empty())
+        {
+            slot = m_free_slots.back();
+            m_free_slots.pop_back();
+        }
+        else
+        {
+            slot = m_slot_owner.size();
+            m_slot_owner.push_back(FREE_SLOT);
+            m_rows.resize(m_rows.size() + m_dim);
+            if (m_ivf.num_lists > 0)
+                m_ivf.add_slot();
+        }
+        std::copy_n(embedding, m_dim, m_rows.data() + slot * m_dim);
+        m_slot_owner[slot] = id;
+        slots.push_front(slot);
+        m_active_rows++;
+        slot_changed(slot);
+        if (m_ivf.num_lists > 0)
+            m_ivf.insert(slot, row(slot), m_dim);
+
+        // Cluster once the threshold is crossed, and again whenever the gallery doubles since
+        bool approximate = m_mode == GALLERY_SEARCH_APPROXIMATE && m_active_rows >= m_ann_threshold;
+        if (approximate && !m_training.valid() && (m_ivf.num_lists == 0 || m_active_rows >= 2 * m_ivf.trained_rows))
+            start_training();
+    }
+
+    /**
+     * @brief Find the global id closest to a query embedding.
+     *
+     * @return std::pair<uint, float> - The index of the closest global id and its distance (1 - similarity).
+     */
+    std::pair<uint, float> closest(const float *query, size_t size)
+    {
+        if (size != m_dim)
+            throw std::runtime_error("Embeddings are with different shape");
+
+        poll_training();
+        m_similarities.assign(m_id_slots.size(), 0.0f);
+        bool approximate = m_mode == GALLERY_SEARCH_APPROXIMATE && m_ivf.num_lists > 0;
+        if (approximate)
+        {
+            m_list_scores.resize(m_ivf.num_lists);
+            for (uint32_t list = 0; list < m_ivf.num_lists; list++)
+                m_list_scores[list] = {gallery_dot_product(query, m_ivf.centroids.data() + list * m_dim, m_dim), list};
+            size_t probes = std::min<size_t>(std::max<uint>(m_ann_probes, 1), m_ivf.num_lists);
+            std::partial_sort(m_list_scores.begin(), m_list_scores.begin() + probes, m_list_scores.end(),
+                              [](const std::pair<float, uint32_t> &a, const std::pair<float, uint32_t> &b)
+                              { return a.first > b.first; });
+            for (size_t probe = 0; probe < probes; probe++)
+            {
+                for (uint32_t slot : m_ivf.lists[m_list_scores[probe].second])
+                    scan(query, slot);
+            }
+        }
+        else
+        {
+            for (uint32_t slot = 0; slot < m_slot_owner.size(); slot++)
+            {
+                if (m_slot_owner[slot] != FREE_SLOT)
+                    scan(query, slot);
+            }
+        }
+
+        uint best_id = std::max_element(m_similarities.begin(), m_similarities.end()) - m_similarities.begin();
+        return std::pair<uint, float>(best_id, 1.0f - m_similarities[best_id]);
+    }
+
+    /**
+     * @brief Distance (1 - best similarity) of a query embedding to every global id, always exact.
+     */
+    std::vector<float> distances(const float *query, size_t size)
+    {
+        if (size != m_dim)
+            throw std::runtime_error("Embeddings are with different shape");
+
+        m_similarities.assign(m_id_slots.size(), 0.0f);
+        for (uint32_t slot = 0; slot < m_slot_owner.size(); slot++)
+        {
+            if (m_slot_owner[slot] != FREE_SLOT)
+                scan(query, slot);
+        }
+        std::vector<float> distances(m_similarities.size());
+        std::transform(m_similarities.begin(), m_similarities.end(), distances.begin(), [](float similarity)
+                       { return 1.0f - similarity; });
+        return distances;
+    }
+
+    void set_search_mode(gallery_search_mode_t mode)
+    {
+        m_mode = mode;
+        if (m_mode == GALLERY_SEARCH_APPROXIMATE && m_ivf.num_lists == 0 && !m_training.valid() &&
+            m_active_rows >= m_ann_threshold && m_active_rows > 0)
+            start_training();
+    }
+    void set_ann_threshold(size_t threshold) { m_ann_threshold = threshold; }
+    void set_ann_probes(uint probes) { m_ann_probes = probes; }
+    gallery_search_mode_t get_search_mode() { return m_mode; }
+    size_t get_ann_threshold() { return m_ann_threshold; }
+    uint get_ann_probes() { return m_ann_probes; }
+};
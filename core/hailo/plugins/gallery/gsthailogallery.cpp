@@ -32,8 +32,29 @@ enum
     PROP_LOAD_GALLERY,
     PROP_SAVE_GALLERY,
     PROP_LOCAL_GALLERY_FILE_PATH,
+    PROP_SEARCH_MODE,
+    PROP_ANN_THRESHOLD,
+    PROP_ANN_PROBES,
 };
 
+#define GST_TYPE_HAILO_GALLERY_SEARCH_MODE (gst_hailo_gallery_search_mode_get_type())
+static GType
+gst_hailo_gallery_search_mode_get_type(void)
+{
+    static GType gallery_search_mode = 0;
+    static const GEnumValue hailo_gallery_search_modes[] = {
+        {GALLERY_SEARCH_EXACT, "Exact search over all the embeddings", "exact"},
+        {GALLERY_SEARCH_APPROXIMATE, "Approximate (IVF) search above ann-threshold embeddings", "approximate"},
+        {0, NULL, NULL},
+    };
+    if (!gallery_search_mode)
+    {
+        gallery_search_mode =
+            g_enum_register_static("GstHailoGallerySearchMode", hailo_gallery_search_modes);
+    }
+    return gallery_search_mode;
+}
+
 //******************************************************************
 // PAD TEMPLATES
 //******************************************************************
@@ -112,6 +133,24 @@ gst_hailo_gallery_class_init(GstHailoGalleryClass *klass)
                                                          FALSE,
                                                          (GParamFlags)(GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+    g_object_class_install_property(gobject_class, PROP_SEARCH_MODE,
+                                    g_param_spec_enum("search-mode", "Search mode",
+                                                      "How the gallery is searched for the closest global ID",
+                                                      GST_TYPE_HAILO_GALLERY_SEARCH_MODE, (gint)GALLERY_SEARCH_EXACT,
+                                                      (GParamFlags)(GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(gobject_class, PROP_ANN_THRESHOLD,
+                                    g_param_spec_uint("ann-threshold", "Approximate search threshold",
+                                                      "Number of stored embeddings from which the approximate search mode clusters the gallery, below it the search is exact",
+                                                      1, G_MAXUINT, 10000,
+                                                      (GParamFlags)(GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(gobject_class, PROP_ANN_PROBES,
+                                    g_param_spec_uint("ann-probes", "Approximate search probes",
+                                                      "Number of closest clusters scanned per query in approximate search mode. Higher is better recall and slower",
+                                                      1, G_MAXUINT, 8,
+                                                      (GParamFlags)(GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
     // Set virtual functions
     gobject_class->dispose = gst_hailo_gallery_dispose;
     base_transform_class->transform_ip = GST_DEBUG_FUNCPTR(gst_hailo_gallery_transform_ip);
@@ -184,6 +223,15 @@ void gst_hailo_gallery_set_property(GObject *object, guint property_id,
     case PROP_SAVE_GALLERY:
         hailogallery->save_gallery = g_value_get_boolean(value);
         break;
+    case PROP_SEARCH_MODE:
+        hailogallery->gallery.set_search_mode((gallery_search_mode_t)g_value_get_enum(value));
+        break;
+    case PROP_ANN_THRESHOLD:
+        hailogallery->gallery.set_ann_threshold(g_value_get_uint(value));
+        break;
+    case PROP_ANN_PROBES:
+        hailogallery->gallery.set_ann_probes(g_value_get_uint(value));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -218,6 +266,15 @@ void gst_hailo_gallery_get_property(GObject *object, guint property_id,
     case PROP_SAVE_GALLERY:
         g_value_set_boolean(value, hailogallery->save_gallery);
         break;
+    case PROP_SEARCH_MODE:
+        g_value_set_enum(value, hailogallery->gallery.get_search_mode());
+        break;
+    case PROP_ANN_THRESHOLD:
+        g_value_set_uint(value, hailogallery->gallery.get_ann_threshold());
+        break;
+    case PROP_ANN_PROBES:
+        g_value_set_uint(value, hailogallery->gallery.get_ann_probes());
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -0,0 +1,285 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+// General cpp includes
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Tappas includes
+#include "hailo_objects.hpp"
+#include "hailo_common.hpp"
+#include "common/binary_meta.hpp"
+
+namespace decode_binary
+{
+    /**
+     * @brief The header fields of a binary metadata message.
+     */
+    struct MessageHeader
+    {
+        uint32_t message_size;
+        uint64_t buffer_offset;
+        int64_t timestamp;
+        std::string stream_id;
+    };
+
+    MessageHeader decode_header(binary_meta::Reader &reader);
+    HailoBBox decode_bbox(binary_meta::Reader &reader);
+    void decode_detection(binary_meta::Reader &reader, HailoROIPtr roi, uint32_t depth);
+    void decode_classification(binary_meta::Reader &reader, HailoROIPtr roi);
+    void decode_landmarks(binary_meta::Reader &reader, HailoROIPtr roi);
+    void decode_tile(binary_meta::Reader &reader, HailoROIPtr roi, uint32_t depth);
+    void decode_unique_id(binary_meta::Reader &reader, HailoROIPtr roi);
+    void decode_depth_mask(binary_meta::Reader &reader, HailoROIPtr roi);
+    void decode_class_mask(binary_meta::Reader &reader, HailoROIPtr roi);
+    void decode_conf_class_mask(binary_meta::Reader &reader, HailoROIPtr roi);
+    void decode_matrix(binary_meta::Reader &reader, HailoROIPtr roi);
+    void decode_hailo_objects(binary_meta::Reader &reader, HailoROIPtr roi, uint32_t depth = 0);
+}
+
+namespace decode_binary
+{
+    /**
+     * @brief Throws std::runtime_error if an array doesn't hold the number of values its dimensions give.
+     */
+    inline void check_array_size(size_t array_size, uint64_t expected_size, const char *object_name)
+    {
+        if (array_size != expected_size)
+            throw std::runtime_error(std::string("binary metadata ") + object_name + " holds " + std::to_string(array_size) +
+                                     " values instead of " + std::to_string(expected_size));
+    }
+
+    inline void check_mask_size(size_t array_size, int width, int height, const char *object_name)
+    {
+        if (width < 0 || height < 0)
+            throw std::runtime_error(std::string("binary metadata ") + object_name + " has negative dimensions");
+        check_array_size(array_size, uint64_t(width) * uint64_t(height), object_name);
+    }
+
+    /**
+     * @brief Decode and validate the header of a message, leaving the reader at the roi.
+     *        The reader ends at the end of the message, so a following message isn't read.
+     *        Throws std::runtime_error if the data is not a binary metadata message of a known version,
+     *        or if its message size doesn't fit the data.
+     */
+    inline MessageHeader decode_header(binary_meta::Reader &reader)
+    {
+        size_t message_start = reader.position();
+        if (reader.read<uint32_t>() != binary_meta::MAGIC)
+            throw std::runtime_error("not a binary metadata message");
+        uint16_t version = reader.read<uint16_t>();
+        if (version != binary_meta::VERSION)
+            throw std::runtime_error("unsupported binary metadata version " + std::to_string(version));
+        reader.read<uint16_t>();
+
+        MessageHeader header;
+        header.message_size = reader.read<uint32_t>();
+        header.buffer_offset = reader.read<uint64_t>();
+        header.timestamp = reader.read<int64_t>();
+        header.stream_id = reader.read_string();
+
+        if (header.message_size < reader.position() - message_start ||
+            header.message_size > reader.position() - message_start + reader.remaining())
+            throw std::runtime_error("binary metadata message size " + std::to_string(header.message_size) +
+                                     " doesn't match the " + std::to_string(reader.position() - message_start + reader.remaining()) +
+                                     " bytes received");
+        reader.set_end(message_start + header.message_size);
+        return header;
+    }
+
+    inline HailoBBox decode_bbox(binary_meta::Reader &reader)
+    {
+        float xmin = reader.read<float>();
+        float ymin = reader.read<float>();
+        float width = reader.read<float>();
+        float height = reader.read<float>();
+        return HailoBBox(xmin, ymin, width, height);
+    }
+
+    inline void decode_detection(binary_meta::Reader &reader, HailoROIPtr roi, uint32_t depth)
+    {
+        HailoBBox bbox = decode_bbox(reader);
+        int class_id = reader.read<int32_t>();
+        float confidence = reader.read<float>();
+        std::string label = reader.read_string();
+
+        HailoDetectionPtr detection = hailo_make_shared<HailoDetection>(bbox, class_id, label, confidence);
+
+        // Add this detection object to the parent
+        roi->add_object(detection);
+
+        // Recurse this object
+        decode_hailo_objects(reader, detection, depth + 1);
+    }
+
+    inline void decode_classification(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        std::string classification_type = reader.read_string();
+        int class_id = reader.read<int32_t>();
+        float confidence = reader.read<float>();
+        std::string label = reader.read_string();
+
+        roi->add_object(hailo_make_shared<HailoClassification>(classification_type, class_id, label, confidence));
+    }
+
+    inline void decode_landmarks(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        std::string landmarks_type = reader.read_string();
+        float threshold = reader.read<float>();
+
+        std::vector<HailoPoint> points;
+        uint32_t points_count = reader.read<uint32_t>();
+        points.reserve(std::min<size_t>(points_count, reader.remaining() / (3 * sizeof(float))));
+        for (uint32_t i = 0; i < points_count; i++)
+        {
+            float x = reader.read<float>();
+            float y = reader.read<float>();
+            float confidence = reader.read<float>();
+            points.emplace_back(x, y, confidence);
+        }
+
+        std::vector<std::pair<int, int>> pairs;
+        uint32_t pairs_count = reader.read<uint32_t>();
+        pairs.reserve(std::min<size_t>(pairs_count, reader.remaining() / (2 * sizeof(int32_t))));
+        for (uint32_t i = 0; i < pairs_count; i++)
+        {
+            int first = reader.read<int32_t>();
+            int second = reader.read<int32_t>();
+            pairs.emplace_back(first, second);
+        }
+
+        roi->add_object(hailo_make_shared<HailoLandmarks>(landmarks_type, points, threshold, pairs));
+    }
+
+    inline void decode_tile(binary_meta::Reader &reader, HailoROIPtr roi, uint32_t depth)
+    {
+        HailoBBox bbox = decode_bbox(reader);
+        uint index = reader.read<uint32_t>();
+        float overlap_x_axis = reader.read<float>();
+        float overlap_y_axis = reader.read<float>();
+        uint layer = reader.read<uint32_t>();
+        hailo_tiling_mode_t mode = (hailo_tiling_mode_t)reader.read<uint32_t>();
+
+        HailoTileROIPtr tile = hailo_make_shared<HailoTileROI>(bbox, index, overlap_x_axis, overlap_y_axis, layer, mode);
+
+        // Add this tile object to the parent
+        roi->add_object(tile);
+
+        // Recurse this object
+        decode_hailo_objects(reader, tile, depth + 1);
+    }
+
+    inline void decode_unique_id(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        int id = reader.read<int32_t>();
+        hailo_unique_id_mode_t mode = (hailo_unique_id_mode_t)reader.read<int32_t>();
+        roi->add_object(hailo_make_shared<HailoUniqueID>(id, mode));
+    }
+
+    inline void decode_depth_mask(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        int width = reader.read<int32_t>();
+        int height = reader.read<int32_t>();
+        float transparency = reader.read<float>();
+        std::vector<float> data = reader.read_array<float>();
+        check_mask_size(data.size(), width, height, "depth mask");
+        roi->add_object(hailo_make_shared<HailoDepthMask>(std::move(data), width, height, transparency));
+    }
+
+    inline void decode_class_mask(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        int width = reader.read<int32_t>();
+        int height = reader.read<int32_t>();
+        float transparency = reader.read<float>();
+        std::vector<uint8_t> data = reader.read_array<uint8_t>();
+        check_mask_size(data.size(), width, height, "class mask");
+        roi->add_object(hailo_make_shared<HailoClassMask>(std::move(data), width, height, transparency));
+    }
+
+    inline void decode_conf_class_mask(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        int width = reader.read<int32_t>();
+        int height = reader.read<int32_t>();
+        float transparency = reader.read<float>();
+        int class_id = reader.read<int32_t>();
+        std::vector<float> data = reader.read_array<float>();
+        check_mask_size(data.size(), width, height, "confidence class mask");
+        roi->add_object(hailo_make_shared<HailoConfClassMask>(std::move(data), width, height, transparency, class_id));
+    }
+
+    inline void decode_matrix(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        uint32_t height = reader.read<uint32_t>();
+        uint32_t width = reader.read<uint32_t>();
+        uint32_t features = reader.read<uint32_t>();
+        std::vector<float> data = reader.read_array<float>();
+        check_array_size(data.size(), uint64_t(height) * uint64_t(width) * uint64_t(features), "matrix");
+        roi->add_object(hailo_make_shared<HailoMatrix>(std::move(data), height, width, features));
+    }
+
+    inline void decode_hailo_objects(binary_meta::Reader &reader, HailoROIPtr roi, uint32_t depth)
+    {
+        if (depth > binary_meta::MAX_OBJECTS_DEPTH)
+            throw std::runtime_error("binary metadata objects are nested too deep");
+        uint32_t count = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint8_t type = reader.read<uint8_t>();
+            uint32_t payload_size = reader.read<uint32_t>();
+            size_t payload_start = reader.position();
+            switch (type)
+            {
+            case HAILO_DETECTION:
+                decode_detection(reader, roi, depth);
+                break;
+            case HAILO_CLASSIFICATION:
+                decode_classification(reader, roi);
+                break;
+            case HAILO_LANDMARKS:
+                decode_landmarks(reader, roi);
+                break;
+            case HAILO_TILE:
+                decode_tile(reader, roi, depth);
+                break;
+            case HAILO_UNIQUE_ID:
+                decode_unique_id(reader, roi);
+                break;
+            case HAILO_DEPTH_MASK:
+                decode_depth_mask(reader, roi);
+                break;
+            case HAILO_CLASS_MASK:
+                decode_class_mask(reader, roi);
+                break;
+            case HAILO_CONF_CLASS_MASK:
+                decode_conf_class_mask(reader, roi);
+                break;
+            case HAILO_MATRIX:
+                decode_matrix(reader, roi);
+                break;
+            default:
+                // Unknown object, skipped below
+                break;
+            }
+
+            // Continue after the payload, so fields a newer exporter appends to an object are skipped
+            if (reader.position() - payload_start > payload_size)
+                throw std::runtime_error("binary metadata object overruns its payload");
+            reader.seek(payload_start + payload_size);
+        }
+    }
+
+    /**
+     * @brief Decode the roi of a message into an existing roi, after the header was decoded.
+     *        The bbox of the exported roi is not applied, like in decode_json.
+     */
+    inline void decode_hailo_roi(binary_meta::Reader &reader, HailoROIPtr roi)
+    {
+        decode_bbox(reader);
+        decode_hailo_objects(reader, roi);
+    }
+
+}
@@ -7,12 +7,13 @@
 #include "gsthailoimportzmq.hpp"
 #pragma GCC diagnostic pop
 #include "gst_hailo_meta.hpp"
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <cstdio>
 #include <ctime>
 #include <gst/video/video.h>
 #include <gst/gst.h>
-#include <unistd.h>
 
 #define RAPIDJSON_HAS_STDSTRING 1
 #include "rapidjson/document.h"
@@ -49,10 +50,18 @@ enum
 {
     PROP_0,
     PROP_ADDRESS,
+    PROP_TIMEOUT,
+    PROP_MATCH_OFFSET,
+    PROP_MAX_OFFSET_GAP,
+    PROP_FORMAT,
 };
 
 // Default import node
 const gchar *DEFAULT_ADDRESS = "tcp://localhost:5555";
+#define DEFAULT_TIMEOUT (-1)
+#define DEFAULT_MATCH_OFFSET (FALSE)
+#define DEFAULT_MAX_OFFSET_GAP (30)
+#define DEFAULT_FORMAT (HAILO_METADATA_FORMAT_JSON)
 
 static void
 gst_hailoimportzmq_class_init(GstHailoImportZMQClass *klass)
@@ -61,9 +70,9 @@ gst_hailoimportzmq_class_init(GstHailoImportZMQClass *klass)
     GstBaseTransformClass *base_transform_class =
         GST_BASE_TRANSFORM_CLASS(klass);
 
-    const char *description = "Imports HailoObjects in JSON format from a ZMQ socket."
+    const char *description = "Imports HailoObjects in JSON or binary format from a ZMQ socket."
                               "\n\t\t\t   "
-                              "Decodes classes contained by JSON to HailoROI objects.";
+                              "Decodes classes contained by JSON or binary messages to HailoROI objects.";
     /* Setting up pads and setting metadata should be moved to
        base_class_init if you intend to subclass this class. */
     gst_element_class_add_pad_template(GST_ELEMENT_CLASS(klass),
@@ -85,6 +94,28 @@ gst_hailoimportzmq_class_init(GstHailoImportZMQClass *klass)
                                     g_param_spec_string("address", "Endpoint address.",
                                                         "Address to bind the socket to.", "tcp://localhost:5555",
                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_TIMEOUT,
+                                    g_param_spec_int("timeout", "Receive timeout",
+                                                     "Milliseconds to wait for a message for each buffer, the buffer passes without imported meta when it expires. -1 waits forever.",
+                                                     -1, G_MAXINT, DEFAULT_TIMEOUT,
+                                                     (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PROP_MATCH_OFFSET,
+                                    g_param_spec_boolean("match-offset", "Match buffer offset",
+                                                         "Import to each buffer the message with the matching buffer_offset (as set by hailoexportzmq) instead of the next message. "
+                                                         "Messages of buffers that already passed are dropped, messages of later buffers wait for their buffer.",
+                                                         DEFAULT_MATCH_OFFSET,
+                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_MAX_OFFSET_GAP,
+                                    g_param_spec_uint("max-offset-gap", "Maximal offset gap",
+                                                      "With match-offset, a message whose buffer_offset is further than this from the expected one resyncs the matching on it "
+                                                      "(the exporter or this pipeline restarted, or messages were lost).",
+                                                      1, G_MAXUINT, DEFAULT_MAX_OFFSET_GAP,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_FORMAT,
+                                    g_param_spec_enum("format", "Message format",
+                                                      "Format of the imported messages, must match the format of the exporting element.",
+                                                      GST_TYPE_HAILO_METADATA_FORMAT, DEFAULT_FORMAT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
 
     gobject_class->dispose = gst_hailoimportzmq_dispose;
     gobject_class->finalize = gst_hailoimportzmq_finalize;
@@ -97,6 +128,15 @@ static void
 gst_hailoimportzmq_init(GstHailoImportZMQ *hailoimportzmq)
 {
     hailoimportzmq->address = g_strdup(DEFAULT_ADDRESS);
+    hailoimportzmq->timeout = DEFAULT_TIMEOUT;
+    hailoimportzmq->match_offset = DEFAULT_MATCH_OFFSET;
+    hailoimportzmq->max_offset_gap = DEFAULT_MAX_OFFSET_GAP;
+    hailoimportzmq->format = DEFAULT_FORMAT;
+    hailoimportzmq->frame_offset = 0;
+    hailoimportzmq->offset_anchored = FALSE;
+    hailoimportzmq->offset_delta = 0;
+    hailoimportzmq->pending_message = nullptr;
+    hailoimportzmq->pending_offset = 0;
 }
 
 void gst_hailoimportzmq_set_property(GObject *object, guint property_id,
@@ -111,6 +151,18 @@ void gst_hailoimportzmq_set_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         hailoimportzmq->address = g_strdup(g_value_get_string(value));
         break;
+    case PROP_TIMEOUT:
+        hailoimportzmq->timeout = g_value_get_int(value);
+        break;
+    case PROP_MATCH_OFFSET:
+        hailoimportzmq->match_offset = g_value_get_boolean(value);
+        break;
+    case PROP_MAX_OFFSET_GAP:
+        hailoimportzmq->max_offset_gap = g_value_get_uint(value);
+        break;
+    case PROP_FORMAT:
+        hailoimportzmq->format = (HailoMetadataFormat)g_value_get_enum(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -129,6 +181,18 @@ void gst_hailoimportzmq_get_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         g_value_set_string(value, hailoimportzmq->address);
         break;
+    case PROP_TIMEOUT:
+        g_value_set_int(value, hailoimportzmq->timeout);
+        break;
+    case PROP_MATCH_OFFSET:
+        g_value_set_boolean(value, hailoimportzmq->match_offset);
+        break;
+    case PROP_MAX_OFFSET_GAP:
+        g_value_set_uint(value, hailoimportzmq->max_offset_gap);
+        break;
+    case PROP_FORMAT:
+        g_value_set_enum(value, hailoimportzmq->format);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -176,6 +240,8 @@ gst_hailoimportzmq_start(GstBaseTransform *trans)
                   err.what());
         return FALSE;
     }
+    hailoimportzmq->frame_offset = 0;
+    hailoimportzmq->offset_anchored = FALSE;
 
     return TRUE;
 }
@@ -190,41 +256,192 @@ gst_hailoimportzmq_stop(GstBaseTransform *trans)
     hailoimportzmq->socket->close();
     hailoimportzmq->context->close();
 
+    hailoimportzmq->pending_message = nullptr;
+    hailoimportzmq->offset_anchored = FALSE;
+
     return TRUE;
 }
 
-static GstFlowReturn
-gst_hailoimportzmq_transform_ip(GstBaseTransform *trans,
-                                GstBuffer *buffer)
+/**
+ * @brief Wait for the next message.
+ *
+ * @param hailoimportzmq The element.
+ * @param message The message to receive into.
+ * @param timeout Milliseconds to wait for the message, -1 waits forever.
+ * @return gboolean TRUE if a message was received.
+ */
+static gboolean
+gst_hailoimportzmq_receive(GstHailoImportZMQ *hailoimportzmq, zmq::message_t &message, gint timeout)
 {
-    GstHailoImportZMQ *hailoimportzmq = GST_HAILO_IMPORT_ZMQ(trans);
-
-    // Get the roi from the current buffer and decode it to a JSON entry
-    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
+    // Sleep in zmq_poll until a message arrives instead of spinning on a non-blocking recv
+    zmq::pollitem_t poll_item = {hailoimportzmq->socket->handle(), 0, ZMQ_POLLIN, 0};
+    int poll_result = zmq_poll(&poll_item, 1, timeout);
+    if (poll_result < 0)
+    {
+        GST_WARNING_OBJECT(hailoimportzmq, "hailoimportzmq failed to poll socket! Error: %s", zmq_strerror(zmq_errno()));
+        return FALSE;
+    }
+    if (poll_result == 0)
+        return FALSE;
 
-    // Recv the message
-    zmq::message_t recv_message;
 #if (CPPZMQ_VERSION_MAJOR >= 4 && CPPZMQ_VERSION_MINOR >= 6 && CPPZMQ_VERSION_PATCH >= 0)
-    zmq::recv_result_t recv_succeeded = 0;
+    zmq::recv_result_t recv_succeeded = hailoimportzmq->socket->recv(message, zmq::recv_flags(ZMQ_DONTWAIT));
 #else
-    zmq::detail::recv_result_t recv_succeeded = 0;
+    zmq::detail::recv_result_t recv_succeeded = hailoimportzmq->socket->recv(message, zmq::recv_flags(ZMQ_DONTWAIT));
 #endif
-    while (recv_message.size() == 0)
+    if (!recv_succeeded)
     {
-        recv_succeeded = hailoimportzmq->socket->recv(recv_message, zmq::recv_flags(ZMQ_DONTWAIT));
-        sleep(0);  // yield the scheduler to prevent the thread from spinning the CPU core
+        GST_WARNING_OBJECT(hailoimportzmq, "hailoimportzmq failed to receive message!");
+        return FALSE;
     }
-    if (recv_succeeded <= 0)
-        GST_WARNING("hailoimportzmq failed to send buffer!");
-
-    // Decode the recvd JSON
-    std::string rx_str;
-    rx_str.assign(static_cast<char *>(recv_message.data()), recv_message.size());
-    rapidjson::Document decoded_stream;
-    if (decoded_stream.Parse(rx_str).HasParseError()) {
-        GST_ERROR("hailoimportzmq failed to parse message to json!");
+    return TRUE;
+}
+
+/**
+ * @brief Decode a message straight from the message buffer, in the format of the element.
+ *
+ * @param hailoimportzmq The element.
+ * @param message The received message.
+ * @param roi The roi to add the decoded objects to.
+ * @param message_offset Set to the buffer_offset of the message, or -1 if the message has none.
+ * @return gboolean TRUE if the message was decoded.
+ */
+static gboolean
+gst_hailoimportzmq_decode(GstHailoImportZMQ *hailoimportzmq, zmq::message_t &message, HailoROIPtr roi, gint64 &message_offset)
+{
+    if (hailoimportzmq->format == HAILO_METADATA_FORMAT_BINARY)
+    {
+        try
+        {
+            binary_meta::Reader reader(message.data(), message.size());
+            decode_binary::MessageHeader header = decode_binary::decode_header(reader);
+            message_offset = header.buffer_offset;
+            decode_binary::decode_hailo_roi(reader, roi);
+        }
+        catch (const std::runtime_error &err)
+        {
+            GST_ERROR_OBJECT(hailoimportzmq, "hailoimportzmq failed to decode binary message! Error: %s", err.what());
+            return FALSE;
+        }
+        return TRUE;
     }
-    decode_json::decode_hailo_roi(decoded_stream, hailo_roi);
+
+    rapidjson::Document document;
+    if (document.Parse(static_cast<const char *>(message.data()), message.size()).HasParseError())
+    {
+        GST_ERROR_OBJECT(hailoimportzmq, "hailoimportzmq failed to parse message to json! Error: %s",
+                         rapidjson::GetParseError_En(document.GetParseError()));
+        return FALSE;
+    }
+    message_offset = document.HasMember("buffer_offset") ? document["buffer_offset"].GetInt64() : -1;
+    decode_json::decode_hailo_roi(document, roi);
+    return TRUE;
+}
+
+/**
+ * @brief Move the objects decoded into a message roi to the roi of a buffer.
+ */
+static void
+gst_hailoimportzmq_move_objects(HailoROIPtr message_roi, HailoROIPtr roi)
+{
+    for (HailoObjectPtr &obj : message_roi->get_objects())
+        roi->add_object(obj);
+}
+
+/**
+ * @brief Import the message of a buffer into its roi.
+ *        Without match-offset this is the next message. With match-offset it is the message
+ *        whose buffer_offset matches the buffer: older messages are dropped, and a message of
+ *        a later buffer is kept until that buffer arrives.
+ *        The exporter counts its buffers since it started, which is not when this element started,
+ *        so the offsets are anchored on the first message: its buffer_offset is taken as the offset
+ *        of the buffer it arrived for. A message further than max-offset-gap from the expected
+ *        offset re-anchors the matching the same way, so a restart on either side resyncs.
+ *
+ * @param hailoimportzmq The element.
+ * @param frame_offset The offset of the buffer, counted since the element started.
+ * @param roi The roi of the buffer.
+ * @return gboolean TRUE if a message for this buffer was found before the timeout.
+ */
+static gboolean
+gst_hailoimportzmq_import_message(GstHailoImportZMQ *hailoimportzmq, guint64 frame_offset, HailoROIPtr roi)
+{
+    if (hailoimportzmq->pending_message != nullptr)
+    {
+        if (hailoimportzmq->pending_offset > (gint64)frame_offset + hailoimportzmq->offset_delta)
+            return FALSE;
+        gst_hailoimportzmq_move_objects(hailoimportzmq->pending_message, roi);
+        hailoimportzmq->pending_message = nullptr;
+        return TRUE;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(hailoimportzmq->timeout);
+    while (true)
+    {
+        gint timeout = -1;
+        if (hailoimportzmq->timeout >= 0)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            timeout = std::max<gint>(0, remaining);
+        }
+
+        zmq::message_t message;
+        if (!gst_hailoimportzmq_receive(hailoimportzmq, message, timeout))
+            return FALSE;
+
+        // Decode aside: a message that fails partway leaves nothing on the buffer,
+        // and with match-offset the message may belong to another buffer
+        gint64 message_offset;
+        HailoROIPtr message_roi = hailo_make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+        if (!gst_hailoimportzmq_decode(hailoimportzmq, message, message_roi, message_offset))
+            return FALSE;
+
+        if (!hailoimportzmq->match_offset || message_offset < 0)
+        {
+            gst_hailoimportzmq_move_objects(message_roi, roi);
+            return TRUE;
+        }
+
+        gint64 expected_offset = (gint64)frame_offset + hailoimportzmq->offset_delta;
+        if (!hailoimportzmq->offset_anchored || std::llabs(message_offset - expected_offset) > (gint64)hailoimportzmq->max_offset_gap)
+        {
+            if (hailoimportzmq->offset_anchored)
+                GST_WARNING_OBJECT(hailoimportzmq, "Message of buffer %" G_GINT64_FORMAT " while expecting %" G_GINT64_FORMAT ", resyncing",
+                                   message_offset, expected_offset);
+            hailoimportzmq->offset_delta = message_offset - (gint64)frame_offset;
+            hailoimportzmq->offset_anchored = TRUE;
+            expected_offset = message_offset;
+        }
+
+        if (message_offset == expected_offset)
+        {
+            gst_hailoimportzmq_move_objects(message_roi, roi);
+            return TRUE;
+        }
+        if (message_offset > expected_offset)
+        {
+            // The message belongs to a later buffer, so this buffer's message is lost
+            hailoimportzmq->pending_message = message_roi;
+            hailoimportzmq->pending_offset = message_offset;
+            return FALSE;
+        }
+        GST_DEBUG_OBJECT(hailoimportzmq, "Dropping message of buffer %" G_GINT64_FORMAT " while expecting %" G_GINT64_FORMAT,
+                         message_offset, expected_offset);
+    }
+}
+
+static GstFlowReturn
+gst_hailoimportzmq_transform_ip(GstBaseTransform *trans,
+                                GstBuffer *buffer)
+{
+    GstHailoImportZMQ *hailoimportzmq = GST_HAILO_IMPORT_ZMQ(trans);
+
+    // Get the roi from the current buffer and decode the received message to it
+    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
+
+    if (!gst_hailoimportzmq_import_message(hailoimportzmq, hailoimportzmq->frame_offset, hailo_roi))
+        GST_DEBUG_OBJECT(hailoimportzmq, "No message imported to buffer %" G_GUINT64_FORMAT, hailoimportzmq->frame_offset);
+    hailoimportzmq->frame_offset++;
 
     GST_DEBUG_OBJECT(hailoimportzmq, "transform_ip");
     return GST_FLOW_OK;
@@ -7,6 +7,8 @@
 #include <gst/base/gstbasetransform.h>
 #include "hailo_objects.hpp"
 #include "import/decode_json.hpp"
+#include "import/decode_binary.hpp"
+#include "common/metadata_format.hpp"
 #include <cstdio>
 #include <zmq.hpp>
 
@@ -25,6 +27,15 @@ struct _GstHailoImportZMQ
 {
     GstBaseTransform base_hailoimportzmq;
     gchar *address;
+    gint timeout;
+    gboolean match_offset;
+    guint max_offset_gap;
+    HailoMetadataFormat format;
+    guint64 frame_offset;
+    gboolean offset_anchored;
+    gint64 offset_delta; // Exporter buffer_offset minus frame_offset
+    HailoROIPtr pending_message;
+    gint64 pending_offset;
     zmq::context_t *context;
     zmq::socket_t *socket;
 };
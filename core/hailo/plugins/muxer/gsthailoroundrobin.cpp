@@ -71,6 +71,8 @@ struct _GstHailoRoundRobinPad
 {
     GstPad parent;
     gboolean got_eos;
+    size_t pad_num;
+    gchar *pad_name;
 };
 
 struct _GstHailoRoundRobinPadClass
@@ -78,14 +80,10 @@ struct _GstHailoRoundRobinPadClass
     GstPadClass parent;
 };
 
-static size_t get_pad_num(GstPad *pad)
+static inline size_t get_pad_num(GstPad *pad)
 {
-    gchar *name = gst_pad_get_name(pad);
-    std::string pad_name_str(name);
-    std::string pad_num_str = pad_name_str.substr(pad_name_str.find_first_of("0123456789"));
-    size_t pad_num = stoi(pad_num_str);
-    g_free(name);
-    return pad_num;
+    // The pad number is resolved once when the pad is requested.
+    return GST_HAILO_ROUND_ROBIN_PAD_CAST(pad)->pad_num;
 }
 
 G_DEFINE_TYPE(GstHailoRoundRobinPad, gst_hailo_round_robin_pad, GST_TYPE_PAD);
@@ -100,17 +98,33 @@ enum
     PROP_QUEUE_SIZE,
     PROP_WAIT_TIME,
     PROP_PREROLL_FRAMES,
+    PROP_IDLE_TIME,
+    PROP_FAIRNESS_SKEW,
+    PROP_STATS,
 };
 
+static void
+gst_hailo_round_robin_pad_finalize(GObject *object)
+{
+    GstHailoRoundRobinPad *pad = GST_HAILO_ROUND_ROBIN_PAD_CAST(object);
+    g_free(pad->pad_name);
+    pad->pad_name = NULL;
+    G_OBJECT_CLASS(gst_hailo_round_robin_pad_parent_class)->finalize(object);
+}
+
 static void
 gst_hailo_round_robin_pad_class_init(GstHailoRoundRobinPadClass *klass)
 {
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    gobject_class->finalize = gst_hailo_round_robin_pad_finalize;
 }
 
 static void
 gst_hailo_round_robin_pad_init(GstHailoRoundRobinPad *pad)
 {
     pad->got_eos = FALSE;
+    pad->pad_num = 0;
+    pad->pad_name = NULL;
 }
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink_%u",
@@ -155,6 +169,8 @@ static GstPad *gst_hailo_round_robin_request_new_pad(GstElement *element,
 
 static void gst_hailo_round_robin_release_pad(GstElement *element, GstPad *pad);
 static void gst_hailo_round_robin_dispose(GObject *object);
+static gdouble gst_hailo_round_robin_get_fairness_skew(GstHailoRoundRobin *hailo_round_robin);
+static GstStructure *gst_hailo_round_robin_get_stats(GstHailoRoundRobin *hailo_round_robin);
 
 static void
 gst_hailo_round_robin_set_property(GObject *object, guint prop_id,
@@ -214,6 +230,19 @@ gst_hailo_round_robin_get_property(GObject *object, guint prop_id, GValue *value
     case PROP_PREROLL_FRAMES:
         g_value_set_uint(value, GST_HAILO_ROUND_ROBIN(object)->preroll_frames);
         break;
+    case PROP_IDLE_TIME:
+    {
+        GstHailoRoundRobin *hailo_round_robin = GST_HAILO_ROUND_ROBIN(object);
+        std::lock_guard<std::mutex> lock(*hailo_round_robin->queues_mutex);
+        g_value_set_uint64(value, hailo_round_robin->idle_time);
+        break;
+    }
+    case PROP_FAIRNESS_SKEW:
+        g_value_set_double(value, gst_hailo_round_robin_get_fairness_skew(GST_HAILO_ROUND_ROBIN(object)));
+        break;
+    case PROP_STATS:
+        g_value_take_boxed(value, gst_hailo_round_robin_get_stats(GST_HAILO_ROUND_ROBIN(object)));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -265,73 +294,136 @@ forward_events(GstPad *pad, GstEvent **event, gpointer user_data)
     return res;
 }
 
+/**
+ * @brief Pops the next buffer of a pad queue and releases a producer waiting for space in it.
+ *        Must be called with queues_mutex held and a non-empty queue.
+ */
+static GstBuffer *pop_pad_queue_unlocked(GstHailoRoundRobin *hailo_round_robin, uint pad_num)
+{
+    HailoRoundRobinQueuedBuffer queued = hailo_round_robin->pad_queues[pad_num]->front();
+    hailo_round_robin->pad_queues[pad_num]->pop();
+    hailo_round_robin->queued_buffers--;
+
+    HailoRoundRobinPadStats &stats = hailo_round_robin->pad_stats[pad_num];
+    stats.pushed_buffers++;
+    stats.total_wait_time += g_get_monotonic_time() - queued.enqueue_time;
+
+    if (hailo_round_robin->condition_vars_non_blocking[pad_num] != NULL)
+        hailo_round_robin->condition_vars_non_blocking[pad_num]->notify_one();
+    return queued.buffer;
+}
+
 void schedule(GstHailoRoundRobin *hailo_round_robin)
 {
     GstFlowReturn res;
+    std::unique_lock<std::mutex> lock(*hailo_round_robin->queues_mutex);
     while (!hailo_round_robin->stop_thread)
     {
-        // iterate the pad queues and push the first buffer in each queueq
-        for (uint i = 0; i < hailo_round_robin->pad_queues.size(); i++)
+        // Block until at least one pad has a buffer waiting, instead of spinning over empty queues.
+        if (hailo_round_robin->queued_buffers == 0)
+        {
+            gint64 idle_start = g_get_monotonic_time();
+            hailo_round_robin->schedule_cond_var->wait(lock, [hailo_round_robin]
+                                                       { return hailo_round_robin->stop_thread || hailo_round_robin->queued_buffers > 0; });
+            hailo_round_robin->idle_time += g_get_monotonic_time() - idle_start;
+            continue;
+        }
+
+        // iterate the pad queues and push the first buffer in each queue
+        for (uint i = 0; i < hailo_round_robin->pad_queues.size() && !hailo_round_robin->stop_thread; i++)
         {
-            if (hailo_round_robin->pad_queues[i] != NULL)
+            if (hailo_round_robin->pad_queues[i] == NULL || hailo_round_robin->sink_pads[i] == NULL)
+                continue;
+
+            // Give a late pad a bounded chance to deliver before skipping it. Producers signal on every enqueue,
+            // so the wait ends as soon as the buffer arrives.
+            std::chrono::milliseconds wait_time(hailo_round_robin->wait_time * hailo_round_robin->retries_num);
+            if (hailo_round_robin->pad_queues[i]->empty() && wait_time.count() > 0)
+            {
+                hailo_round_robin->schedule_cond_var->wait_for(lock, wait_time, [hailo_round_robin, i]
+                                                               { return hailo_round_robin->stop_thread || !hailo_round_robin->pad_queues[i]->empty(); });
+            }
+            if (hailo_round_robin->stop_thread || hailo_round_robin->pad_queues[i]->empty())
+                continue;
+
+            set_current_pad_num(hailo_round_robin, i);
+            GstBuffer *buf = pop_pad_queue_unlocked(hailo_round_robin, i);
+            GstPad *pad = GST_PAD_CAST(gst_object_ref(hailo_round_robin->sink_pads[i]));
+
+            // Push without holding the queues lock, so producers can keep queueing.
+            lock.unlock();
+            gchar *stream_id = gst_pad_get_stream_id(pad);
+
+            // Add stream meta to the buffer including the pad name and stream id.
+            gst_buffer_add_hailo_stream_meta(buf, GST_HAILO_ROUND_ROBIN_PAD_CAST(pad)->pad_name, stream_id);
+
+            // Forward sticky events.
+            gst_pad_sticky_events_foreach(pad, forward_events, hailo_round_robin->srcpad);
+
+            // Push out_buffer forward.
+            res = gst_pad_push(hailo_round_robin->srcpad, buf);
+            if (res != GST_FLOW_OK)
             {
-                for (uint j = 0; j <= hailo_round_robin->retries_num; j++)
-                {
-                    if (hailo_round_robin->pad_queues[i]->empty())
-                    {
-                        if (j < hailo_round_robin->retries_num) // don't sleep on the last iteration
-                        {
-                            sleep((float)hailo_round_robin->wait_time / 1000.0);
-                        }
-                    }
-                    else
-                    {
-                        set_current_pad_num(hailo_round_robin, i);
-                        GstBuffer *buf = hailo_round_robin->pad_queues[i]->front();
-                        hailo_round_robin->pad_queues[i]->pop();
-                        if (hailo_round_robin->condition_vars_non_blocking[i] == NULL)
-                        {
-                            continue;
-                        }
-                        hailo_round_robin->condition_vars_non_blocking[i]->notify_one();
-
-                        GstPad *pad = gst_element_get_static_pad(GST_ELEMENT_CAST(hailo_round_robin), ("sink_" + std::to_string(i)).c_str());
-
-                        if (pad == NULL) // not found, will try different method - maybe the pad names are hailoroundrobinpad0, hailoroundrobinpad1, etc.
-                        {
-                            pad = gst_element_get_static_pad(GST_ELEMENT_CAST(hailo_round_robin), ("hailoroundrobinpad" + std::to_string(i)).c_str());
-                            if (pad == NULL)
-                            {
-                                GST_ERROR_OBJECT(hailo_round_robin, "Failed to get pad %d", i);
-                                continue;
-                            }
-                        }
-                        gchar *pad_name = gst_pad_get_name(pad);
-                        gchar *stream_id = gst_pad_get_stream_id(pad);
-
-                        // Add stream meta to the buffer including the pad name and stream id.
-                        gst_buffer_add_hailo_stream_meta(buf, pad_name, stream_id);
-
-                        // Forward sticky events.
-                        gst_pad_sticky_events_foreach(pad, forward_events, hailo_round_robin->srcpad);
-
-                        // Push out_buffer forward.
-                        res = gst_pad_push(hailo_round_robin->srcpad, buf);
-                        if (res != GST_FLOW_OK)
-                        {
-                            GST_ERROR_OBJECT(hailo_round_robin, "Failed to push buffer to srcpad");
-                        }
-                        gst_object_unref(pad);
-                        g_free(pad_name);
-                        g_free(stream_id);
-                        break; // make sure it only pushes 1 buffer per pad
-                    }
-                }
+                GST_ERROR_OBJECT(hailo_round_robin, "Failed to push buffer to srcpad");
             }
+            gst_object_unref(pad);
+            g_free(stream_id);
+            lock.lock();
         }
     }
 }
 
+static gdouble
+gst_hailo_round_robin_get_fairness_skew(GstHailoRoundRobin *hailo_round_robin)
+{
+    // The difference between the most and least served pads, relative to the mean number of buffers pushed per pad.
+    std::lock_guard<std::mutex> lock(*hailo_round_robin->queues_mutex);
+    guint64 min_pushed = G_MAXUINT64;
+    guint64 max_pushed = 0;
+    guint64 total_pushed = 0;
+    guint active_pads = 0;
+    for (size_t i = 0; i < hailo_round_robin->pad_stats.size(); i++)
+    {
+        if (hailo_round_robin->sink_pads[i] == NULL)
+            continue;
+        guint64 pushed = hailo_round_robin->pad_stats[i].pushed_buffers;
+        min_pushed = MIN(min_pushed, pushed);
+        max_pushed = MAX(max_pushed, pushed);
+        total_pushed += pushed;
+        active_pads++;
+    }
+    if (active_pads == 0 || total_pushed == 0)
+        return 0.0;
+    return (gdouble)(max_pushed - min_pushed) / ((gdouble)total_pushed / active_pads);
+}
+
+static GstStructure *
+gst_hailo_round_robin_get_stats(GstHailoRoundRobin *hailo_round_robin)
+{
+    gdouble fairness_skew = gst_hailo_round_robin_get_fairness_skew(hailo_round_robin);
+    std::lock_guard<std::mutex> lock(*hailo_round_robin->queues_mutex);
+    GstStructure *stats = gst_structure_new("GstHailoRoundRobinStats",
+                                            "idle-time", G_TYPE_UINT64, hailo_round_robin->idle_time,
+                                            "fairness-skew", G_TYPE_DOUBLE, fairness_skew,
+                                            NULL);
+    for (size_t i = 0; i < hailo_round_robin->pad_stats.size(); i++)
+    {
+        if (hailo_round_robin->sink_pads[i] == NULL)
+            continue;
+        const HailoRoundRobinPadStats &pad_stats = hailo_round_robin->pad_stats[i];
+        guint64 average_wait = pad_stats.pushed_buffers ? pad_stats.total_wait_time / pad_stats.pushed_buffers : 0;
+        GstStructure *pad_structure = gst_structure_new(GST_HAILO_ROUND_ROBIN_PAD_CAST(hailo_round_robin->sink_pads[i])->pad_name,
+                                                        "pushed-buffers", G_TYPE_UINT64, pad_stats.pushed_buffers,
+                                                        "total-wait-time", G_TYPE_UINT64, pad_stats.total_wait_time,
+                                                        "average-wait-time", G_TYPE_UINT64, average_wait,
+                                                        NULL);
+        gst_structure_set(stats, GST_HAILO_ROUND_ROBIN_PAD_CAST(hailo_round_robin->sink_pads[i])->pad_name,
+                          GST_TYPE_STRUCTURE, pad_structure, NULL);
+        gst_structure_free(pad_structure);
+    }
+    return stats;
+}
+
 static void
 gst_hailo_round_robin_class_init(GstHailoRoundRobinClass *klass)
 {
@@ -400,6 +492,31 @@ gst_hailo_round_robin_class_init(GstHailoRoundRobinClass *klass)
                                                       MAX_PREROLL_FRAMES,
                                                       DEFAULT_PREROLL_FRAMES,
                                                       (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_IDLE_TIME,
+                                    g_param_spec_uint64("idle-time",
+                                                        "Idle time",
+                                                        "Accumulated time in microseconds the scheduler was blocked waiting for buffers (only relevant when using non-blocking mode)",
+                                                        0,
+                                                        G_MAXUINT64,
+                                                        0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_FAIRNESS_SKEW,
+                                    g_param_spec_double("fairness-skew",
+                                                        "Fairness skew",
+                                                        "Difference between the most and least served sink pads, relative to the mean number of buffers pushed per pad (only relevant when using non-blocking mode)",
+                                                        0.0,
+                                                        G_MAXDOUBLE,
+                                                        0.0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_STATS,
+                                    g_param_spec_boxed("stats",
+                                                       "Stats",
+                                                       "Scheduler statistics: idle-time, fairness-skew and per pad pushed-buffers and queue wait times in microseconds (only relevant when using non-blocking mode)",
+                                                       GST_TYPE_STRUCTURE,
+                                                       (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
@@ -407,10 +524,16 @@ gst_hailo_round_robin_init(GstHailoRoundRobin *hailo_round_robin)
 {
     hailo_round_robin->current_pad_num = 0;
     hailo_round_robin->mutexes_blocking.clear();
-    hailo_round_robin->mutexes_non_blocking.clear();
     hailo_round_robin->pad_queues.clear();
+    hailo_round_robin->sink_pads.clear();
+    hailo_round_robin->pad_stats.clear();
     hailo_round_robin->condition_vars_blocking.clear();
     hailo_round_robin->condition_vars_non_blocking.clear();
+    hailo_round_robin->queues_mutex = std::make_unique<std::mutex>();
+    hailo_round_robin->schedule_cond_var = std::make_unique<std::condition_variable>();
+    hailo_round_robin->queued_buffers = 0;
+    hailo_round_robin->idle_time = 0;
+    hailo_round_robin->thread = NULL;
     hailo_round_robin->preroll_buffer_counter = 0;
     hailo_round_robin->retries_num = DEFAULT_RETRIES_NUM;
     hailo_round_robin->queue_size = DEFAULT_QUEUE_SIZE;
@@ -431,13 +554,35 @@ static void
 gst_hailo_round_robin_dispose(GObject *object)
 {
     GstHailoRoundRobin *hailo_round_robin = GST_HAILO_ROUND_ROBIN_CAST(object);
+    if (hailo_round_robin->thread != NULL)
+    {
+        {
+            std::lock_guard<std::mutex> lock(*hailo_round_robin->queues_mutex);
+            hailo_round_robin->stop_thread = true;
+        }
+        hailo_round_robin->schedule_cond_var->notify_all();
+        if (hailo_round_robin->thread->joinable())
+            hailo_round_robin->thread->join();
+        delete hailo_round_robin->thread;
+        hailo_round_robin->thread = NULL;
+    }
+    for (auto &pad_queue : hailo_round_robin->pad_queues)
+    {
+        while (pad_queue != NULL && !pad_queue->empty())
+        {
+            gst_buffer_unref(pad_queue->front().buffer);
+            pad_queue->pop();
+        }
+    }
     hailo_round_robin->srcpad = NULL;
     hailo_round_robin->current_pad_num = 0;
     hailo_round_robin->pad_queues.clear();
+    hailo_round_robin->sink_pads.clear();
+    hailo_round_robin->pad_stats.clear();
+    hailo_round_robin->queued_buffers = 0;
     hailo_round_robin->preroll_buffer_counter = 0;
     hailo_round_robin->num_of_sink_pads = 0;
     hailo_round_robin->mutexes_blocking.clear();
-    hailo_round_robin->mutexes_non_blocking.clear();
     hailo_round_robin->condition_vars_blocking.clear();
     hailo_round_robin->condition_vars_non_blocking.clear();
     G_OBJECT_CLASS(parent_class)->dispose(object);
@@ -464,14 +609,18 @@ gst_hailo_round_robin_request_new_pad(GstElement *element, GstPadTemplate *templ
     GST_DEBUG_OBJECT(element, "requesting pad");
 
     std::string pad_name;
-    std::shared_lock lock(*(hailo_round_robin->num_of_pads_mutex.get()));
-    pad_name = "sink_" + std::to_string(hailo_round_robin->num_of_sink_pads);
+    std::unique_lock lock(*(hailo_round_robin->num_of_pads_mutex.get()));
+    size_t pad_num = hailo_round_robin->num_of_sink_pads;
+    pad_name = "sink_" + std::to_string(pad_num);
     hailo_round_robin->num_of_sink_pads++;
     lock.unlock();
 
     sinkpad = GST_PAD_CAST(g_object_new(GST_TYPE_HAILO_ROUND_ROBIN_PAD,
                                         "name", pad_name.c_str(), "direction", templ->direction, "template", templ,
                                         NULL));
+    // Cache the pad number and name so the streaming threads don't have to look them up per buffer.
+    GST_HAILO_ROUND_ROBIN_PAD_CAST(sinkpad)->pad_num = pad_num;
+    GST_HAILO_ROUND_ROBIN_PAD_CAST(sinkpad)->pad_name = g_strdup(pad_name.c_str());
 
     // Set sink_chain and sink_event funtions for the new pad
     switch (hailo_round_robin->mode)
@@ -501,12 +650,15 @@ gst_hailo_round_robin_request_new_pad(GstElement *element, GstPadTemplate *templ
     GST_OBJECT_FLAG_SET(sinkpad, GST_PAD_FLAG_PROXY_ALLOCATION);
 
     hailo_round_robin->mutexes_blocking.emplace_back(std::make_unique<std::mutex>());
-    hailo_round_robin->mutexes_non_blocking.emplace_back(std::make_unique<std::mutex>());
 
     // create a new queue for the new pad
-    hailo_round_robin->pad_queues.emplace_back(std::make_unique<std::queue<GstBuffer *>>());
+    std::unique_lock<std::mutex> queues_lock(*hailo_round_robin->queues_mutex);
+    hailo_round_robin->pad_queues.emplace_back(std::make_unique<std::queue<HailoRoundRobinQueuedBuffer>>());
+    hailo_round_robin->sink_pads.emplace_back(sinkpad);
+    hailo_round_robin->pad_stats.emplace_back(HailoRoundRobinPadStats{0, 0});
     hailo_round_robin->condition_vars_blocking.emplace_back(std::make_unique<std::condition_variable>());
     hailo_round_robin->condition_vars_non_blocking.emplace_back(std::make_unique<std::condition_variable>());
+    queues_lock.unlock();
 
     gst_pad_set_active(sinkpad, TRUE);
 
@@ -554,6 +706,19 @@ gst_hailo_round_robin_release_pad(GstElement *element, GstPad *pad)
     GST_DEBUG_OBJECT(hailo_round_robin, "releasing pad %s:%s", GST_DEBUG_PAD_NAME(pad));
     gst_pad_set_active(pad, FALSE);
 
+    {
+        // Stop the scheduler from picking this pad, and drop whatever is still queued on it.
+        std::lock_guard<std::mutex> lock(*hailo_round_robin->queues_mutex);
+        size_t pad_num = get_pad_num(pad);
+        hailo_round_robin->sink_pads[pad_num] = NULL;
+        while (!hailo_round_robin->pad_queues[pad_num]->empty())
+        {
+            gst_buffer_unref(hailo_round_robin->pad_queues[pad_num]->front().buffer);
+            hailo_round_robin->pad_queues[pad_num]->pop();
+            hailo_round_robin->queued_buffers--;
+        }
+    }
+
     if (hailo_round_robin->condition_vars_blocking[get_pad_num(pad)] != NULL)
         hailo_round_robin->condition_vars_blocking[get_pad_num(pad)]->notify_all();
 
@@ -596,11 +761,10 @@ gst_hailo_round_robin_sink_chain_preroll(GstPad *pad, GstObject *parent, GstBuff
 
     buf = gst_buffer_make_writable(buf);
 
-    gchar *pad_name = gst_pad_get_name(pad);
     gchar *stream_id = gst_pad_get_stream_id(pad);
 
     // Add stream meta to the buffer including the pad name and stream id.
-    gst_buffer_add_hailo_stream_meta(buf, pad_name, stream_id);
+    gst_buffer_add_hailo_stream_meta(buf, GST_HAILO_ROUND_ROBIN_PAD_CAST(pad)->pad_name, stream_id);
 
     // Forward sticky events.
     gst_pad_sticky_events_foreach(pad, forward_events, hailo_round_robin->srcpad);
@@ -613,9 +777,7 @@ gst_hailo_round_robin_sink_chain_preroll(GstPad *pad, GstObject *parent, GstBuff
     if (get_buffer_counter_value(hailo_round_robin) == (int)(hailo_round_robin->mutexes_blocking.size() * hailo_round_robin->preroll_frames))
     {
         set_buffer_counter_value(hailo_round_robin, -1); // don't use it anymore
-        std::thread schedule_thread(schedule, hailo_round_robin);
-        hailo_round_robin->thread = std::move(&schedule_thread);
-        hailo_round_robin->thread->detach();
+        hailo_round_robin->thread = new std::thread(schedule, hailo_round_robin);
         set_chain_to_all_pads(hailo_round_robin, gst_hailo_round_robin_sink_chain_non_blocking_mode);
         hailo_round_robin->current_pad_num = 0;
 
@@ -627,7 +789,6 @@ gst_hailo_round_robin_sink_chain_preroll(GstPad *pad, GstObject *parent, GstBuff
         }
     }
 
-    g_free(pad_name);
     g_free(stream_id);
 
     if (get_buffer_counter_value(hailo_round_robin) != -1)
@@ -681,11 +842,10 @@ gst_hailo_round_robin_sink_chain_blocking_mode(GstPad *pad, GstObject *parent, G
 
     buf = gst_buffer_make_writable(buf);
 
-    gchar *pad_name = gst_pad_get_name(pad);
     gchar *stream_id = gst_pad_get_stream_id(pad);
 
     // Add stream meta to the buffer including the pad name and stream id.
-    gst_buffer_add_hailo_stream_meta(buf, pad_name, stream_id);
+    gst_buffer_add_hailo_stream_meta(buf, GST_HAILO_ROUND_ROBIN_PAD_CAST(pad)->pad_name, stream_id);
 
     // Forward sticky events.
     gst_pad_sticky_events_foreach(pad, forward_events, hailo_round_robin->srcpad);
@@ -693,7 +853,6 @@ gst_hailo_round_robin_sink_chain_blocking_mode(GstPad *pad, GstObject *parent, G
     // Push out_buffer forward.
     ret = gst_pad_push(hailo_round_robin->srcpad, buf);
 
-    g_free(pad_name);
     g_free(stream_id);
 
     hailo_round_robin->current_pad_num++;
@@ -716,17 +875,15 @@ gst_hailo_round_robin_sink_chain_funnel_mode(GstPad *pad, GstObject *parent, Gst
     GstFlowReturn ret = GST_FLOW_ERROR;
     GstHailoRoundRobin *hailo_round_robin = GST_HAILO_ROUND_ROBIN_CAST(parent);
     buf = gst_buffer_make_writable(buf);
-    gchar *pad_name = gst_pad_get_name(pad);
     gchar *stream_id = gst_pad_get_stream_id(pad);
 
     // Add stream meta to the buffer including the pad name and stream id.
-    gst_buffer_add_hailo_stream_meta(buf, pad_name, stream_id);
+    gst_buffer_add_hailo_stream_meta(buf, GST_HAILO_ROUND_ROBIN_PAD_CAST(pad)->pad_name, stream_id);
 
     // Forward sticky events.
     gst_pad_sticky_events_foreach(pad, forward_events, hailo_round_robin->srcpad);
 
     ret = gst_pad_push(hailo_round_robin->srcpad, buf);
-    g_free(pad_name);
     g_free(stream_id);
     return ret;
 }
@@ -740,11 +897,24 @@ gst_hailo_round_robin_sink_chain_non_blocking_mode(GstPad *pad, GstObject *paren
 
     if (hailo_round_robin->condition_vars_non_blocking[pad_num] != NULL)
     {
-        std::unique_lock lock(*hailo_round_robin->mutexes_non_blocking[pad_num].get());
+        // The scheduler may stamp stream meta on the buffer, make sure it can.
+        buf = gst_buffer_make_writable(buf);
+        std::unique_lock<std::mutex> lock(*hailo_round_robin->queues_mutex);
         hailo_round_robin->condition_vars_non_blocking[pad_num]->wait(lock, [hailo_round_robin, pad_num]
-                                                                      { return hailo_round_robin->pad_queues[pad_num]->size() < hailo_round_robin->queue_size; });
+                                                                      { return hailo_round_robin->stop_thread ||
+                                                                               hailo_round_robin->pad_queues[pad_num]->size() < hailo_round_robin->queue_size; });
+        if (hailo_round_robin->stop_thread || hailo_round_robin->sink_pads[pad_num] == NULL)
+        {
+            lock.unlock();
+            gst_buffer_unref(buf);
+            return GST_FLOW_FLUSHING;
+        }
 
-        hailo_round_robin->pad_queues[pad_num]->push(buf);
+        hailo_round_robin->pad_queues[pad_num]->push(HailoRoundRobinQueuedBuffer{buf, g_get_monotonic_time()});
+        hailo_round_robin->queued_buffers++;
+        lock.unlock();
+        // Wake up the scheduler.
+        hailo_round_robin->schedule_cond_var->notify_one();
     }
     else
     {
@@ -836,7 +1006,11 @@ gst_hailo_round_robin_change_state(GstElement *element, GstStateChange transitio
     {
         if (hailo_round_robin->mode != GST_HAILO_ROUND_ROBIN_MODE_FUNNEL_MODE)
         {
-            hailo_round_robin->stop_thread = true;
+            {
+                std::lock_guard<std::mutex> lock(*hailo_round_robin->queues_mutex);
+                hailo_round_robin->stop_thread = true;
+            }
+            hailo_round_robin->schedule_cond_var->notify_all();
             for (uint i = 0; i < hailo_round_robin->condition_vars_blocking.size(); i++)
             {
                 if (hailo_round_robin->condition_vars_blocking[i] != NULL)
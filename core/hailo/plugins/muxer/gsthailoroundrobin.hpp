@@ -19,9 +19,28 @@
 #include <condition_variable>
 #include <pthread.h>
 #include <thread>
+#include <chrono>
 
 G_BEGIN_DECLS
 
+/**
+ * A buffer waiting in a pad queue, along with the time (monotonic, in microseconds) it was queued at.
+ */
+struct HailoRoundRobinQueuedBuffer
+{
+    GstBuffer *buffer;
+    gint64 enqueue_time;
+};
+
+/**
+ * Per sink pad scheduler statistics (non-blocking mode).
+ */
+struct HailoRoundRobinPadStats
+{
+    guint64 pushed_buffers;
+    guint64 total_wait_time; // Accumulated time (us) buffers spent in the pad queue.
+};
+
 #define GST_TYPE_HAILO_ROUND_ROBIN \
     (gst_hailo_round_robin_get_type())
 #define GST_HAILO_ROUND_ROBIN(obj) \
@@ -62,12 +81,17 @@ struct _GstHailoRoundRobin
     uint wait_time;
     uint preroll_frames;
     std::vector<std::unique_ptr<std::mutex>> mutexes_blocking;
-    std::vector<std::unique_ptr<std::mutex>> mutexes_non_blocking;
     std::unique_ptr<std::shared_mutex> counter_mutex;
     int preroll_buffer_counter;
     std::vector<std::unique_ptr<std::condition_variable>> condition_vars_blocking;
     std::vector<std::unique_ptr<std::condition_variable>> condition_vars_non_blocking;
-    std::vector<std::unique_ptr<std::queue<GstBuffer *>>> pad_queues;
+    std::vector<std::unique_ptr<std::queue<HailoRoundRobinQueuedBuffer>>> pad_queues;
+    std::vector<GstPad *> sink_pads; // Cached at request time, indexed by pad number.
+    std::vector<HailoRoundRobinPadStats> pad_stats;
+    std::unique_ptr<std::mutex> queues_mutex;                   // Guards pad_queues, sink_pads and pad_stats.
+    std::unique_ptr<std::condition_variable> schedule_cond_var; // Signaled by producers whenever a buffer is queued.
+    guint64 queued_buffers;                                     // Total number of buffers waiting in all pad queues.
+    guint64 idle_time;                                          // Accumulated time (us) the scheduler was blocked with no data.
     std::thread *thread;
     gboolean stop_thread;
     std::unique_ptr<std::shared_mutex> current_pad_mutex;
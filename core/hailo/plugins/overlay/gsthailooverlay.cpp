@@ -8,6 +8,7 @@
 #include "overlay/gsthailooverlay.hpp"
 #include "common/image.hpp"
 #include "overlay/overlay.hpp"
+#include "overlay/overlay_renderer.hpp"
 #include "gst_hailo_meta.hpp"
 #ifdef HAILO15_TARGET
 #include "buffer_utils.hpp"
@@ -89,7 +90,7 @@ gst_hailooverlay_class_init(GstHailoOverlayClass *klass)
                                                          (GParamFlags)(GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
     // install property mask-overlay-n-threads uint default value 0
     g_object_class_install_property(gobject_class, PROP_MASK_OVERLAY_N_THREADS,
-                                    g_param_spec_uint("mask-overlay-n-threads", "mask-overlay-n-threads", "Number of threads to use for parallel mask drawing. Default 0 (Will use the default value OpenCV initializes - effected by the system capabilities).", 0, G_MAXUINT, 0,
+                                    g_param_spec_uint("mask-overlay-n-threads", "mask-overlay-n-threads", "Number of threads to use for drawing the overlay (masks, boxes and text), including the streaming thread. Default 0 (One thread per core).", 0, G_MAXUINT, 0,
                                                       (GParamFlags)(GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
     g_object_class_install_property(gobject_class, PROP_LOCAL_GALLERY,
                                     g_param_spec_boolean("local-gallery", "local-gallery", "Whether to display Identified and UnIdentified ROI's taken from the local gallery, as well as the Global ID they receive.", false,
@@ -215,6 +216,7 @@ gst_hailooverlay_start(GstBaseTransform *trans)
 {
     GstHailoOverlay *hailooverlay = GST_HAILO_OVERLAY(trans);
     GST_DEBUG_OBJECT(hailooverlay, "start");
+    hailooverlay->renderer = new OverlayRenderer(hailooverlay->mask_overlay_n_threads);
 
     return TRUE;
 }
@@ -224,6 +226,8 @@ gst_hailooverlay_stop(GstBaseTransform *trans)
 {
     GstHailoOverlay *hailooverlay = GST_HAILO_OVERLAY(trans);
     GST_DEBUG_OBJECT(hailooverlay, "stop");
+    delete hailooverlay->renderer;
+    hailooverlay->renderer = nullptr;
 
     return TRUE;
 }
@@ -270,7 +274,7 @@ gst_hailooverlay_transform_ip(GstBaseTransform *trans,
             face_blur(*hmat.get(), hailo_roi);
         }
         // Draw all results of the given roi on mat.
-        ret = draw_all(*hmat.get(), hailo_roi, hailooverlay->landmark_point_radius, hailooverlay->show_confidence, hailooverlay->local_gallery, hailooverlay->mask_overlay_n_threads);
+        ret = draw_all(*hmat.get(), hailo_roi, hailooverlay->landmark_point_radius, hailooverlay->show_confidence, hailooverlay->local_gallery, hailooverlay->renderer);
     }
     if (ret != OVERLAY_STATUS_OK)
     {
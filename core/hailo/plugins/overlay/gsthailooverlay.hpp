@@ -16,6 +16,8 @@ G_BEGIN_DECLS
 #define GST_IS_HAILO_OVERLAY(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_HAILO_OVERLAY))
 #define GST_IS_HAILO_OVERLAY_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_HAILO_OVERLAY))
 
+class OverlayRenderer;
+
 typedef struct _GstHailoOverlay GstHailoOverlay;
 typedef struct _GstHailoOverlayClass GstHailoOverlayClass;
 
@@ -29,6 +31,7 @@ struct _GstHailoOverlay
     gboolean show_confidence;
     gboolean local_gallery;
     guint mask_overlay_n_threads;
+    OverlayRenderer *renderer;
 };
 
 struct _GstHailoOverlayClass
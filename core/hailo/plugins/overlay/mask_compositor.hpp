@@ -0,0 +1,368 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include "hailo_objects.hpp"
+#include "common/hailomat.hpp"
+
+#define CONFIDENCE 0.5
+#define DEPTH_MIN_DISTANCE 0.5
+#define DEPTH_MAX_DISTANCE 3
+
+cv::Scalar indexToColor(size_t index);
+
+/**
+ * @brief Blends the masks of a frame (depth, class and confidence class masks) into the frame.
+ *        Masks are queued with add(), prepared once per frame with prepare(), and blended by the caller's
+ *        bands of rows with composite_rows(), so each band blends every mask that covers it while the rows
+ *        are in cache. The resize is fused into the blend
+ *        (every frame pixel samples its mask directly, bilinear for confidence and depth masks, nearest
+ *        for class ids), and colors come from per mask tables already premultiplied by the transparency.
+ *        RGB, RGBA, YUY2 and NV12 frames are blended in their own format, nothing is converted.
+ */
+class MaskCompositor
+{
+private:
+    static constexpr int ALPHA_ONE = 256;
+
+    enum class MaskKind
+    {
+        DEPTH,
+        CLASS,
+        CONF_CLASS,
+    };
+
+    struct Job
+    {
+        MaskKind kind;
+        HailoMaskPtr mask; // Keeps the data alive until the frame is composited
+        const void *data;
+        int mask_width;
+        int mask_height;
+        cv::Rect rect; // Destination in frame pixels
+        int alpha;     // transparency * ALPHA_ONE
+        float depth_min;
+        float depth_scale;
+        // Source column of every destination column, and the weight of the next column for bilinear sampling
+        std::vector<int> x0;
+        std::vector<float> fx;
+        // Color of every class in the frame's color space, premultiplied by alpha
+        std::array<std::array<int, 3>, 256> colors;
+    };
+
+    std::vector<Job> m_jobs; // Kept between frames so their tables are reused
+    size_t m_job_count = 0;
+
+    static uint8_t blend(int pixel, int alpha, int premultiplied)
+    {
+        return (pixel * (ALPHA_ONE - alpha) + premultiplied) >> 8;
+    }
+
+    /**
+     * @brief Sample the mask for one destination row.
+     *
+     * @param on set to 1 for the pixels that are painted
+     * @param color the premultiplied color of every painted pixel
+     */
+    static void sample_row(const Job &job, int row, uint8_t *on, std::array<int, 3> *color)
+    {
+        const int width = job.rect.width;
+        if (job.kind == MaskKind::CLASS)
+        {
+            // Class ids can't be interpolated, take the nearest one
+            int y = std::min((int)(row * (float)job.mask_height / job.rect.height), job.mask_height - 1);
+            const uint8_t *source = static_cast<const uint8_t *>(job.data) + (size_t)y * job.mask_width;
+            for (int x = 0; x < width; x++)
+            {
+                on[x] = 1;
+                color[x] = job.colors[source[job.x0[x]]];
+            }
+            return;
+        }
+
+        float sy = std::max((row + 0.5f) * job.mask_height / job.rect.height - 0.5f, 0.0f);
+        int y0 = std::min((int)sy, job.mask_height - 1);
+        int y1 = std::min(y0 + 1, job.mask_height - 1);
+        float fy = sy - y0;
+        const float *top = static_cast<const float *>(job.data) + (size_t)y0 * job.mask_width;
+        const float *bottom = static_cast<const float *>(job.data) + (size_t)y1 * job.mask_width;
+        for (int x = 0; x < width; x++)
+        {
+            int x0 = job.x0[x];
+            int x1 = std::min(x0 + 1, job.mask_width - 1);
+            float fx = job.fx[x];
+            float value = (top[x0] * (1 - fx) + top[x1] * fx) * (1 - fy) + (bottom[x0] * (1 - fx) + bottom[x1] * fx) * fy;
+            if (job.kind == MaskKind::CONF_CLASS)
+            {
+                on[x] = value > CONFIDENCE;
+                color[x] = job.colors[0];
+            }
+            else
+            {
+                int depth = std::clamp(255 * (value - job.depth_min) * job.depth_scale, 0.0f, 255.0f);
+                on[x] = 1;
+                color[x] = job.colors[depth];
+            }
+        }
+    }
+
+    void prepare_job(Job &job, hailo_mat_t type)
+    {
+        const int width = job.rect.width;
+        job.x0.resize(width);
+        job.fx.resize(width);
+        for (int x = 0; x < width; x++)
+        {
+            if (job.kind == MaskKind::CLASS)
+            {
+                job.x0[x] = std::min((int)(x * (float)job.mask_width / width), job.mask_width - 1);
+                job.fx[x] = 0.0f;
+                continue;
+            }
+            float sx = std::max((x + 0.5f) * job.mask_width / width - 0.5f, 0.0f);
+            job.x0[x] = std::min((int)sx, job.mask_width - 1);
+            job.fx[x] = sx - job.x0[x];
+        }
+
+        switch (job.kind)
+        {
+        case MaskKind::CLASS:
+            for (int id = 0; id < 256; id++)
+                job.colors[id] = frame_color(type, indexToColor(id));
+            break;
+        case MaskKind::CONF_CLASS:
+            job.colors[0] = frame_color(type, indexToColor(std::static_pointer_cast<HailoConfClassMask>(job.mask)->get_class_id()));
+            break;
+        case MaskKind::DEPTH:
+        {
+            // Stretch the default depth range to the values of the mask, a darker color means a smaller depth
+            const std::vector<float> &data = std::static_pointer_cast<HailoDepthMask>(job.mask)->get_data();
+            auto [min_itr, max_itr] = std::minmax_element(data.begin(), data.end());
+            float min = std::min<float>(DEPTH_MIN_DISTANCE, *min_itr);
+            float max = std::max<float>(DEPTH_MAX_DISTANCE, *max_itr);
+            job.depth_min = min;
+            job.depth_scale = 1.0f / (max - min);
+            for (int depth = 0; depth < 256; depth++)
+                job.colors[depth] = frame_color(type, cv::Scalar(depth, depth, depth));
+            break;
+        }
+        }
+
+        for (auto &color : job.colors)
+        {
+            for (int &channel : color)
+                channel *= job.alpha;
+        }
+    }
+
+    /**
+     * @brief Blend one sampled row of a mask into the frame.
+     */
+    static void blend_row(HailoMat &hmat, const Job &job, int y, const uint8_t *on, const std::array<int, 3> *color)
+    {
+        std::vector<cv::Mat> &planes = hmat.get_matrices();
+        const int alpha = job.alpha;
+        const int xmin = job.rect.x;
+        const int width = job.rect.width;
+        switch (hmat.get_type())
+        {
+        case HAILO_MAT_RGB:
+        case HAILO_MAT_RGBA:
+        {
+            const int channels = planes[0].channels();
+            uint8_t *pixel = planes[0].ptr<uint8_t>(y) + xmin * channels;
+            for (int x = 0; x < width; x++, pixel += channels)
+            {
+                if (!on[x])
+                    continue;
+                if (job.kind == MaskKind::DEPTH)
+                {
+                    // Depth is drawn in gray, over the first channel of the frame
+                    uint8_t depth = blend(pixel[0], alpha, color[x][0]);
+                    pixel[0] = pixel[1] = pixel[2] = depth;
+                    continue;
+                }
+                pixel[0] = blend(pixel[0], alpha, color[x][0]);
+                pixel[1] = blend(pixel[1], alpha, color[x][1]);
+                pixel[2] = blend(pixel[2], alpha, color[x][2]);
+            }
+            break;
+        }
+        case HAILO_MAT_NV12:
+        {
+            uint8_t *luma = planes[0].ptr<uint8_t>(y);
+            uint8_t *chroma = (y % 2 == 0) ? planes[1].ptr<uint8_t>(y / 2) : nullptr;
+            for (int x = 0; x < width; x++)
+            {
+                if (!on[x])
+                    continue;
+                int frame_x = xmin + x;
+                luma[frame_x] = blend(luma[frame_x], alpha, color[x][0]);
+                // Every 2x2 block shares one U,V pair, blended by its top left pixel
+                if (chroma != nullptr && frame_x % 2 == 0)
+                {
+                    chroma[frame_x] = blend(chroma[frame_x], alpha, color[x][1]);
+                    chroma[frame_x + 1] = blend(chroma[frame_x + 1], alpha, color[x][2]);
+                }
+            }
+            break;
+        }
+        case HAILO_MAT_YUY2:
+        {
+            // Y0 U Y1 V, every pixel pair shares one U,V pair
+            uint8_t *row = planes[0].ptr<uint8_t>(y);
+            for (int x = 0; x < width; x++)
+            {
+                if (!on[x])
+                    continue;
+                int frame_x = xmin + x;
+                uint8_t *pair = row + (frame_x / 2) * 4;
+                pair[(frame_x % 2) * 2] = blend(pair[(frame_x % 2) * 2], alpha, color[x][0]);
+                // The pair's chroma follows its first painted pixel
+                if (frame_x % 2 == 0 || x == 0 || !on[x - 1])
+                {
+                    pair[1] = blend(pair[1], alpha, color[x][1]);
+                    pair[3] = blend(pair[3], alpha, color[x][2]);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+public:
+    /**
+     * @brief Convert an RGB color to the color space of a frame, YUV for YUY2 and NV12.
+     */
+    static std::array<int, 3> frame_color(hailo_mat_t type, const cv::Scalar &rgb)
+    {
+        if (type == HAILO_MAT_NV12 || type == HAILO_MAT_YUY2)
+        {
+            uint r = rgb[0];
+            uint g = rgb[1];
+            uint b = rgb[2];
+            return {(int)RGB2Y(r, g, b), (int)RGB2U(r, g, b), (int)RGB2V(r, g, b)};
+        }
+        return {(int)rgb[0], (int)rgb[1], (int)rgb[2]};
+    }
+
+    MaskCompositor() = default;
+    MaskCompositor(const MaskCompositor &) = delete;
+    MaskCompositor &operator=(const MaskCompositor &) = delete;
+
+    /**
+     * @brief Queue a mask for the next frame.
+     *
+     * @param mask A HailoDepthMask, HailoClassMask or HailoConfClassMask, other masks are ignored.
+     * @param bbox The area of the frame the mask covers, relative to the frame.
+     * @param frame_width Width of the frame in pixels.
+     * @param frame_height Height of the frame in pixels.
+     */
+    void add(HailoMaskPtr mask, const HailoBBox &bbox, int frame_width, int frame_height)
+    {
+        if (mask->get_height() == 0 || mask->get_width() == 0)
+            return;
+
+        MaskKind kind;
+        const void *data;
+        switch (mask->get_type())
+        {
+        case HAILO_DEPTH_MASK:
+            kind = MaskKind::DEPTH;
+            data = std::static_pointer_cast<HailoDepthMask>(mask)->get_data().data();
+            break;
+        case HAILO_CLASS_MASK:
+            kind = MaskKind::CLASS;
+            data = std::static_pointer_cast<HailoClassMask>(mask)->get_data().data();
+            break;
+        case HAILO_CONF_CLASS_MASK:
+            kind = MaskKind::CONF_CLASS;
+            data = std::static_pointer_cast<HailoConfClassMask>(mask)->get_data().data();
+            break;
+        default:
+            return;
+        }
+
+        int xmin = bbox.xmin() * frame_width;
+        int ymin = bbox.ymin() * frame_height;
+        int width = frame_width * bbox.width();
+        int height = frame_height * bbox.height();
+
+        // clamp the region of interest so it is inside the frame
+        xmin = std::clamp(xmin, 0, frame_width);
+        ymin = std::clamp(ymin, 0, frame_height);
+        width = std::clamp(width, 0, frame_width - xmin);
+        height = std::clamp(height, 0, frame_height - ymin);
+        if (width == 0 || height == 0)
+            return;
+
+        if (m_job_count == m_jobs.size())
+            m_jobs.emplace_back();
+        Job &job = m_jobs[m_job_count++];
+        job.kind = kind;
+        job.mask = mask;
+        job.data = data;
+        job.mask_width = mask->get_width();
+        job.mask_height = mask->get_height();
+        job.rect = cv::Rect(xmin, ymin, width, height);
+        job.alpha = std::clamp<int>(mask->get_transparency() * ALPHA_ONE, 0, ALPHA_ONE);
+    }
+
+    /**
+     * @brief Prepare the queued masks for blending into the frame.
+     *        Call before composite_rows().
+     */
+    void prepare(HailoMat &hmat)
+    {
+        hailo_mat_t type = hmat.get_type();
+        for (size_t i = 0; i < m_job_count; i++)
+            prepare_job(m_jobs[i], type);
+    }
+
+    /**
+     * @brief Blend the prepared masks into rows [start, end) of the frame, in the order they were added.
+     *        Calls on disjoint ranges may run in parallel, as long as start is even (NV12 shares chroma
+     *        between row pairs).
+     */
+    void composite_rows(HailoMat &hmat, int start, int end)
+    {
+        thread_local std::vector<uint8_t> on;
+        thread_local std::vector<std::array<int, 3>> color;
+        for (size_t i = 0; i < m_job_count; i++)
+        {
+            const Job &job = m_jobs[i];
+            int job_start = std::max(start, job.rect.y);
+            int job_end = std::min(end, job.rect.y + job.rect.height);
+            if (job_start >= job_end)
+                continue;
+            on.resize(job.rect.width);
+            color.resize(job.rect.width);
+            for (int y = job_start; y < job_end; y++)
+            {
+                sample_row(job, y - job.rect.y, on.data(), color.data());
+                blend_row(hmat, job, y, on.data(), color.data());
+            }
+        }
+    }
+
+    /**
+     * @brief Drop the queued masks.
+     */
+    void clear()
+    {
+        for (size_t i = 0; i < m_job_count; i++)
+            m_jobs[i].mask.reset();
+        m_job_count = 0;
+    }
+};
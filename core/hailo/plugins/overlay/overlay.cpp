@@ -16,7 +16,7 @@
 #include <opencv2/opencv.hpp>
 #include <algorithm>
 #include "overlay.hpp"
-#include "overlay_utils.hpp"
+#include "overlay_renderer.hpp"
 #include "hailo_common.hpp"
 
 #define SPACE " "
@@ -37,9 +37,6 @@
 #define RGB2U(R, G, B) CLIP((-0.148 * (R)-0.291 * (G) + 0.439 * (B)) + 128)
 #define RGB2V(R, G, B) CLIP((0.439 * (R)-0.368 * (G)-0.071 * (B)) + 128)
 
-#define DEPTH_MIN_DISTANCE 0.5
-#define DEPTH_MAX_DISTANCE 3
-
 static const std::vector<cv::Scalar> tile_layer_color_table = {
     cv::Scalar(0, 0, 255), cv::Scalar(200, 100, 120), cv::Scalar(255, 0, 0), cv::Scalar(120, 0, 0), cv::Scalar(0, 0, 120)};
 
@@ -72,7 +69,7 @@ std::string confidence_to_string(float confidence)
     return std::to_string(confidence_percentage) + "%";
 }
 
-static overlay_status_t draw_classification(HailoMat &mat, HailoROIPtr roi, std::string text, uint number_of_classifications, size_t color_id = NULL_COLOR_ID)
+static overlay_status_t draw_classification(HailoMat &mat, OverlayRenderer &renderer, HailoROIPtr roi, std::string text, uint number_of_classifications, size_t color_id = NULL_COLOR_ID)
 {
     auto bbox = hailo_common::create_flattened_bbox(roi->get_bbox(), roi->get_scaling_bbox());
     int roi_xmin = bbox.xmin() * mat.native_width();
@@ -82,7 +79,7 @@ static overlay_status_t draw_classification(HailoMat &mat, HailoROIPtr roi, std:
     auto text_position = cv::Point(roi_xmin, roi_ymin + (TEXT_DEFAULT_HEIGHT * number_of_classifications * roi_height) + log(roi_height));
     double font_scale = TEXT_CLS_FONT_SCALE_FACTOR * roi_width;
     font_scale = (font_scale < MINIMUM_TEXT_CLS_FONT_SCALE) ? MINIMUM_TEXT_CLS_FONT_SCALE : font_scale;
-    mat.draw_text(text, text_position, font_scale, get_color(color_id));
+    renderer.add_text(text, text_position, font_scale, get_color(color_id), mat.font_thickness());
     return OVERLAY_STATUS_OK;
 }
 
@@ -97,7 +94,7 @@ static std::string get_classification_text(HailoClassificationPtr result, bool s
     return text;
 }
 
-static overlay_status_t draw_landmarks(HailoMat &hmat, HailoLandmarksPtr landmarks, HailoROIPtr roi, float landmark_point_radius)
+static overlay_status_t draw_landmarks(HailoMat &hmat, OverlayRenderer &renderer, HailoLandmarksPtr landmarks, HailoROIPtr roi, float landmark_point_radius)
 {
     HailoBBox bbox = roi->get_bbox();
     int thickness;
@@ -123,7 +120,7 @@ static overlay_status_t draw_landmarks(HailoMat &hmat, HailoLandmarksPtr landmar
             cv::Point joint2 = cv::Point(x2, y2);
 
             thickness = (bbox.width() < 0.05) ? 1 : 2;
-            hmat.draw_line(joint1, joint2, get_color(4), thickness, cv::LINE_4);
+            renderer.add_line(joint1, joint2, get_color(4), thickness, cv::LINE_4);
         }
     }
     for (auto &point : points)
@@ -134,7 +131,7 @@ static overlay_status_t draw_landmarks(HailoMat &hmat, HailoLandmarksPtr landmar
             uint y = ((point.y() * bbox.height()) + bbox.ymin()) * hmat.native_height();
             // Draw the keypoint (multiply x,y values by the sizes of the frame)
             auto center = cv::Point(x, y);
-            hmat.draw_ellipse(center, {R, R}, 0, 0, 360, get_color(7), landmark_point_radius);
+            renderer.add_ellipse(center, {R, R}, get_color(7), landmark_point_radius);
         }
     }
     return OVERLAY_STATUS_OK;
@@ -170,11 +167,11 @@ static std::string get_detection_text(HailoDetectionPtr detection, bool show_con
     return text;
 }
 
-static overlay_status_t draw_tile(HailoMat &mat, HailoTileROIPtr tile)
+static overlay_status_t draw_tile(HailoMat &mat, OverlayRenderer &renderer, HailoTileROIPtr tile)
 {
     auto bbox = tile->get_bbox();
-    auto bbox_min = cv::Point(bbox.xmin() * mat.width(), bbox.ymin() * mat.height());
-    auto bbox_max = cv::Point(bbox.xmax() * mat.width(), bbox.ymax() * mat.height());
+    auto bbox_min = cv::Point(bbox.xmin() * mat.native_width(), bbox.ymin() * mat.native_height());
+    auto bbox_max = cv::Point(bbox.xmax() * mat.native_width(), bbox.ymax() * mat.native_height());
     cv::Rect rect(bbox_min, bbox_max);
     cv::Scalar color;
     uint tile_layer = tile->get_layer();
@@ -184,12 +181,12 @@ static overlay_status_t draw_tile(HailoMat &mat, HailoTileROIPtr tile)
         color = get_color(DEFAULT_TILE_COLOR);
 
     // Draw the tile box
-    mat.draw_rectangle(rect, color);
+    renderer.add_rectangle(rect, color, mat.line_thickness());
 
     return OVERLAY_STATUS_OK;
 }
 
-static overlay_status_t draw_id(HailoMat &mat, HailoUniqueIDPtr &hailo_id, HailoROIPtr roi)
+static overlay_status_t draw_id(HailoMat &mat, OverlayRenderer &renderer, HailoUniqueIDPtr &hailo_id, HailoROIPtr roi)
 {
     std::string id_text = std::to_string(hailo_id->get_id());
 
@@ -203,143 +200,17 @@ static overlay_status_t draw_id(HailoMat &mat, HailoUniqueIDPtr &hailo_id, Hailo
     double font_scale = TEXT_FONT_FACTOR * log(bbox_width);
     auto text_position = cv::Point(bbox_min.x + log(bbox_width), bbox_max.y - log(bbox_width));
     // Draw the class and confidence text
-    mat.draw_text(id_text, text_position, font_scale, color);
-    return OVERLAY_STATUS_OK;
-}
-
-/**
- * @brief calculate the destionation region of interest and the resized mask
- *
- * @param destinationROI the region of interest to paint
- * @param image_planes the image data
- * @param roi the region of interest
- * @param mask a mask object inherited from from HailoMask
- * @param resized_mask_data an output of the fucntion, the mask resized
- * @param data_ptr mask data pointer
- * @param cv_type type of cv data, example: CV_32F
- */
-template <typename T>
-void calc_destination_roi_and_resize_mask(cv::Mat &destinationROI, cv::Mat &image_planes, HailoROIPtr roi, HailoMaskPtr mask, cv::Mat &resized_mask_data, T data_ptr, int cv_type)
-{
-    if (mask->get_height() == 0 || mask->get_width() == 0) {
-        return;
-    }
-
-    HailoBBox bbox = roi->get_bbox();
-    int roi_xmin = bbox.xmin() * image_planes.cols;
-    int roi_ymin = bbox.ymin() * image_planes.rows;
-    int roi_width = image_planes.cols * bbox.width();
-    int roi_height = image_planes.rows * bbox.height();
-
-    // clamp the region of interest so it is inside the image planes
-    roi_xmin = std::clamp(roi_xmin, 0, image_planes.cols);
-    roi_ymin = std::clamp(roi_ymin, 0, image_planes.rows);
-    roi_width = std::clamp(roi_width, 0, image_planes.cols - roi_xmin);
-    roi_height = std::clamp(roi_height, 0, image_planes.rows - roi_ymin);
-
-    cv::Mat mat_data = cv::Mat(mask->get_height(), mask->get_width(), cv_type, (uint8_t *)data_ptr.data());
-    cv::resize(mat_data, resized_mask_data, cv::Size(roi_width, roi_height), 0, 0, cv::INTER_LINEAR);
-
-    cv::Rect roi_rect(cv::Point(roi_xmin, roi_ymin), cv::Size(roi_width, roi_height));
-    destinationROI = image_planes(roi_rect);
-}
-
-/**
- * @brief convert the estimated depths to colors and draw it (override the original image), a darker color means that the depth is smaller.
- *
- * @param image_planes: matrix of the image
- * @param mask : HailoDepthMaskPtr that contains the data of the estimated depth of each pixel
- * @param roi region of interest
- * @return overlay_status_t
- */
-static overlay_status_t draw_depth_mask(cv::Mat &image_planes, HailoDepthMaskPtr mask, HailoROIPtr roi, const uint mask_overlay_n_threads)
-{
-    cv::Mat resized_mask_data;
-    cv::Mat destinationROI;
-    calc_destination_roi_and_resize_mask(destinationROI, image_planes, roi, mask, resized_mask_data, mask->get_data(), CV_32F);
-
-    float min = DEPTH_MIN_DISTANCE;
-    float max = DEPTH_MAX_DISTANCE;
-
-    double min_val;
-    double max_val;
-    cv::Point min_loc;
-    cv::Point max_loc;
-
-    cv::minMaxLoc(resized_mask_data, &min_val, &max_val, &min_loc, &max_loc);
-
-    if (max < max_val)
-        max = max_val;
-    if (min > min_val)
-        min = min_val;
-
-    resized_mask_data = (resized_mask_data - min) / (max - min);
-
-    if (mask_overlay_n_threads > 0)
-        cv::setNumThreads(mask_overlay_n_threads);
-
-    // perform efficient parallel matrix iteration and color every pixel its class color
-    cv::parallel_for_(cv::Range(0, destinationROI.rows * destinationROI.cols), ParallelPixelDepthMask(destinationROI.data, resized_mask_data.data, mask->get_transparency(), image_planes.cols, destinationROI.cols));
-
+    renderer.add_text(id_text, text_position, font_scale, color, mat.font_thickness());
     return OVERLAY_STATUS_OK;
 }
 
 /**
- * @brief draw a mask whose values are ints represting class ids.
- * draw every pixel in the color in its class color.
- *
- * @param image_planes the image data
- * @param mask  HailoClassMask mask object pointer
- * @param roi the region of interest
- * @return overlay_status_t OVERLAY_STATUS_OK
+ * @brief Add the results of the roi, and of the detections and tiles in it, to the draw list.
  */
-static overlay_status_t
-draw_class_mask(cv::Mat &image_planes, HailoClassMaskPtr mask, HailoROIPtr roi, const uint mask_overlay_n_threads)
-{
-    cv::Mat resized_mask_data;
-    cv::Mat destinationROI;
-    calc_destination_roi_and_resize_mask(destinationROI, image_planes, roi, mask, resized_mask_data, mask->get_data(), CV_8UC1);
-
-    if (mask_overlay_n_threads > 0)
-        cv::setNumThreads(mask_overlay_n_threads);
-
-    // perform efficient parallel matrix iteration and color every pixel its class color
-    cv::parallel_for_(cv::Range(0, destinationROI.rows * destinationROI.cols), ParallelPixelClassMask(destinationROI.data, resized_mask_data.data, mask->get_transparency(), image_planes.cols, destinationROI.cols));
-
-    return OVERLAY_STATUS_OK;
-}
-
-/**
- * @brief draw a mask that its values are floats representing confidence.
- * if the pixel value is above threshold, draw this pixel in the mask's class color.
- *
- * @param image_planes the image data
- * @param mask HailoConfClassMask mask object pointer
- * @param roi the region of interest
- * @return overlay_status_t OVERLAY_STATUS_OK
- */
-static overlay_status_t draw_conf_class_mask(cv::Mat &image_planes, HailoConfClassMaskPtr mask, HailoROIPtr roi, const uint mask_overlay_n_threads)
-{
-    cv::Mat resized_mask_data;
-    cv::Mat destinationROI;
-    calc_destination_roi_and_resize_mask(destinationROI, image_planes, roi, mask, resized_mask_data, mask->get_data(), CV_32F);
-
-    cv::Scalar mask_color = indexToColor(mask->get_class_id());
-
-    if (mask_overlay_n_threads > 0)
-        cv::setNumThreads(mask_overlay_n_threads);
-
-    // perform efficient parallel matrix iteration and color every pixel its class color
-    cv::parallel_for_(cv::Range(0, destinationROI.rows * destinationROI.cols), ParallelPixelClassConfMask(destinationROI.data, resized_mask_data.data, mask->get_transparency(), image_planes.cols, destinationROI.cols, mask_color));
-
-    return OVERLAY_STATUS_OK;
-}
-
-overlay_status_t draw_all(HailoMat &hmat, HailoROIPtr roi, float landmark_point_radius, bool show_confidence, bool local_gallery, const uint mask_overlay_n_threads)
+static overlay_status_t draw_objects(HailoMat &hmat, OverlayRenderer &renderer, HailoROIPtr roi, float landmark_point_radius, bool show_confidence, bool local_gallery)
 {
     overlay_status_t ret = OVERLAY_STATUS_UNINITIALIZED;
     uint number_of_classifications = 0;
-    cv::Mat &mat = hmat.get_matrices()[0];
     for (auto obj : roi->get_objects())
     {
         switch (obj->get_type())
@@ -366,15 +237,15 @@ overlay_status_t draw_all(HailoMat &hmat, HailoROIPtr roi, float landmark_point_
 
             // Draw Rectangle
             auto rect = get_rect(hmat, detection, roi);
-            hmat.draw_rectangle(rect, color);
+            renderer.add_rectangle(rect, color, hmat.line_thickness());
 
             // Draw text
             auto text_position = cv::Point(rect.x - log(rect.width), rect.y - log(rect.width));
             float font_scale = TEXT_FONT_FACTOR * log(rect.width);
-            hmat.draw_text(text, text_position, font_scale, color);
+            renderer.add_text(text, text_position, font_scale, color, hmat.font_thickness());
 
             // Draw inner objects.
-            ret = draw_all(hmat, detection, landmark_point_radius, show_confidence, local_gallery, mask_overlay_n_threads);
+            ret = draw_objects(hmat, renderer, detection, landmark_point_radius, show_confidence, local_gallery);
             break;
         }
         case HAILO_CLASSIFICATION:
@@ -385,57 +256,44 @@ overlay_status_t draw_all(HailoMat &hmat, HailoROIPtr roi, float landmark_point_
             {
                 std::string text = get_classification_text(classification, false);
                 if (text == "lost")
-                    ret = draw_classification(hmat, roi, text, number_of_classifications, 0);
+                    ret = draw_classification(hmat, renderer, roi, text, number_of_classifications, 0);
                 else if (text == "new")
-                    ret = draw_classification(hmat, roi, text, number_of_classifications, 1);
+                    ret = draw_classification(hmat, renderer, roi, text, number_of_classifications, 1);
                 else if (text == "tracked")
-                    ret = draw_classification(hmat, roi, text, number_of_classifications, 2);
+                    ret = draw_classification(hmat, renderer, roi, text, number_of_classifications, 2);
             }
             else
             {
                 std::string text = get_classification_text(classification, show_confidence);
-                ret = draw_classification(hmat, roi, text, number_of_classifications);
+                ret = draw_classification(hmat, renderer, roi, text, number_of_classifications);
             }
             break;
         }
         case HAILO_LANDMARKS:
         {
             HailoLandmarksPtr landmarks = std::dynamic_pointer_cast<HailoLandmarks>(obj);
-            draw_landmarks(hmat, landmarks, roi, landmark_point_radius);
+            draw_landmarks(hmat, renderer, landmarks, roi, landmark_point_radius);
             break;
         }
         case HAILO_TILE:
         {
             HailoTileROIPtr tile = std::dynamic_pointer_cast<HailoTileROI>(obj);
-            draw_tile(hmat, tile);
-            draw_all(hmat, tile, landmark_point_radius, show_confidence, local_gallery, mask_overlay_n_threads);
+            draw_tile(hmat, renderer, tile);
+            draw_objects(hmat, renderer, tile, landmark_point_radius, show_confidence, local_gallery);
             break;
         }
         case HAILO_UNIQUE_ID:
         {
             HailoUniqueIDPtr id = std::dynamic_pointer_cast<HailoUniqueID>(obj);
             if ((local_gallery && id->get_mode() == GLOBAL_ID) || (!local_gallery && id->get_mode() == TRACKING_ID))
-                draw_id(hmat, id, roi);
+                draw_id(hmat, renderer, id, roi);
             break;
         }
         case HAILO_DEPTH_MASK:
-        {
-            HailoDepthMaskPtr mask = std::dynamic_pointer_cast<HailoDepthMask>(obj);
-            draw_depth_mask(mat, mask, roi, mask_overlay_n_threads);
-            break;
-        }
         case HAILO_CLASS_MASK:
-        {
-            HailoClassMaskPtr mask = std::dynamic_pointer_cast<HailoClassMask>(obj);
-            draw_class_mask(mat, mask, roi, mask_overlay_n_threads);
-            break;
-        }
         case HAILO_CONF_CLASS_MASK:
-        {
-            HailoConfClassMaskPtr mask = std::dynamic_pointer_cast<HailoConfClassMask>(obj);
-            draw_conf_class_mask(mat, mask, roi, mask_overlay_n_threads);
+            renderer.add_mask(std::dynamic_pointer_cast<HailoMask>(obj), roi->get_bbox(), hmat.native_width(), hmat.native_height());
             break;
-        }
         default:
             // continue
             break;
@@ -445,6 +303,17 @@ overlay_status_t draw_all(HailoMat &hmat, HailoROIPtr roi, float landmark_point_
     return ret;
 }
 
+overlay_status_t draw_all(HailoMat &hmat, HailoROIPtr roi, float landmark_point_radius, bool show_confidence, bool local_gallery, OverlayRenderer *renderer)
+{
+    thread_local OverlayRenderer default_renderer(0);
+    OverlayRenderer &overlay = (renderer != nullptr) ? *renderer : default_renderer;
+
+    // Flatten the results into a draw list, then draw it in one pass over the frame
+    overlay_status_t ret = draw_objects(hmat, overlay, roi, landmark_point_radius, show_confidence, local_gallery);
+    overlay.render(hmat);
+    return ret;
+}
+
 void face_blur(HailoMat &hmat, HailoROIPtr roi)
 {
     for (auto detection : hailo_common::get_hailo_detections(roi))
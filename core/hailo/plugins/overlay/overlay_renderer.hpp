@@ -0,0 +1,344 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "hailo_objects.hpp"
+#include "hailo_thread_pool.hpp"
+#include "common/hailomat.hpp"
+#include "mask_compositor.hpp"
+
+#define MAX_CACHED_TEXT_SPRITES 1024
+
+/**
+ * @brief A text rasterized once: coverage is 255 where the glyphs are and 0 elsewhere.
+ *        offset places the top left corner of coverage relative to the text origin (bottom left of the text).
+ */
+struct TextSprite
+{
+    cv::Mat coverage; // CV_8UC1
+    cv::Point offset;
+};
+
+/**
+ * @brief Rasterized texts by (text, font scale, thickness).
+ *        Sprites hold coverage only, so one sprite serves every color. Font scales are rounded to
+ *        SCALE_STEP, labels whose scale follows the size of their box would rarely hit the cache otherwise.
+ */
+class TextSpriteCache
+{
+private:
+    static constexpr double SCALE_STEP = 0.05;
+
+    using SpriteKey = std::tuple<std::string, int, int>;
+    std::map<SpriteKey, std::shared_ptr<const TextSprite>> m_sprites;
+
+public:
+    /**
+     * @brief Get the sprite of a text, rasterizing it on first use.
+     *
+     * @return std::shared_ptr<const TextSprite> The sprite, or null if there is nothing to draw.
+     */
+    std::shared_ptr<const TextSprite> get(const std::string &text, double font_scale, int thickness)
+    {
+        int scale_steps = std::lround(font_scale / SCALE_STEP);
+        if (text.empty() || scale_steps <= 0 || thickness <= 0)
+            return nullptr;
+
+        SpriteKey key(text, scale_steps, thickness);
+        auto itr = m_sprites.find(key);
+        if (itr != m_sprites.end())
+            return itr->second;
+
+        // Sprites in use by a pending frame are kept alive by their draw commands
+        if (m_sprites.size() >= MAX_CACHED_TEXT_SPRITES)
+            m_sprites.clear();
+
+        double scale = scale_steps * SCALE_STEP;
+        int baseline = 0;
+        cv::Size size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, scale, thickness, &baseline);
+        int padding = thickness + 1; // Thick strokes reach outside the text size
+        cv::Point origin(padding, padding + size.height);
+
+        auto sprite = std::make_shared<TextSprite>();
+        sprite->coverage = cv::Mat::zeros(size.height + baseline + 2 * padding, size.width + 2 * padding, CV_8UC1);
+        cv::putText(sprite->coverage, text, origin, cv::FONT_HERSHEY_SIMPLEX, scale, cv::Scalar(255), thickness);
+        sprite->offset = -origin;
+        m_sprites.emplace(key, sprite);
+        return sprite;
+    }
+
+    size_t size() const
+    {
+        return m_sprites.size();
+    }
+};
+
+/**
+ * @brief Draws the overlay of a frame in two phases.
+ *        First the metadata is flattened into a draw list: masks, filled areas (the edges of boxes) and
+ *        text sprites from a TextSpriteCache, all in frame pixels. Then the list is rendered in bands of
+ *        rows spread over a thread pool, each band drawing every command that covers it, in order, straight
+ *        into the frame's own format. Colors are converted once per command.
+ *        Lines and ellipses (landmarks) are left to the HailoMat, after the bands.
+ */
+class OverlayRenderer
+{
+private:
+    static constexpr int BAND_ROWS = 16; // Even, so an NV12 chroma row is never split between bands
+
+    /**
+     * @brief Paint area with color, or only its pixels covered by sprite when there is one.
+     */
+    struct DrawCommand
+    {
+        cv::Rect area;
+        cv::Scalar rgb;
+        std::array<int, 3> color; // rgb in the frame's color space
+        std::shared_ptr<const TextSprite> sprite;
+        cv::Point origin; // Top left corner of the sprite in the frame
+    };
+
+    struct LineCommand
+    {
+        cv::Point point1;
+        cv::Point point2;
+        cv::Scalar color;
+        int thickness;
+        int line_type;
+    };
+
+    struct EllipseCommand
+    {
+        cv::Point center;
+        cv::Size axes;
+        cv::Scalar color;
+        int thickness;
+    };
+
+    std::unique_ptr<HailoThreadPool> m_pool;
+    MaskCompositor m_masks; // Blended by this renderer's bands
+    TextSpriteCache m_sprites;
+    std::vector<DrawCommand> m_commands;
+    std::vector<LineCommand> m_lines;
+    std::vector<EllipseCommand> m_ellipses;
+
+    static bool covered(const DrawCommand &command, int x, int y)
+    {
+        if (!command.area.contains(cv::Point(x, y)))
+            return false;
+        if (command.sprite == nullptr)
+            return true;
+        return command.sprite->coverage.at<uint8_t>(y - command.origin.y, x - command.origin.x) != 0;
+    }
+
+    /**
+     * @brief Draw one row of a command. For subsampled chroma, a U,V pair is painted when any of the pixels
+     *        sharing it is covered.
+     */
+    static void draw_row(HailoMat &hmat, const DrawCommand &command, int y)
+    {
+        std::vector<cv::Mat> &planes = hmat.get_matrices();
+        const std::array<int, 3> &color = command.color;
+        const int xmin = command.area.x;
+        const int xmax = command.area.x + command.area.width;
+        switch (hmat.get_type())
+        {
+        case HAILO_MAT_RGB:
+        case HAILO_MAT_RGBA:
+        {
+            const int channels = planes[0].channels();
+            uint8_t *pixel = planes[0].ptr<uint8_t>(y) + xmin * channels;
+            for (int x = xmin; x < xmax; x++, pixel += channels)
+            {
+                if (!covered(command, x, y))
+                    continue;
+                pixel[0] = color[0];
+                pixel[1] = color[1];
+                pixel[2] = color[2];
+            }
+            break;
+        }
+        case HAILO_MAT_NV12:
+        {
+            uint8_t *luma = planes[0].ptr<uint8_t>(y);
+            for (int x = xmin; x < xmax; x++)
+            {
+                if (covered(command, x, y))
+                    luma[x] = color[0];
+            }
+            // Chroma rows are painted with their first row, or with the area's first row when it is odd
+            if (y % 2 != 0 && y != command.area.y)
+                break;
+            int top = y & ~1;
+            uint8_t *chroma = planes[1].ptr<uint8_t>(top / 2);
+            for (int x = xmin & ~1; x < xmax; x += 2)
+            {
+                if (covered(command, x, top) || covered(command, x + 1, top) ||
+                    covered(command, x, top + 1) || covered(command, x + 1, top + 1))
+                {
+                    chroma[x] = color[1];
+                    chroma[x + 1] = color[2];
+                }
+            }
+            break;
+        }
+        case HAILO_MAT_YUY2:
+        {
+            // Y0 U Y1 V, every pixel pair shares one U,V pair
+            uint8_t *row = planes[0].ptr<uint8_t>(y);
+            for (int x = xmin & ~1; x < xmax; x += 2)
+            {
+                uint8_t *pair = row + x * 2;
+                bool first = covered(command, x, y);
+                bool second = covered(command, x + 1, y);
+                if (first)
+                    pair[0] = color[0];
+                if (second)
+                    pair[2] = color[0];
+                if (first || second)
+                {
+                    pair[1] = color[1];
+                    pair[3] = color[2];
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void render_rows(HailoMat &hmat, int start, int end)
+    {
+        m_masks.composite_rows(hmat, start, end);
+        for (const DrawCommand &command : m_commands)
+        {
+            int command_start = std::max(start, command.area.y);
+            int command_end = std::min(end, command.area.y + command.area.height);
+            for (int y = command_start; y < command_end; y++)
+                draw_row(hmat, command, y);
+        }
+    }
+
+public:
+    /**
+     * @param n_threads Number of threads rendering the overlay, including the calling thread.
+     *        0 uses one thread per core.
+     */
+    explicit OverlayRenderer(uint n_threads)
+    {
+        if (n_threads == 0)
+            n_threads = std::max(1u, std::thread::hardware_concurrency());
+        if (n_threads > 1)
+            m_pool = std::make_unique<HailoThreadPool>(n_threads - 1);
+    }
+
+    OverlayRenderer(const OverlayRenderer &) = delete;
+    OverlayRenderer &operator=(const OverlayRenderer &) = delete;
+
+    /**
+     * @brief Queue a mask, see MaskCompositor::add. Masks are drawn under everything else.
+     */
+    void add_mask(HailoMaskPtr mask, const HailoBBox &bbox, int frame_width, int frame_height)
+    {
+        m_masks.add(mask, bbox, frame_width, frame_height);
+    }
+
+    /**
+     * @brief Queue the outline of a rectangle, its edges centered on the rectangle's border like cv::rectangle.
+     */
+    void add_rectangle(cv::Rect rect, const cv::Scalar &color, int thickness)
+    {
+        if (rect.width <= 0 || rect.height <= 0)
+            return;
+        thickness = std::max(thickness, 1);
+        int half = thickness / 2;
+        int left = rect.x - half;
+        int top = rect.y - half;
+        int right = rect.x + rect.width - 1 - half;
+        int bottom = rect.y + rect.height - 1 - half;
+        int outer_width = rect.width - 1 + thickness;
+        int outer_height = rect.height - 1 + thickness;
+        for (cv::Rect edge : {cv::Rect(left, top, outer_width, thickness), cv::Rect(left, bottom, outer_width, thickness),
+                              cv::Rect(left, top, thickness, outer_height), cv::Rect(right, top, thickness, outer_height)})
+        {
+            m_commands.push_back(DrawCommand{edge, color, {}, nullptr, {}});
+        }
+    }
+
+    /**
+     * @brief Queue a text, position is its bottom left corner like cv::putText.
+     */
+    void add_text(const std::string &text, cv::Point position, double font_scale, const cv::Scalar &color, int thickness)
+    {
+        std::shared_ptr<const TextSprite> sprite = m_sprites.get(text, font_scale, thickness);
+        if (sprite == nullptr)
+            return;
+        cv::Point origin = position + sprite->offset;
+        m_commands.push_back(DrawCommand{cv::Rect(origin, sprite->coverage.size()), color, {}, sprite, origin});
+    }
+
+    void add_line(cv::Point point1, cv::Point point2, const cv::Scalar &color, int thickness, int line_type)
+    {
+        m_lines.push_back(LineCommand{point1, point2, color, thickness, line_type});
+    }
+
+    void add_ellipse(cv::Point center, cv::Size axes, const cv::Scalar &color, int thickness)
+    {
+        m_ellipses.push_back(EllipseCommand{center, axes, color, thickness});
+    }
+
+    /**
+     * @brief Draw everything queued into the frame and clear the draw list.
+     */
+    void render(HailoMat &hmat)
+    {
+        const int height = hmat.native_height();
+        cv::Rect frame(0, 0, hmat.native_width(), height);
+        hailo_mat_t type = hmat.get_type();
+        for (DrawCommand &command : m_commands)
+        {
+            command.area &= frame;
+            command.color = MaskCompositor::frame_color(type, command.rgb);
+        }
+        m_masks.prepare(hmat);
+
+        int bands = (height + BAND_ROWS - 1) / BAND_ROWS;
+        auto render_band = [&](size_t band)
+        {
+            int start = band * BAND_ROWS;
+            render_rows(hmat, start, std::min(start + BAND_ROWS, height));
+        };
+        if (m_pool)
+            m_pool->parallel_for(bands, render_band);
+        else
+        {
+            for (int band = 0; band < bands; band++)
+                render_band(band);
+        }
+
+        for (const LineCommand &line : m_lines)
+            hmat.draw_line(line.point1, line.point2, line.color, line.thickness, line.line_type);
+        for (const EllipseCommand &ellipse : m_ellipses)
+            hmat.draw_ellipse(ellipse.center, ellipse.axes, 0, 0, 360, ellipse.color, ellipse.thickness);
+
+        m_masks.clear();
+        m_commands.clear();
+        m_lines.clear();
+        m_ellipses.clear();
+    }
+};
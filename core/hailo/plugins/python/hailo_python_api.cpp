@@ -788,7 +788,7 @@ PYBIND11_MODULE(hailo, m)
         .def("add_jde_tracker", py::overload_cast<const std::string &>(&HailoTracker::add_jde_tracker), py::arg("name"))
         .def("remove_jde_tracker", &HailoTracker::remove_jde_tracker, py::arg("name"))
         .def("get_trackers_list", &HailoTracker::get_trackers_list)
-        .def("update", &HailoTracker::update, py::arg("name"), py::arg("inputs"))
+        .def("update", py::overload_cast<const std::string &, std::vector<HailoDetectionPtr> &>(&HailoTracker::update), py::arg("name"), py::arg("inputs"))
         .def("add_object_to_track", &HailoTracker::add_object_to_track, py::arg("name"), py::arg("id"), py::arg("obj"))
         .def("remove_classifications_from_track", &HailoTracker::remove_classifications_from_track, py::arg("name"), py::arg("track_id"), py::arg("classifier_type"))
         .def("remove_matrices_from_track", &HailoTracker::remove_matrices_from_track, py::arg("name"), py::arg("track_id"))
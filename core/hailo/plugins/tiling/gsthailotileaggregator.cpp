@@ -7,6 +7,7 @@
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
 #include "gst_hailo_meta.hpp"
+#include "common/nms.hpp"
 #include "gsthailotileaggregator.hpp"
 
 GST_DEBUG_CATEGORY_STATIC(gst_hailotileaggregator_debug);
@@ -34,7 +35,6 @@ enum
 
 G_DEFINE_TYPE_WITH_CODE(GstHailoTileAggregator, gst_hailotileaggregator, GST_TYPE_HAILO_AGGREGATOR, _do_init);
 
-static float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2);
 static void nms(HailoROIPtr hailo_roi, const float iou_thr);
 static void gst_hailotileaggregator_set_property(GObject *object,
                                                  guint prop_id, const GValue *value, GParamSpec *pspec);
@@ -235,21 +235,6 @@ gst_hailotileaggregator_handle_sub_frame_roi(GstHailoAggregator *hailoaggregator
     GST_HAILO_AGGREGATOR_CLASS(parent_class)->handle_sub_frame_roi(hailoaggregator, sub_buffer_roi);
 }
 
-float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2)
-{
-    // Calculate IOU between two detection boxes
-    const float width_of_overlap_area = std::min(box_1.xmax(), box_2.xmax()) - std::max(box_1.xmin(), box_2.xmin());
-    const float height_of_overlap_area = std::min(box_1.ymax(), box_2.ymax()) - std::max(box_1.ymin(), box_2.ymin());
-    const float positive_width_of_overlap_area = std::max(width_of_overlap_area, 0.0f);
-    const float positive_height_of_overlap_area = std::max(height_of_overlap_area, 0.0f);
-    const float area_of_overlap = positive_width_of_overlap_area * positive_height_of_overlap_area;
-    const float box_1_area = (box_1.ymax() - box_1.ymin()) * (box_1.xmax() - box_1.xmin());
-    const float box_2_area = (box_2.ymax() - box_2.ymin()) * (box_2.xmax() - box_2.xmin());
-    // The IOU is a ratio of how much the boxes overlap vs their size outside the overlap.
-    // Boxes that are similar will have a higher overlap threshold.
-    return area_of_overlap / (box_1_area + box_2_area - area_of_overlap);
-}
-
 /**
  * @brief Perform IOU based NMS on detection objects of HailoRoi
  *
@@ -261,34 +246,27 @@ float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2)
  */
 void nms(HailoROIPtr hailo_roi, const float iou_thr)
 {
-    // The network may propose multiple detections of similar size/score,
-    // which are actually the same detection. We want to filter out the lesser
-    // detections with a simple nms.
-
+    // Detections of neighbouring tiles overlap on the tiles' borders,
+    // flatten them and keep only the best of each overlapping group.
     std::vector<HailoDetectionPtr> objects = hailo_common::get_hailo_detections(hailo_roi);
-    std::sort(objects.begin(), objects.end(),
-              [](HailoDetectionPtr a, HailoDetectionPtr b)
-              { return a->get_confidence() > b->get_confidence(); });
+    common::DetectionBoxes &boxes = common::nms_boxes();
+    boxes.reserve(objects.size());
+    for (HailoDetectionPtr &object : objects)
+    {
+        HailoBBox bbox = object->get_bbox();
+        boxes.push_back(bbox.xmin(), bbox.ymin(), bbox.xmax(), bbox.ymax(), object->get_confidence(), object->get_class_id());
+    }
 
+    common::NmsParams nms_params;
+    nms_params.iou_threshold = iou_thr;
+    const std::vector<uint32_t> &keep = common::nms(boxes, nms_params);
+    std::vector<bool> kept(objects.size(), false);
+    for (uint32_t index : keep)
+        kept[index] = true;
     for (uint index = 0; index < objects.size(); index++)
     {
-        for (uint jindex = index + 1; jindex < objects.size(); jindex++)
-        {
-            if (objects[index]->get_class_id() == objects[jindex]->get_class_id())
-            {
-                // For each detection, calculate the IOU against each following detection.
-                float iou = iou_calc(objects[index]->get_bbox(), objects[jindex]->get_bbox());
-                // If the IOU is above threshold, then we have two similar detections,
-                // and want to delete the one.
-                if (iou >= iou_thr)
-                {
-                    // The detections are arranged in highest score order,
-                    // so we want to erase the latter detection.
-                    hailo_roi->remove_object(objects[jindex]);
-                    objects.erase(objects.begin() + jindex);
-                    jindex--; // Step back jindex since we just erased the current detection.
-                }
-            }
-        }
+        // Detections without a score are not candidates, leave them as they are
+        if (!kept[index] && boxes.score[index] > 0.0f)
+            hailo_roi->remove_object(objects[index]);
     }
-}
\ No newline at end of file
+}
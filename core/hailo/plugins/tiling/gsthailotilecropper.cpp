@@ -250,7 +250,7 @@ static void prepare_tiles(HailoROIPtr hailo_roi, std::vector<HailoROIPtr> &crop_
         while (float(col_offset + col_step) <= 1)
         {
             // Create new tile ROI
-            HailoTileROIPtr tile_roi = std::make_shared<HailoTileROI>(create_tile_roi(index, col_overlap, row_overlap,
+            HailoTileROIPtr tile_roi = hailo_make_shared<HailoTileROI>(create_tile_roi(index, col_overlap, row_overlap,
                                                                                       col_offset, row_offset, (col_offset + col_step), (row_offset + row_step),
                                                                                       layer, tiling_mode));
             // Add the tile to the result vector and into the main hailo_roi.
@@ -369,7 +369,9 @@ void gst_hailo_tracker_set_property(GObject *object, guint property_id,
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
     }
+    GST_OBJECT_LOCK(hailotracker);
     update_active_trackers(hailotracker, property_id);
+    GST_OBJECT_UNLOCK(hailotracker);
 }
 
 /* Handle getting properties */
@@ -461,11 +463,15 @@ static gboolean
 gst_hailo_tracker_stop(GstBaseTransform *trans)
 {
     GstHailoTracker *hailotracker = GST_HAILO_TRACKER(trans);
+    GST_OBJECT_LOCK(hailotracker);
     for (std::string stream_id : hailotracker->active_streams)
     {
         std::string tracker_name = get_tracker_name(hailotracker, stream_id);
         HailoTracker::GetInstance().remove_jde_tracker(tracker_name);
     }
+    hailotracker->active_streams.clear();
+    hailotracker->stream_trackers.clear();
+    GST_OBJECT_UNLOCK(hailotracker);
 
     GST_DEBUG_OBJECT(hailotracker, "stop");
 
@@ -482,7 +488,9 @@ gst_hailo_tracker_transform_frame_ip(GstVideoFilter *filter, GstVideoFrame *fram
     GstHailoTracker *hailotracker = GST_HAILO_TRACKER(filter);
     GstBuffer *buffer = frame->buffer;
     HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
+    GST_OBJECT_LOCK(hailotracker);
     std::string stream_id = hailotracker->current_stream_id;
+    GST_OBJECT_UNLOCK(hailotracker);
     GstHailoStreamMeta *stream_meta = gst_buffer_get_hailo_stream_meta(buffer);
     if (stream_meta)
     {
@@ -505,13 +513,25 @@ gst_hailo_tracker_transform_frame_ip(GstVideoFilter *filter, GstVideoFrame *fram
         }
     }
 
-    // Swap the detections in the roi with just the online tracked detections
+    // Swap the detections in the roi with just the online tracked detections.
+    // Only the handle is taken under the object lock, each tracker has its own lock for the update,
+    // so streams of other elements keep tracking meanwhile.
+    HailoTrackerHandle tracker = nullptr;
     GST_OBJECT_LOCK(hailotracker);
-    std::string tracker_name = get_tracker_name(hailotracker, std::string(stream_id));
-    std::vector<HailoDetectionPtr> online_detection_ptrs = HailoTracker::GetInstance().update(tracker_name, detections);
+    for (size_t i = 0; i < hailotracker->active_streams.size(); i++)
+    {
+        if (hailotracker->active_streams[i] == stream_id)
+        {
+            tracker = hailotracker->stream_trackers[i];
+            break;
+        }
+    }
+    GST_OBJECT_UNLOCK(hailotracker);
+    if (!tracker)
+        tracker = HailoTracker::GetInstance().get_jde_tracker(get_tracker_name(hailotracker, stream_id));
+    std::vector<HailoDetectionPtr> online_detection_ptrs = HailoTracker::GetInstance().update(tracker, detections);
 
     hailo_common::add_detection_pointers(hailo_roi, online_detection_ptrs);
-    GST_OBJECT_UNLOCK(hailotracker);
 
     GST_DEBUG_OBJECT(hailotracker, "transform_frame_ip");
     return GST_FLOW_OK;
@@ -539,6 +559,7 @@ gst_hailo_tracker_sink_event(GstBaseTransform *trans,
         else
         {
             GST_DEBUG_OBJECT(hailotracker, "filtering stream %s", stream_id);
+            GST_OBJECT_LOCK(hailotracker);
             if (hailotracker->current_stream_id) {
                 g_free(hailotracker->current_stream_id);
             }
@@ -552,7 +573,9 @@ gst_hailo_tracker_sink_event(GstBaseTransform *trans,
                 std::string tracker_name = get_tracker_name(hailotracker, std::string(hailotracker->current_stream_id));
                 HailoTracker::GetInstance().add_jde_tracker(tracker_name, hailotracker->tracker_params);
                 hailotracker->active_streams.emplace_back(std::string(hailotracker->current_stream_id));
+                hailotracker->stream_trackers.emplace_back(HailoTracker::GetInstance().get_jde_tracker(tracker_name));
             }
+            GST_OBJECT_UNLOCK(hailotracker);
         }
     default:
         return GST_BASE_TRANSFORM_CLASS(gst_hailo_tracker_parent_class)->sink_event(trans, event);
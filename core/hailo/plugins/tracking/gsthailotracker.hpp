@@ -46,6 +46,7 @@ struct _GstHailoTracker
     gint class_id;
     HailoTrackerParams tracker_params;
     std::vector<std::string> active_streams;
+    std::vector<HailoTrackerHandle> stream_trackers; // Resolved tracker of each active stream, same order
 };
 
 struct _GstHailoTrackerClass
@@ -0,0 +1,166 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Size and encode / decode throughput of the binary metadata format against JSON,
+  on the metadata of typical pipelines. Encoding and decoding follow the export and import elements:
+  JSON is serialized to a string with the export's extra members and parsed back, binary messages
+  are read back from their header.
+ */
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "export/encode_binary.hpp"
+#include "export/encode_json.hpp"
+#include "import/decode_binary.hpp"
+#include "import/decode_json.hpp"
+#include "rapidjson/writer.h"
+
+#define BENCH_BUFFER_OFFSET (1234)
+#define BENCH_TIMESTAMP (5678)
+
+namespace
+{
+    HailoROIPtr make_roi()
+    {
+        HailoROIPtr roi = hailo_make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+        roi->set_stream_id("bench_stream");
+        return roi;
+    }
+
+    HailoDetectionPtr make_detection(int i)
+    {
+        float x = (i % 10) / 10.0f;
+        float y = (i / 10 % 10) / 10.0f;
+        return hailo_make_shared<HailoDetection>(HailoBBox(x, y, 0.08f, 0.09f), 1, "person", 0.87f);
+    }
+
+    // Detector with a tracker and an attributes classifier
+    HailoROIPtr detections_frame()
+    {
+        HailoROIPtr roi = make_roi();
+        for (int i = 0; i < 100; i++)
+        {
+            HailoDetectionPtr detection = make_detection(i);
+            detection->add_object(hailo_make_shared<HailoUniqueID>(i));
+            detection->add_object(hailo_make_shared<HailoClassification>("attributes", 3, "adult", 0.76f));
+            roi->add_object(detection);
+        }
+        return roi;
+    }
+
+    // Pose estimation, 17 key points per person
+    HailoROIPtr pose_frame()
+    {
+        HailoROIPtr roi = make_roi();
+        for (int i = 0; i < 20; i++)
+        {
+            HailoDetectionPtr detection = make_detection(i);
+            std::vector<HailoPoint> points;
+            for (int point = 0; point < 17; point++)
+                points.emplace_back(point / 17.0f, 1.0f - point / 17.0f, 0.9f);
+            detection->add_object(hailo_make_shared<HailoLandmarks>("centerpose", points, 0.0f));
+            roi->add_object(detection);
+        }
+        return roi;
+    }
+
+    // Re-identification, a 512 features embedding per person
+    HailoROIPtr embeddings_frame()
+    {
+        HailoROIPtr roi = make_roi();
+        for (int i = 0; i < 10; i++)
+        {
+            HailoDetectionPtr detection = make_detection(i);
+            std::vector<float> embedding(512);
+            for (size_t feature = 0; feature < embedding.size(); feature++)
+                embedding[feature] = (feature % 97) / 97.0f - 0.5f;
+            detection->add_object(hailo_make_shared<HailoMatrix>(embedding, 1, 512));
+            roi->add_object(detection);
+        }
+        return roi;
+    }
+
+    // Semantic segmentation, one class mask of the network's output size
+    HailoROIPtr segmentation_frame()
+    {
+        HailoROIPtr roi = make_roi();
+        std::vector<uint8_t> classes(1024 * 512);
+        for (size_t pixel = 0; pixel < classes.size(); pixel++)
+            classes[pixel] = (pixel / 4096) % 19;
+        roi->add_object(std::make_shared<HailoClassMask>(std::move(classes), 1024, 512, 0.3f));
+        return roi;
+    }
+
+    std::vector<uint8_t> encode_binary_message(HailoROIPtr roi)
+    {
+        std::vector<uint8_t> buffer;
+        encode_binary::encode_hailo_roi(buffer, roi, BENCH_BUFFER_OFFSET, BENCH_TIMESTAMP, roi->get_stream_id());
+        return buffer;
+    }
+
+    std::string encode_json_message(HailoROIPtr roi)
+    {
+        rapidjson::Document document = encode_json::encode_hailo_roi(roi);
+        document.AddMember("timestamp (ms)", rapidjson::Value(BENCH_TIMESTAMP), document.GetAllocator());
+        document.AddMember("buffer_offset", rapidjson::Value(BENCH_BUFFER_OFFSET), document.GetAllocator());
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        document.Accept(writer);
+        return std::string(buffer.GetString(), buffer.GetSize());
+    }
+
+    HailoROIPtr decode_binary_message(const std::vector<uint8_t> &message)
+    {
+        HailoROIPtr roi = make_roi();
+        binary_meta::Reader reader(message.data(), message.size());
+        decode_binary::decode_header(reader);
+        decode_binary::decode_hailo_roi(reader, roi);
+        return roi;
+    }
+
+    HailoROIPtr decode_json_message(const std::string &message)
+    {
+        HailoROIPtr roi = make_roi();
+        rapidjson::Document document;
+        document.Parse(message.data(), message.size());
+        decode_json::decode_hailo_roi(document, roi);
+        return roi;
+    }
+
+    void bench_frame(const std::string &name, HailoROIPtr roi)
+    {
+        std::vector<uint8_t> binary_message = encode_binary_message(roi);
+        std::string json_message = encode_json_message(roi);
+        WARN(name << ": binary " << binary_message.size() << " bytes, JSON " << json_message.size() << " bytes");
+        CHECK(binary_message.size() < json_message.size());
+
+        BENCHMARK(name + ": encode binary")
+        {
+            return encode_binary_message(roi);
+        };
+        BENCHMARK(name + ": encode JSON")
+        {
+            return encode_json_message(roi);
+        };
+        BENCHMARK(name + ": decode binary")
+        {
+            return decode_binary_message(binary_message);
+        };
+        BENCHMARK(name + ": decode JSON")
+        {
+            return decode_json_message(json_message);
+        };
+    }
+}
+
+TEST_CASE("Binary and JSON metadata", "[metadata_format]")
+{
+    bench_frame("100 tracked detections", detections_frame());
+    bench_frame("20 poses", pose_frame());
+    bench_frame("10 embeddings", embeddings_frame());
+    // JSON import ignores masks, so its decode only parses
+    bench_frame("1024x512 class mask", segmentation_frame());
+}
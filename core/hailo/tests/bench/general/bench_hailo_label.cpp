@@ -0,0 +1,133 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Labeling a frame of 500 detections with every dataset of common/labels.
+  The decoders used to look every detection's class up in the dataset map and copy the label string
+  into the detection. They now resolve classes through a common::LabelTable built once per dataset,
+  and the detections hold interned HailoLabel handles. Labels interned directly (class ids above 255)
+  are found in the registry without taking its lock.
+ */
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "hailo_label.hpp"
+#include "common/label_table.hpp"
+#include "common/labels/celeb_a.hpp"
+#include "common/labels/coco_eighty.hpp"
+#include "common/labels/coco_ninety.hpp"
+#include "common/labels/coco_visdrone.hpp"
+#include "common/labels/imagenet.hpp"
+#include "common/labels/peta.hpp"
+#include "common/labels/yolo_personface.hpp"
+
+#define DETECTIONS_PER_FRAME 500
+
+namespace
+{
+    // Class ids of a frame, spread over the whole dataset like a busy scene
+    template <typename Key>
+    std::vector<Key> frame_class_ids(const std::map<Key, std::string> &dataset)
+    {
+        std::vector<Key> keys;
+        for (auto &entry : dataset)
+            keys.push_back(entry.first);
+        std::vector<Key> class_ids;
+        for (int i = 0; i < DETECTIONS_PER_FRAME; i++)
+            class_ids.push_back(keys[(i * 7) % keys.size()]);
+        return class_ids;
+    }
+
+    template <typename Key>
+    void bench_map_lookup(const std::string &name, const std::map<Key, std::string> &dataset)
+    {
+        std::vector<Key> class_ids = frame_class_ids(dataset);
+        BENCHMARK(name + ": map lookup and string copy per detection (previous)")
+        {
+            std::vector<std::string> labels;
+            labels.reserve(class_ids.size());
+            for (Key class_id : class_ids)
+                labels.push_back(dataset.at(class_id));
+            return labels;
+        };
+    }
+
+    void bench_dataset(const std::string &name, const std::map<uint8_t, std::string> &dataset)
+    {
+        bench_map_lookup(name, dataset);
+
+        std::vector<uint8_t> class_ids = frame_class_ids(dataset);
+        const common::LabelTable table(dataset);
+        BENCHMARK(name + ": LabelTable lookup per detection")
+        {
+            std::vector<HailoLabel> labels;
+            labels.reserve(class_ids.size());
+            for (uint8_t class_id : class_ids)
+                labels.push_back(table[class_id]);
+            return labels;
+        };
+    }
+}
+
+TEST_CASE("Labeling a frame", "[hailo_label]")
+{
+    bench_dataset("coco_eighty", common::coco_eighty);
+    bench_dataset("coco_ninety", common::coco_ninety_classes);
+    bench_dataset("coco_visdrone", common::coco_visdrone_classes);
+    bench_dataset("yolo_personface", common::yolo_personface);
+    bench_dataset("celeb_a", labels::celeb_a);
+    bench_dataset("peta", labels::peta);
+
+    // Class ids above 255 are not served by LabelTable, the classifiers intern the label directly
+    bench_map_lookup("imagenet", common::imagenet_labels);
+    std::vector<uint16_t> imagenet_ids = frame_class_ids(common::imagenet_labels);
+    BENCHMARK("imagenet: HailoLabel per detection")
+    {
+        std::vector<HailoLabel> labels;
+        labels.reserve(imagenet_ids.size());
+        for (uint16_t class_id : imagenet_ids)
+            labels.emplace_back(common::imagenet_labels.at(class_id));
+        return labels;
+    };
+}
+
+TEST_CASE("Copying the labels of a frame", "[hailo_label]")
+{
+    std::vector<std::string> strings;
+    std::vector<HailoLabel> labels;
+    for (uint8_t class_id : frame_class_ids(common::coco_eighty))
+    {
+        strings.push_back(common::coco_eighty.at(class_id));
+        labels.emplace_back(common::coco_eighty.at(class_id));
+    }
+
+    BENCHMARK("std::string labels (previous)")
+    {
+        return std::vector<std::string>(strings);
+    };
+
+    BENCHMARK("HailoLabel handles")
+    {
+        return std::vector<HailoLabel>(labels);
+    };
+
+    BENCHMARK("comparing std::string labels (previous)")
+    {
+        size_t matches = 0;
+        for (const std::string &label : strings)
+            matches += label == strings[0];
+        return matches;
+    };
+
+    BENCHMARK("comparing HailoLabel handles")
+    {
+        size_t matches = 0;
+        for (const HailoLabel &label : labels)
+            matches += label == labels[0];
+        return matches;
+    };
+}
@@ -0,0 +1,129 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Construction and traversal of the metadata of a crowded frame: 500 detections, each with a classification.
+  The previous HailoObject allocated a std::mutex on the heap per object, and the typed getters copied the
+  matching objects into a vector. Both are measured next to their replacements.
+ */
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "catch.hpp"
+#include "hailo_common.hpp"
+
+#define DETECTIONS_PER_FRAME 500
+
+namespace
+{
+    HailoROIPtr make_frame()
+    {
+        HailoROIPtr roi = hailo_make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+        for (int i = 0; i < DETECTIONS_PER_FRAME; i++)
+        {
+            float x = (i % 25) / 25.0f;
+            float y = (i / 25) / 20.0f;
+            HailoDetectionPtr detection = hailo_make_shared<HailoDetection>(HailoBBox(x, y, 0.04f, 0.05f), 1, "person", 0.9f);
+            detection->add_object(hailo_make_shared<HailoClassification>("attributes", 2, "adult", 0.8f));
+            roi->add_object(detection);
+        }
+        return roi;
+    }
+
+    std::vector<HailoROIPtr> make_frames(int count)
+    {
+        std::vector<HailoROIPtr> frames;
+        for (int i = 0; i < count; i++)
+            frames.push_back(make_frame());
+        return frames;
+    }
+}
+
+TEST_CASE("Metadata construction", "[hailo_objects]")
+{
+    BENCHMARK("frame of 500 detections")
+    {
+        return make_frame();
+    };
+
+    BENCHMARK("HailoObjectMutex of every object")
+    {
+        return std::vector<HailoObjectMutex>(DETECTIONS_PER_FRAME * 2);
+    };
+
+    BENCHMARK("heap allocated std::mutex of every object (previous lock)")
+    {
+        std::vector<std::shared_ptr<std::mutex>> mutexes;
+        mutexes.reserve(DETECTIONS_PER_FRAME * 2);
+        for (int i = 0; i < DETECTIONS_PER_FRAME * 2; i++)
+            mutexes.push_back(std::make_shared<std::mutex>());
+        return mutexes;
+    };
+}
+
+TEST_CASE("Metadata traversal", "[hailo_objects]")
+{
+    HailoROIPtr roi = make_frame();
+
+    BENCHMARK("objects_typed view")
+    {
+        size_t count = 0;
+        for (auto &obj : roi->objects_typed(HAILO_DETECTION))
+            count += std::static_pointer_cast<HailoDetection>(obj)->get_class_id();
+        return count;
+    };
+
+    BENCHMARK("get_objects_typed copy (previous getters)")
+    {
+        size_t count = 0;
+        for (auto &obj : roi->get_objects_typed(HAILO_DETECTION))
+            count += std::static_pointer_cast<HailoDetection>(obj)->get_class_id();
+        return count;
+    };
+
+    BENCHMARK("get_hailo_detections and their classifications")
+    {
+        size_t count = 0;
+        for (HailoDetectionPtr &detection : hailo_common::get_hailo_detections(roi))
+            count += hailo_common::get_hailo_classifications(detection).size();
+        return count;
+    };
+
+    BENCHMARK("lock and unlock 500 HailoObjectMutex")
+    {
+        static std::vector<HailoObjectMutex> mutexes(DETECTIONS_PER_FRAME);
+        for (HailoObjectMutex &mutex : mutexes)
+            std::lock_guard<HailoObjectMutex> lock(mutex);
+        return mutexes.size();
+    };
+
+    BENCHMARK("lock and unlock 500 std::mutex (previous lock)")
+    {
+        static std::vector<std::mutex> mutexes(DETECTIONS_PER_FRAME);
+        for (std::mutex &mutex : mutexes)
+            std::lock_guard<std::mutex> lock(mutex);
+        return mutexes.size();
+    };
+}
+
+TEST_CASE("Metadata removal", "[hailo_objects]")
+{
+    BENCHMARK_ADVANCED("remove_objects_typed")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<HailoROIPtr> frames = make_frames(meter.runs());
+        meter.measure([&frames](int run)
+                      { frames[run]->remove_objects_typed(HAILO_DETECTION); });
+    };
+
+    BENCHMARK_ADVANCED("remove_object per match (previous remove_objects_typed)")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<HailoROIPtr> frames = make_frames(meter.runs());
+        meter.measure([&frames](int run)
+                      {
+                          for (auto obj : frames[run]->get_objects_typed(HAILO_DETECTION))
+                              frames[run]->remove_object(obj);
+                      });
+    };
+}
@@ -0,0 +1,83 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Resizing YUY2 crops of a 1080p frame to network inputs, with the packed single pass resize_yuy2
+  and with the split / resize / merge implementation it replaced (resize_yuy2_reference.hpp).
+ */
+#include <string>
+
+#include "catch.hpp"
+#include "common/image.hpp"
+#include "resize_yuy2_reference.hpp"
+
+// The packed resize uses 7 bit weights, OpenCV 11 bit ones
+#define MAX_LINEAR_DIFFERENCE 3
+
+namespace
+{
+    struct ResizeCase
+    {
+        cv::Rect crop; // In pixels of the frame
+        cv::Size size; // In pixels
+    };
+
+    // A 1080p YUY2 frame, each CV_8UC4 element is a macropixel of two pixels
+    cv::Mat make_frame()
+    {
+        cv::Mat frame(1080, 1920 / 2, CV_8UC4);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+        return frame;
+    }
+
+    std::string case_name(const ResizeCase &resize, const std::string &interpolation)
+    {
+        return std::to_string(resize.crop.width) + "x" + std::to_string(resize.crop.height) + " to " +
+               std::to_string(resize.size.width) + "x" + std::to_string(resize.size.height) + " " + interpolation;
+    }
+}
+
+TEST_CASE("Resizing YUY2 crops", "[image]")
+{
+    cv::Mat frame = make_frame();
+    const ResizeCase cases[] = {
+        {cv::Rect(0, 0, 1920, 1080), cv::Size(640, 640)}, // Whole frame to a detector
+        {cv::Rect(400, 200, 640, 480), cv::Size(224, 224)}, // Classifier crop
+        {cv::Rect(1000, 300, 200, 400), cv::Size(128, 256)}, // Person crop to a re-id network
+        {cv::Rect(700, 500, 160, 120), cv::Size(640, 480)}, // Small crop upscaled
+    };
+
+    for (const ResizeCase &resize : cases)
+    {
+        cv::Mat crop = frame(cv::Rect(resize.crop.x / 2, resize.crop.y, resize.crop.width / 2, resize.crop.height));
+        cv::Mat resized(resize.size.height, resize.size.width / 2, CV_8UC4);
+        cv::Mat reference(resize.size.height, resize.size.width / 2, CV_8UC4);
+
+        resize_yuy2(crop, resized, cv::INTER_LINEAR);
+        resize_yuy2_reference(crop, reference, cv::INTER_LINEAR);
+        INFO(case_name(resize, "linear"));
+        CHECK(cv::norm(resized, reference, cv::NORM_INF) <= MAX_LINEAR_DIFFERENCE);
+
+        BENCHMARK(case_name(resize, "linear, packed"))
+        {
+            resize_yuy2(crop, resized, cv::INTER_LINEAR);
+            return resized.data;
+        };
+        BENCHMARK(case_name(resize, "linear, split planes (previous)"))
+        {
+            resize_yuy2_reference(crop, reference, cv::INTER_LINEAR);
+            return reference.data;
+        };
+        BENCHMARK(case_name(resize, "nearest, packed"))
+        {
+            resize_yuy2(crop, resized, cv::INTER_NEAREST);
+            return resized.data;
+        };
+        BENCHMARK(case_name(resize, "nearest, split planes (previous)"))
+        {
+            resize_yuy2_reference(crop, reference, cv::INTER_NEAREST);
+            return reference.data;
+        };
+    }
+}
@@ -0,0 +1,172 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Per frame latency of the yolov5seg postprocess (decoding, nms and mask decoding) on synthetic yolov5n_seg
+  outputs, with the default parameters. The same cases are built twice: bench_yolov5seg links the current
+  postprocess, bench_yolov5seg_previous the one it replaced (yolov5seg_reference.cpp).
+ */
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "yolov5seg.hpp"
+
+#ifdef YOLOV5SEG_PREVIOUS
+#define IMPLEMENTATION_NAME " (previous)"
+#else
+#define IMPLEMENTATION_NAME ""
+#endif
+
+#define NUM_CLASSES (80)
+#define ROW_SIZE (4 + 1 + NUM_CLASSES + 32) // box, objectness, classes, mask coefficients
+#define NUM_ANCHORS (3)
+#define PROTO_SIZE (160)
+#define PROTO_CHANNELS (32)
+
+// Quantization of the branches, a logit of 0 is code 30000
+#define BRANCH_QP_ZP (30000.0f)
+#define BRANCH_QP_SCALE (0.001f)
+#define PROTO_QP_ZP (128.0f)
+#define PROTO_QP_SCALE (0.02f)
+
+namespace
+{
+    uint16_t quantize(float logit)
+    {
+        return uint16_t(logit / BRANCH_QP_SCALE + BRANCH_QP_ZP);
+    }
+
+    HailoTensorPtr make_tensor(uint8_t *data, const std::string &name, uint32_t size, uint32_t features,
+                               HailoTensorFormatType type, float qp_zp, float qp_scale)
+    {
+        hailo_tensor_metadata_t info;
+        std::memset(&info, 0, sizeof(info));
+        std::strncpy(info.name, name.c_str(), sizeof(info.name) - 1);
+        info.shape.height = size;
+        info.shape.width = size;
+        info.shape.features = features;
+        info.format.type = type;
+        info.quant_info.qp_zp = qp_zp;
+        info.quant_info.qp_scale = qp_scale;
+        return std::make_shared<HailoTensor>(data, info);
+    }
+
+    /**
+     * @brief The outputs of one yolov5n_seg frame with a given number of instances.
+     *        Background rows are all below the objectness threshold. Every instance is seen by two
+     *        neighbouring cells with the same box, the weaker one is removed by the nms. Instances are
+     *        two cells apart, so they are all kept.
+     */
+    class SyntheticOutputs
+    {
+    private:
+        std::vector<std::vector<uint16_t>> m_branches;
+        std::vector<uint8_t> m_proto;
+        std::vector<HailoTensorPtr> m_tensors;
+
+        void set_row(uint16_t *row, int class_id, float tx, float objectness, std::mt19937 &generator)
+        {
+            std::uniform_real_distribution<float> coefficient(-1.0f, 1.0f);
+            row[0] = quantize(tx);
+            row[1] = quantize(0.0f);
+            row[2] = quantize(0.0f);
+            row[3] = quantize(0.0f);
+            row[4] = quantize(objectness);
+            for (int class_index = 0; class_index < NUM_CLASSES; class_index++)
+                row[5 + class_index] = quantize(class_index == class_id ? 4.0f : -6.0f);
+            for (int k = 5 + NUM_CLASSES; k < ROW_SIZE; k++)
+                row[k] = quantize(coefficient(generator));
+        }
+
+    public:
+        SyntheticOutputs(size_t instances, unsigned seed)
+        {
+            Yolov5segParams defaults;
+            const size_t num_branches = defaults.outputs_size.size();
+            std::mt19937 generator(seed);
+            std::uniform_real_distribution<float> background(-8.0f, 4.0f);
+            std::uniform_real_distribution<float> background_objectness(-8.0f, -2.0f);
+
+            m_branches.resize(num_branches);
+            for (size_t branch = 0; branch < num_branches; branch++)
+            {
+                const size_t size = defaults.outputs_size[branch];
+                m_branches[branch].resize(size * size * NUM_ANCHORS * ROW_SIZE);
+                for (size_t i = 0; i < m_branches[branch].size(); i++)
+                    m_branches[branch][i] = quantize((i % ROW_SIZE == 4) ? background_objectness(generator) : background(generator));
+            }
+
+            for (size_t instance = 0; instance < instances; instance++)
+            {
+                const size_t branch = instance % num_branches;
+                const size_t position = instance / num_branches;
+                const size_t size = defaults.outputs_size[branch];
+                const size_t columns = size / 2 - 1;
+                const size_t x = (position % columns) * 2;
+                const size_t y = (position / columns) * 2;
+                const size_t anchor = instance % NUM_ANCHORS;
+                const int class_id = instance % NUM_CLASSES;
+                uint16_t *data = m_branches[branch].data();
+                // Both boxes are centered 1.25 cells right of cell x: sigmoid(tx) is 0.875 in x, 0.375 in x + 1
+                set_row(data + ((y * size + x) * NUM_ANCHORS + anchor) * ROW_SIZE, class_id, std::log(7.0f), 3.0f, generator);
+                set_row(data + ((y * size + x + 1) * NUM_ANCHORS + anchor) * ROW_SIZE, class_id, std::log(0.6f), 2.0f, generator);
+            }
+
+            std::uniform_int_distribution<int> proto_code(0, 255);
+            m_proto.resize(PROTO_SIZE * PROTO_SIZE * PROTO_CHANNELS);
+            for (uint8_t &code : m_proto)
+                code = proto_code(generator);
+
+            // outputs_name[0] is the proto layer, branch i is outputs_name[num_branches - i]
+            m_tensors.push_back(make_tensor(m_proto.data(), defaults.outputs_name[0], PROTO_SIZE, PROTO_CHANNELS,
+                                            HailoTensorFormatType::HAILO_FORMAT_TYPE_UINT8, PROTO_QP_ZP, PROTO_QP_SCALE));
+            for (size_t branch = 0; branch < num_branches; branch++)
+                m_tensors.push_back(make_tensor(reinterpret_cast<uint8_t *>(m_branches[branch].data()),
+                                                defaults.outputs_name[num_branches - branch], defaults.outputs_size[branch],
+                                                NUM_ANCHORS * ROW_SIZE, HailoTensorFormatType::HAILO_FORMAT_TYPE_UINT16,
+                                                BRANCH_QP_ZP, BRANCH_QP_SCALE));
+        }
+
+        HailoROIPtr make_roi() const
+        {
+            HailoROIPtr roi = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+            for (const HailoTensorPtr &tensor : m_tensors)
+                roi->add_tensor(tensor);
+            return roi;
+        }
+    };
+}
+
+TEST_CASE("yolov5seg per frame latency", "[yolov5seg]")
+{
+    // No config file, the default yolov5n_seg parameters
+    Yolov5segParams *params = init("", "yolov5seg");
+
+    for (size_t instances : {0, 10, 50, 100})
+    {
+        SyntheticOutputs outputs(instances, instances);
+        HailoROIPtr roi = outputs.make_roi();
+        filter(roi, params);
+        CHECK(roi->get_objects_typed(HAILO_DETECTION).size() == instances);
+
+        // Frames are made ahead, each run gets its own roi to add the detections to
+        BENCHMARK_ADVANCED(std::to_string(instances) + " instances" + IMPLEMENTATION_NAME)(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<HailoROIPtr> rois;
+            for (int run = 0; run < meter.runs(); run++)
+                rois.push_back(outputs.make_roi());
+            meter.measure([&rois, params](int run)
+                          {
+                              filter(rois[run], params);
+                              return rois[run]->get_objects().size();
+                          });
+        };
+    }
+
+    free_resources(params);
+}
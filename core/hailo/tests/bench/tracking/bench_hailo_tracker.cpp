@@ -0,0 +1,102 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Scaling of the tracker registry with the number of streams: every stream runs on its own thread, like the
+  streaming threads of hailotracker elements, and updates its own tracker with a synthetic scene.
+  Trackers used to share one registry lock, held for the whole update. The run under a single global lock
+  reproduces that, next to per stream handles (hailotracker) and updates by name (python API).
+ */
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "hailo_tracker.hpp"
+#include "synthetic_scene.hpp"
+
+#define MAX_STREAMS (8)
+#define OBJECTS_PER_STREAM (30)
+#define FRAMES_PER_RUN (50)
+
+namespace
+{
+    std::mutex previous_registry_mutex;
+
+    std::string tracker_name(size_t stream)
+    {
+        return "bench_stream_" + std::to_string(stream);
+    }
+
+    /**
+     * @brief Track FRAMES_PER_RUN frames on every stream, concurrently.
+     *
+     * @return size_t Number of tracked detections reported, summed over the streams.
+     */
+    template <typename Update>
+    size_t run_streams(size_t streams, Update update)
+    {
+        std::atomic<size_t> tracked{0};
+        std::vector<std::thread> threads;
+        for (size_t stream = 0; stream < streams; stream++)
+        {
+            threads.emplace_back([&tracked, &update, stream]()
+                                 {
+                                     SyntheticScene scene(OBJECTS_PER_STREAM, stream);
+                                     size_t count = 0;
+                                     for (int frame = 0; frame < FRAMES_PER_RUN; frame++)
+                                     {
+                                         std::vector<HailoDetectionPtr> detections = scene.next_frame();
+                                         count += update(stream, detections).size();
+                                     }
+                                     tracked += count;
+                                 });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+        return tracked;
+    }
+}
+
+TEST_CASE("Tracking concurrent streams", "[hailo_tracker]")
+{
+    HailoTracker &registry = HailoTracker::GetInstance();
+    std::vector<HailoTrackerHandle> handles;
+    for (size_t stream = 0; stream < MAX_STREAMS; stream++)
+    {
+        registry.add_jde_tracker(tracker_name(stream));
+        handles.push_back(registry.get_jde_tracker(tracker_name(stream)));
+    }
+
+    for (size_t streams : {1, 2, 4, MAX_STREAMS})
+    {
+        std::string run = std::to_string(streams) + " streams x " + std::to_string(FRAMES_PER_RUN) + " frames";
+
+        BENCHMARK("per stream handles, " + run)
+        {
+            return run_streams(streams, [&](size_t stream, std::vector<HailoDetectionPtr> &detections)
+                               { return registry.update(handles[stream], detections); });
+        };
+
+        BENCHMARK("update by name, " + run)
+        {
+            return run_streams(streams, [&](size_t stream, std::vector<HailoDetectionPtr> &detections)
+                               { return registry.update(tracker_name(stream), detections); });
+        };
+
+        BENCHMARK("one global lock (previous), " + run)
+        {
+            return run_streams(streams, [&](size_t stream, std::vector<HailoDetectionPtr> &detections)
+                               {
+                                   std::lock_guard<std::mutex> lock(previous_registry_mutex);
+                                   return registry.update(handles[stream], detections);
+                               });
+        };
+    }
+
+    for (size_t stream = 0; stream < MAX_STREAMS; stream++)
+        registry.remove_jde_tracker(tracker_name(stream));
+}
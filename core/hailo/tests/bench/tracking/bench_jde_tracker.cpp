@@ -0,0 +1,67 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Per frame update latency of the JDE tracker over synthetic scenes of 10 to 1000 objects.
+  The tracker is warmed up first, so the measured frames run with every track confirmed.
+ */
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "jde_tracker.hpp"
+#include "synthetic_scene.hpp"
+
+#define WARMUP_FRAMES (30)
+// In the scenes with missed detections, every object is missed once every MISS_PERIOD frames
+#define MISS_PERIOD (10)
+
+namespace
+{
+    std::vector<HailoDetectionPtr> next_frame(SyntheticScene &scene, int frame, bool missed_detections)
+    {
+        std::vector<HailoDetectionPtr> detections = scene.next_frame();
+        if (!missed_detections)
+            return detections;
+        std::vector<HailoDetectionPtr> detected;
+        for (size_t i = 0; i < detections.size(); i++)
+        {
+            if ((i + frame) % MISS_PERIOD != 0)
+                detected.push_back(detections[i]);
+        }
+        return detected;
+    }
+
+    void bench_scene(size_t objects, bool missed_detections)
+    {
+        std::string name = std::to_string(objects) + " tracks" + (missed_detections ? ", 10% missed per frame" : "");
+        BENCHMARK_ADVANCED(name)(Catch::Benchmark::Chronometer meter)
+        {
+            SyntheticScene scene(objects, objects);
+            JDETracker tracker;
+            int frame = 0;
+            for (; frame < WARMUP_FRAMES; frame++)
+            {
+                std::vector<HailoDetectionPtr> detections = next_frame(scene, frame, missed_detections);
+                tracker.update(detections);
+            }
+
+            // Frames are detected ahead, only the tracker update is timed
+            std::vector<std::vector<HailoDetectionPtr>> frames;
+            for (int run = 0; run < meter.runs(); run++)
+                frames.push_back(next_frame(scene, frame++, missed_detections));
+            meter.measure([&tracker, &frames](int run)
+                          { return tracker.update(frames[run]).size(); });
+        };
+    }
+}
+
+TEST_CASE("JDE tracker update latency", "[jde_tracker]")
+{
+    for (size_t objects : {10, 50, 100, 250, 500, 1000})
+    {
+        bench_scene(objects, false);
+        bench_scene(objects, true);
+    }
+}
@@ -0,0 +1,87 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include "hailo_objects.hpp"
+
+/**
+ * @brief Objects moving at constant velocity over a frame, bouncing off its edges.
+ *        Every frame detects each object once, with a little noise on its box, in normalized coordinates
+ *        like the detections a post process attaches to a frame.
+ */
+class SyntheticScene
+{
+private:
+    struct SceneObject
+    {
+        float x;
+        float y;
+        float width;
+        float height;
+        float velocity_x;
+        float velocity_y;
+    };
+
+    std::mt19937 m_generator;
+    std::vector<SceneObject> m_objects;
+
+    float uniform(float min, float max)
+    {
+        return std::uniform_real_distribution<float>(min, max)(m_generator);
+    }
+
+    static void bounce(float &position, float &velocity, float size)
+    {
+        if (position < 0.0f || position + size > 1.0f)
+        {
+            velocity = -velocity;
+            position = std::min(std::max(position, 0.0f), 1.0f - size);
+        }
+    }
+
+public:
+    SyntheticScene(size_t objects, unsigned int seed) : m_generator(seed)
+    {
+        for (size_t i = 0; i < objects; i++)
+        {
+            SceneObject object;
+            object.width = uniform(0.01f, 0.05f);
+            object.height = uniform(0.02f, 0.1f);
+            object.x = uniform(0.0f, 1.0f - object.width);
+            object.y = uniform(0.0f, 1.0f - object.height);
+            object.velocity_x = uniform(-0.005f, 0.005f);
+            object.velocity_y = uniform(-0.005f, 0.005f);
+            m_objects.push_back(object);
+        }
+    }
+
+    size_t size() const
+    {
+        return m_objects.size();
+    }
+
+    /**
+     * @brief Move the objects by one frame and detect them.
+     */
+    std::vector<HailoDetectionPtr> next_frame()
+    {
+        std::vector<HailoDetectionPtr> detections;
+        detections.reserve(m_objects.size());
+        for (SceneObject &object : m_objects)
+        {
+            object.x += object.velocity_x;
+            object.y += object.velocity_y;
+            bounce(object.x, object.velocity_x, object.width);
+            bounce(object.y, object.velocity_y, object.height);
+            float noise = uniform(-0.001f, 0.001f);
+            HailoBBox bbox(object.x + noise, object.y - noise, object.width, object.height);
+            detections.push_back(hailo_make_shared<HailoDetection>(bbox, 1, "person", uniform(0.5f, 1.0f)));
+        }
+        return detections;
+    }
+};
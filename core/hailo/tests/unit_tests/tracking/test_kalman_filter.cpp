@@ -0,0 +1,217 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Checks the unrolled Kalman filter of the JDE tracker against the xtensor implementation it replaced,
+  over random predict / update / gating sequences.
+ */
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+#include "kalman_filter.hpp"
+#include "kalman_filter_reference.hpp"
+
+// Both filters sum in the same order, only FMA contraction may move the last bits
+#define KALMAN_EPSILON 1e-5
+
+namespace
+{
+    struct TrackState
+    {
+        TrackerTypes::KAL_MEAN mean;
+        TrackerTypes::KAL_COVA covariance;
+    };
+
+    class RandomBoxes
+    {
+    private:
+        std::mt19937 m_generator;
+
+    public:
+        explicit RandomBoxes(unsigned int seed) : m_generator(seed) {}
+
+        float uniform(float min, float max)
+        {
+            return std::uniform_real_distribution<float>(min, max)(m_generator);
+        }
+
+        // A box (x, y, a, h) in pixels of a 1080p frame
+        TrackerTypes::DETECTBOX box()
+        {
+            TrackerTypes::DETECTBOX measurement;
+            measurement(0) = uniform(0.0f, 1920.0f);
+            measurement(1) = uniform(0.0f, 1080.0f);
+            measurement(2) = uniform(0.3f, 2.0f);
+            measurement(3) = uniform(20.0f, 400.0f);
+            return measurement;
+        }
+
+        // The box moved by a few pixels, as the next detection of the same object
+        TrackerTypes::DETECTBOX near(const TrackerTypes::DETECTBOX &measurement)
+        {
+            TrackerTypes::DETECTBOX moved = measurement;
+            moved(0) += uniform(-8.0f, 8.0f);
+            moved(1) += uniform(-8.0f, 8.0f);
+            moved(2) += uniform(-0.05f, 0.05f);
+            moved(3) += uniform(-4.0f, 4.0f);
+            return moved;
+        }
+    };
+
+    template <typename T>
+    void require_equal(const T &actual, const T &expected)
+    {
+        REQUIRE(actual.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            INFO("element " << i);
+            REQUIRE(actual.data()[i] == Approx(expected.data()[i]).epsilon(KALMAN_EPSILON).margin(KALMAN_EPSILON));
+        }
+    }
+
+    void require_equal(const TrackState &actual, const TrackState &expected)
+    {
+        require_equal(actual.mean, expected.mean);
+        require_equal(actual.covariance, expected.covariance);
+    }
+}
+
+TEST_CASE("initiate matches the reference filter", "[kalman_filter]")
+{
+    KalmanFilter filter;
+    ReferenceKalmanFilter reference;
+    RandomBoxes boxes(1);
+    for (int i = 0; i < 100; i++)
+    {
+        TrackerTypes::DETECTBOX measurement = boxes.box();
+        TrackerTypes::KAL_DATA actual = filter.initiate(measurement);
+        TrackerTypes::KAL_DATA expected = reference.initiate(measurement);
+        require_equal(actual.first, expected.first);
+        require_equal(actual.second, expected.second);
+    }
+}
+
+TEST_CASE("predict matches the reference filter", "[kalman_filter]")
+{
+    KalmanFilter filter;
+    ReferenceKalmanFilter reference;
+    RandomBoxes boxes(2);
+    for (int track = 0; track < 50; track++)
+    {
+        TrackerTypes::KAL_DATA initial = filter.initiate(boxes.box());
+        TrackState actual{initial.first, initial.second};
+        TrackState expected = actual;
+        // Lost tracks are predicted for many frames without an update
+        for (int frame = 0; frame < 30; frame++)
+        {
+            filter.predict(actual.mean, actual.covariance);
+            reference.predict(expected.mean, expected.covariance);
+            require_equal(actual, expected);
+        }
+    }
+}
+
+TEST_CASE("update matches the reference filter", "[kalman_filter]")
+{
+    KalmanFilter filter;
+    ReferenceKalmanFilter reference;
+    RandomBoxes boxes(3);
+    for (int track = 0; track < 50; track++)
+    {
+        TrackerTypes::DETECTBOX measurement = boxes.box();
+        TrackerTypes::KAL_DATA initial = filter.initiate(measurement);
+        TrackState actual{initial.first, initial.second};
+        TrackState expected = actual;
+        for (int frame = 0; frame < 30; frame++)
+        {
+            filter.predict(actual.mean, actual.covariance);
+            reference.predict(expected.mean, expected.covariance);
+            measurement = boxes.near(measurement);
+            TrackerTypes::KAL_DATA actual_update = filter.update(actual.mean, actual.covariance, measurement);
+            TrackerTypes::KAL_DATA expected_update = reference.update(expected.mean, expected.covariance, measurement);
+            actual = {actual_update.first, actual_update.second};
+            expected = {expected_update.first, expected_update.second};
+            require_equal(actual, expected);
+        }
+    }
+}
+
+TEST_CASE("gating_distance matches the reference filter", "[kalman_filter]")
+{
+    KalmanFilter filter;
+    ReferenceKalmanFilter reference;
+    RandomBoxes boxes(4);
+    std::vector<float> distances;
+    for (int track = 0; track < 50; track++)
+    {
+        TrackerTypes::DETECTBOX measurement = boxes.box();
+        TrackerTypes::KAL_DATA state = filter.initiate(measurement);
+        for (int frame = 0; frame < 5; frame++)
+        {
+            filter.predict(state.first, state.second);
+            measurement = boxes.near(measurement);
+            state = filter.update(state.first, state.second, measurement);
+        }
+
+        // Close and far detections, the tracker gates them against chi2inv95
+        std::vector<TrackerTypes::DETECTBOX> measurements;
+        for (int i = 0; i < 10; i++)
+            measurements.push_back(i % 2 == 0 ? boxes.near(measurement) : boxes.box());
+
+        filter.gating_distance(state.first, state.second, measurements, distances);
+        xt::xarray<float> expected = reference.gating_distance(state.first, state.second, measurements);
+        REQUIRE(distances.size() == expected.size());
+        for (size_t i = 0; i < distances.size(); i++)
+        {
+            INFO("measurement " << i);
+            REQUIRE(distances[i] == Approx(expected(i)).epsilon(KALMAN_EPSILON).margin(KALMAN_EPSILON));
+            bool gated = distances[i] > KalmanFilter::chi2inv95[4];
+            bool expected_gated = expected(i) > ReferenceKalmanFilter::chi2inv95[4];
+            REQUIRE(gated == expected_gated);
+        }
+    }
+}
+
+TEST_CASE("multi_predict matches predicting every track with the reference filter", "[kalman_filter]")
+{
+    KalmanFilter filter;
+    ReferenceKalmanFilter reference;
+    RandomBoxes boxes(5);
+    // Several batches, the last one partial
+    for (size_t count : {1, 31, 32, 33, 100})
+    {
+        std::vector<TrackState> actual;
+        for (size_t i = 0; i < count; i++)
+        {
+            TrackerTypes::DETECTBOX measurement = boxes.box();
+            TrackerTypes::KAL_DATA state = filter.initiate(measurement);
+            // Give every track a velocity, so the position and velocity blocks are all non zero
+            filter.predict(state.first, state.second);
+            state = filter.update(state.first, state.second, boxes.near(measurement));
+            actual.push_back({state.first, state.second});
+        }
+        std::vector<TrackState> expected = actual;
+
+        std::vector<TrackerTypes::KAL_MEAN *> means;
+        std::vector<TrackerTypes::KAL_COVA *> covariances;
+        for (TrackState &track : actual)
+        {
+            means.push_back(&track.mean);
+            covariances.push_back(&track.covariance);
+        }
+        for (int frame = 0; frame < 3; frame++)
+        {
+            filter.multi_predict(means.data(), covariances.data(), count);
+            for (TrackState &track : expected)
+                reference.predict(track.mean, track.covariance);
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            INFO(count << " tracks, track " << i);
+            require_equal(actual[i], expected[i]);
+        }
+    }
+}
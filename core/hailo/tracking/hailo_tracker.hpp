@@ -7,6 +7,7 @@
 // General cpp includes
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <map>
@@ -45,6 +46,18 @@ struct HailoTrackerParams
     std::vector<hailo_object_t> hailo_objects_blacklist;
 };
 
+/**
+ * @brief A single JDE tracker and its lock, see HailoTracker::get_jde_tracker.
+ */
+class HailoTrackerEntry;
+using HailoTrackerHandle = std::shared_ptr<HailoTrackerEntry>;
+
+/**
+ * @brief Registry of the JDE trackers of the process, by name.
+ * Every tracker has its own lock, the registry lock is only held to resolve a name. So trackers of
+ * different streams (or elements) update concurrently. Callers on a hot path can resolve the name
+ * once with get_jde_tracker and keep the handle, which stays valid even if the tracker is removed.
+ */
 class HailoTracker
 {
 private:
@@ -54,7 +67,6 @@ private:
     HailoTracker &operator=(const HailoTracker &) = delete;
     ~HailoTracker();
     HailoTracker();
-    static std::mutex mutex_;
 
 public:
     static HailoTracker &GetInstance();
@@ -62,7 +74,9 @@ public:
     void add_jde_tracker(const std::string &name);
     void remove_jde_tracker(const std::string &name);
     std::vector<std::string> get_trackers_list();
+    HailoTrackerHandle get_jde_tracker(const std::string &name);
     std::vector<HailoDetectionPtr> update(const std::string &name, std::vector<HailoDetectionPtr> &inputs);
+    std::vector<HailoDetectionPtr> update(const HailoTrackerHandle &tracker, std::vector<HailoDetectionPtr> &inputs);
     void add_object_to_track(const std::string &name, int id, HailoObjectPtr obj);
     void remove_classifications_from_track(const std::string &name, int track_id, std::string classifier_type);
     void remove_matrices_from_track(const std::string &name, int track_id);
@@ -0,0 +1,83 @@
+/**
+* Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+* Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+**/
+/*
+  Contiguous buffers used by the JDETracker association steps.
+  They are owned by the tracker and reused across frames, so a steady scene runs
+  the association without allocating.
+*/
+
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief A dense, row-major cost matrix between two sets of objects.
+ *        Resizing keeps the allocated capacity.
+ */
+class CostMatrix
+{
+private:
+    std::vector<float> m_data;
+    int m_rows{0};
+    int m_cols{0};
+
+public:
+    void resize(int rows, int cols)
+    {
+        m_rows = rows;
+        m_cols = cols;
+        m_data.resize(static_cast<size_t>(rows) * cols);
+    }
+
+    void clear() { resize(0, 0); }
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    bool empty() const { return m_data.empty(); }
+
+    float *row(int i) { return m_data.data() + static_cast<size_t>(i) * m_cols; }
+    const float *row(int i) const { return m_data.data() + static_cast<size_t>(i) * m_cols; }
+
+    float &operator()(int i, int j) { return row(i)[j]; }
+    float operator()(int i, int j) const { return row(i)[j]; }
+};
+
+/**
+ * @brief A set of bounding boxes <xmin,ymin,xmax,ymax> stored as separate columns,
+ *        so the iou kernel can compare one box against several boxes at once.
+ */
+struct TrackBoxes
+{
+    std::vector<float> xmin;
+    std::vector<float> ymin;
+    std::vector<float> xmax;
+    std::vector<float> ymax;
+    std::vector<float> area;
+
+    void clear()
+    {
+        xmin.clear();
+        ymin.clear();
+        xmax.clear();
+        ymax.clear();
+        area.clear();
+    }
+
+    /**
+     * @brief Add a box given as tlwh (xmin,ymin,width,height)
+     */
+    void push_back(const std::vector<float> &tlwh)
+    {
+        float x2 = tlwh[0] + tlwh[2];
+        float y2 = tlwh[1] + tlwh[3];
+        xmin.push_back(tlwh[0]);
+        ymin.push_back(tlwh[1]);
+        xmax.push_back(x2);
+        ymax.push_back(y2);
+        area.push_back((x2 - tlwh[0]) * (y2 - tlwh[1]));
+    }
+
+    size_t size() const { return xmin.size(); }
+};
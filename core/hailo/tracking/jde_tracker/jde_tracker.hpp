@@ -17,6 +17,7 @@
 #include <vector>
 
 // Tappas includes
+#include "cost_matrix.hpp"
 #include "hailo_objects.hpp"
 #include "kalman_filter.hpp"
 #include "lapjv.hpp"
@@ -57,6 +58,25 @@ private:
     KalmanFilter m_kalman_filter;                          // Kalman Filter
     std::vector<hailo_object_t> m_hailo_objects_blacklist; // Objects that will never be kept track of
 
+    // Association buffers, kept between updates to avoid reallocating them every frame
+    std::vector<STrack> m_activated_stracks;             // Next tracked STracks
+    std::vector<STrack> m_next_lost_stracks;             // Next lost STracks
+    std::vector<STrack> m_next_new_stracks;              // Next new STracks
+    std::vector<STrack *> m_strack_pool;                 // Tracked/lost STracks to match
+    std::vector<STrack *> m_detection_pool;              // Detections to match
+    std::vector<STrack *> m_unconfirmed_pool;            // New STracks to match
+    std::vector<int> m_track_ids;                        // Track ids when joining STracks
+    CostMatrix m_distances;                              // Cost matrix of the current association
+    TrackBoxes m_atlbrs;                                 // Boxes of the cost matrix rows
+    TrackBoxes m_btlbrs;                                 // Boxes of the cost matrix columns
+    std::vector<TrackerTypes::DETECTBOX> m_measurements; // Detections in xyah for gating
+    std::vector<float> m_gating_distances;               // Gating distances of one STrack
+    std::vector<std::pair<int, int>> m_matches;          // Matches of the current association
+    std::vector<int> m_unmatched_tracked;                // Unmatched rows of the current association
+    std::vector<int> m_unmatched_detections;             // Unmatched columns of the current association
+    std::vector<int> m_rowsol;                           // Linear assignment row solution
+    std::vector<int> m_colsol;                           // Linear assignment column solution
+
     //******************************************************************
     // CLASS RESOURCE MANAGEMENT
     //******************************************************************
@@ -126,21 +146,20 @@ public:
 
     /******************** PRIVATE FUNCTIONS ****************************/
 private:
-    void update_unmatches(std::vector<STrack *> strack_pool, std::vector<STrack> &tracked_stracks, std::vector<STrack> &lost_stracks, std::vector<STrack> &new_stracks);
-    void update_matches(std::vector<std::pair<int, int>> matches, std::vector<STrack *> tracked_stracks, std::vector<STrack> &detections, std::vector<STrack> &activated_stracks);
-    void linear_assignment(std::vector<std::vector<float>> &cost_matrix, int cost_matrix_rows, int cost_matrix_cols, float thresh, std::vector<std::pair<int, int>> &matches, std::vector<int> &unmatched_a, std::vector<int> &unmatched_b);
+    void update_unmatches(const std::vector<STrack *> &strack_pool, std::vector<STrack> &tracked_stracks, std::vector<STrack> &lost_stracks, std::vector<STrack> &new_stracks);
+    void update_matches(const std::vector<std::pair<int, int>> &matches, const std::vector<STrack *> &tracked_stracks, const std::vector<STrack *> &detections, std::vector<STrack> &activated_stracks);
+    void linear_assignment(const CostMatrix &cost_matrix, int cost_matrix_rows, int cost_matrix_cols, float thresh, std::vector<std::pair<int, int>> &matches, std::vector<int> &unmatched_a, std::vector<int> &unmatched_b);
 
-    std::vector<std::vector<float>> iou_distance(std::vector<STrack *> &atracks, std::vector<STrack> &btracks);
-    std::vector<std::vector<float>> iou_distance(std::vector<STrack> &atracks, std::vector<STrack> &btracks);
+    void iou_distance(const std::vector<STrack *> &atracks, const std::vector<STrack *> &btracks, CostMatrix &cost_matrix);
 
     std::vector<STrack *> joint_strack_pointers(std::vector<STrack *> &tlista, std::vector<STrack *> &tlistb);
-    std::vector<STrack *> joint_strack_pointers(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
+    void joint_strack_pointers(std::vector<STrack> &tlista, std::vector<STrack> &tlistb, std::vector<STrack *> &res);
     std::vector<STrack> joint_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
     std::vector<STrack> sub_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
     void remove_duplicate_stracks(std::vector<STrack> &stracksa, std::vector<STrack> &stracksb);
 
-    void embedding_distance(std::vector<STrack *> &tracks, std::vector<STrack> &detections, std::vector<std::vector<float>> &cost_matrix);
-    void fuse_motion(std::vector<std::vector<float>> &cost_matrix, std::vector<STrack *> &tracks, std::vector<STrack> &detections, float lambda_);
+    void embedding_distance(const std::vector<STrack *> &tracks, const std::vector<STrack *> &detections, CostMatrix &cost_matrix);
+    void fuse_motion(CostMatrix &cost_matrix, const std::vector<STrack *> &tracks, const std::vector<STrack *> &detections, float lambda_);
 };
 __END_DECLS
 
@@ -30,13 +30,13 @@
  */
 inline std::vector<STrack> JDETracker::hailo_detections_to_stracks(std::vector<HailoDetectionPtr> &inputs, int frame_id, std::vector<hailo_object_t> hailo_objects_blacklist)
 {
-    std::vector<STrack> detections(inputs.size());
+    std::vector<STrack> detections;
+    detections.reserve(inputs.size());
     for (uint i = 0; i < inputs.size(); i++)
     {
         HailoBBox bbox = inputs[i]->get_bbox();
         std::vector<float> detection_box = {bbox.xmin(), bbox.ymin(), bbox.width(), bbox.height()};
-        STrack strack(detection_box, inputs[i]->get_confidence(), {}, inputs[i], frame_id, hailo_objects_blacklist);
-        detections[i] = strack;
+        detections.emplace_back(detection_box, inputs[i]->get_confidence(), std::vector<float>{}, inputs[i], frame_id, hailo_objects_blacklist);
     }
 
     return detections;
@@ -88,7 +88,7 @@ inline std::vector<HailoDetectionPtr> JDETracker::stracks_to_hailo_detections(st
             // Strack tlwh is stored as top-left, width-height: xmin,ymin,width,height
             HailoBBox bbox(stracks[i].m_tlwh[0], stracks[i].m_tlwh[1], stracks[i].m_tlwh[2], stracks[i].m_tlwh[3]);
             // HailoDetection is constructed as HailoDetection(HailoBBox, label, confidence)
-            objects.emplace_back(std::make_shared<HailoDetection>(HailoDetection(bbox, "tracked", stracks[i].m_confidence)));
+            objects.emplace_back(hailo_make_shared<HailoDetection>(HailoDetection(bbox, "tracked", stracks[i].m_confidence)));
         }
     }
 
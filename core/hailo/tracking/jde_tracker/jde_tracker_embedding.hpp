@@ -13,6 +13,7 @@
 #include <vector>
 
 // Tappas includes
+#include "cost_matrix.hpp"
 #include "strack.hpp"
 #include "tracker_macros.hpp"
 
@@ -20,47 +21,42 @@
 /**
  * @brief Create a cost matrix based on the features saved
  *        in each STrack. No return, is made, the matrix is
- *        filled in place.
+ *        filled in place, and left empty if either set is empty.
  * 
  * @param tracks  -  std::vector<STrack*>
  *        Pointers to tracked STracks
  *
- * @param detections  -  std::vector<STrack>
- *        The newly detected STracks
+ * @param detections  -  std::vector<STrack*>
+ *        Pointers to the newly detected STracks
  *
- * @param cost_matrix  -  std::vector<std::vector<float>>
+ * @param cost_matrix  -  CostMatrix
  *        The cost matrix to fill in.
- *
- * @param cost_matrix_rows  -  int *
- *        To fill in with number of cost matrix rows.
- *
- * @param cost_matrix_cols  -  int *
- *        To fill in with number of cost matrix columns.
  */
-inline void JDETracker::embedding_distance(std::vector<STrack*> &tracks,
-                                           std::vector<STrack> &detections,
-                                           std::vector<std::vector<float>> &cost_matrix)
+inline void JDETracker::embedding_distance(const std::vector<STrack*> &tracks,
+                                           const std::vector<STrack*> &detections,
+                                           CostMatrix &cost_matrix)
 {
     if (tracks.size() * detections.size() == 0)
     {
+        cost_matrix.clear();
         return;
     }
 
+    cost_matrix.resize(tracks.size(), detections.size());
     for (uint i = 0; i < tracks.size(); i++)
     {
-        std::vector<float> cost_matrix_tmp(detections.size());
-        std::vector<float> track_feature = tracks[i]->m_smooth_feat;
+        const float *track_feature = tracks[i]->m_smooth_feat.data();
+        float *cost_row = cost_matrix.row(i);
         for (uint j = 0; j < detections.size(); j++)
         {
-            std::vector<float> det_feature = detections[j].m_curr_feat;
+            const std::vector<float> &det_feature = detections[j]->m_curr_feat;
             float feat_square = 0.0;
             for (uint k = 0; k < det_feature.size(); k++)
             {
                 feat_square += (track_feature[k] - det_feature[k])*(track_feature[k] - det_feature[k]);
             }
-            cost_matrix_tmp[j] = std::sqrt(feat_square);
+            cost_row[j] = std::sqrt(feat_square);
         }
-        cost_matrix.push_back(cost_matrix_tmp);
     }
 }
 
@@ -69,49 +65,50 @@ inline void JDETracker::embedding_distance(std::vector<STrack*> &tracks,
  * @brief Update a cost matrix with the gating distance of all STracks.
  *        No returns are made 
  * 
- * @param cost_matrix  -  std::vector<std::vector<float>>
+ * @param cost_matrix  -  CostMatrix
  *        A preliminary cost matrix made by embedding_distance
  *
  * @param tracks  -  std::vector<STrack*>
  *        Pointers to tracked STracks.
  *
- * @param detections  -  std::vector<STrack>
- *        The newly detected STracks.
+ * @param detections  -  std::vector<STrack*>
+ *        Pointers to the newly detected STracks.
  *
  * @param lambda_  -  float
  *        How much weight to give the gating distance.
  */
-inline void JDETracker::fuse_motion(std::vector<std::vector<float>> &cost_matrix,
-                                    std::vector<STrack*> &tracks,
-                                    std::vector<STrack> &detections,
+inline void JDETracker::fuse_motion(CostMatrix &cost_matrix,
+                                    const std::vector<STrack*> &tracks,
+                                    const std::vector<STrack*> &detections,
                                     float lambda_ = 0.98)
 {
-    if (cost_matrix.size() == 0)
+    if (cost_matrix.empty())
         return;
 
     int gating_dim = 4;
     float gating_threshold = this->m_kalman_filter.chi2inv95[gating_dim];
 
-    std::vector<TrackerTypes::DETECTBOX> measurements(detections.size());
+    m_measurements.resize(detections.size());
     for (uint i = 0; i < detections.size(); i++)
     {
-        std::vector<float> tlwh_ = detections[i].to_xyah();
-        TrackerTypes::DETECTBOX measurement = {{tlwh_[0], tlwh_[1], tlwh_[2], tlwh_[3]}};
-        measurements[i] = measurement;
+        // xyah: center x, center y, aspect ratio, height
+        const std::vector<float> &tlwh_ = detections[i]->m_tlwh;
+        TrackerTypes::DETECTBOX measurement = {{tlwh_[0] + tlwh_[2] / 2, tlwh_[1] + tlwh_[3] / 2, tlwh_[2] / tlwh_[3], tlwh_[3]}};
+        m_measurements[i] = measurement;
     }
 
     for (uint i = 0; i < tracks.size(); i++)
     {
-        xt::xarray<float, xt::layout_type::row_major> gating_distance = m_kalman_filter.gating_distance(tracks[i]->m_mean,
-                                                                                                        tracks[i]->m_covariance,
-                                                                                                        measurements);
-        for (uint j = 0; j < cost_matrix[i].size(); j++)
+        std::vector<float> &gating_distance = m_gating_distances;
+        m_kalman_filter.gating_distance(tracks[i]->m_mean, tracks[i]->m_covariance, m_measurements, gating_distance);
+        float *cost_row = cost_matrix.row(i);
+        for (int j = 0; j < cost_matrix.cols(); j++)
         {
             if (gating_distance[j] > gating_threshold)
             {
-                cost_matrix[i][j] = FLT_MAX;
+                cost_row[j] = FLT_MAX;
             }
-            cost_matrix[i][j] = lambda_ * cost_matrix[i][j] + (1 - lambda_)*gating_distance[j];
+            cost_row[j] = lambda_ * cost_row[j] + (1 - lambda_)*gating_distance[j];
         }
     }
-}
\ No newline at end of file
+}
@@ -12,167 +12,141 @@
 #include <string>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 // Tappas includes
+#include "cost_matrix.hpp"
 #include "strack.hpp"
 #include "tracker_macros.hpp"
 
 
 /**
- * @brief Calculate the ious between two sets of bounding boxes.
- *        Iou is calculated and filled into a dense graph.
- * 
- * @param atlbrs  -  std::vector<std::vector<float>>
- *        A vector of bounding boxes <xmin,ymin,xmax,ymax>
+ * @brief Calculate the iou distances (1 - iou) between one box and a set of boxes.
+ *
+ * @param a  -  int
+ *        The index of the box in atlbrs.
+ *
+ * @param atlbrs  -  TrackBoxes
+ *        A set of bounding boxes <xmin,ymin,xmax,ymax>
  *
- * @param btlbrs  -  std::vector<std::vector<float>>
- *        A vector of bounding boxes <xmin,ymin,xmax,ymax>
+ * @param btlbrs  -  TrackBoxes
+ *        A set of bounding boxes <xmin,ymin,xmax,ymax>
  *
- * @return std::vector<std::vector<float>> 
- *         A dense graph of of ious of shape atlbrs.size() x btlbrs.size()
- *         For interpreting distances - 0 is far, 1 is close
+ * @param distances  -  float *
+ *        Row to fill, of size btlbrs.size()
  */
-inline std::vector<std::vector<float>> ious(std::vector<std::vector<float>> &atlbrs, std::vector<std::vector<float>> &btlbrs)
+inline void iou_distance_row(int a, const TrackBoxes &atlbrs, const TrackBoxes &btlbrs, float *distances)
 {
-    // The iou graph will be of shape atlbrs.size() x btlbrs.size()
-    std::vector<std::vector<float>> ious( atlbrs.size() , std::vector<float> (btlbrs.size()));
-
-    // If there are no box, then return
-    if (atlbrs.size() * btlbrs.size() == 0)
-        return ious;
-
-    //Calculate the ious between each possible pair of boxes from set A and set B
-    for (uint k = 0; k < btlbrs.size(); k++)
+    const float ax1 = atlbrs.xmin[a], ay1 = atlbrs.ymin[a], ax2 = atlbrs.xmax[a], ay2 = atlbrs.ymax[a];
+    const float a_area = atlbrs.area[a];
+    const int size = btlbrs.size();
+    int k = 0;
+#if defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; k + 4 <= size; k += 4)
     {
-        float box_area = (btlbrs[k][2] - btlbrs[k][0]) * (btlbrs[k][3] - btlbrs[k][1]);
-        for (uint n = 0; n < atlbrs.size(); n++)
+        __m128 iw = _mm_sub_ps(_mm_min_ps(_mm_set1_ps(ax2), _mm_loadu_ps(&btlbrs.xmax[k])), _mm_max_ps(_mm_set1_ps(ax1), _mm_loadu_ps(&btlbrs.xmin[k])));
+        __m128 ih = _mm_sub_ps(_mm_min_ps(_mm_set1_ps(ay2), _mm_loadu_ps(&btlbrs.ymax[k])), _mm_max_ps(_mm_set1_ps(ay1), _mm_loadu_ps(&btlbrs.ymin[k])));
+        __m128 overlap = _mm_and_ps(_mm_cmpgt_ps(iw, zero), _mm_cmpgt_ps(ih, zero));
+        __m128 inter = _mm_mul_ps(iw, ih);
+        __m128 ua = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(a_area), _mm_loadu_ps(&btlbrs.area[k])), inter);
+        // Lanes without overlap may divide by a degenerate union, the mask zeroes them anyway
+        __m128 iou = _mm_and_ps(overlap, _mm_div_ps(inter, ua));
+        _mm_storeu_ps(distances + k, _mm_sub_ps(one, iou));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (; k + 4 <= size; k += 4)
+    {
+        float32x4_t iw = vsubq_f32(vminq_f32(vdupq_n_f32(ax2), vld1q_f32(&btlbrs.xmax[k])), vmaxq_f32(vdupq_n_f32(ax1), vld1q_f32(&btlbrs.xmin[k])));
+        float32x4_t ih = vsubq_f32(vminq_f32(vdupq_n_f32(ay2), vld1q_f32(&btlbrs.ymax[k])), vmaxq_f32(vdupq_n_f32(ay1), vld1q_f32(&btlbrs.ymin[k])));
+        uint32x4_t overlap = vandq_u32(vcgtq_f32(iw, zero), vcgtq_f32(ih, zero));
+        float32x4_t inter = vmulq_f32(iw, ih);
+        float32x4_t ua = vsubq_f32(vaddq_f32(vdupq_n_f32(a_area), vld1q_f32(&btlbrs.area[k])), inter);
+        // Lanes without overlap may divide by a degenerate union, the mask zeroes them anyway
+        float32x4_t iou = vreinterpretq_f32_u32(vandq_u32(overlap, vreinterpretq_u32_f32(vdivq_f32(inter, ua))));
+        vst1q_f32(distances + k, vsubq_f32(one, iou));
+    }
+#endif
+    for (; k < size; k++)
+    {
+        float iou = 0.0f;
+        float iw = std::min(ax2, btlbrs.xmax[k]) - std::max(ax1, btlbrs.xmin[k]);
+        if (iw > 0.0f)
         {
-            float iw = std::min(atlbrs[n][2], btlbrs[k][2]) - std::max(atlbrs[n][0], btlbrs[k][0]);
-            if (iw > 0.0f)
+            float ih = std::min(ay2, btlbrs.ymax[k]) - std::max(ay1, btlbrs.ymin[k]);
+            if (ih > 0.0f)
             {
-                float ih = std::min(atlbrs[n][3], btlbrs[k][3]) - std::max(atlbrs[n][1], btlbrs[k][1]);
-                if (ih > 0.0f)
-                {
-                    float ua = (atlbrs[n][2] - atlbrs[n][0]) * (atlbrs[n][3] - atlbrs[n][1]) + box_area - iw * ih;
-                    ious[n][k] = iw * ih / ua;
-                }
-                else
-                {
-                    ious[n][k] = 0.0;
-                }
-            }
-            else
-            {
-                ious[n][k] = 0.0;
+                float ua = a_area + btlbrs.area[k] - iw * ih;
+                iou = iw * ih / ua;
             }
         }
+        distances[k] = 1.0f - iou;
     }
-
-    return ious;
 }
 
 /**
- * @brief Calculates the iou distances (1 - iou) between two sets of STracks
- *        Distances are returned as a dense graph.
- * 
- * @param atracks  -  std::vector<STrack *>
- *        A set of STracks (by pointer)
+ * @brief Calculate the iou distances (1 - iou) between two sets of bounding boxes.
+ *        Distances are filled into a dense graph.
  *
- * @param btracks   -  std::vector<STrack>
- *        A set of STracks
+ * @param atlbrs  -  TrackBoxes
+ *        A set of bounding boxes <xmin,ymin,xmax,ymax>
  *
- * @param dist_rows   -  int &
- *        int & to fill with the # of rows of the distance graph
+ * @param btlbrs  -  TrackBoxes
+ *        A set of bounding boxes <xmin,ymin,xmax,ymax>
  *
- * @param dist_cols   -  int &
- *        int & to fill with the # of columns of the distance graph
- *
- * @return std::vector<std::vector<float>> 
- *         A dense graph of iou distances (1 - iou), of shape atracks.size() x btracks.size()
+ * @param cost_matrix  -  CostMatrix
+ *         Filled with a dense graph of iou distances, of shape atlbrs.size() x btlbrs.size()
  *         For interpreting distances - 1 is far, 0 is close
  */
-inline std::vector<std::vector<float>> JDETracker::iou_distance(std::vector<STrack *> &atracks, std::vector<STrack> &btracks)
+inline void iou_distances(const TrackBoxes &atlbrs, const TrackBoxes &btlbrs, CostMatrix &cost_matrix)
 {
-    if ( (atracks.size() == 0) | (btracks.size() == 0) )
+    cost_matrix.resize(atlbrs.size(), btlbrs.size());
+    for (int i = 0; i < cost_matrix.rows(); i++)
     {
-        std::vector<std::vector<float>> cost_matrix;
-        return cost_matrix;
+        iou_distance_row(i, atlbrs, btlbrs, cost_matrix.row(i));
     }
-
-    // Prepare a set of bounding boxes from each of the two sets of STracks
-    std::vector<std::vector<float>> atlbrs( atracks.size() , std::vector<float> (4));
-    std::vector<std::vector<float>> btlbrs( btracks.size() , std::vector<float> (4));
-    for (uint i = 0; i < atracks.size(); i++)
-    {
-        atlbrs[i] = atracks[i]->tlbr();
-    }
-    for (uint i = 0; i < btracks.size(); i++)
-    {
-        btlbrs[i] = btracks[i].tlbr();
-    }
-
-    // Get a dense graph of the ious between all pairs of boxes fromt he two sets
-    std::vector<std::vector<float>> _ious = ious(atlbrs, btlbrs);
-
-    // The cost matrix will have the same shape as the ious graph
-    std::vector<std::vector<float>> cost_matrix( atracks.size() , std::vector<float> (btracks.size()));
-    //The cost matrix = 1 - ious
-    for (uint i = 0; i < _ious.size(); i++)
-    {
-        for (uint j = 0; j < _ious[i].size(); j++)
-        {
-            cost_matrix[i][j] = 1 - _ious[i][j];
-        }
-    }
-
-    return cost_matrix;
 }
 
 /**
  * @brief Calculates the iou distances (1 - iou) between two sets of STracks
- *        Distances are returned as a dense graph.
- * 
+ *        Distances are filled into a dense graph, left empty if either set is empty.
+ *
  * @param atracks  -  std::vector<STrack *>
- *        A set of STracks
+ *        A set of STracks (by pointer)
  *
- * @param btracks  -  std::vector<STrack>
- *        A set of STracks
+ * @param btracks   -  std::vector<STrack *>
+ *        A set of STracks (by pointer)
  *
- * @return std::vector<std::vector<float>> 
- *         A dense graph of iou distances (1 - iou), of shape atracks.size() x btracks.size()
+ * @param cost_matrix  -  CostMatrix
+ *         Filled with a dense graph of iou distances (1 - iou), of shape atracks.size() x btracks.size()
  *         For interpreting distances - 1 is far, 0 is close
  */
-inline std::vector<std::vector<float>> JDETracker::iou_distance(std::vector<STrack> &atracks, std::vector<STrack> &btracks)
+inline void JDETracker::iou_distance(const std::vector<STrack *> &atracks, const std::vector<STrack *> &btracks, CostMatrix &cost_matrix)
 {
-    if ( (atracks.size() == 0) | (btracks.size() == 0) )
+    if ((atracks.size() == 0) | (btracks.size() == 0))
     {
-        std::vector<std::vector<float>> cost_matrix;
-        return cost_matrix;
+        cost_matrix.clear();
+        return;
     }
 
     // Prepare a set of bounding boxes from each of the two sets of STracks
-    std::vector<std::vector<float>> atlbrs( atracks.size() , std::vector<float> (4));
-    std::vector<std::vector<float>> btlbrs( btracks.size() , std::vector<float> (4));
-    for (uint i = 0; i < atracks.size(); i++)
+    m_atlbrs.clear();
+    m_btlbrs.clear();
+    for (STrack *track : atracks)
     {
-        atlbrs[i] = atracks[i].tlbr();
+        m_atlbrs.push_back(track->m_tlwh);
     }
-    for (uint i = 0; i < btracks.size(); i++)
+    for (STrack *track : btracks)
     {
-        btlbrs[i] = btracks[i].tlbr();
-    }
-
-    // Get a dense graph of the ious between all pairs of boxes fromt he two sets
-    std::vector<std::vector<float>> _ious = ious(atlbrs, btlbrs);
-    // The cost matrix will have the same shape as the ious graph
-    std::vector<std::vector<float>> cost_matrix( atracks.size() , std::vector<float> (btracks.size()));
-    //The cost matrix = 1 - ious
-    for (uint i = 0; i < _ious.size(); i++)
-    {
-        for (uint j = 0; j < _ious[i].size(); j++)
-        {
-            cost_matrix[i][j] = 1 - _ious[i][j];
-        }
+        m_btlbrs.push_back(track->m_tlwh);
     }
 
-    return cost_matrix;
+    iou_distances(m_atlbrs, m_btlbrs, cost_matrix);
 }
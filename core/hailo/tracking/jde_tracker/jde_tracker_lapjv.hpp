@@ -13,6 +13,7 @@
 #include <vector>
 
 // Tappas includes
+#include "cost_matrix.hpp"
 #include "lapjv.hpp"
 #include "strack.hpp"
 #include "tracker_macros.hpp"
@@ -22,8 +23,10 @@
  * @brief Performs linear assignment on a given cost matrix.
  *        No return is made, instead vectors are filled with
  *        matching indices for row and column items.
+ *        The matrix is extended to a square one in a scratch buffer
+ *        that is kept between calls.
  * 
- * @param cost  -  std::vector<std::vector<float>>
+ * @param cost  -  CostMatrix
  *        A 2D cost matrix of distances between 2 sets of objects
  *
  * @param rowsol  -  std::vector<int>
@@ -40,76 +43,48 @@
  * @param return_cost  -  bool
  *        If true, then return the total cost, default true.
  */
-inline double lapjv_external(const std::vector<std::vector<float>> &cost,
+inline double lapjv_external(const CostMatrix &cost,
                              std::vector<int> &rowsol,
                              std::vector<int> &colsol,
                              float cost_limit = LONG_MAX, bool return_cost = true)
 {
-    std::vector<std::vector<float>> cost_c;
-    cost_c.assign(cost.begin(), cost.end());
+    thread_local std::vector<double> cost_extended;
+    thread_local std::vector<double *> cost_ptr;
+    thread_local std::vector<int> x_c;
+    thread_local std::vector<int> y_c;
 
-    std::vector<std::vector<float>> cost_c_extended;
-
-    int n_rows = cost.size();
-    int n_cols = cost[0].size();
+    int n_rows = cost.rows();
+    int n_cols = cost.cols();
     rowsol.resize(n_rows);
     colsol.resize(n_cols);
 
-    int n = 0;
-    if (n_rows == n_cols)
-    {
-        n = n_rows;
-    }
-
-    n = n_rows + n_cols;
-    cost_c_extended.resize(n);
-    for (uint i = 0; i < cost_c_extended.size(); i++) {
-        cost_c_extended[i].resize(n);
-    }
-
-    for (uint i = 0; i < cost_c_extended.size(); i++)
-    {
-        for (uint j = 0; j < cost_c_extended[i].size(); j++)
-        {
-            cost_c_extended[i][j] = cost_limit / 2.0;
-        }
-    }
-
-    for (uint i = n_rows; i < cost_c_extended.size(); i++)
-    {
-        for (uint j = n_cols; j < cost_c_extended[i].size(); j++)
-        {
-            cost_c_extended[i][j] = 0;
-        }
-    }
-    for (int i = 0; i < n_rows; i++)
+    // Extend the matrix to n x n: the cost matrix on the top left, zeros on the bottom right,
+    // and cost_limit / 2 everywhere else
+    int n = n_rows + n_cols;
+    cost_extended.resize(static_cast<size_t>(n) * n);
+    cost_ptr.resize(n);
+    x_c.resize(n);
+    y_c.resize(n);
+    const double half_limit = cost_limit / 2.0;
+    for (int i = 0; i < n; i++)
     {
-        for (int j = 0; j < n_cols; j++)
+        double *row = cost_extended.data() + static_cast<size_t>(i) * n;
+        cost_ptr[i] = row;
+        if (i < n_rows)
         {
-            cost_c_extended[i][j] = cost_c[i][j];
+            const float *cost_row = cost.row(i);
+            for (int j = 0; j < n_cols; j++)
+                row[j] = cost_row[j];
+            std::fill(row + n_cols, row + n, half_limit);
         }
-    }
-
-    cost_c.clear();
-    cost_c.assign(cost_c_extended.begin(), cost_c_extended.end());
-
-    double **cost_ptr;
-    cost_ptr = new double *[sizeof(double *) * n];
-    for (int i = 0; i < n; i++)
-        cost_ptr[i] = new double[sizeof(double) * n];
-
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = 0; j < n; j++)
+        else
         {
-            cost_ptr[i][j] = cost_c[i][j];
+            std::fill(row, row + n_cols, half_limit);
+            std::fill(row + n_cols, row + n, 0.0);
         }
     }
 
-    int x_c[n];
-    int y_c[n];
-
-    int ret = lapjv_internal(n, cost_ptr, x_c, y_c);
+    int ret = lapjv_internal(n, cost_ptr.data(), x_c.data(), y_c.data());
     if (ret != 0)
     {
         throw std::runtime_error("JDETracker error: incorrect lapjv calculation!");
@@ -154,12 +129,6 @@ inline double lapjv_external(const std::vector<std::vector<float>> &cost,
         }
     }
 
-    for (int i = 0; i < n; i++)
-    {
-        delete[] cost_ptr[i];
-    }
-    delete[] cost_ptr;
-
     return opt;
 }
 
@@ -169,9 +138,15 @@ inline double lapjv_external(const std::vector<std::vector<float>> &cost,
  *        No return is made, instead a given matrix of matches is filled,
  *        and vectors are filled for unmatched members of each list.
  * 
- * @param cost_matrix  -  std::vector<std::vector<float>>
+ * @param cost_matrix  -  CostMatrix
  *        A 2D cost matrix of distances between 2 sets of objects
  *
+ * @param cost_matrix_rows  -  int
+ *        Number of row items, used when the cost matrix is empty
+ *
+ * @param cost_matrix_cols  -  int
+ *        Number of column items, used when the cost matrix is empty
+ *
  * @param thresh  -  float
  *        The cost limit for lapjv
  *
@@ -184,7 +159,7 @@ inline double lapjv_external(const std::vector<std::vector<float>> &cost,
  * @param unmatched_b  - std::vector<int>
  *        Indices of unmatched objects from the column items
  */
-inline void JDETracker::linear_assignment(std::vector<std::vector<float>> &cost_matrix,
+inline void JDETracker::linear_assignment(const CostMatrix &cost_matrix,
                                           int cost_matrix_rows,
                                           int cost_matrix_cols,
                                           float thresh,
@@ -197,7 +172,7 @@ inline void JDETracker::linear_assignment(std::vector<std::vector<float>> &cost_
     unmatched_a.clear();
     unmatched_b.clear();
 
-	if (cost_matrix.size() == 0)
+	if (cost_matrix.empty())
 	{
 		for (int i = 0; i < cost_matrix_rows; i++)
 		{
@@ -210,15 +185,13 @@ inline void JDETracker::linear_assignment(std::vector<std::vector<float>> &cost_
 		return;
 	}
 
-    std::vector<int> rowsol;
-    std::vector<int> colsol;
-    lapjv_external(cost_matrix, rowsol, colsol, thresh);
+    lapjv_external(cost_matrix, m_rowsol, m_colsol, thresh, false);
 
-    for (uint i = 0; i < rowsol.size(); i++)
+    for (uint i = 0; i < m_rowsol.size(); i++)
     {
-        if (rowsol[i] >= 0)
+        if (m_rowsol[i] >= 0)
         {
-            matches.push_back(std::make_pair(i, rowsol[i]));
+            matches.push_back(std::make_pair(i, m_rowsol[i]));
         }
         else
         {
@@ -226,9 +199,9 @@ inline void JDETracker::linear_assignment(std::vector<std::vector<float>> &cost_
         }
     }
 
-    for (uint i = 0; i < colsol.size(); i++)
+    for (uint i = 0; i < m_colsol.size(); i++)
     {
-        if (colsol[i] < 0)
+        if (m_colsol[i] < 0)
         {
             unmatched_b.push_back(i);
         }
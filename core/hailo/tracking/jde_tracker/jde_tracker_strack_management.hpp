@@ -44,7 +44,9 @@ inline std::vector<STrack *> JDETracker::joint_strack_pointers(std::vector<STrac
 
 
 /**
- * @brief Returns a union of two vectors of STracks
+ * @brief Fills a vector with pointers to the union of two vectors of STracks.
+ *        STracks of tlistb whose track id already appears in tlista are skipped,
+ *        track ids are unique within each of the lists.
  * 
  * @param tlista  -  std::vector<STrack>
  *        A set of STracks to join
@@ -52,28 +54,26 @@ inline std::vector<STrack *> JDETracker::joint_strack_pointers(std::vector<STrac
  * @param tlistb  -  std::vector<STrack>
  *        A set of STracks to join
  *
- * @return std::vector<STrack *> 
- *         Pointers to the union of the two sets
+ * @param res  -  std::vector<STrack *>
+ *        Filled with pointers to the union of the two sets
  */
-inline std::vector<STrack *> JDETracker::joint_strack_pointers(std::vector<STrack> &tlista, std::vector<STrack> &tlistb)
+inline void JDETracker::joint_strack_pointers(std::vector<STrack> &tlista, std::vector<STrack> &tlistb, std::vector<STrack *> &res)
 {
-    std::set<int> existing_stracks_set;
-    std::vector<STrack *> res;
+    res.clear();
+    m_track_ids.clear();
     for (uint i = 0; i < tlista.size(); i++)
     {
-        existing_stracks_set.insert(tlista[i].m_track_id);
+        m_track_ids.push_back(tlista[i].m_track_id);
         res.push_back(&tlista[i]);
     }
+    std::sort(m_track_ids.begin(), m_track_ids.end());
     for (uint i = 0; i < tlistb.size(); i++)
     {
-        int tid = tlistb[i].m_track_id;
-        if (existing_stracks_set.count(tid) == 0)
+        if (!std::binary_search(m_track_ids.begin(), m_track_ids.end(), tlistb[i].m_track_id))
         {
-            existing_stracks_set.insert(tid);
             res.push_back(&tlistb[i]);
         }
     }
-    return res;
 }
 
 /**
@@ -123,10 +123,10 @@ inline std::vector<STrack> JDETracker::joint_stracks(std::vector<STrack> &tlista
  */
 inline std::vector<STrack> JDETracker::sub_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb)
 {
-    std::map<int, STrack> stracks;
+    std::map<int, STrack *> stracks;
     for (uint i = 0; i < tlista.size(); i++)
     {
-        stracks.insert(std::pair<int, STrack>(tlista[i].m_track_id, tlista[i]));
+        stracks.insert(std::pair<int, STrack *>(tlista[i].m_track_id, &tlista[i]));
     }
     for (uint i = 0; i < tlistb.size(); i++)
     {
@@ -138,9 +138,10 @@ inline std::vector<STrack> JDETracker::sub_stracks(std::vector<STrack> &tlista,
     }
 
     std::vector<STrack> res;
+    res.reserve(stracks.size());
     for (auto &it : stracks)
     {
-        res.push_back(it.second);
+        res.push_back(*it.second);
     }
     return res;
 }
@@ -165,13 +166,18 @@ inline std::vector<STrack> JDETracker::sub_stracks(std::vector<STrack> &tlista,
 inline void JDETracker::remove_duplicate_stracks(std::vector<STrack> &stracksa, std::vector<STrack> &stracksb)
 {
     std::vector<STrack> resa, resb;
-    std::vector<std::vector<float>> pdist = iou_distance(stracksa, stracksb);
+    std::vector<STrack *> pointersa, pointersb;
+    for (uint i = 0; i < stracksa.size(); i++)
+        pointersa.push_back(&stracksa[i]);
+    for (uint i = 0; i < stracksb.size(); i++)
+        pointersb.push_back(&stracksb[i]);
+    iou_distance(pointersa, pointersb, m_distances);
     std::vector<std::pair<int, int>> pairs;
-    for (uint i = 0; i < pdist.size(); i++)
+    for (int i = 0; i < m_distances.rows(); i++)
     {
-        for (uint j = 0; j < pdist[i].size(); j++)
+        for (int j = 0; j < m_distances.cols(); j++)
         {
-            if (pdist[i][j] < IOU_THRESHOLD)
+            if (m_distances(i, j) < IOU_THRESHOLD)
             {
                 pairs.push_back(std::pair<int, int>(i, j));
             }
@@ -208,8 +214,6 @@ inline void JDETracker::remove_duplicate_stracks(std::vector<STrack> &stracksa,
     }
 
     // Remove the duplicates
-    stracksa.clear();
-    stracksa.assign(resa.begin(), resa.end());
-    stracksb.clear();
-    stracksb.assign(resb.begin(), resb.end());
+    stracksa = std::move(resa);
+    stracksb = std::move(resb);
 }
\ No newline at end of file
@@ -20,27 +20,8 @@
 
 /**
  * @brief Keep specific indices from an input vector of stracks.
- *
- * @param stracks  -  std::vector<STrack>
- *        The stracks to keep from.
- *
- * @param indices  -  std::vector<int>
- *        The indices to keep.
- */
-inline void keep_indices(std::vector<STrack> &stracks, const std::vector<int> &indices)
-{
-    std::vector<STrack> stracks_swap;
-    stracks_swap.reserve(indices.size());
-    for (uint i = 0; i < indices.size(); i++)
-    {
-        if (indices[i] < (int)stracks.size())
-            stracks_swap.emplace_back(stracks[indices[i]]);
-    }
-    stracks = stracks_swap;
-}
-
-/**
- * @brief Keep specific indices from an input vector of stracks.
+ *        The vector is compacted in place, so the indices must be increasing
+ *        (as the unmatched indices from linear_assignment are).
  *
  * @param stracks  -  std::vector<STrack *>
  *        The stracks (by pointer) to keep from.
@@ -50,14 +31,13 @@ inline void keep_indices(std::vector<STrack> &stracks, const std::vector<int> &i
  */
 inline void keep_indices(std::vector<STrack *> &stracks, const std::vector<int> &indices)
 {
-    std::vector<STrack *> stracks_swap;
-    stracks_swap.reserve(indices.size());
+    uint kept = 0;
     for (uint i = 0; i < indices.size(); i++)
     {
         if (indices[i] < (int)stracks.size())
-            stracks_swap.emplace_back(stracks[indices[i]]);
+            stracks[kept++] = stracks[indices[i]];
     }
-    stracks = stracks_swap;
+    stracks.resize(kept);
 }
 
 /**
@@ -70,16 +50,16 @@ inline void keep_indices(std::vector<STrack *> &stracks, const std::vector<int>
  * @param tracked_stracks  -  std::vector<STrack *>
  *        The tracked stracks (by pointer).
  *
- * @param detections  -  std::vector<STrack>
- *        The detected objects.
+ * @param detections  -  std::vector<STrack *>
+ *        The detected objects (by pointer).
  *
  * @param activated_stracks  - std::vector<STrack>
  *        The currently active stracks. All matched stracks
- *        will be added here.
+ *        will be moved here.
  */
-inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
-                                       std::vector<STrack *> tracked_stracks,
-                                       std::vector<STrack> &detections,
+inline void JDETracker::update_matches(const std::vector<std::pair<int, int>> &matches,
+                                       const std::vector<STrack *> &tracked_stracks,
+                                       const std::vector<STrack *> &detections,
                                        std::vector<STrack> &activated_stracks)
 {
     for (uint i = 0; i < matches.size(); i++)
@@ -87,7 +67,7 @@ inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
         if ((tracked_stracks.size() == 0) || (detections.size() == 0))
             continue;
         STrack *track = tracked_stracks[matches[i].first];
-        STrack *det = &detections[matches[i].second];
+        STrack *det = detections[matches[i].second];
         switch (track->get_state())
         {
         case TrackState::Tracked: // The tracklet was already tracked, so update
@@ -100,7 +80,7 @@ inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
             track->activate(&this->m_kalman_filter, this->m_frame_id);
             break;
         }
-        activated_stracks.push_back(*track);
+        activated_stracks.push_back(std::move(*track));
     }
 }
 
@@ -112,6 +92,7 @@ inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
  *        Example: If a tracked object has been unmatched for more than
  *                 m_keep_tracked_frames, then it will be marked lost
  *                 and moved to the list of lost_stracks
+ *        Kept stracks are moved out of the pool.
  *
  * @param strack_pool  -  std::vector<STrack *>
  *        The pool of unmatched stracks.
@@ -126,7 +107,7 @@ inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
  *        The list of new stracks.
  *
  */
-inline void JDETracker::update_unmatches(std::vector<STrack *> strack_pool,
+inline void JDETracker::update_unmatches(const std::vector<STrack *> &strack_pool,
                                          std::vector<STrack> &tracked_stracks,
                                          std::vector<STrack> &lost_stracks,
                                          std::vector<STrack> &new_stracks)
@@ -139,18 +120,18 @@ inline void JDETracker::update_unmatches(std::vector<STrack *> strack_pool,
         case TrackState::Tracked:
             if (this->m_frame_id - track->end_frame() < this->m_keep_tracked_frames)
             {
-                tracked_stracks.push_back(*track); // Not over threshold, so still tracked
+                tracked_stracks.push_back(std::move(*track)); // Not over threshold, so still tracked
             }
             else
             {
                 track->mark_lost();
-                lost_stracks.push_back(*track); // Over keep threshold, now lost
+                lost_stracks.push_back(std::move(*track)); // Over keep threshold, now lost
             }
             break;
         case TrackState::Lost:
             if (this->m_frame_id - track->end_frame() < this->m_keep_lost_frames)
             {
-                lost_stracks.push_back(*track); // Not over threshold, so still lost
+                lost_stracks.push_back(std::move(*track)); // Not over threshold, so still lost
             }
             else
             {
@@ -160,7 +141,7 @@ inline void JDETracker::update_unmatches(std::vector<STrack *> strack_pool,
         case TrackState::New:
             if (this->m_frame_id - track->end_frame() < this->m_keep_new_frames)
             {
-                new_stracks.push_back(*track); // Not over threshold, so still new
+                new_stracks.push_back(std::move(*track)); // Not over threshold, so still new
             }
             else
             {
@@ -204,57 +185,64 @@ inline void JDETracker::update_unmatches(std::vector<STrack *> strack_pool,
 inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &inputs, bool report_unconfirmed = false, bool report_lost = false)
 {
     this->m_frame_id++;
-    std::vector<STrack> detections;        // New detections in this update
-    std::vector<STrack> activated_stracks; // Currently active stracks
-    std::vector<STrack> lost_stracks;      // Currently lost stracks
-    std::vector<STrack> new_stracks;       // Currently new stracks
+    // The association works on pointers into the tracker database and the detections of this update,
+    // stracks are only moved once they are sorted into the next tracked/lost/new lists.
+    std::vector<STrack> detections;                          // New detections in this update
+    std::vector<STrack> &activated_stracks = m_activated_stracks; // Currently active stracks
+    std::vector<STrack> &lost_stracks = m_next_lost_stracks;      // Currently lost stracks
+    std::vector<STrack> &new_stracks = m_next_new_stracks;        // Currently new stracks
 
-    std::vector<STrack *> strack_pool; // A pool of tracked/lost stracks to find matches for
+    std::vector<STrack *> &strack_pool = m_strack_pool;           // A pool of tracked/lost stracks to find matches for
+    std::vector<STrack *> &detection_pool = m_detection_pool;     // A pool of new detections to find matches for
+    std::vector<STrack *> &unconfirmed_pool = m_unconfirmed_pool; // A pool of unconfirmed stracks to find matches for
 
-    std::vector<std::vector<float>> distances; // A distance cost matrix for linear assignment
-    std::vector<std::pair<int, int>> matches;  // Pairs of matches between sets of stracks
-    std::vector<int> unmatched_tracked;        // Unmatched tracked stracks
-    std::vector<int> unmatched_detections;     // Unmatched new detections
+    CostMatrix &distances = m_distances;                             // A distance cost matrix for linear assignment
+    std::vector<std::pair<int, int>> &matches = m_matches;           // Pairs of matches between sets of stracks
+    std::vector<int> &unmatched_tracked = m_unmatched_tracked;       // Unmatched tracked stracks
+    std::vector<int> &unmatched_detections = m_unmatched_detections; // Unmatched new detections
 
     //******************************************************************
     // Step 1: Prepare tracks for new detections
     //******************************************************************
     detections = JDETracker::hailo_detections_to_stracks(inputs, this->m_frame_id, this->m_hailo_objects_blacklist); // Convert the new detections into STracks
+    detection_pool.clear();
+    for (uint i = 0; i < detections.size(); i++)
+        detection_pool.push_back(&detections[i]);
 
-    strack_pool = joint_strack_pointers(this->m_tracked_stracks, this->m_lost_stracks); // Pool together the tracked and lost stracks
-    STrack::multi_predict(strack_pool, this->m_kalman_filter);                          // Run Kalman Filter prediction step
+    joint_strack_pointers(this->m_tracked_stracks, this->m_lost_stracks, strack_pool); // Pool together the tracked and lost stracks
+    STrack::multi_predict(strack_pool, this->m_kalman_filter);                         // Run Kalman Filter prediction step
 
     //******************************************************************
     // Step 2: First association, tracked with embedding
     //******************************************************************
     // Calculate the distances between the tracked/lost stracks and the newly detected inputs
-    embedding_distance(strack_pool, detections, distances); // Calculate the distances
-    fuse_motion(distances, strack_pool, detections);        // Create the cost matrix
+    embedding_distance(strack_pool, detection_pool, distances); // Calculate the distances
+    fuse_motion(distances, strack_pool, detection_pool);        // Create the cost matrix
 
     // Use linear assignment to find matches
-    linear_assignment(distances, strack_pool.size(), detections.size(), this->m_kalman_dist_thr, matches, unmatched_tracked, unmatched_detections);
+    linear_assignment(distances, strack_pool.size(), detection_pool.size(), this->m_kalman_dist_thr, matches, unmatched_tracked, unmatched_detections);
 
     // Update the matches
-    update_matches(matches, strack_pool, detections, activated_stracks);
+    update_matches(matches, strack_pool, detection_pool, activated_stracks);
 
     //******************************************************************
     // Step 3: Second association, leftover tracked with IOU
     //******************************************************************
     // Use the unmatched_detections indices to get a vector of just the unmatched new detections
-    keep_indices(detections, unmatched_detections);
+    keep_indices(detection_pool, unmatched_detections);
 
     // Use the unmatched_tracked indices to get a vector of only unmatched, previously tracked, but-not-yet-lost stracks
     keep_indices(strack_pool, unmatched_tracked);
 
     // Instead of embedding distance, this time we will associate based on iou,
     // so calculate the iou distance of what's left
-    distances = iou_distance(strack_pool, detections);
+    iou_distance(strack_pool, detection_pool, distances);
 
     // Recalculate the linear assignment, this time use the iou threshold
-    linear_assignment(distances, strack_pool.size(), detections.size(), this->m_iou_thr, matches, unmatched_tracked, unmatched_detections);
+    linear_assignment(distances, strack_pool.size(), detection_pool.size(), this->m_iou_thr, matches, unmatched_tracked, unmatched_detections);
 
     // Update the matches
-    update_matches(matches, strack_pool, detections, activated_stracks);
+    update_matches(matches, strack_pool, detection_pool, activated_stracks);
 
     // Break down the strack_pool to just the remaining unmatched stracks
     keep_indices(strack_pool, unmatched_tracked);
@@ -267,18 +255,19 @@ inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &in
     //******************************************************************
     // Deal with the unconfirmed stracks, these are usually stracks with only one beginning frame
     // Use the unmatched_detections indices to get a vector of just the unmatched new detections again
-    keep_indices(detections, unmatched_detections);
-    std::vector<STrack> blank;
-    std::vector<STrack *> unconfirmed_pool = joint_strack_pointers(this->m_new_stracks, blank); // Prepare a pool of unconfirmed stracks
+    keep_indices(detection_pool, unmatched_detections);
+    unconfirmed_pool.clear();
+    for (uint i = 0; i < this->m_new_stracks.size(); i++)
+        unconfirmed_pool.push_back(&this->m_new_stracks[i]); // Prepare a pool of unconfirmed stracks
 
     // Recalculate the iou distance, this time between unconfirmed stracks and the remaining detections
-    distances = iou_distance(unconfirmed_pool, detections);
+    iou_distance(unconfirmed_pool, detection_pool, distances);
 
     // Recalculate the linear assignment, this time with the lower m_init_iou_thr threshold
-    linear_assignment(distances, unconfirmed_pool.size(), detections.size(), this->m_init_iou_thr, matches, unmatched_tracked, unmatched_detections);
+    linear_assignment(distances, unconfirmed_pool.size(), detection_pool.size(), this->m_init_iou_thr, matches, unmatched_tracked, unmatched_detections);
 
     // Update the matches
-    update_matches(matches, unconfirmed_pool, detections, activated_stracks);
+    update_matches(matches, unconfirmed_pool, detection_pool, activated_stracks);
 
     // Break down the strack_pool to just the remaining unmatched stracks
     keep_indices(unconfirmed_pool, unmatched_tracked);
@@ -291,21 +280,25 @@ inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &in
     //******************************************************************
     // At this point, any leftover unmatched new detections are considered new object instances for tracking
     for (uint i = 0; i < unmatched_detections.size(); i++)
-        new_stracks.emplace_back(detections[unmatched_detections[i]]);
+        new_stracks.emplace_back(std::move(*detection_pool[unmatched_detections[i]]));
 
     //******************************************************************
     // Step 6: Update Database
     //******************************************************************
-    // Update the tracker database members with the results of this update
-    this->m_tracked_stracks = activated_stracks;
-    this->m_lost_stracks = lost_stracks;
-    this->m_new_stracks = new_stracks;
+    // Update the tracker database members with the results of this update,
+    // the previous database is left in the scratch lists to be reused on the next update
+    std::swap(this->m_tracked_stracks, activated_stracks);
+    std::swap(this->m_lost_stracks, lost_stracks);
+    std::swap(this->m_new_stracks, new_stracks);
+    activated_stracks.clear();
+    lost_stracks.clear();
+    new_stracks.clear();
 
     //******************************************************************
     // Step 7: Set the output stracks
     //******************************************************************
     std::vector<STrack> output_stracks;
-    output_stracks.reserve(this->m_tracked_stracks.size());
+    output_stracks.reserve(this->m_tracked_stracks.size() + this->m_new_stracks.size() + this->m_lost_stracks.size());
     for (uint i = 0; i < this->m_tracked_stracks.size(); i++)
         output_stracks.emplace_back(this->m_tracked_stracks[i]);
 
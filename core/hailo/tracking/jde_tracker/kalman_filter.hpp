@@ -31,15 +31,6 @@
 #include "hailo_common.hpp"
 #include "tracker_macros.hpp"
 
-// Open source includes
-#include "xtensor/xadapt.hpp"
-#include "xtensor/xarray.hpp"
-#include "xtensor/xio.hpp"
-#include "xtensor/xmath.hpp"
-#include "xtensor/xview.hpp"
-
-using namespace xt::placeholders;
-
 __BEGIN_DECLS
 class KalmanFilter
 {
@@ -63,14 +54,16 @@ class KalmanFilter
         16.919};
 
     private:
-    // Identity matrices by which to multiply later means and covariances, initialized in the constructor and unchanged later
-    xt::xtensor_fixed<float, xt::xshape<8, 8>, xt::layout_type::row_major> m_motion_matrix;
-    xt::xtensor_fixed<float, xt::xshape<4, 8>, xt::layout_type::row_major> m_update_matrix;
+    // The motion (constant velocity, dt = 1) and observation (x, y, a, h) models are fixed,
+    // so they are unrolled into the kernels below instead of being kept as matrices
     float m_std_weight_position;  // weight of standard deviation for x and y
     float m_std_weight_position_box;  // weight of standard deviation for a and h
     float m_std_weight_velocity;  // weight of standard deviation for vx and vy
     float m_std_weight_velocity_box;  // weight of standard deviation for va and vh
 
+    // Number of tracks predicted together by multi_predict, sized so a batch stays in L1
+    static constexpr size_t PREDICT_BATCH_SIZE = 32;
+
     //******************************************************************
     // CLASS RESOURCE MANAGEMENT
     //******************************************************************
@@ -80,15 +73,6 @@ class KalmanFilter
     m_std_weight_position(std_weight_position), m_std_weight_position_box(std_weight_position_box),
     m_std_weight_velocity(std_weight_velocity), m_std_weight_velocity_box(std_weight_velocity_box)
     {
-        int ndim = 4;
-        float dt = 1.;
-
-        m_motion_matrix = xt::eye<float>({8, 8}, 0); // Identity matrix of shape 8 x 8
-        for (int i = 0; i < ndim; i++)
-        {
-            m_motion_matrix(i, ndim + i) = dt;
-        }
-        m_update_matrix = xt::eye<float>({4, 8}, 0); // Identity matrix of shape 4 x 8
     }
 
     // Params setters
@@ -104,244 +88,104 @@ class KalmanFilter
     float get_std_weight_velocity_box() { return m_std_weight_velocity_box; }
 
     //******************************************************************
-    // LINEAR ALGEBRA HELPER FUNCTIONS
+    // FIXED SIZE KERNELS
     //******************************************************************
     private:
     /**
      * @brief Performs a LL^T Cholesky decomposition of a symmetric, positive definite 
-     *        matrix A such that A = LLT, where L is a lower triangular matrix and LT it's transpose.
+     *        4x4 matrix A such that A = LLT, where L is a lower triangular matrix and LT it's transpose.
+     *        The partial sums are accumulated in an int, as the tracker always did, so the gating
+     *        distances and gains stay the same.
      * 
-     * @param matrix  -  TrackerTypes::KAL_HCOVA : <4x4>
-     *        The matrix to decompose, expected to be 4x4, and positive definite
+     * @param matrix  -  const float * : <4x4>
+     *        The row major matrix to decompose, expected to be positive definite
      *
-     * @return TrackerTypes::KAL_HCOVA  : <4x4>
-     *         The lower triamgular matrix of the cholesky decomposition.
+     * @param lower_matrix  -  float * : <4x4>
+     *        Filled with the row major lower triangular matrix of the decomposition.
      */
-    TrackerTypes::KAL_HCOVA cholesky_decomposition(TrackerTypes::KAL_HCOVA &matrix)
+    static void cholesky_decomposition(const float *matrix, float *lower_matrix)
     {
-        TrackerTypes::KAL_HCOVA lower_matrix = xt::zeros<float>({(int)matrix.shape(0), (int)matrix.shape(0)});
+        for (int i = 0; i < 16; i++)
+            lower_matrix[i] = 0.0f;
 
         int sum = 0;
-        // Decomposing a matrix into Lower Triangular
-        for (uint i = 0; i < matrix.shape(0); i++) {
-            for (uint j = 0; j <= i; j++) {
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j <= i; j++) {
                 sum = 0;
                 if (j == i) // summation for diagonals
                 {
-                    for (uint k = 0; k < j; k++)
-                        sum += std::pow(lower_matrix(j, k), 2);
-                    lower_matrix(j,j) = std::sqrt(matrix(j,j) - sum);
+                    for (int k = 0; k < j; k++)
+                        sum += std::pow(lower_matrix[j * 4 + k], 2);
+                    lower_matrix[j * 4 + j] = std::sqrt(matrix[j * 4 + j] - sum);
                 } else {
                     // Evaluating L(i, j) using L(j, j)
-                    for (uint k = 0; k < j; k++)
-                        sum += lower_matrix(i, k) * lower_matrix(j, k);
-                    lower_matrix(i, j) = (matrix(i, j) - sum) / lower_matrix(j, j);
+                    for (int k = 0; k < j; k++)
+                        sum += lower_matrix[i * 4 + k] * lower_matrix[j * 4 + k];
+                    lower_matrix[i * 4 + j] = (matrix[i * 4 + j] - sum) / lower_matrix[j * 4 + j];
                 }
             }
         }
-        return lower_matrix;
     }
 
     /**
-     * @brief Solves the system of linear equations Ax=B
-     *        where A is a lower triangular matrix L.
-     *        In short, performs forward-substitution.
+     * @brief Project a state to measurement space: the (x, y, a, h) part of the mean,
+     *        and the matching 4x4 block of the covariance plus the innovation noise.
      * 
-     * @param L  -  xt::xarray<float>
-     *        A lower trangular matrix.
-     *
-     * @param B  -  xt::xarray<float>
-     *        The right-hand-side of the system Ax=B, the number of rows
-     *        must match the rows of L.
-     *
-     * @return xt::xarray<float> 
-     *         The solution x to the system Ax=B.
+     * @param mean  -  const float * : <8>
+     * @param covariance  -  const float * : <8x8>
+     * @param projected_mean  -  float * : <4>
+     * @param projected_covariance  -  float * : <4x4>
      */
-    xt::xarray<float> forward_substitution(xt::xarray<float> L, xt::xarray<float> B)
+    void project(const float *mean, const float *covariance, float *projected_mean, float *projected_covariance) const
     {
-        // Check dimensionality
-        if (L.dimension() != 2 || B.dimension() != 2)
-            throw std::invalid_argument("forward_substitution broadcast error: only 2D matrices supported!");
-
-        // Get the rows and cols
-        int L_rows = L.shape(0);
-        int L_cols = L.shape(1);
-        int B_rows = B.shape(0);
-        int B_cols = B.shape(1);
-
-        // Check broadcasting rules
-        if (L_rows != B_rows)
-            throw std::invalid_argument("forward_substitution broadcast error: rows don't match!");
-
-        // Prepare x matrix
-        float partial_sum = 0.0;
-        xt::xarray<float>::shape_type shape = {(long unsigned int)L_cols, (long unsigned int)B_cols};
-        xt::xarray<float, xt::layout_type::row_major> x = xt::zeros<float>(shape);
-
-        // For each column of x (=B_cols)
-        for (int i = 0; i < B_cols; ++i)
+        float mean_height = mean[3];
+        const float standard_deviation[4] = {m_std_weight_position * mean_height, m_std_weight_position * mean_height,
+                                             m_std_weight_position_box * mean_height, m_std_weight_position_box * mean_height};
+        for (int i = 0; i < 4; i++)
         {
-            // For each row of x (and row of L, since symmetric)
-            for (int j = 0; j < L_rows; ++j)
-            {
-                partial_sum = 0;  // Reset the partial sum
-                // For each column of L up to the current diagonal (the j current row in L)
-                // This process is forward substitution
-                for (int k = 0; k < j; ++k)
-                {
-                    // Sum the dot product of the L_row*x_col up to the missing diagonal 
-                    partial_sum += L(j, k) * x(k, i);
-                }
-                // x at the missing diagonal is (B - the known sum)/the known L
-                x(j, i) = (B(j, i) - partial_sum) / L(j, j);
-            }
+            projected_mean[i] = mean[i];
+            for (int j = 0; j < 4; j++)
+                projected_covariance[i * 4 + j] = covariance[i * 8 + j];
+            projected_covariance[i * 4 + i] += standard_deviation[i] * standard_deviation[i];
         }
-        return x;
     }
 
     /**
-     * @brief Solves the system of linear equations Ax=B
-     *        where A is an upper triangular matrix U.
-     *        In short, performs back-substitution.
+     * @brief Prediction step over a batch of tracks stored as structure of arrays:
+     *        element e of track t is at [e][t], so every statement runs over all the tracks.
      * 
-     * @param U  -  xt::xarray<float>
-     *        An upper trangular matrix.
-     *
-     * @param B  -  xt::xarray<float>
-     *        The right-hand-side of the system Ax=B, the number of rows
-     *        must match the rows of U.
-     *
-     * @return xt::xarray<float> 
-     *         The solution x to the system Ax=B.
+     * @param mean  -  float[8][PREDICT_BATCH_SIZE]
+     * @param covariance  -  float[64][PREDICT_BATCH_SIZE]
+     * @param count  -  size_t
+     *        Number of tracks in the batch.
      */
-    xt::xarray<float> back_substitution(xt::xarray<float> U, xt::xarray<float> B)
+    void predict_batch(float (*mean)[PREDICT_BATCH_SIZE], float (*covariance)[PREDICT_BATCH_SIZE], size_t count) const
     {
-        // Check dimensionality
-        if (U.dimension() != 2 || B.dimension() != 2)
-            throw std::invalid_argument("forward_substitution broadcast error: only 2D matrices supported!");
-
-        // Get the rows and cols
-        int U_rows = U.shape(0);
-        int U_cols = U.shape(1);
-        int B_rows = B.shape(0);
-        int B_cols = B.shape(1);
-
-        // Check broadcasting rules
-        if (U_rows != B_rows)
-            throw std::invalid_argument("forward_substitution broadcast error: rows don't match!");
-
-        // Prepare x matrix
-        float partial_sum = 0.0;
-        xt::xarray<float>::shape_type shape = {(long unsigned int)U_cols, (long unsigned int)B_cols};
-        xt::xarray<float, xt::layout_type::row_major> x = xt::zeros<float>(shape);
-
-        // For each column of x (=y_cols=B_cols)
-        for (int i = 0; i < B_cols; ++i)
-        {
-            // For each row of U
-            // Since U is an upper matrix, we have to iterate in ascending order (starting from the bottom rows)
-            for (int j = U_rows - 1; j >= 0; j--)
-            {
-                partial_sum = 0;  // Reset the partial sum
-                // For each column of U up to the current diagonal
-                // Since U is an upper matrix, we have to iterate backwards
-                // This process is back substitution
-                for (int k = U_rows - 1; k > j; k--)
-                {
-                    // Sum the dot product of the U_row*x_col up to the missing diagonal 
-                    partial_sum += U(j, k) * x(k, i);
-                }
-                // x at the missing diagonal is (B - the known sum)/the known U
-                x(j, i) = (B(j, i) - partial_sum) / U(j, j);
-            }
-        }
-        return x;
-    }
-
-    /**
-     * @brief Solves the system of linear equations Ax=B
-     *        using the cholesky decomposition of A.
-     *        Parameters are auto and then adapted to 
-     *        support all types of xcontainers.
-     *
-     *        Given the cholesky A=LLT (where LT = L transposed),
-     *        we can turn Ax=B into LLTx=B, and split this into
-     *        the equations Ly=B, LTx=y. We first solve for y in 
-     *        Ly=B using forward-substitution, then solve for x in
-     *        LTx=y using back-substitution.
-     * 
-     * @param L_  -  any xcontainer
-     *        The cholesky decomposition of A, where A=LLT
-     *
-     * @param B_  -  any xcontainer
-     *        The right-hand-side of the system Ax=B, the number of rows
-     *        must match the sides of L_
-     *
-     * @return xt::xarray<float>
-     *         The solution x to the system Ax=B.
-     */
-    xt::xarray<float> solve_linear_eq_with_cholesky(auto L_, auto B_)
-    {
-        // Adapt the auto inputs to ensure xarrays
-        xt::xarray<float> L = L_;
-        xt::xarray<float> LT = xt::transpose(L);
-        xt::xarray<float> B = B_;
-
-        // Check dimensionality
-        if (L.dimension() != 2 || B.dimension() != 2)
-            throw std::invalid_argument("solve_cholesky broadcast error: only 2D matrices supported!");
-
-        // Check broadcasting rules: the rows of L and B should match
-        if (L.shape(0) != B.shape(0))
-            throw std::invalid_argument("solve_cholesky broadcast error: rows don't match!");
-
-        // First solve Ly=B with forward-substitution
-        xt::xarray<float, xt::layout_type::row_major> y = forward_substitution(L, B);
-
-        // Then solve LTx=y with back-substitution
-        xt::xarray<float, xt::layout_type::row_major> x = back_substitution(LT, y);
-
-        return x;
-    }
-
-    /**
-     * @brief Compute matrix multiplication between two 2 dimensional matrices .
-     * 
-     * @param matrix_1  -  xt::xarray<float, xt::layout_type::row_major>
-     *        The LHS matrix, columns must match rows in RHS matrix.
-     * 
-     * @param matrix_2  -  xt::xarray<float, xt::layout_type::row_major>
-     *        The RHS matrix, rows must match columns in LHS matrix.
-     * 
-     * @return xt::xarray<float, xt::layout_type::row_major>
-     *         The matrix multiplication of the two matrices.
-     *         Normal matrix broadcasting rules apply.
-     */
-    xt::xarray<float, xt::layout_type::row_major> mat_mul_2D(xt::xarray<float, xt::layout_type::row_major> matrix_1,
-                                                             xt::xarray<float, xt::layout_type::row_major> matrix_2)
-    {
-        uint axis_length = matrix_1.shape(1);
-        if (axis_length != matrix_2.shape(0))
-        {
-            throw std::invalid_argument("mat_mul_2D broadcast error: axis don't match!");
-        }
-
-        float row_sum;
-        xt::xarray<float>::shape_type shape = {matrix_1.shape(0), matrix_2.shape(1)};
-        xt::xarray<float, xt::layout_type::row_major> product_matrix(shape);
-        for (uint i = 0; i < matrix_1.shape(0); ++i)
+        const float std_weights[8] = {m_std_weight_position, m_std_weight_position, m_std_weight_position_box, m_std_weight_position_box,
+                                      m_std_weight_velocity, m_std_weight_velocity, m_std_weight_velocity_box, m_std_weight_velocity_box};
+        // Covariance: P * F^T adds the velocity columns to the position columns,
+        // then F * (P * F^T) adds the velocity rows to the position rows
+        for (int i = 0; i < 8; i++)
+            for (int j = 0; j < 4; j++)
+                for (size_t t = 0; t < count; t++)
+                    covariance[i * 8 + j][t] += covariance[i * 8 + j + 4][t];
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 8; j++)
+                for (size_t t = 0; t < count; t++)
+                    covariance[i * 8 + j][t] += covariance[(i + 4) * 8 + j][t];
+        // Motion noise, proportional to the height before the prediction
+        for (int i = 0; i < 8; i++)
         {
-            for (uint j = 0; j < matrix_2.shape(1); ++j)
+            for (size_t t = 0; t < count; t++)
             {
-                row_sum = 0.0;
-                for (uint k = 0; k < matrix_1.shape(1); ++k)
-                {
-                    row_sum += matrix_1(i, k) * matrix_2(k, j);
-                }
-                product_matrix(i, j) = row_sum;
+                float standard_deviation = std_weights[i] * mean[3][t];
+                covariance[i * 9][t] += standard_deviation * standard_deviation;
             }
         }
-        return product_matrix;
+        // Mean: F * mean moves the position by the velocity
+        for (int i = 0; i < 4; i++)
+            for (size_t t = 0; t < count; t++)
+                mean[i][t] += mean[i + 4][t];
     }
 
     //******************************************************************
@@ -362,26 +206,32 @@ class KalmanFilter
      */
     TrackerTypes::KAL_DATA initiate(const TrackerTypes::DETECTBOX &measurement)
     {
-        TrackerTypes::KAL_MEAN mean;
-        xt::view(mean, xt::all(), xt::range(_, 4)) = xt::squeeze(measurement);
-        xt::view(mean, xt::all(), xt::range(4, _)) = xt::zeros<float>({4});
+        TrackerTypes::KAL_DATA result;
+        float *mean = result.first.data();
+        float *covariance = result.second.data();
 
         float measured_height = measurement(3);
-        TrackerTypes::KAL_MEAN standard_deviation;
-        // Build standard deviation to the position (x, y, a, h)
-        standard_deviation(0) = 2 * m_std_weight_position * measured_height;
-        standard_deviation(1) = 2 * m_std_weight_position * measured_height;
-        standard_deviation(2) = 2 * m_std_weight_position_box * measured_height;
-        standard_deviation(3) = 2 * m_std_weight_position_box * measured_height;
-        // Build standard deviation to the velocities (vx, vy, va, vh)
-        standard_deviation(4) = 10 * m_std_weight_velocity * measured_height;
-        standard_deviation(5) = 10 * m_std_weight_velocity * measured_height;
-        standard_deviation(6) = 5 * m_std_weight_velocity_box * measured_height;
-        standard_deviation(7) = 5 * m_std_weight_velocity_box * measured_height;
+        const float standard_deviation[8] = {
+            // Standard deviation of the position (x, y, a, h)
+            2 * m_std_weight_position * measured_height,
+            2 * m_std_weight_position * measured_height,
+            2 * m_std_weight_position_box * measured_height,
+            2 * m_std_weight_position_box * measured_height,
+            // Standard deviation of the velocities (vx, vy, va, vh)
+            10 * m_std_weight_velocity * measured_height,
+            10 * m_std_weight_velocity * measured_height,
+            5 * m_std_weight_velocity_box * measured_height,
+            5 * m_std_weight_velocity_box * measured_height};
 
         // The standard deviations form the diagonal of the new covariance
-        TrackerTypes::KAL_COVA var = xt::diag(xt::squeeze(xt::square(standard_deviation)));
-        return std::make_pair(mean, var);
+        for (int i = 0; i < 64; i++)
+            covariance[i] = 0.0f;
+        for (int i = 0; i < 8; i++)
+        {
+            mean[i] = i < 4 ? measurement(i) : 0.0f;
+            covariance[i * 9] = standard_deviation[i] * standard_deviation[i];
+        }
+        return result;
     }
 
     /**
@@ -398,28 +248,54 @@ class KalmanFilter
      */
     void predict(TrackerTypes::KAL_MEAN &mean, TrackerTypes::KAL_COVA &covariance)
     {
-        float mean_height = mean(3);
-        TrackerTypes::KAL_MEAN standard_deviation;
-        // Build standard deviation for the position (x, y, a, h)
-        standard_deviation(0) = m_std_weight_position * mean_height;
-        standard_deviation(1) = m_std_weight_position * mean_height;
-        standard_deviation(2) = m_std_weight_position_box * mean_height;
-        standard_deviation(3) = m_std_weight_position_box * mean_height;
-        // Build standard deviation for the velocities (vx, vy, va, vh)
-        standard_deviation(4) = m_std_weight_velocity * mean_height;
-        standard_deviation(5) = m_std_weight_velocity * mean_height;
-        standard_deviation(6) = m_std_weight_velocity_box * mean_height;
-        standard_deviation(7) = m_std_weight_velocity_box * mean_height;
-        // Square and reshape the deviations to match the covariance space
-        TrackerTypes::KAL_COVA motion_covariance = xt::diag(xt::squeeze(xt::square(standard_deviation)));
-
-        TrackerTypes::KAL_MEAN predicted_mean = mat_mul_2D(this->m_motion_matrix, xt::transpose(mean));
-        TrackerTypes::KAL_COVA predicted_covariance = mat_mul_2D(this->m_motion_matrix, mat_mul_2D(covariance, xt::transpose(m_motion_matrix)));
-        predicted_covariance += motion_covariance;  // Apply the standard deviation of motion to the covariance
-
-        // Update the input mean / covariance 
-        mean = predicted_mean;
-        covariance = predicted_covariance;
+        TrackerTypes::KAL_MEAN *means[1] = {&mean};
+        TrackerTypes::KAL_COVA *covariances[1] = {&covariance};
+        multi_predict(means, covariances, 1);
+    }
+
+    /**
+     * @brief Run Kalman filter prediction step on several tracks.
+     *        The tracks are gathered into structure of arrays batches,
+     *        so the prediction of a batch runs as vector operations across the tracks.
+     * 
+     * @param means  -  TrackerTypes::KAL_MEAN * []
+     *        The mean vectors to predict in place.
+     * 
+     * @param covariances  -  TrackerTypes::KAL_COVA * []
+     *        The covariance matrices to predict in place, matching means.
+     * 
+     * @param count  -  size_t
+     *        Number of tracks.
+     */
+    void multi_predict(TrackerTypes::KAL_MEAN *const *means, TrackerTypes::KAL_COVA *const *covariances, size_t count)
+    {
+        float mean_batch[8][PREDICT_BATCH_SIZE];
+        float covariance_batch[64][PREDICT_BATCH_SIZE];
+        for (size_t first = 0; first < count; first += PREDICT_BATCH_SIZE)
+        {
+            size_t batch = std::min(PREDICT_BATCH_SIZE, count - first);
+            for (size_t t = 0; t < batch; t++)
+            {
+                const float *mean = means[first + t]->data();
+                const float *covariance = covariances[first + t]->data();
+                for (int e = 0; e < 8; e++)
+                    mean_batch[e][t] = mean[e];
+                for (int e = 0; e < 64; e++)
+                    covariance_batch[e][t] = covariance[e];
+            }
+
+            predict_batch(mean_batch, covariance_batch, batch);
+
+            for (size_t t = 0; t < batch; t++)
+            {
+                float *mean = means[first + t]->data();
+                float *covariance = covariances[first + t]->data();
+                for (int e = 0; e < 8; e++)
+                    mean[e] = mean_batch[e][t];
+                for (int e = 0; e < 64; e++)
+                    covariance[e] = covariance_batch[e][t];
+            }
+        }
     }
 
     /**
@@ -437,20 +313,9 @@ class KalmanFilter
      */
     TrackerTypes::KAL_HDATA project(const TrackerTypes::KAL_MEAN &mean, const TrackerTypes::KAL_COVA &covariance)
     {
-        float mean_height = mean(3);
-        TrackerTypes::DETECTBOX standard_deviation;
-        // Build standard deviation for the position (x, y, a, h)
-        standard_deviation(0) = m_std_weight_position * mean_height;
-        standard_deviation(1) = m_std_weight_position * mean_height;
-        standard_deviation(2) = m_std_weight_position_box * mean_height;
-        standard_deviation(3) = m_std_weight_position_box * mean_height;
-        // Square and reshape the deviations to match the covariance space
-        TrackerTypes::KAL_HCOVA innovation_covariance = xt::diag(xt::square(xt::squeeze(standard_deviation)));
-
-        TrackerTypes::KAL_HMEAN mean1 = mat_mul_2D(this->m_update_matrix, xt::transpose(mean));
-        TrackerTypes::KAL_HCOVA covariance1 = mat_mul_2D(this->m_update_matrix, mat_mul_2D(covariance, xt::transpose(this->m_update_matrix)));
-        covariance1 += innovation_covariance;
-        return std::make_pair(mean1, covariance1);
+        TrackerTypes::KAL_HDATA result;
+        project(mean.data(), covariance.data(), result.first.data(), result.second.data());
+        return result;
     }
 
     /**
@@ -477,20 +342,74 @@ class KalmanFilter
                                   const TrackerTypes::KAL_COVA &covariance,
                                   const TrackerTypes::DETECTBOX &measurement)
     {
-        TrackerTypes::KAL_HDATA projection_results = project(mean, covariance);
-        TrackerTypes::KAL_HMEAN projected_mean = projection_results.first;
-        TrackerTypes::KAL_HCOVA projected_covariance = projection_results.second;
-
-        // Solve Ax=B using cholesky decomposition
-        xt::xtensor_fixed<float, xt::xshape<4, 8>> B = xt::transpose(mat_mul_2D(covariance, xt::transpose(this->m_update_matrix)));
-        auto cholesky_factor = cholesky_decomposition(projected_covariance);
-        xt::xtensor_fixed<float, xt::xshape<8, 4>> kalman_gain = xt::transpose(solve_linear_eq_with_cholesky(cholesky_factor, B));
-        xt::xtensor_fixed<float, xt::xshape<1, 4>> innovation = measurement - projected_mean;
-        auto tmp = mat_mul_2D(innovation, xt::transpose(kalman_gain));
-
-        TrackerTypes::KAL_MEAN new_mean = mean + tmp;
-        TrackerTypes::KAL_COVA new_covariance = covariance - mat_mul_2D(kalman_gain, mat_mul_2D(projected_covariance, xt::transpose(kalman_gain)));
-        return std::make_pair(new_mean, new_covariance);
+        const float *state_mean = mean.data();
+        const float *state_covariance = covariance.data();
+        float projected_mean[4];
+        float projected_covariance[16];
+        project(state_mean, state_covariance, projected_mean, projected_covariance);
+
+        // Solve S * K^T = (P * H^T)^T for the kalman gain K with the cholesky factor of S:
+        // forward-substitution with L, then back-substitution with L^T, one column at a time
+        float lower_matrix[16];
+        cholesky_decomposition(projected_covariance, lower_matrix);
+        float gain_t[4][8]; // The kalman gain, transposed
+        for (int c = 0; c < 8; c++)
+        {
+            float y[4];
+            for (int j = 0; j < 4; j++)
+            {
+                float partial_sum = 0.0;
+                for (int k = 0; k < j; k++)
+                    partial_sum += lower_matrix[j * 4 + k] * y[k];
+                y[j] = (state_covariance[c * 8 + j] - partial_sum) / lower_matrix[j * 4 + j];
+            }
+            for (int j = 3; j >= 0; j--)
+            {
+                float partial_sum = 0.0;
+                for (int k = 3; k > j; k--)
+                    partial_sum += lower_matrix[k * 4 + j] * gain_t[k][c];
+                gain_t[j][c] = (y[j] - partial_sum) / lower_matrix[j * 4 + j];
+            }
+        }
+
+        float innovation[4];
+        for (int k = 0; k < 4; k++)
+            innovation[k] = measurement(k) - projected_mean[k];
+
+        TrackerTypes::KAL_DATA result;
+        float *new_mean = result.first.data();
+        float *new_covariance = result.second.data();
+        for (int j = 0; j < 8; j++)
+        {
+            float correction = 0.0;
+            for (int k = 0; k < 4; k++)
+                correction += innovation[k] * gain_t[k][j];
+            new_mean[j] = state_mean[j] + correction;
+        }
+
+        // new covariance = P - K * S * K^T
+        float sk_t[4][8];
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 8; j++)
+            {
+                float row_sum = 0.0;
+                for (int k = 0; k < 4; k++)
+                    row_sum += projected_covariance[i * 4 + k] * gain_t[k][j];
+                sk_t[i][j] = row_sum;
+            }
+        }
+        for (int i = 0; i < 8; i++)
+        {
+            for (int j = 0; j < 8; j++)
+            {
+                float row_sum = 0.0;
+                for (int k = 0; k < 4; k++)
+                    row_sum += gain_t[k][i] * sk_t[k][j];
+                new_covariance[i * 8 + j] = state_covariance[i * 8 + j] - row_sum;
+            }
+        }
+        return result;
     }
 
     /**
@@ -508,31 +427,38 @@ class KalmanFilter
      *        format (x, y, a, h) where (x, y) is the bounding box center
      *        position, a the aspect ratio, and h the height.
      * 
-     * @return xt::xarray<float>: <1, -1>
-     *         Returns an array of length N, where the i-th element contains the
-     *         squared Mahalanobis distance between (mean, covariance) and 
-     *         `measurements[i]`.
+     * @param square_mahalanobis  -  std::vector<float>
+     *        Filled with N elements, where the i-th element contains the
+     *        squared Mahalanobis distance between (mean, covariance) and 
+     *        `measurements[i]`.
      */
-    xt::xarray<float> gating_distance(const TrackerTypes::KAL_MEAN &mean,
-                                      const TrackerTypes::KAL_COVA &covariance,
-                                      const std::vector<TrackerTypes::DETECTBOX> &measurements)
+    void gating_distance(const TrackerTypes::KAL_MEAN &mean,
+                         const TrackerTypes::KAL_COVA &covariance,
+                         const std::vector<TrackerTypes::DETECTBOX> &measurements,
+                         std::vector<float> &square_mahalanobis)
     {
-        TrackerTypes::KAL_HDATA projection_results = project(mean, covariance);
-        TrackerTypes::KAL_HMEAN mean1 = projection_results.first;
-        TrackerTypes::KAL_HCOVA covariance1 = projection_results.second;
-        
-        // DETECTBOXSS differs from DETECTBOX in that DETECTBOXSS is Nx4 instead of 1x4
-        TrackerTypes::DETECTBOXSS d = xt::zeros<float>({(int)measurements.size(), 4});
+        float projected_mean[4];
+        float projected_covariance[16];
+        project(mean.data(), covariance.data(), projected_mean, projected_covariance);
+
+        // Solve L * z = d with forward-substitution, the distance is the squared norm of z
+        float lower_matrix[16];
+        cholesky_decomposition(projected_covariance, lower_matrix);
+        square_mahalanobis.resize(measurements.size());
         for (uint i = 0; i < measurements.size(); ++i)
         {
-            xt::row(d, i) = xt::squeeze(measurements[i] - mean1);
+            float z[4];
+            float distance = 0.0;
+            for (int j = 0; j < 4; j++)
+            {
+                float partial_sum = 0.0;
+                for (int k = 0; k < j; k++)
+                    partial_sum += lower_matrix[j * 4 + k] * z[k];
+                z[j] = ((measurements[i](j) - projected_mean[j]) - partial_sum) / lower_matrix[j * 4 + j];
+                distance += z[j] * z[j];
+            }
+            square_mahalanobis[i] = distance;
         }
-        // Extract lower triangular matrix from cholesky decomposition
-        xt::xarray<float, xt::layout_type::row_major> cholesky_factor = cholesky_decomposition(covariance1);
-        xt::xarray<float, xt::layout_type::row_major> z = xt::transpose(forward_substitution(cholesky_factor, xt::transpose(d)));
-        auto zz = z * z;  // Element-wise multiplication
-        xt::xarray<float> square_mahalanobis = xt::sum(zz, {1});
-        return square_mahalanobis;
     }
 };
 __END_DECLS
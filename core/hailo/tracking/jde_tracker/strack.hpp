@@ -12,6 +12,7 @@
 
 // General cpp includes
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 #include <string>
@@ -277,10 +278,9 @@ public:
      */
     int next_id()
     {
-        static int _count = 0;
-        _count++;
-        _count = _count % 100000; // Cycle ids after 100000
-        return _count;
+        // Shared by the trackers of every stream, which may run on different threads
+        static std::atomic<unsigned int> _count{0};
+        return (_count.fetch_add(1, std::memory_order_relaxed) + 1) % 100000; // Cycle ids after 100000
     }
 
     /**
@@ -305,14 +305,20 @@ public:
      */
     static void multi_predict(std::vector<STrack *> &stracks, KalmanFilter &kalman_filter)
     {
+        thread_local std::vector<TrackerTypes::KAL_MEAN *> means;
+        thread_local std::vector<TrackerTypes::KAL_COVA *> covariances;
+        means.clear();
+        covariances.clear();
         for (uint i = 0; i < stracks.size(); i++)
         {
             if (stracks[i]->m_state != TrackState::Tracked)
             {
                 stracks[i]->m_mean(7) = 0;
             }
-            kalman_filter.predict(stracks[i]->m_mean, stracks[i]->m_covariance);
+            means.push_back(&stracks[i]->m_mean);
+            covariances.push_back(&stracks[i]->m_covariance);
         }
+        kalman_filter.multi_predict(means.data(), covariances.data(), stracks.size());
     }
 
     /**
@@ -332,7 +338,7 @@ public:
         this->m_kalman_filter = kalman_filter;
         this->m_track_id = this->next_id();
 
-        HailoUniqueIDPtr object_id = std::make_shared<HailoUniqueID>(HailoUniqueID(this->m_track_id));
+        HailoUniqueIDPtr object_id = hailo_make_shared<HailoUniqueID>(HailoUniqueID(this->m_track_id));
         this->m_hailo_detection->add_object(object_id);
 
         TrackerTypes::DETECTBOX xyah_box = STrack::get_detectbox_from_tlwh(this->tmp_location_tlwh);